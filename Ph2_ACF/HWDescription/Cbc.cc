@@ -108,7 +108,7 @@ namespace Ph2_HwDescription {
                     fRegItem.fDefValue = strtoul ( fDefValue_str.c_str(), 0, 16 );
                     fRegItem.fValue = strtoul ( fValue_str.c_str(), 0, 16 );
 
-                    fRegMap[fName] = fRegItem;
+                    fRegMap[fName].reload ( fRegItem );
                     cLineCounter++;
                 }
             }
@@ -150,20 +150,69 @@ namespace Ph2_HwDescription {
             i->second.fValue = psetValue;
     }
 
-    RegItem Cbc::getRegItem ( const std::string& pReg )
+    const RegItem& Cbc::getRegItem ( const std::string& pReg ) const
     {
-        RegItem cItem;
-        CbcRegMap::iterator i = fRegMap.find ( pReg );
+        CbcRegMap::const_iterator i = fRegMap.find ( pReg );
 
         if ( i != std::end ( fRegMap ) ) return ( i->second );
         else
         {
             LOG (ERROR) << "Error, no Register " << pReg << " found in the RegisterMap of CBC " << +fCbcId << "!" ;
             throw Exception ( "Cbc: no matching register found" );
-            return cItem;
         }
     }
 
+    RegItem& Cbc::getRegItem ( const std::string& pReg )
+    {
+        return const_cast<RegItem&> ( static_cast<const Cbc*> ( this )->getRegItem ( pReg ) );
+    }
+
+    uint8_t Cbc::getReg ( CbcRegId pId ) const
+    {
+        const RegItem* cItem = fRegMap.get ( pId );
+
+        if ( cItem == nullptr )
+        {
+            LOG (INFO) << "The Cbc object: " << +fCbcId << " doesn't have register #" << pId ;
+            return 0;
+        }
+        else
+            return cItem->fValue;
+    }
+
+    void Cbc::setReg ( CbcRegId pId, uint8_t psetValue )
+    {
+        RegItem* cItem = fRegMap.get ( pId );
+
+        if ( cItem == nullptr )
+            LOG (INFO) << "The Cbc object: " << +fCbcId << " doesn't have register #" << pId ;
+        else
+            cItem->fValue = psetValue;
+    }
+
+    const RegItem& Cbc::getRegItem ( CbcRegId pId ) const
+    {
+        const RegItem* cItem = fRegMap.get ( pId );
+
+        if ( cItem != nullptr ) return *cItem;
+        else
+        {
+            LOG (ERROR) << "Error, no Register #" << pId << " found in the RegisterMap of CBC " << +fCbcId << "!" ;
+            throw Exception ( "Cbc: no matching register found" );
+        }
+    }
+
+    RegItem& Cbc::getRegItem ( CbcRegId pId )
+    {
+        return const_cast<RegItem&> ( static_cast<const Cbc*> ( this )->getRegItem ( pId ) );
+    }
+
+    void Cbc::invalidateShadow()
+    {
+        for ( auto& cReg : fRegMap )
+            cReg.second.fHwValid = false;
+    }
+
 
     //Write RegValues in a file
 
@@ -15,6 +15,7 @@
 
 #include "FrontEndDescription.h"
 #include "RegItem.h"
+#include "CbcRegMap.h"
 #include "../Utils/Visitor.h"
 #include "../Utils/Exception.h"
 #include <iostream>
@@ -34,8 +35,6 @@
  */
 namespace Ph2_HwDescription {
 
-    using CbcRegMap = std::map < std::string, RegItem >;
-    using CbcRegPair = std::pair <std::string, RegItem>;
     using CommentMap = std::map <int, std::string>;
 
     /*!
@@ -93,11 +92,35 @@ namespace Ph2_HwDescription {
         */
         void setReg ( const std::string& pReg, uint8_t psetValue );
         /*!
-        * \brief Get any registeritem of the Map
+        * \brief Get any registeritem of the Map, throws if the Cbc does not have it
         * \param pReg
         * \return  RegItem
         */
-        RegItem getRegItem ( const std::string& pReg );
+        const RegItem& getRegItem ( const std::string& pReg ) const;
+        RegItem& getRegItem ( const std::string& pReg );
+        /*!
+        * \brief Get any register from the Map by its index, see CbcRegIndex
+        * \param pId
+        * \return The value of the register
+        */
+        uint8_t getReg ( CbcRegId pId ) const;
+        /*!
+        * \brief Set any register of the Map by its index
+        * \param pId
+        * \param psetValue
+        */
+        void setReg ( CbcRegId pId, uint8_t psetValue );
+        /*!
+        * \brief Get any registeritem of the Map by its index, throws if the Cbc does not have it
+        * \param pId
+        * \return  RegItem
+        */
+        const RegItem& getRegItem ( CbcRegId pId ) const;
+        RegItem& getRegItem ( CbcRegId pId );
+        /*!
+        * \brief Forget what the chip holds, after a reset or a power cycle the next configuration writes every register
+        */
+        void invalidateShadow();
         /*!
         * \brief Write the registers of the Map in a file
         * \param filename
@@ -138,7 +161,7 @@ namespace Ph2_HwDescription {
 
         uint8_t fCbcId;
 
-        // Map of Register Name vs. RegisterItem that contains: Page, Address, Default Value, Value
+        // Register Name vs. RegisterItem that contains: Page, Address, Default Value, Value, stored by register index
         CbcRegMap fRegMap;
         CommentMap fCommentMap;
 
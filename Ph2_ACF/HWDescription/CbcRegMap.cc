@@ -0,0 +1,116 @@
+/*!
+
+        Filename :                      CbcRegMap.cc
+        Content :                       Flat, index based register storage of the Cbcs
+        Version :                       1.0
+
+ */
+
+#include "CbcRegMap.h"
+#include "Definition.h"
+#include <cstdio>
+
+namespace Ph2_HwDescription {
+
+    CbcRegIndex::CbcRegIndex()
+    {
+        // the offset registers first, so that channelOffset() is a subtraction
+        char cName[16];
+
+        for ( uint32_t cChannel = 1; cChannel <= NCHANNELS; cChannel++ )
+        {
+            snprintf ( cName, sizeof ( cName ), "Channel%03u", cChannel );
+            doIntern ( cName );
+        }
+    }
+
+    CbcRegIndex& CbcRegIndex::instance()
+    {
+        static CbcRegIndex cIndex;
+        return cIndex;
+    }
+
+    CbcRegId CbcRegIndex::doIntern ( const std::string& pName )
+    {
+        auto cIt = fIds.find ( pName );
+
+        if ( cIt != fIds.end() ) return cIt->second;
+
+        CbcRegId cId = CbcRegId ( fNames.size() );
+        fIds.emplace ( pName, cId );
+        fNames.push_back ( pName );
+        return cId;
+    }
+
+    CbcRegId CbcRegIndex::intern ( const std::string& pName )
+    {
+        CbcRegIndex& cIndex = instance();
+        std::lock_guard<std::mutex> cLock ( cIndex.fMutex );
+        return cIndex.doIntern ( pName );
+    }
+
+    CbcRegId CbcRegIndex::find ( const std::string& pName )
+    {
+        CbcRegIndex& cIndex = instance();
+        std::lock_guard<std::mutex> cLock ( cIndex.fMutex );
+        auto cIt = cIndex.fIds.find ( pName );
+        return ( cIt != cIndex.fIds.end() ) ? cIt->second : CBC_REG_INVALID;
+    }
+
+    const std::string& CbcRegIndex::name ( CbcRegId pId )
+    {
+        CbcRegIndex& cIndex = instance();
+        std::lock_guard<std::mutex> cLock ( cIndex.fMutex );
+        return cIndex.fNames.at ( pId );
+    }
+
+    size_t CbcRegIndex::size()
+    {
+        CbcRegIndex& cIndex = instance();
+        std::lock_guard<std::mutex> cLock ( cIndex.fMutex );
+        return cIndex.fNames.size();
+    }
+
+
+    void CbcRegMap::clear()
+    {
+        fItems.clear();
+        fIds.clear();
+        fFused.clear();
+        fSlots.clear();
+    }
+
+    CbcRegMap::iterator CbcRegMap::find ( const std::string& pName )
+    {
+        CbcRegId cId = CbcRegIndex::find ( pName );
+
+        if ( cId < fSlots.size() && fSlots[cId] >= 0 ) return fItems.begin() + fSlots[cId];
+        else return fItems.end();
+    }
+
+    CbcRegMap::const_iterator CbcRegMap::find ( const std::string& pName ) const
+    {
+        CbcRegId cId = CbcRegIndex::find ( pName );
+
+        if ( cId < fSlots.size() && fSlots[cId] >= 0 ) return fItems.begin() + fSlots[cId];
+        else return fItems.end();
+    }
+
+    RegItem& CbcRegMap::operator[] ( const std::string& pName )
+    {
+        CbcRegId cId = CbcRegIndex::intern ( pName );
+
+        if ( cId >= fSlots.size() ) fSlots.resize ( cId + 1, -1 );
+
+        if ( fSlots[cId] < 0 )
+        {
+            fSlots[cId] = fItems.size();
+            fItems.push_back ( {pName, RegItem() } );
+            fIds.push_back ( cId );
+            //this is to protect from readback errors during Configure as the BandgapFuse and ChipIDFuse registers should be e-fused in the CBC3
+            fFused.push_back ( pName.find ( "BandgapFuse" ) != std::string::npos || pName.find ( "ChipIDFuse" ) != std::string::npos );
+        }
+
+        return fItems[fSlots[cId]].second;
+    }
+}
@@ -0,0 +1,154 @@
+/*!
+
+        \file                   CbcRegMap.h
+        \brief                  Flat, index based register storage of the Cbcs
+        \version                1.0
+
+ */
+
+#ifndef CbcRegMap_h__
+#define CbcRegMap_h__
+
+#include "RegItem.h"
+#include <deque>
+#include <mutex>
+#include <string>
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Ph2_HwDescription {
+
+    using CbcRegId = uint16_t;
+    using CbcRegPair = std::pair <std::string, RegItem>;
+
+    const CbcRegId CBC_REG_INVALID = 0xFFFF;
+
+    /*!
+     * \class CbcRegIndex
+     * \brief Process wide index of the Cbc register names
+     *
+     * Every register name seen in a register file is interned once and gets a small integer id that is shared by all the
+     * Cbc objects, so the register storage of a chip is an array indexed by this id. The offset registers Channel001 to
+     * Channel254 are interned first and are contiguous, channelOffset() maps a channel to its id without any string.
+     */
+    class CbcRegIndex
+    {
+      public:
+        /*!
+         * \brief Id of pName, interned if it was not known yet
+         */
+        static CbcRegId intern ( const std::string& pName );
+        /*!
+         * \brief Id of pName, CBC_REG_INVALID if it was never interned
+         */
+        static CbcRegId find ( const std::string& pName );
+        /*!
+         * \brief Name of the register with id pId
+         */
+        static const std::string& name ( CbcRegId pId );
+        /*!
+         * \brief Id of the offset register ChannelXXX of channel pChannel, counting from 1 like the register names
+         */
+        static CbcRegId channelOffset ( uint8_t pChannel )
+        {
+            return CbcRegId ( pChannel - 1 );
+        }
+        /*!
+         * \brief Number of interned names
+         */
+        static size_t size();
+
+      private:
+        CbcRegIndex();
+        static CbcRegIndex& instance();
+        CbcRegId doIntern ( const std::string& pName );
+
+        std::mutex fMutex;
+        std::unordered_map<std::string, CbcRegId> fIds;
+        std::deque<std::string> fNames;         /*!< by id, a deque so that name() references stay valid */
+    };
+
+    /*!
+     * \class CbcRegMap
+     * \brief Register items of one Cbc in a contiguous array, in the order of the register file
+     *
+     * Iterates like the std::map it replaces (first is the name, second the RegItem), the lookup by CbcRegId is a table
+     * access and the lookup by name goes through CbcRegIndex.
+     */
+    class CbcRegMap
+    {
+      public:
+        using value_type = CbcRegPair;
+        using iterator = std::vector<CbcRegPair>::iterator;
+        using const_iterator = std::vector<CbcRegPair>::const_iterator;
+
+        iterator begin()
+        {
+            return fItems.begin();
+        }
+        iterator end()
+        {
+            return fItems.end();
+        }
+        const_iterator begin() const
+        {
+            return fItems.begin();
+        }
+        const_iterator end() const
+        {
+            return fItems.end();
+        }
+        size_t size() const
+        {
+            return fItems.size();
+        }
+        bool empty() const
+        {
+            return fItems.empty();
+        }
+        void clear();
+
+        iterator find ( const std::string& pName );
+        const_iterator find ( const std::string& pName ) const;
+        /*!
+         * \brief Item of the register pName, inserted at the end of the array if the chip does not have it yet
+         */
+        RegItem& operator[] ( const std::string& pName );
+
+        /*!
+         * \brief Item of register pId, nullptr if the chip does not have it
+         */
+        RegItem* get ( CbcRegId pId )
+        {
+            return ( pId < fSlots.size() && fSlots[pId] >= 0 ) ? &fItems[fSlots[pId]].second : nullptr;
+        }
+        const RegItem* get ( CbcRegId pId ) const
+        {
+            return ( pId < fSlots.size() && fSlots[pId] >= 0 ) ? &fItems[fSlots[pId]].second : nullptr;
+        }
+        /*!
+         * \brief Id of the register at position pIndex of the array
+         */
+        CbcRegId id ( size_t pIndex ) const
+        {
+            return fIds[pIndex];
+        }
+        /*!
+         * \brief true if the register at position pIndex is e-fused in the CBC3 (BandgapFuse, ChipIDFuse) and is not written at configuration
+         */
+        bool isFused ( size_t pIndex ) const
+        {
+            return fFused[pIndex];
+        }
+
+      private:
+        std::vector<CbcRegPair> fItems;
+        std::vector<CbcRegId> fIds;             /*!< id of each item */
+        std::vector<bool> fFused;
+        std::vector<int32_t> fSlots;            /*!< position in fItems by id, -1 if the chip does not have the register */
+    };
+}
+
+#endif
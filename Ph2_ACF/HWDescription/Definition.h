@@ -121,5 +121,6 @@ enum class BoardType {GLIB, ICGLIB, CTA, ICFC7, CBC3FC7, D19C, MPAlightGLIB, SUP
 enum class ChipType {UNDEFINED = 0, CBC2, CBC3, MPA, SSA};
 enum class SLinkDebugMode {SUMMARY = 0, FULL = 1, ERROR = 2};
 enum class EventType {ZS = 1, VR = 2};
+enum class RegWriteMode {FULL = 0, DELTA_ONLY = 1};
 
 #endif
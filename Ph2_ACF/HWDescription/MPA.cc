@@ -90,7 +90,7 @@ namespace Ph2_HwDescription {
                     fRegItem.fDefValue = strtoul ( fDefValue_str.c_str(), 0, 16 );
                     fRegItem.fValue = strtoul ( fValue_str.c_str(), 0, 16 );
 
-                    fRegMap[fName] = fRegItem;
+                    fRegMap[fName].reload ( fRegItem );
                     cLineCounter++;
                 }
             }
@@ -133,9 +133,8 @@ namespace Ph2_HwDescription {
             i->second.fValue = psetValue;
     }
 
-    RegItem MPA::getRegItem ( const std::string& pReg )
+    RegItem& MPA::getRegItem ( const std::string& pReg )
     {
-        RegItem cItem;
         MPARegMap::iterator i = fRegMap.find ( pReg );
 
         if ( i != std::end ( fRegMap ) ) return ( i->second );
@@ -143,10 +142,15 @@ namespace Ph2_HwDescription {
         {
             LOG (ERROR) << "Error, no Register " << pReg << " found in the RegisterMap of MPA " << +fMPAId << "!" ;
             throw Exception ( "MPA: no matching register found" );
-            return cItem;
         }
     }
 
+    void MPA::invalidateShadow()
+    {
+        for ( auto& cReg : fRegMap )
+            cReg.second.fHwValid = false;
+    }
+
 
     //Write RegValues in a file
 
@@ -88,7 +88,11 @@ namespace Ph2_HwDescription {
         * \param pReg
         * \return  RegItem
         */
-        RegItem getRegItem ( const std::string& pReg );
+        RegItem& getRegItem ( const std::string& pReg );
+        /*!
+        * \brief Forget what the chip holds, after a reset or a power cycle the next configuration writes every register
+        */
+        void invalidateShadow();
         /*!
         * \brief Write the registers of the Map in a file
         * \param filename
@@ -22,7 +22,7 @@ namespace Ph2_HwDescription {
      */
     struct RegItem
     {
-        RegItem() {};
+        RegItem() : fPage (0), fAddress (0), fDefValue (0), fValue (0) {}
         RegItem (uint8_t pPage, uint16_t pAddress, uint8_t pDefValue, uint8_t pValue) : fPage (pPage), fAddress (pAddress), fDefValue (pDefValue), fValue (pValue) {}
 
         uint8_t fPage;
@@ -30,6 +30,37 @@ namespace Ph2_HwDescription {
         uint8_t fDefValue;
         uint8_t fValue;
 
+        // shadow of the chip: the value the hardware holds as far as the software knows, from the last successful write or read
+        uint8_t fHwValue = 0;
+        bool fHwValid = false;
+
+        /*!
+         * \brief true if the chip is known to hold pValue
+         */
+        bool hwHolds ( uint8_t pValue ) const
+        {
+            return fHwValid && fHwValue == pValue;
+        }
+        /*!
+         * \brief Record that the chip holds pValue
+         */
+        void setHwValue ( uint8_t pValue )
+        {
+            fHwValue = pValue;
+            fHwValid = true;
+        }
+        /*!
+         * \brief Take page, address and values from pItem, the shadow is kept if the register did not move
+         */
+        void reload ( const RegItem& pItem )
+        {
+            if ( pItem.fPage != fPage || pItem.fAddress != fAddress ) fHwValid = false;
+
+            fPage = pItem.fPage;
+            fAddress = pItem.fAddress;
+            fDefValue = pItem.fDefValue;
+            fValue = pItem.fValue;
+        }
     };
 }
 
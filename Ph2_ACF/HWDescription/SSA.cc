@@ -74,7 +74,7 @@ namespace Ph2_HwDescription {
                     fRegItem.fAddress = strtoul ( fAddress_str.c_str(), 0, 16 );
                     fRegItem.fDefValue = strtoul ( fDefValue_str.c_str(), 0, 16 );
                     fRegItem.fValue = strtoul ( fValue_str.c_str(), 0, 16 );
-                    fRegMap[fName] = fRegItem;
+                    fRegMap[fName].reload ( fRegItem );
                     cLineCounter++;
                 }
             }
@@ -113,9 +113,8 @@ namespace Ph2_HwDescription {
             i->second.fValue = psetValue;
     }
 
-    RegItem SSA::getRegItem ( const std::string& pReg )
+    RegItem& SSA::getRegItem ( const std::string& pReg )
     {
-        RegItem cItem;
         SSARegMap::iterator i = fRegMap.find ( pReg );
 
         if ( i != std::end ( fRegMap ) ) return ( i->second );
@@ -123,10 +122,15 @@ namespace Ph2_HwDescription {
         {
             LOG (ERROR) << "Error, no Register " << pReg << " found in the RegisterMap of SSA " << +fSSAId << "!" ;
             throw Exception ( "SSA: no matching register found" );
-            return cItem;
         }
     }
 
+    void SSA::invalidateShadow()
+    {
+        for ( auto& cReg : fRegMap )
+            cReg.second.fHwValid = false;
+    }
+
     // D'Tor
 
     SSA::~SSA()
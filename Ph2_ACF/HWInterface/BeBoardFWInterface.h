@@ -13,6 +13,7 @@
 
 #include <uhal/uhal.hpp>
 #include "RegManager.h"
+#include "ReadoutWait.h"
 #include "../Utils/Event.h"
 #include "../Utils/FileHandler.h"
 #include "../Utils/Data.h"
@@ -97,6 +98,27 @@ namespace Ph2_HwInterface {
             fSaveToFile = false;
         }
         /*!
+        * \brief set how to wait between two polls of the readout status
+        */
+        void setReadoutWaitPolicy ( const ReadoutWaitPolicy& pPolicy )
+        {
+            fWaitPolicy = pPolicy;
+        }
+        /*!
+        * \brief get the time spent waiting for versus transferring readout data
+        */
+        const ReadoutTiming& getReadoutTiming() const
+        {
+            return fReadoutTiming;
+        }
+        /*!
+        * \brief reset the readout wait/transfer counters
+        */
+        void resetReadoutTiming()
+        {
+            fReadoutTiming.reset();
+        }
+        /*!
         * \brief Get the board type
         */
         virtual std::string readBoardType();
@@ -277,6 +299,8 @@ namespace Ph2_HwInterface {
 
         //bool runningAcquisition;
         uint32_t fBlockSize, fNPackets, numAcq, nbMaxAcq;
+        ReadoutWaitPolicy fWaitPolicy;
+        ReadoutTiming fReadoutTiming;
         //boost::thread thrAcq;
 
         //template to return a vector of all mismatched elements in two vectors using std::mismatch for readback value comparison
@@ -13,6 +13,24 @@
 
 namespace Ph2_HwInterface {
 
+    namespace {
+        // after a reset the chips hold their power-up values, the next configuration has to write everything
+        void invalidateShadows ( const BeBoard* pBoard )
+        {
+            for ( auto cFe : pBoard->fModuleVector )
+            {
+                for ( auto cCbc : cFe->fCbcVector )
+                    cCbc->invalidateShadow();
+
+                for ( auto cMPA : cFe->fMPAVector )
+                    cMPA->invalidateShadow();
+
+                for ( auto cSSA : cFe->fSSAVector )
+                    cSSA->invalidateShadow();
+            }
+        }
+    }
+
     BeBoardInterface::BeBoardInterface ( const BeBoardFWMap& pBoardMap ) :
         fBoardMap ( pBoardMap ),
         fBoardFW ( nullptr ),
@@ -137,6 +155,8 @@ namespace Ph2_HwInterface {
     {
         setBoard ( pBoard->getBeBoardIdentifier() );
         fBoardFW->ConfigureBoard ( pBoard );
+        // the board configuration resets the front-ends
+        invalidateShadows ( pBoard );
     }
 
     void BeBoardInterface::Start ( BeBoard* pBoard )
@@ -179,6 +199,24 @@ namespace Ph2_HwInterface {
         fBoardFW->ReadNEvents ( pBoard, pNEvents, pData, pWait );
     }
 
+    void BeBoardInterface::setReadoutWaitPolicy ( BeBoard* pBoard, const ReadoutWaitPolicy& pPolicy )
+    {
+        setBoard ( pBoard->getBeBoardIdentifier() );
+        fBoardFW->setReadoutWaitPolicy ( pPolicy );
+    }
+
+    const ReadoutTiming& BeBoardInterface::getReadoutTiming ( BeBoard* pBoard )
+    {
+        setBoard ( pBoard->getBeBoardIdentifier() );
+        return fBoardFW->getReadoutTiming();
+    }
+
+    void BeBoardInterface::resetReadoutTiming ( BeBoard* pBoard )
+    {
+        setBoard ( pBoard->getBeBoardIdentifier() );
+        fBoardFW->resetReadoutTiming();
+    }
+
     void BeBoardInterface::CbcFastReset ( const BeBoard* pBoard )
     {
         setBoard ( pBoard->getBeBoardIdentifier() );
@@ -201,6 +239,7 @@ namespace Ph2_HwInterface {
     {
         setBoard ( pBoard->getBeBoardIdentifier() );
         fBoardFW->CbcHardReset();
+        invalidateShadows ( pBoard );
     }
 
     const uhal::Node& BeBoardInterface::getUhalNode ( const BeBoard* pBoard, const std::string& pStrPath )
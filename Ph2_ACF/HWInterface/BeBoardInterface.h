@@ -217,6 +217,23 @@ namespace Ph2_HwInterface {
          * \param pNEvents :  the 1 indexed number of Events to read - this will set the packet size to this value -1
          */
         void ReadNEvents (BeBoard* pBoard, uint32_t pNEvents, std::vector<uint32_t>& pData, bool pWait = true);
+        /*!
+         * \brief Set how to wait between two polls of the readout status of a board
+         * \param pBoard
+         * \param pPolicy
+         */
+        void setReadoutWaitPolicy ( BeBoard* pBoard, const ReadoutWaitPolicy& pPolicy );
+        /*!
+         * \brief Get the time spent waiting for versus transferring readout data
+         * \param pBoard
+         * \return the readout counters of the board
+         */
+        const ReadoutTiming& getReadoutTiming ( BeBoard* pBoard );
+        /*!
+         * \brief Reset the readout wait/transfer counters of a board
+         * \param pBoard
+         */
+        void resetReadoutTiming ( BeBoard* pBoard );
 
         /*! \brief Get a uHAL node object from its path in the uHAL XML address file
          * \param pBoard pointer to a board description
@@ -11,6 +11,7 @@
 
 #include "CbcInterface.h"
 #include "../Utils/ConsoleColor.h"
+#include <algorithm>
 
 #define DEV_FLAG 0
 // #define COUNT_FLAG 0
@@ -22,7 +23,8 @@ namespace Ph2_HwInterface {
         fBoardFW ( nullptr ),
         prevBoardIdentifier ( 65535 ),
         fRegisterCount ( 0 ),
-        fTransactionCount ( 0 )
+        fTransactionCount ( 0 ),
+        fI2CWordsSaved ( 0 )
     {
 #ifdef COUNT_FLAG
         LOG (DEBUG) << "Counting number of Transactions!" ;
@@ -38,6 +40,7 @@ namespace Ph2_HwInterface {
 #ifdef COUNT_FLAG
         LOG (DEBUG) << "This instance of HWInterface::CbcInterface wrote (only write!) " << fRegisterCount << " Registers in " << fTransactionCount << " Transactions (only write!)! " ;
 #endif
+        LOG (DEBUG) << "Register writes skipped because the Cbcs already held the values: " << fI2CWordsSaved ;
     }
 
     void CbcInterface::setBoard ( uint16_t pBoardIdentifier )
@@ -57,31 +60,45 @@ namespace Ph2_HwInterface {
     }
 
 
-    bool CbcInterface::ConfigureCbc ( const Cbc* pCbc, bool pVerifLoop, uint32_t pBlockSize )
+    bool CbcInterface::ConfigureCbc ( Cbc* pCbc, bool pVerifLoop, uint32_t pBlockSize, RegWriteMode pMode )
     {
         //first, identify the correct BeBoardFWInterface
         setBoard ( pCbc->getBeBoardIdentifier() );
 
         //vector to encode all the registers into
         std::vector<uint32_t> cVec;
+        //helper vector with the position in the register array of what is written
+        std::vector<size_t> cWritten;
 
-        //Deal with the RegItems and encode them
+        //Deal with the RegItems and encode them, straight from the register array of the Cbc
 
-        CbcRegMap cCbcRegMap = pCbc->getRegMap();
+        CbcRegMap& cCbcRegMap = pCbc->getRegMap();
+        cVec.reserve ( cCbcRegMap.size() );
+        cWritten.reserve ( cCbcRegMap.size() );
 
-        for ( auto& cRegItem : cCbcRegMap )
+        for ( size_t cIndex = 0; cIndex < cCbcRegMap.size(); cIndex++ )
         {
             //this is to protect from readback errors during Configure as the BandgapFuse and ChipIDFuse registers should be e-fused in the CBC3
-            if (cRegItem.first.find ("BandgapFuse") == std::string::npos && cRegItem.first.find ("ChipIDFuse") == std::string::npos)
+            if ( cCbcRegMap.isFused ( cIndex ) ) continue;
+
+            const RegItem& cRegItem = ( cCbcRegMap.begin() + cIndex )->second;
+
+            if ( pMode == RegWriteMode::DELTA_ONLY && cRegItem.hwHolds ( cRegItem.fValue ) )
             {
-                fBoardFW->EncodeReg (cRegItem.second, pCbc->getFeId(), pCbc->getCbcId(), cVec, pVerifLoop, true);
+                fI2CWordsSaved++;
+                continue;
+            }
+
+            fBoardFW->EncodeReg ( cRegItem, pCbc->getFeId(), pCbc->getCbcId(), cVec, pVerifLoop, true);
+            cWritten.push_back ( cIndex );
 
 #ifdef COUNT_FLAG
-                fRegisterCount++;
+            fRegisterCount++;
 #endif
-            }
         }
 
+        if ( cVec.empty() ) return true;
+
         // write the registers, the answer will be in the same cVec
         // the number of times the write operation has been attempted is given by cWriteAttempts
         uint8_t cWriteAttempts = 0 ;
@@ -91,6 +108,15 @@ namespace Ph2_HwInterface {
         fTransactionCount++;
 #endif
 
+        // on failure it is not known which of the registers made it to the chip
+        for ( auto cIndex : cWritten )
+        {
+            RegItem& cRegItem = ( cCbcRegMap.begin() + cIndex )->second;
+
+            if ( cSuccess ) cRegItem.setHwValue ( cRegItem.fValue );
+            else cRegItem.fHwValid = false;
+        }
+
         return cSuccess;
     }
 
@@ -102,19 +128,17 @@ namespace Ph2_HwInterface {
 
         //vector to encode all the registers into
         std::vector<uint32_t> cVec;
-        //helper vector to store the register names in the same order as the RegItems
-        std::vector<std::string> cNameVec;
 
-        //Deal with the RegItems and encode them
+        //Deal with the RegItems and encode them, the replies come back in the order of the register array
 
-        CbcRegMap cCbcRegMap = pCbc->getRegMap();
+        CbcRegMap& cCbcRegMap = pCbc->getRegMap();
+        cVec.reserve ( cCbcRegMap.size() );
 
-        for ( auto& cRegItem : cCbcRegMap )
+        for ( const auto& cReg : cCbcRegMap )
         {
-            cRegItem.second.fValue = 0x00;
-            fBoardFW->EncodeReg (cRegItem.second, pCbc->getFeId(), pCbc->getCbcId(), cVec, true, false);
-            //push back the names in cNameVec for latercReg
-            cNameVec.push_back (cRegItem.first);
+            RegItem cRegItem = cReg.second;
+            cRegItem.fValue = 0x00;
+            fBoardFW->EncodeReg (cRegItem, pCbc->getFeId(), pCbc->getCbcId(), cVec, true, false);
 #ifdef COUNT_FLAG
             fRegisterCount++;
 #endif
@@ -140,12 +164,14 @@ namespace Ph2_HwInterface {
         for ( const auto& cReadWord : cVec )
         {
             RegItem cRegItem;
-            std::string cName = cNameVec[idxReadWord++];
+            RegItem& cStored = ( cCbcRegMap.begin() + idxReadWord++ )->second;
             fBoardFW->DecodeReg ( cRegItem, cCbcId, cReadWord, cRead, cFailed );
 
-            // here I need to find the string matching to the reg item!
             if (!cFailed)
-                pCbc->setReg ( cName, cRegItem.fValue );
+            {
+                cStored.fValue = cRegItem.fValue;
+                cStored.setHwValue ( cRegItem.fValue );
+            }
 
             //LOG (INFO) << "CBC " << +pCbc->getCbcId() << " " << cName << ": 0x" << std::hex << +cRegItem.fValue << std::dec ;
         }
@@ -159,7 +185,8 @@ namespace Ph2_HwInterface {
         setBoard ( pCbc->getBeBoardIdentifier() );
 
         //next, get the reg item
-        RegItem cRegItem = pCbc->getRegItem ( pRegNode );
+        RegItem& cStored = pCbc->getRegItem ( pRegNode );
+        RegItem cRegItem = cStored;
         cRegItem.fValue = pValue;
 
         //vector for transaction
@@ -174,7 +201,12 @@ namespace Ph2_HwInterface {
 
         //update the HWDescription object
         if (cSuccess)
-            pCbc->setReg ( pRegNode, pValue );
+        {
+            cStored.fValue = pValue;
+            cStored.setHwValue ( pValue );
+        }
+        else
+            cStored.fHwValid = false;
 
 #ifdef COUNT_FLAG
         fRegisterCount++;
@@ -184,27 +216,41 @@ namespace Ph2_HwInterface {
         return cSuccess;
     }
 
-    bool CbcInterface::WriteCbcMultReg ( Cbc* pCbc, const std::vector< std::pair<std::string, uint8_t> >& pVecReq, bool pVerifLoop )
+    bool CbcInterface::WriteCbcMultReg ( Cbc* pCbc, const std::vector< std::pair<std::string, uint8_t> >& pVecReq, bool pVerifLoop, RegWriteMode pMode )
     {
         //first, identify the correct BeBoardFWInterface
         setBoard ( pCbc->getBeBoardIdentifier() );
 
         std::vector<uint32_t> cVec;
+        //the stored items of what is written, with the value
+        std::vector<std::pair<RegItem*, uint8_t>> cWritten;
 
         //Deal with the RegItems and encode them
         RegItem cRegItem;
 
         for ( const auto& cReg : pVecReq )
         {
-            cRegItem = pCbc->getRegItem ( cReg.first );
+            RegItem& cStored = pCbc->getRegItem ( cReg.first );
+
+            if ( pMode == RegWriteMode::DELTA_ONLY && cStored.hwHolds ( cReg.second ) )
+            {
+                cStored.fValue = cReg.second;
+                fI2CWordsSaved++;
+                continue;
+            }
+
+            cRegItem = cStored;
             cRegItem.fValue = cReg.second;
 
             fBoardFW->EncodeReg ( cRegItem, pCbc->getFeId(), pCbc->getCbcId(), cVec, pVerifLoop, true );
+            cWritten.push_back ( {&cStored, cReg.second} );
 #ifdef COUNT_FLAG
             fRegisterCount++;
 #endif
         }
 
+        if ( cVec.empty() ) return true;
+
         // write the registers, the answer will be in the same cVec
         // the number of times the write operation has been attempted is given by cWriteAttempts
         uint8_t cWriteAttempts = 0 ;
@@ -215,19 +261,146 @@ namespace Ph2_HwInterface {
 #endif
 
         // if the transaction is successfull, update the HWDescription object
-        if (cSuccess)
+        for ( auto& cReg : cWritten )
         {
-            for ( const auto& cReg : pVecReq )
+            if ( cSuccess )
             {
-                cRegItem = pCbc->getRegItem ( cReg.first );
-                pCbc->setReg ( cReg.first, cReg.second );
+                cReg.first->fValue = cReg.second;
+                cReg.first->setHwValue ( cReg.second );
             }
+            else
+                cReg.first->fHwValid = false;
         }
 
         return cSuccess;
     }
 
 
+    bool CbcInterface::FlushCbcRegBatch ( CbcRegBatch& pBatch, bool pVerifLoop, RegWriteMode pMode, uint32_t pBlockSize )
+    {
+        using Operation = CbcRegBatch::Operation;
+
+        bool cSuccess = true;
+
+        if ( pBlockSize == 0 ) pBlockSize = 310;
+
+        // the operations per board, in the order they were queued
+        std::map<uint16_t, std::vector<const Operation*>> cWrites;
+        std::map<uint16_t, std::vector<const Operation*>> cReads;
+
+        for ( const auto& cOp : pBatch.fWrites )
+        {
+            if ( pMode == RegWriteMode::DELTA_ONLY && cOp.fItem->hwHolds ( cOp.fValue ) )
+            {
+                cOp.fItem->fValue = cOp.fValue;
+                fI2CWordsSaved++;
+            }
+            else
+                cWrites[cOp.fCbc->getBeBoardIdentifier()].push_back ( &cOp );
+        }
+
+        for ( const auto& cOp : pBatch.fReads )
+            cReads[cOp.fCbc->getBeBoardIdentifier()].push_back ( &cOp );
+
+        for ( const auto& cBoard : cWrites )
+        {
+            setBoard ( cBoard.first );
+            const std::vector<const Operation*>& cOps = cBoard.second;
+
+            for ( size_t cFirst = 0; cFirst < cOps.size(); cFirst += pBlockSize )
+            {
+                size_t cLast = std::min ( cFirst + pBlockSize, cOps.size() );
+                std::vector<uint32_t> cVec;
+                RegItem cRegItem;
+
+                // the commands carry the hybrid and the Cbc Id, so the Cbcs of the whole board share one FIFO fill
+                for ( size_t cIndex = cFirst; cIndex < cLast; cIndex++ )
+                {
+                    cRegItem = *cOps[cIndex]->fItem;
+                    cRegItem.fValue = cOps[cIndex]->fValue;
+                    fBoardFW->EncodeReg ( cRegItem, cOps[cIndex]->fCbc->getFeId(), cOps[cIndex]->fCbc->getCbcId(), cVec, pVerifLoop, true );
+#ifdef COUNT_FLAG
+                    fRegisterCount++;
+#endif
+                }
+
+                uint8_t cWriteAttempts = 0 ;
+                bool cBlockSuccess = fBoardFW->WriteCbcBlockReg ( cVec, cWriteAttempts, pVerifLoop );
+
+#ifdef COUNT_FLAG
+                fTransactionCount++;
+#endif
+
+                for ( size_t cIndex = cFirst; cIndex < cLast; cIndex++ )
+                {
+                    RegItem* cStored = cOps[cIndex]->fItem;
+
+                    if ( cBlockSuccess )
+                    {
+                        cStored->fValue = cOps[cIndex]->fValue;
+                        cStored->setHwValue ( cOps[cIndex]->fValue );
+                    }
+                    else
+                        cStored->fHwValid = false;
+                }
+
+                cSuccess &= cBlockSuccess;
+            }
+        }
+
+        for ( const auto& cBoard : cReads )
+        {
+            setBoard ( cBoard.first );
+            const std::vector<const Operation*>& cOps = cBoard.second;
+
+            for ( size_t cFirst = 0; cFirst < cOps.size(); cFirst += pBlockSize )
+            {
+                size_t cLast = std::min ( cFirst + pBlockSize, cOps.size() );
+                std::vector<uint32_t> cVec;
+
+                for ( size_t cIndex = cFirst; cIndex < cLast; cIndex++ )
+                {
+                    fBoardFW->EncodeReg ( *cOps[cIndex]->fItem, cOps[cIndex]->fCbc->getFeId(), cOps[cIndex]->fCbc->getCbcId(), cVec, true, false );
+#ifdef COUNT_FLAG
+                    fRegisterCount++;
+#endif
+                }
+
+                fBoardFW->ReadCbcBlockReg ( cVec );
+
+#ifdef COUNT_FLAG
+                fTransactionCount++;
+#endif
+
+                if ( cVec.size() != cLast - cFirst )
+                {
+                    LOG (ERROR) << BOLDRED << "Got " << cVec.size() << " I2C replies for " << cLast - cFirst << " register reads" << RESET;
+                    cSuccess = false;
+                }
+
+                bool cFailed = false;
+                bool cRead;
+                uint8_t cCbcId;
+                RegItem cRegItem;
+
+                // the replies come back in the order of the commands
+                for ( size_t cIndex = cFirst; cIndex < cLast && cIndex - cFirst < cVec.size(); cIndex++ )
+                {
+                    fBoardFW->DecodeReg ( cRegItem, cCbcId, cVec[cIndex - cFirst], cRead, cFailed );
+
+                    if (!cFailed)
+                    {
+                        cOps[cIndex]->fItem->fValue = cRegItem.fValue;
+                        cOps[cIndex]->fItem->setHwValue ( cRegItem.fValue );
+                    }
+                }
+            }
+        }
+
+        pBatch.clear();
+        return cSuccess;
+    }
+
 
     uint8_t CbcInterface::ReadCbcReg ( Cbc* pCbc, const std::string& pRegNode )
     {
@@ -246,7 +419,12 @@ namespace Ph2_HwInterface {
         uint8_t cCbcId;
         fBoardFW->DecodeReg ( cRegItem, cCbcId, cVecReq[0], cRead, cFailed );
 
-        if (!cFailed) pCbc->setReg ( pRegNode, cRegItem.fValue );
+        if (!cFailed)
+        {
+            RegItem& cStored = pCbc->getRegItem ( pRegNode );
+            cStored.fValue = cRegItem.fValue;
+            cStored.setHwValue ( cRegItem.fValue );
+        }
 
         return cRegItem.fValue;
     }
@@ -293,7 +471,11 @@ namespace Ph2_HwInterface {
 
             // here I need to find the string matching to the reg item!
             if (!cFailed)
-                pCbc->setReg ( cReg, cRegItem.fValue );
+            {
+                RegItem& cStored = pCbc->getRegItem ( cReg );
+                cStored.fValue = cRegItem.fValue;
+                cStored.setHwValue ( cRegItem.fValue );
+            }
         }
     }
 
@@ -369,9 +551,25 @@ namespace Ph2_HwInterface {
 #endif
 
         //update the HWDescription object -- not sure if the transaction was successfull
-        if (cSuccess)
-            for (auto& cCbc : pModule->fCbcVector)
-                cCbc->setReg ( pRegNode, pValue );
+        for (auto& cCbc : pModule->fCbcVector)
+        {
+            // a Cbc without this register is skipped, as setReg() did
+            CbcRegMap::iterator cStored = cCbc->getRegMap().find ( pRegNode );
+
+            if ( cStored == cCbc->getRegMap().end() )
+            {
+                LOG (ERROR) << "The Cbc object: " << +cCbc->getCbcId() << " doesn't have " << pRegNode ;
+                continue;
+            }
+
+            if (cSuccess)
+            {
+                cStored->second.fValue = pValue;
+                cStored->second.setHwValue ( pValue );
+            }
+            else
+                cStored->second.fHwValid = false;
+        }
     }
 
     void CbcInterface::WriteBroadcastMultReg (const Module* pModule, const std::vector<std::pair<std::string, uint8_t>> pVecReg)
@@ -402,12 +600,25 @@ namespace Ph2_HwInterface {
         fTransactionCount++;
 #endif
 
-        if (cSuccess)
-            for (auto& cCbc : pModule->fCbcVector)
-                for (auto& cReg : pVecReg)
+        for (auto& cCbc : pModule->fCbcVector)
+            for (auto& cReg : pVecReg)
+            {
+                // a Cbc without this register is skipped, as setReg() did
+                CbcRegMap::iterator cStored = cCbc->getRegMap().find ( cReg.first );
+
+                if ( cStored == cCbc->getRegMap().end() )
+                {
+                    LOG (ERROR) << "The Cbc object: " << +cCbc->getCbcId() << " doesn't have " << cReg.first ;
+                    continue;
+                }
+
+                if (cSuccess)
                 {
-                    cRegItem = cCbc->getRegItem ( cReg.first );
-                    cCbc->setReg ( cReg.first, cReg.second );
+                    cStored->second.fValue = cReg.second;
+                    cStored->second.setHwValue ( cReg.second );
                 }
+                else
+                    cStored->second.fHwValid = false;
+            }
     }
 }
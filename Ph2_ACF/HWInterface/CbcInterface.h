@@ -28,6 +28,74 @@ namespace Ph2_HwInterface {
 
     using BeBoardFWMap = std::map<uint16_t, BeBoardFWInterface*>;    /*!< Map of Board connected */
 
+    /*!
+     * \class CbcRegBatch
+     * \brief Register writes and reads for many Cbcs, on any number of hybrids and boards, sent by CbcInterface::FlushCbcRegBatch
+     *
+     * The register items are looked up when an operation is queued, so the batch is only valid as long as the register maps of the
+     * Cbcs do not get new registers.
+     */
+    class CbcRegBatch
+    {
+      public:
+        /*!
+         * \brief Queue writing pValue to register pRegNode of pCbc
+         */
+        void write ( Cbc* pCbc, const std::string& pRegNode, uint8_t pValue )
+        {
+            fWrites.push_back ( {pCbc, &pCbc->getRegItem ( pRegNode ), pValue} );
+        }
+        void write ( Cbc* pCbc, CbcRegId pId, uint8_t pValue )
+        {
+            fWrites.push_back ( {pCbc, &pCbc->getRegItem ( pId ), pValue} );
+        }
+        /*!
+         * \brief Queue writing several registers of pCbc
+         */
+        void write ( Cbc* pCbc, const std::vector< std::pair<std::string, uint8_t> >& pVecReq )
+        {
+            for ( const auto& cReg : pVecReq )
+                write ( pCbc, cReg.first, cReg.second );
+        }
+        /*!
+         * \brief Queue reading register pRegNode of pCbc, the value is stored in the Cbc object by the flush
+         */
+        void read ( Cbc* pCbc, const std::string& pRegNode )
+        {
+            fReads.push_back ( {pCbc, &pCbc->getRegItem ( pRegNode ), 0} );
+        }
+        void read ( Cbc* pCbc, CbcRegId pId )
+        {
+            fReads.push_back ( {pCbc, &pCbc->getRegItem ( pId ), 0} );
+        }
+        size_t size() const
+        {
+            return fWrites.size() + fReads.size();
+        }
+        bool empty() const
+        {
+            return fWrites.empty() && fReads.empty();
+        }
+        void clear()
+        {
+            fWrites.clear();
+            fReads.clear();
+        }
+
+      private:
+        friend class CbcInterface;
+
+        struct Operation
+        {
+            Cbc* fCbc;
+            RegItem* fItem;
+            uint8_t fValue;
+        };
+
+        std::vector<Operation> fWrites;
+        std::vector<Operation> fReads;
+    };
+
     /*!
      * \class CbcInterface
      * \brief Class representing the User Interface to the Cbc on different boards
@@ -42,6 +110,7 @@ namespace Ph2_HwInterface {
 
         uint16_t fRegisterCount;                                /*!< Counter for the number of Registers written */
         uint16_t fTransactionCount;         /*!< Counter for the number of Transactions */
+        uint32_t fI2CWordsSaved;            /*!< Counter for the register writes skipped by RegWriteMode::DELTA_ONLY, one I2C word each */
 
 
       private:
@@ -66,8 +135,9 @@ namespace Ph2_HwInterface {
          * \param pCbc: pointer to CBC object
          * \param pVerifLoop: perform a readback check
          * \param pBlockSize: the number of registers to be written at once, default is 310
+         * \param pMode: RegWriteMode::DELTA_ONLY only writes the registers the Cbc is not known to hold already
          */
-        bool ConfigureCbc ( const Cbc* pCbc, bool pVerifLoop = true, uint32_t pBlockSize = 310 );
+        bool ConfigureCbc ( Cbc* pCbc, bool pVerifLoop = true, uint32_t pBlockSize = 310, RegWriteMode pMode = RegWriteMode::FULL );
         /*!
          * \brief Read all the I2C parameters from the CBC
          * \param pCbc: pointer to CBC object
@@ -91,8 +161,19 @@ namespace Ph2_HwInterface {
          * \brief Write several registers in both Cbc and Cbc Config File
          * \param pCbc
          * \param pVecReq : Vector of pair: Node of the register to write versus value to write
+         * \param pMode : RegWriteMode::DELTA_ONLY skips the registers the Cbc is known to hold at the requested value
+         */
+        bool WriteCbcMultReg ( Cbc* pCbc, const std::vector< std::pair<std::string, uint8_t> >& pVecReq, bool pVerifLoop = true, RegWriteMode pMode = RegWriteMode::FULL );
+        /*!
+         * \brief Send the operations of pBatch and empty it: per board, all the writes go out as one I2C command FIFO fill with one
+         * reply readback, then all the reads the same way
+         * \param pBatch : the queued operations, cleared on return
+         * \param pVerifLoop : perform a readback check of the writes
+         * \param pMode : RegWriteMode::DELTA_ONLY skips the writes of values the Cbcs are known to hold
+         * \param pBlockSize : the maximum number of registers per FIFO fill, default is 310 like ConfigureCbc
+         * \return true if all the writes succeeded and all the replies of the reads came back
          */
-        bool WriteCbcMultReg ( Cbc* pCbc, const std::vector< std::pair<std::string, uint8_t> >& pVecReq, bool pVerifLoop = true );
+        bool FlushCbcRegBatch ( CbcRegBatch& pBatch, bool pVerifLoop = true, RegWriteMode pMode = RegWriteMode::FULL, uint32_t pBlockSize = 310 );
         /*!
          * \brief Write same register in all Cbcs and then UpdateCbc
          * \param pModule : Module containing vector of Cbcs
@@ -126,6 +207,13 @@ namespace Ph2_HwInterface {
         //void ReadAllCbc ( const Module* pModule );
         //void CbcCalibrationTrigger(const Cbc* pCbc );
         void output();
+        /*!
+         * \brief Number of register writes skipped so far because the Cbcs already held the values
+         */
+        uint32_t getI2CWordsSaved() const
+        {
+            return fI2CWordsSaved;
+        }
 
     };
 }
@@ -0,0 +1,733 @@
+/*!
+
+        \file                           D19cEmulatorFWInterface.cc
+        \brief                          D19cFWInterface served by a software model of the FC7 and its CBC3s
+        \version                        1.0
+
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <uhal/uhal.hpp>
+#include "D19cEmulatorFWInterface.h"
+
+namespace Ph2_HwInterface {
+
+    const char* const D19cEmulatorFWInterface::UHAL_URI = "ipbusudp-2.0://127.0.0.1:50001";
+
+    D19cEmulatorFWInterface::D19cEmulatorFWInterface ( const char* pId, const char* pUri, const char* pAddressTable ) :
+        D19cFWInterface ( pId, UHAL_URI, pAddressTable ),
+        fConfig(),
+        fPorts(),
+        fMemory(),
+        fCbcs(),
+        fRunning ( false ),
+        fTriggerRate ( 0 ),
+        fTriggersToAccept ( 0 ),
+        fNTriggersOffered ( 0 ),
+        fNTriggers ( 0 ),
+        fNTriggersTotal ( 0 ),
+        fL1Counter ( 0 ),
+        fFeMask ( 0 ),
+        fZeroSuppression ( false ),
+        fHandshake ( false ),
+        fPacketSize ( 1 ),
+        fReadout(),
+        fReadoutHead ( 0 ),
+        fReadoutBase ( 0 ),
+        fEventEnds(),
+        fHits(),
+        fReplies(),
+        fRepliesHead ( 0 ),
+        fI2CWritePending ( false ),
+        fI2CCommand ( 0 )
+    {
+        std::fill ( fChipMasks, fChipMasks + 8, 0 );
+        parseUri ( pUri );
+        // xorshift needs a non zero state
+        fRandomState = 0x9E3779B97F4A7C15ULL * ( uint64_t ( fConfig.fSeed ) + 1 );
+        buildPorts();
+        resetStatus();
+
+        LOG (INFO) << BOLDYELLOW << "Board " << pId << " is emulated in software, no hardware is accessed" << RESET;
+    }
+
+    bool D19cEmulatorFWInterface::isEmulatorUri ( const std::string& pUri )
+    {
+        return pUri.compare ( 0, 11, "emulator://" ) == 0;
+    }
+
+    void D19cEmulatorFWInterface::ResetRegManager ( const char* pId, const char* pUri, const char* pAddressTable )
+    {
+        // the emulator URI is not one uHAL knows; the D19C handles are dropped with the old HwInterface
+        D19cFWInterface::ResetRegManager ( pId, UHAL_URI, pAddressTable );
+        fMemory.clear();
+        buildPorts();
+        resetStatus();
+    }
+
+    void D19cEmulatorFWInterface::parseUri ( const std::string& pUri )
+    {
+        size_t cQuery = pUri.find ( '?' );
+
+        if ( cQuery == std::string::npos ) return;
+
+        std::stringstream cStream ( pUri.substr ( cQuery + 1 ) );
+        std::string cItem;
+
+        while ( std::getline ( cStream, cItem, '&' ) )
+        {
+            if ( cItem.empty() ) continue;
+
+            size_t cEqual = cItem.find ( '=' );
+
+            if ( cEqual == std::string::npos )
+            {
+                LOG (ERROR) << "Emulator parameter " << cItem << " has no value, ignored";
+                continue;
+            }
+
+            std::string cKey = cItem.substr ( 0, cEqual );
+            double cValue = strtod ( cItem.c_str() + cEqual + 1, nullptr );
+
+            if ( cKey == "pedestal" ) fConfig.fPedestal = cValue;
+            else if ( cKey == "pedestal_spread" ) fConfig.fPedestalSpread = cValue;
+            else if ( cKey == "noise" ) fConfig.fNoise = cValue;
+            else if ( cKey == "noise_spread" ) fConfig.fNoiseSpread = cValue;
+            else if ( cKey == "offset_gain" ) fConfig.fOffsetGain = cValue;
+            else if ( cKey == "trigger_rate" ) fConfig.fTriggerRate = cValue;
+            else if ( cKey == "ddr3" ) fConfig.fDDR3 = cValue;
+            else if ( cKey == "hybrids" ) fConfig.fNHybrids = cValue;
+            else if ( cKey == "chips" ) fConfig.fNChips = cValue;
+            else if ( cKey == "seed" ) fConfig.fSeed = cValue;
+            else LOG (ERROR) << "Unknown emulator parameter " << cKey << ", ignored";
+        }
+    }
+
+    void D19cEmulatorFWInterface::buildPorts()
+    {
+        fPorts.clear();
+        fPorts[resolve ( "fc7_daq_stat.readout_block.general.words_cnt" )] = Port::WORDS_CNT;
+        fPorts[resolve ( "fc7_daq_stat.readout_block.general.readout_req" )] = Port::READOUT_REQ;
+        fPorts[resolve ( "fc7_daq_stat.fast_command_block.trigger_in_counter" )] = Port::TRIGGER_IN_COUNTER;
+        fPorts[resolve ( "fc7_daq_stat.fast_command_block.general.fsm_state" )] = Port::FSM_STATE;
+        fPorts[resolve ( "fc7_daq_stat.command_processor_block.i2c.nreplies" )] = Port::I2C_NREPLIES;
+        fPorts[resolve ( "fc7_daq_stat.command_processor_block.i2c.reply_fifo.empty" )] = Port::I2C_REPLY_EMPTY;
+        fPorts[resolve ( "fc7_daq_ctrl.readout_block.readout_fifo" )] = Port::READOUT_FIFO;
+        fPorts[resolve ( "fc7_daq_ddr3" )] = Port::DDR3;
+        fPorts[resolve ( "fc7_daq_ctrl.command_processor_block.i2c.command_fifo" )] = Port::I2C_COMMAND_FIFO;
+        fPorts[resolve ( "fc7_daq_ctrl.command_processor_block.i2c.reply_fifo" )] = Port::I2C_REPLY_FIFO;
+        fPorts[resolve ( "fc7_daq_ctrl.fast_command_block.control.start_trigger" )] = Port::START_TRIGGER;
+        fPorts[resolve ( "fc7_daq_ctrl.fast_command_block.control.stop_trigger" )] = Port::STOP_TRIGGER;
+        fPorts[resolve ( "fc7_daq_ctrl.fast_command_block.control.load_config" )] = Port::LOAD_CONFIG;
+        fPorts[resolve ( "fc7_daq_ctrl.fast_command_block.control.fast_trigger" )] = Port::FAST_TRIGGER;
+        fPorts[resolve ( "fc7_daq_ctrl.readout_block.control.readout_reset" )] = Port::READOUT_RESET;
+        fPorts[resolve ( "fc7_daq_ctrl.command_processor_block.i2c.control.reset" )] = Port::I2C_RESET;
+        fPorts[resolve ( "fc7_daq_ctrl.command_processor_block.i2c.control.reset_fifos" )] = Port::I2C_RESET;
+        fPorts[resolve ( "fc7_daq_ctrl.command_processor_block.global.reset" )] = Port::GLOBAL_RESET;
+        fPorts[resolve ( "fc7_daq_ctrl.physical_interface_block.control.chip_hard_reset" )] = Port::CHIP_HARD_RESET;
+
+        fHybridEnableNode = resolve ( "fc7_daq_cnfg.global.hybrid_enable" );
+        fChipsEnableNodes.clear();
+
+        for ( int cFe = 0; cFe < 16; cFe++ )
+        {
+            char cName[64];
+            sprintf ( cName, "fc7_daq_cnfg.global.chips_enable_hyb_%02d", cFe );
+            fChipsEnableNodes.push_back ( resolve ( cName ) );
+        }
+
+        fTriggersToAcceptNode = resolve ( "fc7_daq_cnfg.fast_command_block.triggers_to_accept" );
+        fTriggerFrequencyNode = resolve ( "fc7_daq_cnfg.fast_command_block.user_trigger_frequency" );
+        fPacketNbrNode = resolve ( "fc7_daq_cnfg.readout_block.packet_nbr" );
+        fHandshakeNode = resolve ( "fc7_daq_cnfg.readout_block.global.data_handshake_enable" );
+        fZeroSuppressionNode = resolve ( "fc7_daq_cnfg.readout_block.global.zero_suppression_enable" );
+    }
+
+    void D19cEmulatorFWInterface::resetStatus()
+    {
+        // emulation firmware: no phase tuning of the lines
+        writeMemory ( resolve ( "fc7_daq_stat.general.info.implementation" ), 2 );
+        writeMemory ( resolve ( "fc7_daq_stat.general.info.chip_type" ), 1 );
+        writeMemory ( resolve ( "fc7_daq_stat.general.info.num_hybrids" ), fConfig.fNHybrids );
+        writeMemory ( resolve ( "fc7_daq_stat.general.info.num_chips" ), fConfig.fNChips );
+        writeMemory ( resolve ( "fc7_daq_stat.command_processor_block.i2c.master_version" ), 1 );
+        writeMemory ( resolve ( "fc7_daq_stat.ddr3_block.is_ddr3_type" ), fConfig.fDDR3 );
+        writeMemory ( resolve ( "fc7_daq_stat.ddr3_block.init_calib_done" ), 1 );
+    }
+
+    uhal::ValWord<uint32_t> D19cEmulatorFWInterface::queueRead ( RegHandle pHandle )
+    {
+        uhal::ValWord<uint32_t> cWord ( readNode ( pHandle ) );
+        cWord.valid ( true );
+        return cWord;
+    }
+
+    void D19cEmulatorFWInterface::queueWrite ( RegHandle pHandle, uint32_t pVal )
+    {
+        writeNode ( pHandle, pVal );
+    }
+
+    uhal::ValVector<uint32_t> D19cEmulatorFWInterface::queueReadBlock ( RegHandle pHandle, uint32_t pBlocksize, uint32_t pBlockOffset )
+    {
+        std::vector<uint32_t> cValues;
+        auto cPort = fPorts.find ( pHandle );
+
+        if ( cPort != fPorts.end() && ( cPort->second == Port::READOUT_FIFO || cPort->second == Port::DDR3 ) )
+            // the DDR3 is read at the offset where the previous read stopped
+            cValues = popReadout ( pBlocksize );
+        else if ( cPort != fPorts.end() && cPort->second == Port::I2C_REPLY_FIFO )
+        {
+            for ( uint32_t cIndex = 0; cIndex < pBlocksize; cIndex++ )
+                cValues.push_back ( readNode ( pHandle ) );
+        }
+        else
+        {
+            bool cIncremental = pHandle->getMode() != uhal::defs::NON_INCREMENTAL;
+
+            for ( uint32_t cIndex = 0; cIndex < pBlocksize; cIndex++ )
+            {
+                auto cWord = fMemory.find ( pHandle->getAddress() + ( cIncremental ? pBlockOffset + cIndex : 0 ) );
+                cValues.push_back ( cWord != fMemory.end() ? cWord->second : 0 );
+            }
+        }
+
+        uhal::ValVector<uint32_t> cBlock ( cValues );
+        cBlock.valid ( true );
+        return cBlock;
+    }
+
+    void D19cEmulatorFWInterface::queueWriteBlock ( RegHandle pHandle, const std::vector< uint32_t >& pValues )
+    {
+        auto cPort = fPorts.find ( pHandle );
+
+        if ( cPort != fPorts.end() && cPort->second == Port::I2C_COMMAND_FIFO ) executeI2C ( pValues );
+        else if ( cPort != fPorts.end() )
+        {
+            for ( auto cValue : pValues )
+                writeNode ( pHandle, cValue );
+        }
+        else
+        {
+            bool cIncremental = pHandle->getMode() != uhal::defs::NON_INCREMENTAL;
+
+            for ( size_t cIndex = 0; cIndex < pValues.size(); cIndex++ )
+                fMemory[pHandle->getAddress() + ( cIncremental ? cIndex : 0 )] = pValues[cIndex];
+        }
+    }
+
+    void D19cEmulatorFWInterface::dispatch()
+    {
+        // every access is served when it is queued
+    }
+
+    uint32_t D19cEmulatorFWInterface::readMemory ( RegHandle pHandle ) const
+    {
+        auto cWord = fMemory.find ( pHandle->getAddress() );
+
+        if ( cWord == fMemory.end() ) return 0;
+
+        uint32_t cMask = pHandle->getMask();
+        return ( cWord->second & cMask ) >> __builtin_ctz ( cMask );
+    }
+
+    void D19cEmulatorFWInterface::writeMemory ( RegHandle pHandle, uint32_t pVal )
+    {
+        uint32_t cMask = pHandle->getMask();
+        uint32_t& cWord = fMemory[pHandle->getAddress()];
+        cWord = ( cWord & ~cMask ) | ( ( pVal << __builtin_ctz ( cMask ) ) & cMask );
+    }
+
+    uint32_t D19cEmulatorFWInterface::readNode ( RegHandle pHandle )
+    {
+        auto cPort = fPorts.find ( pHandle );
+
+        if ( cPort == fPorts.end() ) return readMemory ( pHandle );
+
+        switch ( cPort->second )
+        {
+            case Port::WORDS_CNT:
+                advance();
+                return fReadout.size() - fReadoutHead;
+
+            case Port::READOUT_REQ:
+                advance();
+                return packetFull() || ( !fRunning && eventsInFifo() > 0 );
+
+            case Port::TRIGGER_IN_COUNTER:
+                advance();
+                return fNTriggers;
+
+            case Port::FSM_STATE:
+                advance();
+                return !fRunning ? 0 : ( packetFull() ? 2 : 1 );
+
+            case Port::I2C_NREPLIES:
+                return fReplies.size() - fRepliesHead;
+
+            case Port::I2C_REPLY_EMPTY:
+                return fReplies.size() == fRepliesHead;
+
+            case Port::READOUT_FIFO:
+            case Port::DDR3:
+                return popReadout ( 1 ).front();
+
+            case Port::I2C_REPLY_FIFO:
+            {
+                if ( fRepliesHead == fReplies.size() ) return 0;
+
+                uint32_t cReply = fReplies[fRepliesHead++];
+
+                if ( fRepliesHead == fReplies.size() )
+                {
+                    fReplies.clear();
+                    fRepliesHead = 0;
+                }
+
+                return cReply;
+            }
+
+            default:
+                // the control bits are pulses
+                return 0;
+        }
+    }
+
+    void D19cEmulatorFWInterface::writeNode ( RegHandle pHandle, uint32_t pVal )
+    {
+        auto cPort = fPorts.find ( pHandle );
+
+        if ( cPort == fPorts.end() )
+        {
+            writeMemory ( pHandle, pVal );
+            return;
+        }
+
+        if ( cPort->second == Port::I2C_COMMAND_FIFO )
+        {
+            executeI2C ( std::vector<uint32_t> ( 1, pVal ) );
+            return;
+        }
+
+        // the rest acts on a 1 only
+        if ( pVal == 0 ) return;
+
+        switch ( cPort->second )
+        {
+            case Port::START_TRIGGER:
+                startTrigger();
+                break;
+
+            case Port::STOP_TRIGGER:
+                advance();
+                fRunning = false;
+                break;
+
+            case Port::LOAD_CONFIG:
+                loadConfig();
+                break;
+
+            case Port::FAST_TRIGGER:
+                if ( !fRunning ) latchReadoutConfig();
+
+                generateEvent();
+                break;
+
+            case Port::READOUT_RESET:
+                resetReadout();
+                break;
+
+            case Port::I2C_RESET:
+            case Port::GLOBAL_RESET:
+                fReplies.clear();
+                fRepliesHead = 0;
+                fI2CWritePending = false;
+                break;
+
+            case Port::CHIP_HARD_RESET:
+                for ( auto& cCbc : fCbcs )
+                    resetCbc ( cCbc.second );
+
+                break;
+
+            default:
+                // status registers are read only
+                break;
+        }
+    }
+
+    void D19cEmulatorFWInterface::loadConfig()
+    {
+        fTriggersToAccept = readMemory ( fTriggersToAcceptNode );
+
+        if ( fConfig.fTriggerRate > 0 ) fTriggerRate = fConfig.fTriggerRate * 1e3;
+        else if ( fConfig.fTriggerRate == 0 ) fTriggerRate = -1;
+        else fTriggerRate = readMemory ( fTriggerFrequencyNode ) * 1e3;
+    }
+
+    void D19cEmulatorFWInterface::latchReadoutConfig()
+    {
+        fFeMask = readMemory ( fHybridEnableNode ) & 0xFF;
+
+        for ( int cFe = 0; cFe < 8; cFe++ )
+            fChipMasks[cFe] = readMemory ( fChipsEnableNodes[cFe] ) & 0xFF;
+
+        fZeroSuppression = readMemory ( fZeroSuppressionNode );
+        fHandshake = readMemory ( fHandshakeNode );
+        fPacketSize = readMemory ( fPacketNbrNode ) + 1;
+    }
+
+    void D19cEmulatorFWInterface::startTrigger()
+    {
+        latchReadoutConfig();
+        fRunning = true;
+        fStartTime = std::chrono::steady_clock::now();
+        fNTriggersOffered = 0;
+        fNTriggers = 0;
+    }
+
+    void D19cEmulatorFWInterface::advance()
+    {
+        if ( !fRunning ) return;
+
+        uint64_t cNew;
+
+        if ( fTriggerRate < 0 ) cNew = UINT64_MAX;
+        else
+        {
+            double cElapsed = std::chrono::duration<double> ( std::chrono::steady_clock::now() - fStartTime ).count();
+            uint64_t cOffered = cElapsed * fTriggerRate;
+            cNew = cOffered - fNTriggersOffered;
+            fNTriggersOffered = cOffered;
+        }
+
+        for ( ; cNew > 0; cNew-- )
+        {
+            if ( fTriggersToAccept > 0 && fNTriggers >= fTriggersToAccept ) break;
+
+            // back-pressure: the triggers that come while the packet or the FIFO is full are vetoed
+            if ( packetFull() || fReadout.size() - fReadoutHead >= READOUT_FIFO_WORDS ) break;
+
+            generateEvent();
+        }
+
+        if ( fTriggersToAccept > 0 && fNTriggers >= fTriggersToAccept ) fRunning = false;
+    }
+
+    uint32_t D19cEmulatorFWInterface::eventsInFifo() const
+    {
+        return fEventEnds.size();
+    }
+
+    bool D19cEmulatorFWInterface::packetFull() const
+    {
+        return fHandshake && eventsInFifo() >= fPacketSize;
+    }
+
+    void D19cEmulatorFWInterface::generateEvent()
+    {
+        fNTriggers++;
+        fNTriggersTotal++;
+        fL1Counter = ( fL1Counter + 1 ) & 0xFFFFFF;
+
+        size_t cStart = fReadout.size();
+        fReadout.resize ( cStart + 5, 0 );
+
+        for ( uint8_t cFe = 0; cFe < 8; cFe++ )
+        {
+            if ( ! ( ( fFeMask >> cFe ) & 1 ) ) continue;
+
+            size_t cHeader = fReadout.size();
+            fReadout.push_back ( 0 );
+
+            for ( uint8_t cCbcId = 0; cCbcId < 8; cCbcId++ )
+            {
+                if ( ! ( ( fChipMasks[cFe] >> cCbcId ) & 1 ) ) continue;
+
+                CbcModel& cCbc = getCbc ( cFe, cCbcId );
+
+                if ( fZeroSuppression ) appendCbcZS ( cCbc, cCbcId );
+                else appendCbcVR ( cCbc, cCbcId );
+            }
+
+            fReadout[cHeader] = ( uint32_t ( fChipMasks[cFe] ) << 24 ) | ( 1 << 16 ) | ( ( fReadout.size() - cHeader ) & 0xFFFF );
+        }
+
+        // the DDR3 firmware writes whole 256 bit words
+        uint32_t cNDummy = 0;
+
+        if ( fConfig.fDDR3 )
+        {
+            while ( ( fReadout.size() - cStart ) % 8 )
+            {
+                fReadout.push_back ( 0 );
+                cNDummy++;
+            }
+        }
+
+        uint32_t cEventSize = fReadout.size() - cStart;
+        fReadout[cStart] = ( 5 << 24 ) | ( uint32_t ( fFeMask ) << 16 ) | ( cEventSize & 0xFFFF );
+        fReadout[cStart + 1] = cNDummy & 0xFF;
+        fReadout[cStart + 2] = fL1Counter;
+        fReadout[cStart + 3] = fNTriggers;
+        fReadout[cStart + 4] = 0;
+
+        fEventEnds.push_back ( fReadoutBase + fReadout.size() );
+    }
+
+    void D19cEmulatorFWInterface::appendCbcVR ( CbcModel& pCbc, uint8_t pCbcId )
+    {
+        sampleHits ( pCbc );
+
+        size_t cFirst = fReadout.size();
+        fReadout.resize ( cFirst + 8, 0 );
+
+        // even channels in words 3 down to 0, odd ones in words 7 down to 4, 31 bits in the first word
+        for ( auto cChannel : fHits )
+        {
+            uint32_t cLast = ( cChannel & 1 ) ? 7 : 3;
+            uint32_t cIndex = cChannel >> 1;
+
+            if ( cIndex < 31 ) fReadout[cFirst + cLast] |= 1u << cIndex;
+            else fReadout[cFirst + cLast - 1 - ( cIndex - 31 ) / 32] |= 1u << ( ( cIndex - 31 ) % 32 );
+        }
+
+        uint32_t cL1 = fL1Counter & 0x1FF;
+        fReadout.push_back ( ( cL1 << 16 ) | ( cL1 << 4 ) );
+        // no stub, sync bit set
+        fReadout.push_back ( 0 );
+        fReadout.push_back ( 1 << 3 );
+    }
+
+    void D19cEmulatorFWInterface::appendCbcZS ( CbcModel& pCbc, uint8_t pCbcId )
+    {
+        sampleHits ( pCbc );
+
+        // clusters of neighbour strips of the same sensor, at most 8 wide
+        std::vector<uint32_t> cClusters;
+
+        for ( uint8_t cSensor = 0; cSensor < 2; cSensor++ )
+        {
+            int cAddress = -1;
+            uint32_t cWidth = 0;
+
+            for ( auto cChannel : fHits )
+            {
+                if ( ( cChannel & 1 ) != cSensor ) continue;
+
+                if ( cAddress >= 0 && cChannel == cAddress + 2 * cWidth && cWidth < 8 )
+                {
+                    cWidth++;
+                    continue;
+                }
+
+                if ( cAddress >= 0 ) cClusters.push_back ( ( cAddress << 3 ) | ( cWidth - 1 ) );
+
+                cAddress = cChannel;
+                cWidth = 1;
+            }
+
+            if ( cAddress >= 0 ) cClusters.push_back ( ( cAddress << 3 ) | ( cWidth - 1 ) );
+        }
+
+        uint32_t cChipBits = uint32_t ( pCbcId & 0x7 ) << 29;
+
+        for ( size_t cIndex = 0; cIndex < cClusters.size(); cIndex += 2 )
+        {
+            uint32_t cWord = cChipBits | ( 1 << 24 ) | cClusters[cIndex];
+
+            if ( cIndex + 1 < cClusters.size() ) cWord |= ( 1 << 25 ) | ( cClusters[cIndex + 1] << 11 );
+
+            fReadout.push_back ( cWord );
+        }
+
+        uint32_t cL1 = fL1Counter & 0x1FF;
+        fReadout.push_back ( cChipBits | ( 2 << 27 ) | ( cL1 << 16 ) | ( cL1 << 4 ) );
+    }
+
+    void D19cEmulatorFWInterface::sampleHits ( CbcModel& pCbc )
+    {
+        if ( pCbc.fChanged ) updateThresholds ( pCbc );
+
+        fHits.clear();
+
+        for ( uint32_t cChannel = 0; cChannel < NCHANNELS; cChannel++ )
+        {
+            uint64_t cThreshold = pCbc.fHitThreshold[cChannel];
+
+            if ( cThreshold == 0 ) continue;
+
+            if ( random32() < cThreshold ) fHits.push_back ( cChannel );
+        }
+    }
+
+    void D19cEmulatorFWInterface::resetReadout()
+    {
+        fReadout.clear();
+        fReadoutHead = 0;
+        fReadoutBase = 0;
+        fEventEnds.clear();
+    }
+
+    std::vector<uint32_t> D19cEmulatorFWInterface::popReadout ( uint32_t pNWords )
+    {
+        // an empty FIFO reads 0
+        std::vector<uint32_t> cWords ( pNWords, 0 );
+        size_t cNWords = fReadout.size() - fReadoutHead;
+
+        if ( pNWords < cNWords ) cNWords = pNWords;
+
+        std::copy ( fReadout.begin() + fReadoutHead, fReadout.begin() + fReadoutHead + cNWords, cWords.begin() );
+        fReadoutHead += cNWords;
+
+        while ( !fEventEnds.empty() && fEventEnds.front() <= fReadoutBase + fReadoutHead )
+            fEventEnds.pop_front();
+
+        // drop the words already read once they are half of the buffer
+        if ( fReadoutHead > 4096 && 2 * fReadoutHead > fReadout.size() )
+        {
+            fReadout.erase ( fReadout.begin(), fReadout.begin() + fReadoutHead );
+            fReadoutBase += fReadoutHead;
+            fReadoutHead = 0;
+        }
+
+        return cWords;
+    }
+
+    bool D19cEmulatorFWInterface::chipEnabled ( uint8_t pFeId, uint8_t pCbcId ) const
+    {
+        if ( pFeId >= fChipsEnableNodes.size() || pCbcId >= 32 ) return false;
+
+        return ( ( readMemory ( fHybridEnableNode ) >> pFeId ) & 1 ) && ( ( readMemory ( fChipsEnableNodes[pFeId] ) >> pCbcId ) & 1 );
+    }
+
+    D19cEmulatorFWInterface::CbcModel& D19cEmulatorFWInterface::getCbc ( uint8_t pFeId, uint8_t pCbcId )
+    {
+        uint16_t cKey = ( uint16_t ( pFeId ) << 8 ) | pCbcId;
+        auto cCbc = fCbcs.find ( cKey );
+
+        if ( cCbc != fCbcs.end() ) return cCbc->second;
+
+        CbcModel& cModel = fCbcs[cKey];
+        // the same chip gets the same channels for a given seed
+        std::mt19937 cGenerator ( fConfig.fSeed * 65537u + cKey );
+        std::normal_distribution<float> cPedestal ( fConfig.fPedestal, fConfig.fPedestalSpread );
+        std::normal_distribution<float> cNoise ( fConfig.fNoise, fConfig.fNoiseSpread );
+
+        for ( uint32_t cChannel = 0; cChannel < NCHANNELS; cChannel++ )
+        {
+            cModel.fPedestal.push_back ( cPedestal ( cGenerator ) );
+            cModel.fNoise.push_back ( std::max ( 0.01f, cNoise ( cGenerator ) ) );
+        }
+
+        cModel.fHitThreshold.assign ( NCHANNELS, 0 );
+        resetCbc ( cModel );
+        return cModel;
+    }
+
+    void D19cEmulatorFWInterface::resetCbc ( CbcModel& pCbc )
+    {
+        memset ( pCbc.fRegisters, 0, sizeof ( pCbc.fRegisters ) );
+
+        for ( uint32_t cChannel = 0; cChannel < NCHANNELS; cChannel++ )
+            pCbc.fRegisters[1][cChannel + 1] = 0x80;
+
+        pCbc.fRegisters[0][0x50] = 0x02;
+        pCbc.fChanged = true;
+    }
+
+    void D19cEmulatorFWInterface::updateThresholds ( CbcModel& pCbc )
+    {
+        // electron mode: the channel fires when VCth is above its pedestal plus the noise
+        double cVCth = pCbc.fRegisters[0][0x4F] | ( ( pCbc.fRegisters[0][0x50] & 0x3 ) << 8 );
+
+        for ( uint32_t cChannel = 0; cChannel < NCHANNELS; cChannel++ )
+        {
+            bool cEnabled = ( pCbc.fRegisters[0][0x20 + cChannel / 8] >> ( cChannel % 8 ) ) & 1;
+            uint8_t cOffset = pCbc.fRegisters[1][cChannel + 1];
+
+            if ( !cEnabled || cOffset == 0xFF )
+            {
+                pCbc.fHitThreshold[cChannel] = 0;
+                continue;
+            }
+
+            double cPedestal = pCbc.fPedestal[cChannel] + fConfig.fOffsetGain * ( int ( cOffset ) - 0x80 );
+            double cProbability = 0.5 * std::erfc ( ( cPedestal - cVCth ) / ( pCbc.fNoise[cChannel] * std::sqrt ( 2. ) ) );
+            pCbc.fHitThreshold[cChannel] = cProbability * 4294967296.;
+        }
+
+        pCbc.fChanged = false;
+    }
+
+    void D19cEmulatorFWInterface::executeI2C ( const std::vector<uint32_t>& pCommands )
+    {
+        for ( auto cWord : pCommands )
+        {
+            // the broadcast keeps the single word format of the first I2C master
+            if ( ( cWord >> 28 ) == 2 )
+            {
+                fI2CWritePending = false;
+                bool cWrite = ! ( ( cWord >> 16 ) & 1 );
+                accessCbcs ( -1, 0, ( cWord >> 17 ) & 1, ( cWord >> 8 ) & 0xFF, cWrite, cWord & 0xFF, !cWrite || ( ( cWord >> 19 ) & 1 ) );
+                continue;
+            }
+
+            // data word of the write before it
+            if ( ( cWord >> 27 ) == 1 )
+            {
+                if ( fI2CWritePending )
+                    accessCbcs ( ( fI2CCommand >> 23 ) & 0xF, ( fI2CCommand >> 18 ) & 0x1F, ( fI2CCommand >> 8 ) & 1, fI2CCommand & 0xFF, true, cWord & 0xFF, ( fI2CCommand >> 17 ) & 1 );
+
+                fI2CWritePending = false;
+                continue;
+            }
+
+            fI2CWritePending = false;
+
+            if ( ( cWord >> 16 ) & 1 ) accessCbcs ( ( cWord >> 23 ) & 0xF, ( cWord >> 18 ) & 0x1F, ( cWord >> 8 ) & 1, cWord & 0xFF, false, 0, true );
+            else
+            {
+                fI2CWritePending = true;
+                fI2CCommand = cWord;
+            }
+        }
+    }
+
+    void D19cEmulatorFWInterface::accessCbcs ( int pFeId, uint8_t pCbcId, uint8_t pPage, uint8_t pAddress, bool pWrite, uint8_t pValue, bool pReply )
+    {
+        for ( uint8_t cFe = 0; cFe < 8; cFe++ )
+        {
+            for ( uint8_t cCbc = 0; cCbc < 8; cCbc++ )
+            {
+                if ( pFeId >= 0 && ( cFe != pFeId || cCbc != pCbcId ) ) continue;
+
+                if ( !chipEnabled ( cFe, cCbc ) ) continue;
+
+                CbcModel& cModel = getCbc ( cFe, cCbc );
+
+                if ( pWrite )
+                {
+                    cModel.fRegisters[pPage][pAddress] = pValue;
+                    cModel.fChanged = true;
+                }
+
+                if ( pReply )
+                    fReplies.push_back ( ( uint32_t ( cFe ) << 23 ) | ( uint32_t ( cCbc ) << 18 ) | ( uint32_t ( !pWrite ) << 16 ) | ( uint32_t ( pAddress ) << 8 ) | cModel.fRegisters[pPage][pAddress] );
+            }
+        }
+    }
+
+    uint32_t D19cEmulatorFWInterface::random32()
+    {
+        // xorshift64*
+        fRandomState ^= fRandomState >> 12;
+        fRandomState ^= fRandomState << 25;
+        fRandomState ^= fRandomState >> 27;
+        return ( fRandomState * 2685821657736338717ULL ) >> 32;
+    }
+}
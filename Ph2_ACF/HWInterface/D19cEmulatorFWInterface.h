@@ -0,0 +1,196 @@
+/*!
+
+        \file                           D19cEmulatorFWInterface.h
+        \brief                          D19cFWInterface served by a software model of the FC7 and its CBC3s
+        \version                        1.0
+
+ */
+
+#ifndef _D19CEMULATORFWINTERFACE_H__
+#define _D19CEMULATORFWINTERFACE_H__
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include "D19cFWInterface.h"
+
+/*!
+ * \namespace Ph2_HwInterface
+ * \brief Namespace regrouping all the interfaces to the hardware
+ */
+namespace Ph2_HwInterface {
+
+    /*!
+     * \class D19cEmulatorFWInterface
+     * \brief D19C board without hardware, for throughput measurements of the readout and calibration code
+     *
+     * The register accesses of RegManager are served in memory at the addresses of the D19C address table, so all the
+     * code of D19cFWInterface runs unchanged. The model has the readout FIFO (or the DDR3), the I2C command and reply FIFOs
+     * and the register pages of CBC3 chips. Triggers come at the configured rate for any trigger source and every enabled
+     * chip sends its hits in the VR or ZS format: a channel fires when VCth is above its pedestal, shifted by its offset
+     * register, plus a gaussian noise. Stubs, test pulses, the I2C bus timing and the MPA/SSA are not emulated.
+     *
+     * It is selected by a connection URI emulator://<name>[?<key>=<value>&...], see EmulatorConfig for the keys. uHAL is
+     * only used to load the address table, the board is never contacted.
+     */
+    class D19cEmulatorFWInterface : public D19cFWInterface
+    {
+      public:
+        /*!
+         * \brief Parameters of the emulation, given in the query of the connection URI
+         */
+        struct EmulatorConfig
+        {
+            double fPedestal = 512;         /*!< pedestal: mean of the chip, VCth units*/
+            double fPedestalSpread = 10;    /*!< pedestal_spread: rms of the channel pedestals around it*/
+            double fNoise = 4;              /*!< noise: mean of the channel noise, VCth units*/
+            double fNoiseSpread = 0.5;      /*!< noise_spread: rms of the channel noise*/
+            double fOffsetGain = 1;         /*!< offset_gain: pedestal shift per unit of the offset register above 0x80*/
+            double fTriggerRate = -1;       /*!< trigger_rate: in kHz, 0 for as fast as the readout goes, negative to follow user_trigger_frequency*/
+            uint32_t fDDR3 = 0;             /*!< ddr3: 1 to emulate a DDR3 readout firmware*/
+            uint32_t fNHybrids = 8;         /*!< hybrids: number of hybrids the firmware claims to be built for*/
+            uint32_t fNChips = 8;           /*!< chips: number of chips per hybrid the firmware claims to be built for*/
+            uint32_t fSeed = 1;             /*!< seed: of the channel parameters and of the noise*/
+        };
+
+        /*!
+         * \brief Constructor of the D19cEmulatorFWInterface class
+         * \param pId : ID string
+         * \param pUri : emulator:// URI with the parameters of the emulation
+         * \param pAddressTable : D19C address table
+         */
+        D19cEmulatorFWInterface ( const char* pId, const char* pUri, const char* pAddressTable );
+
+        /*!
+         * \brief Is this connection URI one of the emulator
+         */
+        static bool isEmulatorUri ( const std::string& pUri );
+
+        const EmulatorConfig& getEmulatorConfig() const
+        {
+            return fConfig;
+        }
+        /*!
+         * \brief Number of triggers accepted since the construction
+         */
+        uint64_t getNTriggers() const
+        {
+            return fNTriggersTotal;
+        }
+
+        void ResetRegManager ( const char* pId, const char* pUri, const char* pAddressTable ) override;
+
+      protected:
+        uhal::ValWord<uint32_t> queueRead ( RegHandle pHandle ) override;
+        void queueWrite ( RegHandle pHandle, uint32_t pVal ) override;
+        uhal::ValVector<uint32_t> queueReadBlock ( RegHandle pHandle, uint32_t pBlocksize, uint32_t pBlockOffset ) override;
+        void queueWriteBlock ( RegHandle pHandle, const std::vector< uint32_t >& pValues ) override;
+        void dispatch() override;
+
+      private:
+        // registers with a behaviour, everything else is plain memory
+        enum class Port {WORDS_CNT, READOUT_REQ, TRIGGER_IN_COUNTER, FSM_STATE, I2C_NREPLIES, I2C_REPLY_EMPTY, READOUT_FIFO, DDR3,
+                         I2C_COMMAND_FIFO, I2C_REPLY_FIFO, START_TRIGGER, STOP_TRIGGER, LOAD_CONFIG, FAST_TRIGGER, READOUT_RESET,
+                         I2C_RESET, GLOBAL_RESET, CHIP_HARD_RESET
+                        };
+
+        struct CbcModel
+        {
+            uint8_t fRegisters[2][256];
+            std::vector<float> fPedestal;
+            std::vector<float> fNoise;
+            std::vector<uint64_t> fHitThreshold;    /*!< hit probability of each channel times 2^32*/
+            bool fChanged;                          /*!< the thresholds have to be computed again*/
+        };
+
+        // parse the query of the URI into fConfig
+        void parseUri ( const std::string& pUri );
+        // the behaviour of the special registers and the content of the status ones
+        void buildPorts();
+        void resetStatus();
+
+        uint32_t readNode ( RegHandle pHandle );
+        void writeNode ( RegHandle pHandle, uint32_t pVal );
+        uint32_t readMemory ( RegHandle pHandle ) const;
+        void writeMemory ( RegHandle pHandle, uint32_t pVal );
+
+        // triggers
+        void loadConfig();
+        void startTrigger();
+        void latchReadoutConfig();
+        void advance();
+        uint32_t eventsInFifo() const;
+        bool packetFull() const;
+        void generateEvent();
+        void appendCbcVR ( CbcModel& pCbc, uint8_t pCbcId );
+        void appendCbcZS ( CbcModel& pCbc, uint8_t pCbcId );
+        // fills fHits with the channels that fire, in increasing order
+        void sampleHits ( CbcModel& pCbc );
+        void resetReadout();
+        std::vector<uint32_t> popReadout ( uint32_t pNWords );
+
+        // front-ends
+        bool chipEnabled ( uint8_t pFeId, uint8_t pCbcId ) const;
+        CbcModel& getCbc ( uint8_t pFeId, uint8_t pCbcId );
+        void resetCbc ( CbcModel& pCbc );
+        void updateThresholds ( CbcModel& pCbc );
+        void executeI2C ( const std::vector<uint32_t>& pCommands );
+        // one chip, or every enabled chip for a negative pFeId
+        void accessCbcs ( int pFeId, uint8_t pCbcId, uint8_t pPage, uint8_t pAddress, bool pWrite, uint8_t pValue, bool pReply );
+
+        uint32_t random32();
+
+        EmulatorConfig fConfig;
+
+        std::unordered_map<RegHandle, Port> fPorts;
+        std::unordered_map<uint32_t, uint32_t> fMemory;         /*!< word of every address written so far*/
+
+        RegHandle fHybridEnableNode;
+        std::vector<RegHandle> fChipsEnableNodes;
+        RegHandle fTriggersToAcceptNode;
+        RegHandle fTriggerFrequencyNode;
+        RegHandle fPacketNbrNode;
+        RegHandle fHandshakeNode;
+        RegHandle fZeroSuppressionNode;
+
+        std::map<uint16_t, CbcModel> fCbcs;                     /*!< by (FeId << 8 | CbcId), which is also the reply order of a broadcast*/
+
+        // trigger state, latched at load_config and start_trigger
+        bool fRunning;
+        std::chrono::steady_clock::time_point fStartTime;
+        double fTriggerRate;                                    /*!< Hz, negative for as fast as the readout goes*/
+        uint32_t fTriggersToAccept;
+        uint64_t fNTriggersOffered;
+        uint64_t fNTriggers;
+        uint64_t fNTriggersTotal;
+        uint32_t fL1Counter;
+        uint8_t fFeMask;
+        uint8_t fChipMasks[8];
+        bool fZeroSuppression;
+        bool fHandshake;
+        uint32_t fPacketSize;
+
+        // readout FIFO, the words before fReadoutHead are already read
+        std::vector<uint32_t> fReadout;
+        size_t fReadoutHead;
+        uint64_t fReadoutBase;                                  /*!< number of words read before fReadout[0]*/
+        std::deque<uint64_t> fEventEnds;                        /*!< number of words written up to the end of each event still in the FIFO*/
+        std::vector<uint8_t> fHits;
+
+        std::vector<uint32_t> fReplies;
+        size_t fRepliesHead;
+        bool fI2CWritePending;                                  /*!< fI2CCommand is a write waiting for its data word*/
+        uint32_t fI2CCommand;
+
+        uint64_t fRandomState;
+
+        static const char* const UHAL_URI;                      /*!< valid URI given to uHAL, never contacted*/
+        static const uint32_t READOUT_FIFO_WORDS = 1 << 22;     /*!< the triggers are vetoed above this occupancy of the readout FIFO*/
+    };
+}
+
+#endif
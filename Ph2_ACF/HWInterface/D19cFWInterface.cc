@@ -13,9 +13,11 @@
 
 #include <time.h>
 #include <chrono>
+#include <algorithm>
 #include <uhal/uhal.hpp>
 #include "D19cFWInterface.h"
 #include "CtaFpgaConfig.h"
+#include "../Utils/BitKernels.h"
 
 //#include "CbcInterface.h"
 
@@ -29,7 +31,19 @@ D19cFWInterface::D19cFWInterface ( const char* puHalConfigFileName,
     fBroadcastCbcId (0),
     fNCbc (0),
     fNMPA (0),
-    fFMCId (1)
+    fFMCId (1),
+    fWordsCntReg (nullptr),
+    fReadoutReqReg (nullptr),
+    fTriggerInCntReg (nullptr),
+    fFsmStateReg (nullptr),
+    fPacketNbrReg (nullptr),
+    fDataHandshakeReg (nullptr),
+    fBulkReadout (true),
+    fReadoutFifoReg (nullptr),
+    fDDR3Reg (nullptr),
+    fI2CNRepliesReg (nullptr),
+    fI2CReplyFifoReg (nullptr),
+    fI2CCommandFifoReg (nullptr)
 {fResetAttempts = 0 ; }
 
 
@@ -42,7 +56,19 @@ D19cFWInterface::D19cFWInterface ( const char* puHalConfigFileName,
     fNCbc (0),
     fNMPA (0),
     fFileHandler ( pFileHandler ),
-    fFMCId (1)
+    fFMCId (1),
+    fWordsCntReg (nullptr),
+    fReadoutReqReg (nullptr),
+    fTriggerInCntReg (nullptr),
+    fFsmStateReg (nullptr),
+    fPacketNbrReg (nullptr),
+    fDataHandshakeReg (nullptr),
+    fBulkReadout (true),
+    fReadoutFifoReg (nullptr),
+    fDDR3Reg (nullptr),
+    fI2CNRepliesReg (nullptr),
+    fI2CReplyFifoReg (nullptr),
+    fI2CCommandFifoReg (nullptr)
 {
     if ( fFileHandler == nullptr ) fSaveToFile = false;
     else fSaveToFile = true;
@@ -57,7 +83,19 @@ D19cFWInterface::D19cFWInterface ( const char* pId,
     fBroadcastCbcId (0),
     fNCbc (0),
     fNMPA (0),
-    fFMCId (1)
+    fFMCId (1),
+    fWordsCntReg (nullptr),
+    fReadoutReqReg (nullptr),
+    fTriggerInCntReg (nullptr),
+    fFsmStateReg (nullptr),
+    fPacketNbrReg (nullptr),
+    fDataHandshakeReg (nullptr),
+    fBulkReadout (true),
+    fReadoutFifoReg (nullptr),
+    fDDR3Reg (nullptr),
+    fI2CNRepliesReg (nullptr),
+    fI2CReplyFifoReg (nullptr),
+    fI2CCommandFifoReg (nullptr)
 {fResetAttempts = 0 ; }
 
 
@@ -71,7 +109,19 @@ D19cFWInterface::D19cFWInterface ( const char* pId,
     fNCbc (0),
     fNMPA (0),
     fFileHandler ( pFileHandler ),
-    fFMCId (1)
+    fFMCId (1),
+    fWordsCntReg (nullptr),
+    fReadoutReqReg (nullptr),
+    fTriggerInCntReg (nullptr),
+    fFsmStateReg (nullptr),
+    fPacketNbrReg (nullptr),
+    fDataHandshakeReg (nullptr),
+    fBulkReadout (true),
+    fReadoutFifoReg (nullptr),
+    fDDR3Reg (nullptr),
+    fI2CNRepliesReg (nullptr),
+    fI2CReplyFifoReg (nullptr),
+    fI2CCommandFifoReg (nullptr)
 {
     if ( fFileHandler == nullptr ) fSaveToFile = false;
     else fSaveToFile = true;
@@ -306,14 +356,23 @@ void D19cFWInterface::ConfigureBoard ( const BeBoard* pBoard )
     usleep (500);
 
     // read info about current firmware
-    uint32_t cChipTypeCode = ReadReg ("fc7_daq_stat.general.info.chip_type");
+    RegTransaction cTransaction (this);
+    uhal::ValWord<uint32_t> cChipType = cTransaction.ReadReg ("fc7_daq_stat.general.info.chip_type");
+    uhal::ValWord<uint32_t> cNumHybrids = cTransaction.ReadReg ("fc7_daq_stat.general.info.num_hybrids");
+    uhal::ValWord<uint32_t> cNumChips = cTransaction.ReadReg ("fc7_daq_stat.general.info.num_chips");
+    uhal::ValWord<uint32_t> cImplementation = cTransaction.ReadReg ("fc7_daq_stat.general.info.implementation");
+    uhal::ValWord<uint32_t> cDDR3Type = cTransaction.ReadReg ("fc7_daq_stat.ddr3_block.is_ddr3_type");
+    uhal::ValWord<uint32_t> cI2CVersion = cTransaction.ReadReg ("fc7_daq_stat.command_processor_block.i2c.master_version");
+    cTransaction.Dispatch();
+
+    uint32_t cChipTypeCode = cChipType.value();
     std::string cChipName = getChipName (cChipTypeCode);
     fFirwmareChipType = getChipType (cChipTypeCode);
-    fFWNHybrids = ReadReg ("fc7_daq_stat.general.info.num_hybrids");
-    fFWNChips = ReadReg ("fc7_daq_stat.general.info.num_chips");
-    fChipEmulator = (ReadReg ("fc7_daq_stat.general.info.implementation") == 2);
-    fIsDDR3Readout = (ReadReg("fc7_daq_stat.ddr3_block.is_ddr3_type") == 1);
-    fI2CVersion = (ReadReg("fc7_daq_stat.command_processor_block.i2c.master_version"));
+    fFWNHybrids = cNumHybrids.value();
+    fFWNChips = cNumChips.value();
+    fChipEmulator = (cImplementation.value() == 2);
+    fIsDDR3Readout = (cDDR3Type.value() == 1);
+    fI2CVersion = cI2CVersion.value();
     if(fI2CVersion >= 1) this->SetI2CAddressTable();
 
     fNCbc = 0;
@@ -388,12 +447,12 @@ void D19cFWInterface::ConfigureBoard ( const BeBoard* pBoard )
         if (it.first == "fc7_daq_cnfg.dio5_block.dio5_en") dio5_enabled = (bool) it.second;
     }
 
-    WriteStackReg ( cVecReg );
+    // the configuration and the trigger configuration load go out together
+    cTransaction.WriteStackReg ( cVecReg );
+    cTransaction.WriteReg ("fc7_daq_ctrl.fast_command_block.control.load_config", 0x1);
+    cTransaction.Dispatch();
     cVecReg.clear();
 
-    // load trigger configuration
-    WriteReg ("fc7_daq_ctrl.fast_command_block.control.load_config", 0x1);
-
     // load dio5 configuration
     if (dio5_enabled)
     {
@@ -858,26 +917,39 @@ void D19cFWInterface::PhaseTuning (const BeBoard* pBoard)
 
 uint32_t D19cFWInterface::ReadData ( BeBoard* pBoard, bool pBreakTrigger, std::vector<uint32_t>& pData, bool pWait)
 {
+    if ( fWordsCntReg == nullptr ) ResolveRegHandles();
+
     uint32_t cEventSize = computeEventSize (pBoard);
     uint32_t cBoardHeader1Size = D19C_EVENT_HEADER1_SIZE_32;
-    uint32_t cNWords = ReadReg ("fc7_daq_stat.readout_block.general.words_cnt");
-    uint32_t data_handshake = ReadReg ("fc7_daq_cnfg.readout_block.global.data_handshake_enable");
-    uint32_t cPackageSize = ReadReg ("fc7_daq_cnfg.readout_block.packet_nbr") + 1;
+    RegTransaction cTransaction (this);
+    uhal::ValWord<uint32_t> cWordsCnt = cTransaction.ReadReg (fWordsCntReg);
+    uhal::ValWord<uint32_t> cHandshake = cTransaction.ReadReg (fDataHandshakeReg);
+    uhal::ValWord<uint32_t> cPacketNbr = cTransaction.ReadReg (fPacketNbrReg);
+    cTransaction.Dispatch();
+    uint32_t cNWords = cWordsCnt.value();
+    uint32_t data_handshake = cHandshake.value();
+    uint32_t cPackageSize = cPacketNbr.value() + 1;
 
     bool pFailed = false;
     int cCounter = 0 ;
-    while (cNWords == 0 && !pFailed )
+
     {
-        cNWords = ReadReg ("fc7_daq_stat.readout_block.general.words_cnt");
-        if(cCounter % 100 == 0 && cCounter > 0) {
-            LOG(INFO) << BOLDRED << "Zero events in FIFO, waiting for the triggers" << RESET;
-        }
-        cCounter++;
+        // only the polling is booked as wait time, the scope ends with the loop
+        ReadoutWait cWait (fWaitPolicy, &fReadoutTiming);
 
-        if (!pWait)
-            return 0;
-        else
-            std::this_thread::sleep_for (std::chrono::milliseconds (10) );
+        while (cNWords == 0 && !pFailed )
+        {
+            cNWords = ReadReg (fWordsCntReg);
+            if(cCounter % 100 == 0 && cCounter > 0) {
+                LOG(INFO) << BOLDRED << "Zero events in FIFO, waiting for the triggers" << RESET;
+            }
+            cCounter++;
+
+            if (!pWait)
+                return 0;
+            else
+                cWait.wait();
+        }
     }
 
     uint32_t cNEvents = 0;
@@ -886,44 +958,58 @@ uint32_t D19cFWInterface::ReadData ( BeBoard* pBoard, bool pBreakTrigger, std::v
 
     if (data_handshake == 1 && !pFailed )
     {
-        cNWords = ReadReg ("fc7_daq_stat.readout_block.general.words_cnt");
-        cNtriggers = ReadReg ("fc7_daq_stat.fast_command_block.trigger_in_counter");
+        // the three status registers are always read together, in a single dispatch
+        auto cReadStatus = [&] (uint32_t& pReadoutReq)
+        {
+            uhal::ValWord<uint32_t> cReq = cTransaction.ReadReg (fReadoutReqReg);
+            uhal::ValWord<uint32_t> cWords = cTransaction.ReadReg (fWordsCntReg);
+            uhal::ValWord<uint32_t> cTriggers = cTransaction.ReadReg (fTriggerInCntReg);
+            cTransaction.Dispatch();
+            pReadoutReq = cReq.value();
+            cNWords = cWords.value();
+            cNtriggers = cTriggers.value();
+        };
+
+        uint32_t cReadoutReq = 0;
+        cReadStatus (cReadoutReq);
         cNtriggers_prev = cNtriggers;
         uint32_t cNWords_prev = cNWords;
-        uint32_t cReadoutReq = ReadReg ("fc7_daq_stat.readout_block.general.readout_req");
 
         cCounter = 0 ;
-        while (cReadoutReq == 0 && !pFailed )
         {
-            if (!pWait) {
-                return 0;
-            }
+            ReadoutWait cWait (fWaitPolicy, &fReadoutTiming);
 
-            cNWords_prev = cNWords;
-            cNtriggers_prev = cNtriggers;
+            while (cReadoutReq == 0 && !pFailed )
+            {
+                if (!pWait) {
+                    return 0;
+                }
+
+                cNWords_prev = cNWords;
+                cNtriggers_prev = cNtriggers;
+
+                cReadStatus (cReadoutReq);
 
-            cReadoutReq = ReadReg ("fc7_daq_stat.readout_block.general.readout_req");
-            cNWords = ReadReg ("fc7_daq_stat.readout_block.general.words_cnt");
-            cNtriggers = ReadReg ("fc7_daq_stat.fast_command_block.trigger_in_counter");
+                /*if( cNWords == cNWords_prev && cCounter > 100 && cNtriggers != cNtriggers_prev )
+                    {
+                        pFailed = true;
+                        LOG (INFO) << BOLDRED << "Warning!! Read-out has stopped responding after receiving " << +cNtriggers << " triggers!! Read back " << +cNWords << " from FC7." << RESET ;
 
-            /*if( cNWords == cNWords_prev && cCounter > 100 && cNtriggers != cNtriggers_prev )
+                    }
+                    else*/
+                if( cNtriggers == cNtriggers_prev && cCounter > 0 )
                 {
-                    pFailed = true;
-                    LOG (INFO) << BOLDRED << "Warning!! Read-out has stopped responding after receiving " << +cNtriggers << " triggers!! Read back " << +cNWords << " from FC7." << RESET ;
+                    if( cCounter % 100 == 0 )
+                        LOG (INFO) << BOLDRED << " ..... waiting for more triggers .... got " << +cNtriggers << " so far." << RESET ;
 
                 }
-                else*/
-            if( cNtriggers == cNtriggers_prev && cCounter > 0 )
-            {
-                if( cCounter % 100 == 0 )
-                    LOG (INFO) << BOLDRED << " ..... waiting for more triggers .... got " << +cNtriggers << " so far." << RESET ;
-
+                else cWait.reset();
+                cCounter++;
+                cWait.wait();
             }
-            cCounter++;
-            std::this_thread::sleep_for (std::chrono::milliseconds (10) );
         }
 
-        cNWords = ReadReg ("fc7_daq_stat.readout_block.general.words_cnt");
+        cNWords = ReadReg (fWordsCntReg);
         if (pBoard->getEventType() == EventType::VR)
         {
             cNEvents = cNWords / computeEventSize (pBoard);
@@ -939,13 +1025,9 @@ uint32_t D19cFWInterface::ReadData ( BeBoard* pBoard, bool pBreakTrigger, std::v
         }
 
         // read all the words
-        if (fIsDDR3Readout) {
-            pData = ReadBlockRegOffsetValue ("fc7_daq_ddr3", cNWords, fDDR3Offset);
-            //in the handshake mode offset is cleared after each handshake
-            fDDR3Offset = 0;
-        }
-        else
-            pData = ReadBlockRegValue ("fc7_daq_ctrl.readout_block.readout_fifo", cNWords);
+        pData = ReadEventWords (cNWords);
+        //in the handshake mode offset is cleared after each handshake
+        if (fIsDDR3Readout) fDDR3Offset = 0;
 
     }
     else if(!pFailed)
@@ -958,25 +1040,25 @@ uint32_t D19cFWInterface::ReadData ( BeBoard* pBoard, bool pBreakTrigger, std::v
         cNEvents = 0;
         //while (cNEvents < cPackageSize)
         //{
-        cNWords = ReadReg ("fc7_daq_stat.readout_block.general.words_cnt");
+        cNWords = ReadReg (fWordsCntReg);
         uint32_t cNEventsAvailable = (uint32_t) cNWords / cEventSize;
 
-        while (cNEventsAvailable < 1)
         {
-            if(!pWait) {
-                return 0;
-            }
-            std::this_thread::sleep_for (std::chrono::milliseconds (10) );
-            cNWords = ReadReg ("fc7_daq_stat.readout_block.general.words_cnt");
-            cNEventsAvailable = (uint32_t) cNWords / cEventSize;
+            ReadoutWait cWait (fWaitPolicy, &fReadoutTiming);
+
+            while (cNEventsAvailable < 1)
+            {
+                if(!pWait) {
+                    return 0;
+                }
+                cWait.wait();
+                cNWords = ReadReg (fWordsCntReg);
+                cNEventsAvailable = (uint32_t) cNWords / cEventSize;
 
+            }
         }
 
-        std::vector<uint32_t> event_data;
-        if (fIsDDR3Readout)
-            event_data = ReadBlockRegOffsetValue ("fc7_daq_ddr3", cNEventsAvailable*cEventSize, fDDR3Offset);
-        else
-            event_data = ReadBlockRegValue ("fc7_daq_ctrl.readout_block.readout_fifo", cNEventsAvailable*cEventSize);
+        std::vector<uint32_t> event_data = ReadEventWords (cNEventsAvailable * cEventSize);
 
         pData.insert (pData.end(), event_data.begin(), event_data.end() );
         cNEvents += cNEventsAvailable;
@@ -986,6 +1068,7 @@ uint32_t D19cFWInterface::ReadData ( BeBoard* pBoard, bool pBreakTrigger, std::v
 
     if( pFailed )
     {
+        fReadoutTiming.fNWordsDropped += pData.size();
         pData.clear();
 
         LOG(INFO) << BOLDRED << "Re-starting the run and resetting the readout" << RESET;
@@ -1011,72 +1094,108 @@ uint32_t D19cFWInterface::ReadData ( BeBoard* pBoard, bool pBreakTrigger, std::v
 
 void D19cFWInterface::ReadNEvents (BeBoard* pBoard, uint32_t pNEvents, std::vector<uint32_t>& pData, bool pWait )
 {
+    if ( fWordsCntReg == nullptr ) ResolveRegHandles();
+
+    RegTransaction cTransaction (this);
     // data hadnshake has to be disabled in that mode
-    WriteReg ("fc7_daq_cnfg.readout_block.packet_nbr", 0x0);
-    WriteReg ("fc7_daq_cnfg.readout_block.global.data_handshake_enable", 0x0);
+    cTransaction.WriteReg (fPacketNbrReg, 0x0);
+    cTransaction.WriteReg (fDataHandshakeReg, 0x0);
 
     // write the amount of the test pulses to be sent
-    WriteReg ("fc7_daq_cnfg.fast_command_block.triggers_to_accept", pNEvents);
-    WriteReg ("fc7_daq_ctrl.fast_command_block.control.load_config", 0x1);
+    cTransaction.WriteReg ("fc7_daq_cnfg.fast_command_block.triggers_to_accept", pNEvents);
+    cTransaction.WriteReg ("fc7_daq_ctrl.fast_command_block.control.load_config", 0x1);
+    cTransaction.Dispatch();
     usleep (1);
 
     // start triggering machine which will collect N events
     this->Start();
 
     bool failed = false;
+    uint32_t cNEventsRead = 0;
 
-    for (uint32_t event = 0; event < pNEvents; event++)
+    while (cNEventsRead < pNEvents)
     {
-        uint32_t cNWords = ReadReg ("fc7_daq_stat.readout_block.general.words_cnt");
+        uint32_t cNWords = ReadReg (fWordsCntReg);
 
-        int cNTries = 0;
-        int cNTriesMax = 50;
+        // check the trigger FSM when no data arrived for that long
+        const double cMaxWaitTime = 0.5;
 
-        while (cNWords < 1)
         {
-            if (cNTries >= cNTriesMax)
-            {
-                uint32_t state_id = ReadReg ("fc7_daq_stat.fast_command_block.general.fsm_state");
+            // only the polling is booked as wait time, not the transfers below
+            ReadoutWait cWait (fWaitPolicy, &fReadoutTiming);
 
-                if (state_id == 0)
+            while (cNWords < 1)
+            {
+                if (cWait.elapsed() >= cMaxWaitTime)
                 {
-                    LOG (INFO) << "After fsm stopped, still no data: resetting and re-trying";
-                    failed = true;
-                    break;
+                    uint32_t state_id = ReadReg (fFsmStateReg);
+
+                    if (state_id == 0)
+                    {
+                        LOG (INFO) << "After fsm stopped, still no data: resetting and re-trying";
+                        failed = true;
+                        break;
+                    }
+                    else cWait.reset();
                 }
-                else cNTries = 0;
+                cWait.wait();
+                cNWords = ReadReg (fWordsCntReg);
             }
-            std::this_thread::sleep_for (std::chrono::milliseconds (10) );
-            cNWords = ReadReg ("fc7_daq_stat.readout_block.general.words_cnt");
-            cNTries++;
         }
 
         if (failed) break;
 
-        // reading header 1
-        uint32_t header1 = 0;
-        if (fIsDDR3Readout)
-            header1 = ReadBlockRegOffsetValue ("fc7_daq_ddr3", 1, fDDR3Offset).at(0);
-        else
-            header1 = ReadReg ("fc7_daq_ctrl.readout_block.readout_fifo");
-        uint32_t cEventSize = (0x0000FFFF & header1);
+        // in bulk mode everything available is read in one transfer and split using the event size in header 1,
+        // otherwise only header 1 is read and the rest of the event is fetched below
+        std::vector<uint32_t> cWords = ReadEventWords (fBulkReadout ? cNWords : 1);
+        uint32_t cIndex = 0;
 
-        while (cNWords < cEventSize - 1)
+        while (cIndex < cWords.size() && cNEventsRead < pNEvents)
         {
-            std::this_thread::sleep_for (std::chrono::milliseconds (10) );
-            cNWords = ReadReg ("fc7_daq_stat.readout_block.general.words_cnt");
-        }
+            uint32_t cEventSize = (0x0000FFFF & cWords.at (cIndex) );
 
-        pData.push_back (header1);
-        std::vector<uint32_t> rest_of_data;
-        if (fIsDDR3Readout) {
-            rest_of_data = ReadBlockRegOffsetValue ("fc7_daq_ddr3", cEventSize - 1, fDDR3Offset);
-        }
-        else {
-            rest_of_data = ReadBlockRegValue ("fc7_daq_ctrl.readout_block.readout_fifo", cEventSize - 1);
+            if (cEventSize == 0)
+            {
+                LOG (ERROR) << BOLDRED << "Event header with a size of 0 words, resetting and re-trying" << RESET;
+                failed = true;
+                break;
+            }
+
+            uint32_t cAvailable = std::min<uint32_t> (cWords.size() - cIndex, cEventSize);
+            pData.insert (pData.end(), cWords.begin() + cIndex, cWords.begin() + cIndex + cAvailable);
+
+            if (cAvailable < cEventSize)
+            {
+                // the end of this event is not in the block: wait for it and read only the missing words
+                uint32_t cMissing = cEventSize - cAvailable;
+                cNWords = ReadReg (fWordsCntReg);
+
+                {
+                    ReadoutWait cWait (fWaitPolicy, &fReadoutTiming);
+
+                    while (cNWords < cMissing)
+                    {
+                        cWait.wait();
+                        cNWords = ReadReg (fWordsCntReg);
+                    }
+                }
+
+                std::vector<uint32_t> rest_of_data = ReadEventWords (cMissing);
+                pData.insert (pData.end(), rest_of_data.begin(), rest_of_data.end() );
+            }
+
+            cIndex += cAvailable;
+            cNEventsRead++;
         }
-        pData.insert (pData.end(), rest_of_data.begin(), rest_of_data.end() );
 
+        if (failed) break;
+
+        // the bulk read can go past the last event requested, those words are lost
+        if (cIndex < cWords.size() )
+        {
+            LOG (ERROR) << BOLDRED << "Read " << cWords.size() - cIndex << " words past the " << pNEvents << " events requested, they are dropped" << RESET;
+            fReadoutTiming.fNWordsDropped += cWords.size() - cIndex;
+        }
     }
 
     if (failed)
@@ -1145,6 +1264,72 @@ std::vector<uint32_t> D19cFWInterface::ReadBlockRegOffsetValue ( const std::stri
     return vBlock;
 }
 
+std::vector<uint32_t> D19cFWInterface::ReadBlockRegValue ( RegHandle pHandle, const uint32_t& pBlocksize )
+{
+    uhal::ValVector<uint32_t> valBlock = ReadBlockReg ( pHandle, pBlocksize );
+    std::vector<uint32_t> vBlock = valBlock.value();
+    return vBlock;
+}
+
+std::vector<uint32_t> D19cFWInterface::ReadBlockRegOffsetValue ( RegHandle pHandle, const uint32_t& pBlocksize, const uint32_t& pBlockOffset )
+{
+    uhal::ValVector<uint32_t> valBlock = ReadBlockRegOffset ( pHandle, pBlocksize, pBlockOffset );
+    std::vector<uint32_t> vBlock = valBlock.value();
+    if (fIsDDR3Readout) {
+        fDDR3Offset += pBlocksize;
+    }
+    return vBlock;
+}
+
+std::vector<uint32_t> D19cFWInterface::ReadEventWords ( uint32_t pNWords )
+{
+    auto cStart = std::chrono::steady_clock::now();
+    std::vector<uint32_t> cData;
+
+    if (fIsDDR3Readout)
+        cData = ReadBlockRegOffsetValue (fDDR3Reg, pNWords, fDDR3Offset);
+    else
+        cData = ReadBlockRegValue (fReadoutFifoReg, pNWords);
+
+    fReadoutTiming.fTransferTime += std::chrono::duration<double> (std::chrono::steady_clock::now() - cStart).count();
+    fReadoutTiming.fNTransfers++;
+    fReadoutTiming.fNWords += cData.size();
+    return cData;
+}
+
+void D19cFWInterface::ResolveRegHandles()
+{
+    fWordsCntReg = resolve ("fc7_daq_stat.readout_block.general.words_cnt");
+    fReadoutReqReg = resolve ("fc7_daq_stat.readout_block.general.readout_req");
+    fTriggerInCntReg = resolve ("fc7_daq_stat.fast_command_block.trigger_in_counter");
+    fFsmStateReg = resolve ("fc7_daq_stat.fast_command_block.general.fsm_state");
+    fPacketNbrReg = resolve ("fc7_daq_cnfg.readout_block.packet_nbr");
+    fDataHandshakeReg = resolve ("fc7_daq_cnfg.readout_block.global.data_handshake_enable");
+    fReadoutFifoReg = resolve ("fc7_daq_ctrl.readout_block.readout_fifo");
+    fDDR3Reg = resolve ("fc7_daq_ddr3");
+    fI2CNRepliesReg = resolve ("fc7_daq_stat.command_processor_block.i2c.nreplies");
+    fI2CReplyFifoReg = resolve ("fc7_daq_ctrl.command_processor_block.i2c.reply_fifo");
+    fI2CCommandFifoReg = resolve ("fc7_daq_ctrl.command_processor_block.i2c.command_fifo");
+}
+
+void D19cFWInterface::ResetRegManager ( const char* pId, const char* pUri, const char* pAddressTable )
+{
+    RegManager::ResetRegManager ( pId, pUri, pAddressTable );
+
+    // the readout and I2C loops resolve them again when fWordsCntReg is null
+    fWordsCntReg = nullptr;
+    fReadoutReqReg = nullptr;
+    fTriggerInCntReg = nullptr;
+    fFsmStateReg = nullptr;
+    fPacketNbrReg = nullptr;
+    fDataHandshakeReg = nullptr;
+    fReadoutFifoReg = nullptr;
+    fDDR3Reg = nullptr;
+    fI2CNRepliesReg = nullptr;
+    fI2CReplyFifoReg = nullptr;
+    fI2CCommandFifoReg = nullptr;
+}
+
 bool D19cFWInterface::WriteBlockReg ( const std::string& pRegNode, const std::vector< uint32_t >& pValues )
 {
     bool cWriteCorr = RegManager::WriteBlockReg ( pRegNode, pValues );
@@ -1228,34 +1413,59 @@ void D19cFWInterface::DecodeReg ( RegItem& pRegItem,
 
 bool D19cFWInterface::ReadI2C (  uint32_t pNReplies, std::vector<uint32_t>& pReplies)
 {
+    if ( fWordsCntReg == nullptr ) ResolveRegHandles();
+
     bool cFailed (false);
 
-    uint32_t single_WaitingTime = SINGLE_I2C_WAIT * pNReplies * 15;
-    uint32_t max_Attempts = 100;
-    uint32_t counter_Attempts = 0;
+    // the replies arrive at the pace of the I2C bus: sleep for about the time the missing ones take, and only give up when the
+    // reply counter stopped moving for I2C_REPLY_TIMEOUT
+    uint32_t cNReplies = 0;
+    uint32_t cWaitingTime = SINGLE_I2C_WAIT * pNReplies;
+    uint32_t cStalledTime = 0;
 
-    //read the number of received replies from ndata and use this number to compare with the number of expected replies and to read this number 32-bit words from the reply FIFO
-    usleep (single_WaitingTime);
-    uint32_t cNReplies = ReadReg ("fc7_daq_stat.command_processor_block.i2c.nreplies");
-    LOG (INFO) << RED << cNReplies << " N replies" << RESET;
-    while (cNReplies != pNReplies)
+    while (cNReplies < pNReplies)
     {
-        if (counter_Attempts > max_Attempts)
+        usleep (cWaitingTime);
+        uint32_t cNewReplies = ReadReg (fI2CNRepliesReg);
+
+        if (cNewReplies > cNReplies)
         {
-            LOG (INFO) << BOLDRED << "Error: Read " << cNReplies << " I2C replies whereas " << pNReplies << " are expected!" << RESET;
-            ReadErrors();
-            cFailed = true;
-            break;
+            cStalledTime = 0;
+            cWaitingTime = (cNewReplies < pNReplies) ? SINGLE_I2C_WAIT * (pNReplies - cNewReplies) : 0;
+        }
+        else
+        {
+            cStalledTime += cWaitingTime;
+
+            if (cStalledTime >= I2C_REPLY_TIMEOUT)
+            {
+                LOG (INFO) << BOLDRED << "Error: Read " << cNReplies << " I2C replies whereas " << pNReplies << " are expected!" << RESET;
+                ReadErrors();
+                cFailed = true;
+                break;
+            }
+
+            cWaitingTime = std::min (2 * cWaitingTime, I2C_REPLY_TIMEOUT / 10);
         }
 
-        usleep (single_WaitingTime);
-        cNReplies = ReadReg ("fc7_daq_stat.command_processor_block.i2c.nreplies");
-        counter_Attempts++;
+        cNReplies = cNewReplies;
+    }
+
+    if (cNReplies > pNReplies)
+    {
+        LOG (INFO) << BOLDRED << "Error: Read " << cNReplies << " I2C replies whereas " << pNReplies << " are expected!" << RESET;
+        cFailed = true;
+    }
+
+    if (cNReplies == 0)
+    {
+        pReplies.clear();
+        return cFailed;
     }
 
     try
     {
-        pReplies = ReadBlockRegValue ( "fc7_daq_ctrl.command_processor_block.i2c.reply_fifo", cNReplies );
+        pReplies = ReadBlockRegValue ( fI2CReplyFifoReg, cNReplies );
     }
     catch ( Exception& except )
     {
@@ -1268,6 +1478,8 @@ bool D19cFWInterface::ReadI2C (  uint32_t pNReplies, std::vector<uint32_t>& pRep
 
 bool D19cFWInterface::WriteI2C ( std::vector<uint32_t>& pVecSend, std::vector<uint32_t>& pReplies, bool pReadback, bool pBroadcast )
 {
+    if ( fWordsCntReg == nullptr ) ResolveRegHandles();
+
     bool cFailed ( false );
     //reset the I2C controller
     WriteReg ("fc7_daq_ctrl.command_processor_block.i2c.control.reset_fifos", 0x1);
@@ -1275,7 +1487,7 @@ bool D19cFWInterface::WriteI2C ( std::vector<uint32_t>& pVecSend, std::vector<ui
 
     try
     {
-        WriteBlockReg ( "fc7_daq_ctrl.command_processor_block.i2c.command_fifo", pVecSend );
+        WriteBlockReg ( fI2CCommandFifoReg, pVecSend );
     }
     catch ( Exception& except )
     {
@@ -1289,8 +1501,6 @@ bool D19cFWInterface::WriteI2C ( std::vector<uint32_t>& pVecSend, std::vector<ui
         if (fI2CVersion >= 1) {
             if ( (((word & 0x08000000) >> 27) == 0) && (( ( (word & 0x00010000) >> 16) == 1) or ( ( (word & 0x00020000) >> 17) == 1)) )
             {
-	    	std::bitset<32> y(word);
-	    	LOG (INFO) << RED << y << "  < word!"<< RESET;
                 if (pBroadcast) cNReplies += (fNCbc+fNMPA+fNSSA);
                 else cNReplies += 1;
             }
@@ -1302,9 +1512,8 @@ bool D19cFWInterface::WriteI2C ( std::vector<uint32_t>& pVecSend, std::vector<ui
             }
         }
     }
-    LOG (INFO) << YELLOW << cNReplies << RESET;
+
     cFailed = ReadI2C (  cNReplies, pReplies) ;
-    LOG (INFO) << YELLOW << " - = - = - = - " << RESET;
 
     return cFailed;
 }
@@ -1316,9 +1525,7 @@ bool D19cFWInterface::WriteCbcBlockReg ( std::vector<uint32_t>& pVecReg, uint8_t
     uint8_t cMaxWriteAttempts = 5;
     // the actual write & readback command is in the vector
     std::vector<uint32_t> cReplies;
-    LOG (INFO) << BLUE << "Is this the issue?" << RESET;
     bool cSuccess = !WriteI2C ( pVecReg, cReplies, pReadback, false );
-    LOG (INFO) << BLUE << "Is this the issue?" << RESET;
 
     //for (int i = 0; i < pVecReg.size(); i++)
     //{
@@ -1992,36 +2199,15 @@ std::vector<uint16_t> D19cFWInterface::ReadoutCounters_MPA(uint32_t raw_mode_en)
 
     if (raw_mode_en == 1)
     {
-        uint32_t cycle = 0;
-        for (int i=0; i<20000;i++)
-        {
-            uint32_t fifo1_word = ReadReg("fc7_daq_ctrl.physical_interface_block.ctrl_slvs_debug_fifo1_data");
-            uint32_t fifo2_word = ReadReg("fc7_daq_ctrl.physical_interface_block.ctrl_slvs_debug_fifo2_data");
-
-            uint32_t line1 = (fifo1_word&0x0000FF)>>0; //to_number(fifo1_word,8,0)
-            uint32_t line2 = (fifo1_word&0x00FF00)>>8; // to_number(fifo1_word,16,8)
-            uint32_t line3 = (fifo1_word&0xFF0000)>>16; //  to_number(fifo1_word,24,16)
-
-            uint32_t line4 = (fifo2_word&0x0000FF)>>0; //to_number(fifo2_word,8,0)
-            uint32_t line5 = (fifo2_word&0x00FF00)>>8; // to_number(fifo2_word,16,8)
-
-            if (((line1 & 0b10000000) == 128) && ((line4 & 0b10000000) == 128))
-            {
-                uint32_t temp = ((line2 & 0b00100000) << 9) | ((line3 & 0b00100000) << 8) | ((line4 & 0b00100000) << 7) | ((line5 & 0b00100000) << 6) | ((line1 & 0b00010000) << 6) | ((line2 & 0b00010000) << 5) | ((line3 & 0b00010000) << 4) | ((line4 & 0b00010000) << 3) | ((line5 & 0b10000000) >> 1) | ((line1 & 0b01000000) >> 1) | ((line2 & 0b01000000) >> 2) | ((line3 & 0b01000000) >> 3) | ((line4 & 0b01000000) >> 4) | ((line5 & 0b01000000) >> 5) | ((line1 & 0b00100000) >> 5);
-                if (temp != 0) {
-                    count[cycle] = temp - 1;
-                    cycle += 1;
-                }
-            }
-        }
+        // the raw SLVS lines of the 2040 counters, both FIFOs popped in one dispatch each and decoded at once
+        std::vector<uint32_t> fifo1_words = ReadFifoReg ( resolve ( "fc7_daq_ctrl.physical_interface_block.ctrl_slvs_debug_fifo1_data" ), MPA_RAW_COUNTER_WORDS );
+        std::vector<uint32_t> fifo2_words = ReadFifoReg ( resolve ( "fc7_daq_ctrl.physical_interface_block.ctrl_slvs_debug_fifo2_data" ), MPA_RAW_COUNTER_WORDS );
+        decodeMPACounters ( fifo1_words.data(), fifo2_words.data(), std::min ( fifo1_words.size(), fifo2_words.size() ), count.data(), count.size() );
     } else 	{
-        ReadReg("fc7_daq_ctrl.physical_interface_block.ctrl_slvs_debug_fifo2_data");
-        for (int i=0; i<2040;i++)
-        {
-            //std::chrono::milliseconds cWait( 100 );
-            count[i] = ReadReg("fc7_daq_ctrl.physical_interface_block.ctrl_slvs_debug_fifo2_data") - 1;
-            //std::cout<<i<<"     "<<count[i]<<std::endl;
-        }
+        // the first word of the FIFO is not a counter
+        std::vector<uint32_t> fifo2_words = ReadFifoReg ( resolve ( "fc7_daq_ctrl.physical_interface_block.ctrl_slvs_debug_fifo2_data" ), count.size() + 1 );
+        for (size_t i=0; i<count.size() && i+1<fifo2_words.size();i++)
+            count[i] = fifo2_words[i+1] - 1;
     }
 
     std::this_thread::sleep_for( cWait );
@@ -2077,7 +2263,7 @@ uint32_t D19cFWInterface::Pix_read_MPA(MPA* cMPA,RegItem cRegItem,uint32_t row,u
 
     std::vector<uint32_t> cVecReq;
     cVecReq.clear();
-    this->EncodeReg (cRegItem, cMPA->getFeId(), cMPA->getMPAId(), cVecReq, false, false);
+    this->EncodeReg (rowreg, cMPA->getFeId(), cMPA->getMPAId(), cVecReq, false, false);
     this->WriteCbcBlockReg (cVecReq,cWriteAttempts, false);
     std::chrono::milliseconds cShort( 1 );
     //uint32_t readempty = ReadReg ("fc7_daq_stat.command_processor_block.i2c.reply_fifo.empty");
@@ -2094,6 +2280,26 @@ uint32_t D19cFWInterface::Pix_read_MPA(MPA* cMPA,RegItem cRegItem,uint32_t row,u
     return rep;
 }
 
+void D19cFWInterface::Pix_write_MPA(MPA* cMPA,RegItem cRegItem,const std::vector<std::pair<uint32_t,uint32_t>>& pPixels,uint32_t data)
+{
+    RegItem rowreg =cRegItem;
+    rowreg.fValue  = data;
+
+    for (size_t first = 0; first < pPixels.size(); first += MPA_PIXEL_BLOCK_SIZE)
+    {
+        size_t last = std::min (first + MPA_PIXEL_BLOCK_SIZE, pPixels.size() );
+        std::vector<uint32_t> cVecReq;
+
+        for (size_t i = first; i < last; i++)
+        {
+            rowreg.fAddress  = ((pPixels[i].first & 0x0001f) << 11 ) | ((cRegItem.fAddress & 0x000f) << 7 ) | (pPixels[i].second & 0xfffffff);
+            this->EncodeReg (rowreg, cMPA->getFeId(), cMPA->getMPAId(), cVecReq, false, true);
+        }
+
+        uint8_t cWriteAttempts = 0;
+        this->WriteCbcBlockReg (cVecReq, cWriteAttempts, false);
+    }
+}
 
 void D19cFWInterface::Compose_fast_command(uint32_t duration ,uint32_t resync_en ,uint32_t l1a_en ,uint32_t cal_pulse_en ,uint32_t bc0_en )
 {
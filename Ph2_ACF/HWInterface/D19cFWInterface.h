@@ -61,10 +61,39 @@ namespace Ph2_HwInterface {
 	// i2c version of master
 	uint32_t fI2CVersion;
 
-        const uint32_t SINGLE_I2C_WAIT = 200; //used for 1MHz I2C
+        const uint32_t SINGLE_I2C_WAIT = 40; //usec per reply for 1MHz I2C, write with readback
+        const uint32_t I2C_REPLY_TIMEOUT = 100000; //usec without a new reply before giving up
+        const uint32_t MPA_RAW_COUNTER_WORDS = 20000; //words of each SLVS debug FIFO in a raw mode MPA counter readout
+        const uint32_t MPA_PIXEL_BLOCK_SIZE = 310; //pixel registers per I2C command FIFO fill, as the Cbc configuration blocks
 
         // some useful stuff
         int fResetAttempts;
+
+        // pre-resolved handles of the registers polled in the readout and I2C loops
+        RegHandle fWordsCntReg;
+        RegHandle fReadoutReqReg;
+        RegHandle fTriggerInCntReg;
+        RegHandle fFsmStateReg;
+        RegHandle fPacketNbrReg;
+        RegHandle fDataHandshakeReg;
+        // read all the available words at once in ReadNEvents
+        bool fBulkReadout;
+        RegHandle fReadoutFifoReg;
+        RegHandle fDDR3Reg;
+        RegHandle fI2CNRepliesReg;
+        RegHandle fI2CReplyFifoReg;
+        RegHandle fI2CCommandFifoReg;
+
+        /*!
+         * \brief Resolve the handles of the hot readout and I2C registers once
+         */
+        void ResolveRegHandles();
+
+        /*!
+         * \brief Read event data words from the DDR3 or the readout FIFO, and book the transfer time
+         * \param pNWords Number of 32-bit words to read
+         */
+        std::vector<uint32_t> ReadEventWords ( uint32_t pNWords );
       public:
         /*!
          *
@@ -86,6 +115,10 @@ namespace Ph2_HwInterface {
         D19cFWInterface ( const char* pId, const char* pUri, const char* pAddressTable );
         D19cFWInterface ( const char* pId, const char* pUri, const char* pAddressTable, FileHandler* pFileHandler );
         void setFileHandler (FileHandler* pHandler);
+        /*!
+         * \brief Reset the HW Interface, the pre-resolved register handles point into the old one and are resolved again on their next use
+         */
+        void ResetRegManager ( const char* pId, const char* pUri, const char* pAddressTable ) override;
 
         /*!
          *
@@ -116,7 +149,31 @@ namespace Ph2_HwInterface {
          */
         std::vector<uint32_t> ReadBlockRegOffsetValue ( const std::string& pRegNode, const uint32_t& pBlocksize, const uint32_t& pBlockOffset );
 
+        /*! \brief Read a block of a given size from a pre-resolved register handle
+         * \param pHandle Register handle
+         * \param pBlocksize Number of 32-bit words to read
+         * \return Vector of validated 32-bit values
+         */
+        std::vector<uint32_t> ReadBlockRegValue ( RegHandle pHandle, const uint32_t& pBlocksize );
+
+        /*! \brief Read a block of a given size from a pre-resolved register handle
+         * \param pHandle Register handle
+         * \param pBlocksize Number of 32-bit words to read
+         * \param pBlockOffset Offset of the block
+         * \return Vector of validated 32-bit values
+         */
+        std::vector<uint32_t> ReadBlockRegOffsetValue ( RegHandle pHandle, const uint32_t& pBlocksize, const uint32_t& pBlockOffset );
+
         bool WriteBlockReg ( const std::string& pRegNode, const std::vector< uint32_t >& pValues ) override;
+        using RegManager::WriteBlockReg;
+        /*!
+         * \brief Choose how ReadNEvents reads the events
+         * \param pBulk if true, all available words are read in one block and split into events in software; if false, each event is read with two transfers
+         */
+        void setBulkReadout ( bool pBulk )
+        {
+            fBulkReadout = pBulk;
+        }
         /*!
          * \brief Get the FW info
          */
@@ -293,6 +350,8 @@ namespace Ph2_HwInterface {
 
 	void Pix_write_MPA(MPA* cMPA,RegItem cRegItem,uint32_t row,uint32_t pixel,uint32_t data);
 	uint32_t Pix_read_MPA(MPA* cMPA,RegItem cRegItem,uint32_t row,uint32_t pixel);
+	/// the same register of many pixels, given as (row, pixel) pairs, in one I2C command FIFO fill per MPA_PIXEL_BLOCK_SIZE pixels
+	void Pix_write_MPA(MPA* cMPA,RegItem cRegItem,const std::vector<std::pair<uint32_t,uint32_t>>& pPixels,uint32_t data);
 	std::vector<uint16_t> ReadoutCounters_MPA(uint32_t raw_mode_en = 0);
 
 	void Compose_fast_command(uint32_t duration = 0,uint32_t resync_en = 0,uint32_t l1a_en = 0,uint32_t cal_pulse_en = 0,uint32_t bc0_en = 0);
@@ -24,7 +24,8 @@ MPAInterface::MPAInterface( const BeBoardFWMap& pBoardMap ) :
     fBoardFW( nullptr ),
     prevBoardIdentifier( 65535 ),
     fRegisterCount( 0 ),
-    fTransactionCount( 0 )
+    fTransactionCount( 0 ),
+    fI2CWordsSaved( 0 )
 {
 #ifdef COUNT_FLAG
     std::cout << "Counting number of Transactions!" << std::endl;
@@ -91,26 +92,37 @@ void MPAInterface::MainPowerOff()
     fMPAFW->PSInterfaceBoard_PowerOff( );
 }
 
-bool MPAInterface::ConfigureMPA (const MPA* pMPA, bool pVerifLoop)
+bool MPAInterface::ConfigureMPA (MPA* pMPA, bool pVerifLoop, RegWriteMode pMode)
 {
     //first, identify the correct BeBoardFWInterface
     setBoard ( pMPA->getBeBoardIdentifier() );
 
     //vector to encode all the registers into
     std::vector<uint32_t> cVec;
+    //helper vector with the stored items of what is written
+    std::vector<RegItem*> cWritten;
 
     //Deal with the RegItems and encode them
 
-    MPARegMap cMPARegMap = pMPA->getRegMap();
+    MPARegMap& cMPARegMap = pMPA->getRegMap();
 
     for ( auto& cRegItem : cMPARegMap )
     {
+        if ( pMode == RegWriteMode::DELTA_ONLY && cRegItem.second.hwHolds ( cRegItem.second.fValue ) )
+        {
+            fI2CWordsSaved++;
+            continue;
+        }
+
         fBoardFW->EncodeReg (cRegItem.second, pMPA->getFeId(), pMPA->getMPAId(), cVec, pVerifLoop, true);
+        cWritten.push_back ( &cRegItem.second );
 #ifdef COUNT_FLAG
         fRegisterCount++;
 #endif
     }
 
+    if ( cVec.empty() ) return true;
+
     // write the registers, the answer will be in the same cVec
     // the number of times the write operation has been attempted is given by cWriteAttempts
     uint8_t cWriteAttempts = 0 ;
@@ -120,6 +132,13 @@ bool MPAInterface::ConfigureMPA (const MPA* pMPA, bool pVerifLoop)
     fTransactionCount++;
 #endif
 
+    // on failure it is not known which of the registers made it to the chip
+    for ( auto cRegItem : cWritten )
+    {
+        if ( cSuccess ) cRegItem->setHwValue ( cRegItem->fValue );
+        else cRegItem->fHwValid = false;
+    }
+
     return cSuccess;
 }
 
@@ -131,7 +150,8 @@ bool MPAInterface::WriteMPAReg ( MPA* pMPA, const std::string& pRegNode, uint8_t
     setBoard ( pMPA->getBeBoardIdentifier() );
 
     //next, get the reg item
-    RegItem cRegItem = pMPA->getRegItem ( pRegNode );
+    RegItem& cStored = pMPA->getRegItem ( pRegNode );
+    RegItem cRegItem = cStored;
     cRegItem.fValue = pValue;
 
     //vector for transaction
@@ -146,7 +166,12 @@ bool MPAInterface::WriteMPAReg ( MPA* pMPA, const std::string& pRegNode, uint8_t
 
     //update the HWDescription object
     if (cSuccess)
-        pMPA->setReg ( pRegNode, pValue );
+    {
+        cStored.fValue = pValue;
+        cStored.setHwValue ( pValue );
+    }
+    else
+        cStored.fHwValid = false;
 
 #ifdef COUNT_FLAG
     fRegisterCount++;
@@ -159,27 +184,41 @@ bool MPAInterface::WriteMPAReg ( MPA* pMPA, const std::string& pRegNode, uint8_t
 
 
 
-bool MPAInterface::WriteMPAMultReg ( MPA* pMPA, const std::vector< std::pair<std::string, uint8_t> >& pVecReq, bool pVerifLoop )
+bool MPAInterface::WriteMPAMultReg ( MPA* pMPA, const std::vector< std::pair<std::string, uint8_t> >& pVecReq, bool pVerifLoop, RegWriteMode pMode )
 {
     //first, identify the correct BeBoardFWInterface
     setBoard ( pMPA->getBeBoardIdentifier() );
 
     std::vector<uint32_t> cVec;
+    //the stored items of what is written, with the value
+    std::vector<std::pair<RegItem*, uint8_t>> cWritten;
 
     //Deal with the RegItems and encode them
     RegItem cRegItem;
 
     for ( const auto& cReg : pVecReq )
     {
-        cRegItem = pMPA->getRegItem ( cReg.first );
+        RegItem& cStored = pMPA->getRegItem ( cReg.first );
+
+        if ( pMode == RegWriteMode::DELTA_ONLY && cStored.hwHolds ( cReg.second ) )
+        {
+            cStored.fValue = cReg.second;
+            fI2CWordsSaved++;
+            continue;
+        }
+
+        cRegItem = cStored;
         cRegItem.fValue = cReg.second;
 
         fBoardFW->EncodeReg ( cRegItem, pMPA->getFeId(), pMPA->getMPAId(), cVec, pVerifLoop, true );
+        cWritten.push_back ( {&cStored, cReg.second} );
 #ifdef COUNT_FLAG
         fRegisterCount++;
 #endif
     }
 
+    if ( cVec.empty() ) return true;
+
     // write the registers, the answer will be in the same cVec
     // the number of times the write operation has been attempted is given by cWriteAttempts
     uint8_t cWriteAttempts = 0 ;
@@ -190,13 +229,15 @@ bool MPAInterface::WriteMPAMultReg ( MPA* pMPA, const std::vector< std::pair<std
 #endif
 
     // if the transaction is successfull, update the HWDescription object
-    if (cSuccess)
+    for ( auto& cReg : cWritten )
     {
-        for ( const auto& cReg : pVecReq )
+        if ( cSuccess )
         {
-            cRegItem = pMPA->getRegItem ( cReg.first );
-            pMPA->setReg ( cReg.first, cReg.second );
+            cReg.first->fValue = cReg.second;
+            cReg.first->setHwValue ( cReg.second );
         }
+        else
+            cReg.first->fHwValid = false;
     }
 
     return cSuccess;
@@ -219,7 +260,12 @@ uint8_t MPAInterface::ReadMPAReg ( MPA* pMPA, const std::string& pRegNode )
     uint8_t cMPAId;
     fBoardFW->DecodeReg ( cRegItem, cMPAId, cVecReq[0], cRead, cFailed );
 
-    if (!cFailed) pMPA->setReg ( pRegNode, cRegItem.fValue );
+    if (!cFailed)
+    {
+        RegItem& cStored = pMPA->getRegItem ( pRegNode );
+        cStored.fValue = cRegItem.fValue;
+        cStored.setHwValue ( cRegItem.fValue );
+    }
 
     return cRegItem.fValue;
 }
@@ -265,7 +311,11 @@ void MPAInterface::ReadMPAMultReg ( MPA* pMPA, const std::vector<std::string>& p
 
         // here I need to find the string matching to the reg item!
         if (!cFailed)
-            pMPA->setReg ( cReg, cRegItem.fValue );
+        {
+            RegItem& cStored = pMPA->getRegItem ( cReg );
+            cStored.fValue = cRegItem.fValue;
+            cStored.setHwValue ( cRegItem.fValue );
+        }
     }
 }
 
@@ -319,7 +369,11 @@ void MPAInterface::ReadMPA ( MPA* pMPA )
 
         // here I need to find the string matching to the reg item!
         if (!cFailed)
-            pMPA->setReg ( cName, cRegItem.fValue );
+        {
+            RegItem& cStored = pMPA->getRegItem ( cName );
+            cStored.fValue = cRegItem.fValue;
+            cStored.setHwValue ( cRegItem.fValue );
+        }
 
     }
 
@@ -338,6 +392,12 @@ uint32_t MPAInterface::Pix_read(MPA* cMPA,RegItem cRegItem,uint32_t row,uint32_t
     return fMPAFW->Pix_read_MPA(cMPA, cRegItem, row, pixel);
 }
 
+void MPAInterface::Pix_write(MPA* cMPA,RegItem cRegItem,const std::vector<std::pair<uint32_t,uint32_t>>& pPixels,uint32_t data)
+{
+    setBoard(0);
+    fMPAFW->Pix_write_MPA(cMPA, cRegItem, pPixels, data);
+}
+
 
 void MPAInterface::PS_Start_counters_read(uint32_t duration )
 {
@@ -516,6 +576,13 @@ void MPAInterface::Pix_Set_enable(MPA* pMPA,uint32_t r,uint32_t p,uint32_t Pixel
 }
 
 
+void MPAInterface::Pix_Set_enable(MPA* pMPA,const std::vector<std::pair<uint32_t,uint32_t>>& pPixels,uint32_t PixelMask,uint32_t Polarity,uint32_t EnEdgeBR,uint32_t EnLevelBR,uint32_t Encount,uint32_t DigCal,uint32_t AnCal,uint32_t BRclk)
+{
+    uint32_t comboword = (PixelMask) + (Polarity<<1) + (EnEdgeBR<<2) + (EnLevelBR<<3) + (Encount<<4) + (DigCal<<5) + (AnCal<<6)  + (BRclk<<7);
+    Pix_write(pMPA,pMPA->getRegItem("ENFLAGS"), pPixels, comboword );
+}
+
+
 void MPAInterface::Pix_Smode(MPA* pMPA,uint32_t r,uint32_t p, std::string smode = "edge")
 {
     uint32_t smodewrite = 0b00;
@@ -565,6 +632,12 @@ void MPAInterface::Enable_pix_counter(MPA* pMPA,uint32_t r,uint32_t p)
     Pix_Set_enable(pMPA,r,p,PixelMask,Polarity,EnEdgeBR,EnLevelBR,Encount,DigCal,AnCal,BRclk);
 }
 
+void MPAInterface::Enable_pix_counter(MPA* pMPA,const std::vector<std::pair<uint32_t,uint32_t>>& pPixels)
+{
+    uint32_t PixelMask=1,Polarity=1,EnEdgeBR=0,EnLevelBR=0,Encount=1,DigCal=0,AnCal=1,BRclk=0;
+    Pix_Set_enable(pMPA,pPixels,PixelMask,Polarity,EnEdgeBR,EnLevelBR,Encount,DigCal,AnCal,BRclk);
+}
+
 void MPAInterface::Enable_pix_sync(MPA* pMPA,uint32_t r,uint32_t p)
 {
     uint32_t PixelMask=1,Polarity=1,EnEdgeBR=0,EnLevelBR=0,Encount=1,DigCal=0,AnCal=1,BRclk=0;
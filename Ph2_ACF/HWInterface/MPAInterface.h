@@ -60,6 +60,7 @@ private:
 
     uint16_t fRegisterCount;                                /*!< Counter for the number of Registers written */
     uint16_t fTransactionCount;         /*!< Counter for the number of Transactions */
+    uint32_t fI2CWordsSaved;            /*!< Counter for the register writes skipped by RegWriteMode::DELTA_ONLY, one I2C word each */
 
 
 private:
@@ -86,7 +87,14 @@ public:
     void MainPowerOn(uint8_t mpaid = 0, uint8_t ssaid = 0);
     void MainPowerOff();
 
-    bool ConfigureMPA (const MPA* pMPA , bool pVerifLoop = true);
+    bool ConfigureMPA (MPA* pMPA , bool pVerifLoop = true, RegWriteMode pMode = RegWriteMode::FULL);
+    /*!
+     * \brief Number of register writes skipped so far because the MPAs already held the values
+     */
+    uint32_t getI2CWordsSaved() const
+    {
+        return fI2CWordsSaved;
+    }
 
 
 
@@ -97,7 +105,7 @@ public:
 
 
     bool WriteMPAReg ( MPA* pMPA, const std::string& pRegNode, uint8_t pValue, bool pVerifLoop = true );
-    bool WriteMPAMultReg ( MPA* pMPA, const std::vector< std::pair<std::string, uint8_t> >& pVecReq, bool pVerifLoop = true );
+    bool WriteMPAMultReg ( MPA* pMPA, const std::vector< std::pair<std::string, uint8_t> >& pVecReq, bool pVerifLoop = true, RegWriteMode pMode = RegWriteMode::FULL );
     uint8_t ReadMPAReg ( MPA* pMPA, const std::string& pRegNode );
     void ReadMPAMultReg ( MPA* pMPA, const std::vector<std::string>& pVecReg );
 
@@ -106,6 +114,9 @@ public:
 
     void Pix_write(MPA* cMPA,RegItem cRegItem,uint32_t row,uint32_t pixel,uint32_t data);
     uint32_t Pix_read(MPA* cMPA,RegItem cRegItem,uint32_t row,uint32_t pixel);
+    // the same register of many pixels, given as (row, pixel) pairs, in as few I2C transactions as possible
+    // there is no batched read, the firmware keeps only the last MPA/SSA I2C reply
+    void Pix_write(MPA* cMPA,RegItem cRegItem,const std::vector<std::pair<uint32_t,uint32_t>>& pPixels,uint32_t data);
 
 
     void activate_I2C_chip();
@@ -123,6 +134,7 @@ public:
     void Activate_ps(MPA* pMPA);
 
     void Enable_pix_counter(MPA* pMPA,uint32_t r,uint32_t p);
+    void Enable_pix_counter(MPA* pMPA,const std::vector<std::pair<uint32_t,uint32_t>>& pPixels);
     void Enable_pix_sync(MPA* pMPA,uint32_t r,uint32_t p);
     void Disable_pixel(MPA* pMPA,uint32_t r,uint32_t p);
     void Enable_pix_digi(MPA* pMPA,uint32_t r,uint32_t p);
@@ -136,6 +148,7 @@ public:
 
     void Enable_pix_BRcal(MPA* pMPA,uint32_t r,uint32_t p,std::string polarity = "rise",std::string smode = "edge");
     void Pix_Set_enable(MPA* pMPA,uint32_t r,uint32_t p,uint32_t PixelMask,uint32_t Polarity,uint32_t EnEdgeBR,uint32_t EnLevelBR,uint32_t Encount,uint32_t DigCal,uint32_t AnCal,uint32_t BRclk);
+    void Pix_Set_enable(MPA* pMPA,const std::vector<std::pair<uint32_t,uint32_t>>& pPixels,uint32_t PixelMask,uint32_t Polarity,uint32_t EnEdgeBR,uint32_t EnLevelBR,uint32_t Encount,uint32_t DigCal,uint32_t AnCal,uint32_t BRclk);
     Stubs Format_stubs(std::vector<std::vector<uint8_t>> rawstubs);
     L1data Format_l1(std::vector<uint8_t> rawl1,bool verbose=false);
 
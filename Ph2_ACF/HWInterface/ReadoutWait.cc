@@ -0,0 +1,60 @@
+/*
+
+        FileName :                    ReadoutWait.cc
+        Content :                     Wait policy used while polling the board for readout data
+
+ */
+
+#include "ReadoutWait.h"
+#include <thread>
+#include <algorithm>
+
+namespace Ph2_HwInterface {
+
+    ReadoutWait::ReadoutWait ( const ReadoutWaitPolicy& pPolicy, ReadoutTiming* pTiming ) :
+        fPolicy ( pPolicy ),
+        fTiming ( pTiming ),
+        fStart ( std::chrono::steady_clock::now() ),
+        fLoopStart ( fStart ),
+        fSleep ( pPolicy.fMinSleep )
+    {
+    }
+
+    ReadoutWait::~ReadoutWait()
+    {
+        if ( fTiming != nullptr )
+            fTiming->fWaitTime += std::chrono::duration<double> ( std::chrono::steady_clock::now() - fStart ).count();
+    }
+
+    void ReadoutWait::wait()
+    {
+        if ( fTiming != nullptr ) fTiming->fNPolls++;
+
+        if ( fPolicy.fMode == WaitMode::Fixed )
+        {
+            std::this_thread::sleep_for ( std::chrono::microseconds ( fPolicy.fMaxSleep ) );
+            return;
+        }
+
+        // each poll is already an IPbus round trip, so spinning only means not sleeping
+        if ( elapsed() * 1e6 < fPolicy.fSpinTime )
+        {
+            std::this_thread::yield();
+            return;
+        }
+
+        std::this_thread::sleep_for ( std::chrono::microseconds ( fSleep ) );
+        fSleep = std::min ( std::max ( 2 * fSleep, 1u ), fPolicy.fMaxSleep );
+    }
+
+    void ReadoutWait::reset()
+    {
+        fLoopStart = std::chrono::steady_clock::now();
+        fSleep = fPolicy.fMinSleep;
+    }
+
+    double ReadoutWait::elapsed() const
+    {
+        return std::chrono::duration<double> ( std::chrono::steady_clock::now() - fLoopStart ).count();
+    }
+}
@@ -0,0 +1,92 @@
+/*!
+        \file                ReadoutWait.h
+        \brief               Wait policy used while polling the board for readout data
+ */
+
+#ifndef __READOUTWAIT_H__
+#define __READOUTWAIT_H__
+
+#include <cstdint>
+#include <chrono>
+
+/*!
+ * \namespace Ph2_HwInterface
+ * \brief Namespace regrouping all the interfaces to the hardware
+ */
+namespace Ph2_HwInterface {
+
+    /*!
+     * \brief How to wait between two polls of the readout status registers
+     */
+    enum class WaitMode : uint32_t {Fixed = 0, Adaptive = 1};
+
+    /*!
+     * \struct ReadoutWaitPolicy
+     * \brief Parameters of the wait between two polls, all times in us
+     */
+    struct ReadoutWaitPolicy
+    {
+        WaitMode fMode = WaitMode::Adaptive;
+        uint32_t fSpinTime = 200;        /*!< poll back to back for this long before sleeping (Adaptive only)*/
+        uint32_t fMinSleep = 50;         /*!< first sleep of the exponential back-off (Adaptive only)*/
+        uint32_t fMaxSleep = 10000;      /*!< upper bound of the back-off, or the sleep itself in Fixed mode*/
+    };
+
+    /*!
+     * \struct ReadoutTiming
+     * \brief Counters of the time spent waiting for data versus transferring it
+     */
+    struct ReadoutTiming
+    {
+        double fWaitTime = 0;            /*!< seconds spent in polling loops*/
+        double fTransferTime = 0;        /*!< seconds spent in the block transfers of the event data*/
+        uint64_t fNPolls = 0;            /*!< number of waits between polls*/
+        uint64_t fNTransfers = 0;        /*!< number of block transfers*/
+        uint64_t fNWords = 0;            /*!< number of 32-bit words transferred*/
+        uint64_t fNWordsDropped = 0;     /*!< words transferred but discarded: misaligned data, or past the last event requested*/
+
+        void reset()
+        {
+            *this = ReadoutTiming();
+        }
+    };
+
+    /*!
+     * \class ReadoutWait
+     * \brief One polling loop: spins, then sleeps with an exponential back-off bounded by the policy
+     *
+     * The time between construction and destruction is booked as wait time in the ReadoutTiming.
+     */
+    class ReadoutWait
+    {
+      public:
+        /*!
+         * \brief Constructor of the ReadoutWait class
+         * \param pPolicy : wait policy
+         * \param pTiming : counters to book the waiting time in, can be nullptr
+         */
+        ReadoutWait ( const ReadoutWaitPolicy& pPolicy, ReadoutTiming* pTiming = nullptr );
+        ~ReadoutWait();
+        /*!
+         * \brief Wait before the next poll
+         */
+        void wait();
+        /*!
+         * \brief Restart the back-off, to be called when the polled condition made progress
+         */
+        void reset();
+        /*!
+         * \brief Time since construction or the last reset() in seconds
+         */
+        double elapsed() const;
+
+      private:
+        const ReadoutWaitPolicy& fPolicy;
+        ReadoutTiming* fTiming;
+        std::chrono::steady_clock::time_point fStart;
+        std::chrono::steady_clock::time_point fLoopStart;
+        uint32_t fSleep;
+    };
+}
+
+#endif
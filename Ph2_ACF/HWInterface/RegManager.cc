@@ -67,24 +67,29 @@ namespace Ph2_HwInterface {
     }
 
     bool RegManager::WriteReg ( const std::string& pRegNode, const uint32_t& pVal )
+    {
+        return WriteReg ( resolve ( pRegNode ), pVal );
+    }
+
+    bool RegManager::WriteReg ( RegHandle pHandle, const uint32_t& pVal )
     {
         //std::lock_guard<std::mutex> cGuard (fBoardMutex);
-        fBoard->getNode ( pRegNode ).write ( pVal );
-        fBoard->dispatch();
+        queueWrite ( pHandle, pVal );
+        dispatch();
 
-        //LOG (DEBUG) << "Write: " <<  pRegNode << ": " << pVal;
+        //LOG (DEBUG) << "Write: " <<  pHandle->getPath() << ": " << pVal;
 
         // Verify if the writing is done correctly
         if ( DEV_FLAG )
         {
-            uhal::ValWord<uint32_t> reply = fBoard->getNode ( pRegNode ).read();
-            fBoard->dispatch();
+            uhal::ValWord<uint32_t> reply = queueRead ( pHandle );
+            dispatch();
 
             uint32_t comp = ( uint32_t ) reply;
 
             if ( comp == pVal )
             {
-                LOG (DEBUG) << "Values written correctly !" << pRegNode << "=" << pVal ;
+                LOG (DEBUG) << "Values written correctly !" << pHandle->getPath() << "=" << pVal ;
                 return true;
             }
 
@@ -101,13 +106,13 @@ namespace Ph2_HwInterface {
 
         for ( auto const& v : pVecReg )
         {
-            fBoard->getNode ( v.first ).write ( v.second );
+            queueWrite ( resolve ( v.first ), v.second );
             //LOG (DEBUG) << "Write: " <<  v.first << ": " << v.second;
         }
 
         try
         {
-            fBoard->dispatch();
+            dispatch();
         }
         catch (...)
         {
@@ -127,8 +132,8 @@ namespace Ph2_HwInterface {
 
             for ( auto const& v : pVecReg )
             {
-                uhal::ValWord<uint32_t> reply = fBoard->getNode ( v.first ).read();
-                fBoard->dispatch();
+                uhal::ValWord<uint32_t> reply = queueRead ( resolve ( v.first ) );
+                dispatch();
 
                 comp = static_cast<uint32_t> ( reply );
 
@@ -150,12 +155,17 @@ namespace Ph2_HwInterface {
 
 
     bool RegManager::WriteBlockReg ( const std::string& pRegNode, const std::vector< uint32_t >& pValues )
+    {
+        return WriteBlockReg ( resolve ( pRegNode ), pValues );
+    }
+
+    bool RegManager::WriteBlockReg ( RegHandle pHandle, const std::vector< uint32_t >& pValues )
     {
         //std::lock_guard<std::mutex> cGuard (fBoardMutex);
-        fBoard->getNode ( pRegNode ).writeBlock ( pValues );
-        fBoard->dispatch();
+        queueWriteBlock ( pHandle, pValues );
+        dispatch();
 
-        //LOG (DEBUG) << "Write block: " << pRegNode;
+        //LOG (DEBUG) << "Write block: " << pHandle->getPath();
 
         //for (auto cWord : pValues)
         //LOG (DEBUG) << "Write block: " <<  std::bitset<32> (cWord);
@@ -167,8 +177,8 @@ namespace Ph2_HwInterface {
         {
             int cErrCount = 0;
 
-            uhal::ValVector<uint32_t> cBlockRead = fBoard->getNode ( pRegNode ).readBlock ( pValues.size() );
-            fBoard->dispatch();
+            uhal::ValVector<uint32_t> cBlockRead = queueReadBlock ( pHandle, pValues.size(), 0 );
+            dispatch();
 
             //Use size_t and not an iterator as op[] only works with size_t type
             for ( std::size_t i = 0; i != cBlockRead.size(); i++ )
@@ -220,16 +230,21 @@ namespace Ph2_HwInterface {
 
 
     uhal::ValWord<uint32_t> RegManager::ReadReg ( const std::string& pRegNode )
+    {
+        return ReadReg ( resolve ( pRegNode ) );
+    }
+
+    uhal::ValWord<uint32_t> RegManager::ReadReg ( RegHandle pHandle )
     {
         //std::lock_guard<std::mutex> cGuard (fBoardMutex);
-        uhal::ValWord<uint32_t> cValRead = fBoard->getNode ( pRegNode ).read();
-        fBoard->dispatch();
-       	// LOG (INFO) << "Read: " << pRegNode << ": " << static_cast<uint32_t> (cValRead);
+        uhal::ValWord<uint32_t> cValRead = queueRead ( pHandle );
+        dispatch();
+       	// LOG (INFO) << "Read: " << pHandle->getPath() << ": " << static_cast<uint32_t> (cValRead);
 
         if ( DEV_FLAG )
         {
             uint32_t read = ( uint32_t ) cValRead;
-            LOG (DEBUG) << "Value in register ID " << pRegNode << " : " << read ;
+            LOG (DEBUG) << "Value in register ID " << pHandle->getPath() << " : " << read ;
         }
 
         return cValRead;
@@ -252,18 +267,23 @@ namespace Ph2_HwInterface {
 
 
     uhal::ValVector<uint32_t> RegManager::ReadBlockReg ( const std::string& pRegNode, const uint32_t& pBlockSize )
+    {
+        return ReadBlockReg ( resolve ( pRegNode ), pBlockSize );
+    }
+
+    uhal::ValVector<uint32_t> RegManager::ReadBlockReg ( RegHandle pHandle, const uint32_t& pBlockSize )
     {
         //std::lock_guard<std::mutex> cGuard (fBoardMutex);
-        uhal::ValVector<uint32_t> cBlockRead = fBoard->getNode ( pRegNode ).readBlock ( pBlockSize );
-        fBoard->dispatch();
-        //LOG (DEBUG) << "Read block: " << pRegNode;
+        uhal::ValVector<uint32_t> cBlockRead = queueReadBlock ( pHandle, pBlockSize, 0 );
+        dispatch();
+        //LOG (DEBUG) << "Read block: " << pHandle->getPath();
 
         //for (auto cWord : cBlockRead)
-        //if (pRegNode != "data") LOG (DEBUG) << "Read block: " << std::bitset<32> (cWord);
+        //if (pHandle->getPath() != "data") LOG (DEBUG) << "Read block: " << std::bitset<32> (cWord);
 
         if ( DEV_FLAG )
         {
-            LOG (DEBUG) << "Values in register block " << pRegNode << " : " ;
+            LOG (DEBUG) << "Values in register block " << pHandle->getPath() << " : " ;
 
             //Use size_t and not an iterator as op[] only works with size_t type
             for ( std::size_t i = 0; i != cBlockRead.size(); i++ )
@@ -278,17 +298,19 @@ namespace Ph2_HwInterface {
 
     uhal::ValVector<uint32_t> RegManager::ReadBlockRegOffset ( const std::string& pRegNode, const uint32_t& pBlocksize, const uint32_t& pBlockOffset )
     {
-        //std::lock_guard<std::mutex> cGuard (fBoardMutex);
-        uhal::ValVector<uint32_t> cBlockRead = fBoard->getNode ( pRegNode ).readBlockOffset ( pBlocksize, pBlockOffset );
-        fBoard->dispatch();
-        //LOG (DEBUG) << "Read block: " << pRegNode;
+        return ReadBlockRegOffset ( resolve ( pRegNode ), pBlocksize, pBlockOffset );
+    }
 
-        //for (auto cWord : cBlockRead)
-        //if (pRegNode != "data") LOG (DEBUG) << "Read block: " << std::bitset<32> (cWord);
+    uhal::ValVector<uint32_t> RegManager::ReadBlockRegOffset ( RegHandle pHandle, const uint32_t& pBlocksize, const uint32_t& pBlockOffset )
+    {
+        //std::lock_guard<std::mutex> cGuard (fBoardMutex);
+        uhal::ValVector<uint32_t> cBlockRead = queueReadBlock ( pHandle, pBlocksize, pBlockOffset );
+        dispatch();
+        //LOG (DEBUG) << "Read block: " << pHandle->getPath();
 
         if ( DEV_FLAG )
         {
-            LOG (DEBUG) << "Values in register block " << pRegNode << " : " ;
+            LOG (DEBUG) << "Values in register block " << pHandle->getPath() << " : " ;
 
             //Use size_t and not an iterator as op[] only works with size_t type
             for ( std::size_t i = 0; i != cBlockRead.size(); i++ )
@@ -301,22 +323,92 @@ namespace Ph2_HwInterface {
         return cBlockRead;
     }
 
-    void RegManager::StackReg ( const std::string& pRegNode, const uint32_t& pVal, bool pSend )
+    std::vector<uint32_t> RegManager::ReadFifoReg ( RegHandle pHandle, const uint32_t& pNWords )
     {
+        std::vector<uint32_t> cWords;
+        cWords.reserve ( pNWords );
 
-        for ( std::vector< std::pair<std::string, uint32_t> >::iterator cIt = fStackReg.begin(); cIt != fStackReg.end(); cIt++ )
+        if ( pHandle->getMode() == uhal::defs::NON_INCREMENTAL )
+        {
+            uhal::ValVector<uint32_t> cBlockRead = queueReadBlock ( pHandle, pNWords, 0 );
+            dispatch();
+            cWords = cBlockRead.value();
+        }
+        else
         {
-            if ( cIt->first == pRegNode )
-                fStackReg.erase ( cIt );
+            // a plain register port: every read pops one word, uHAL packs the reads into as few IPbus packets as it can
+            std::vector<uhal::ValWord<uint32_t>> cReads;
+            cReads.reserve ( pNWords );
+
+            for ( uint32_t cWord = 0; cWord < pNWords; cWord++ )
+                cReads.push_back ( queueRead ( pHandle ) );
+
+            dispatch();
+
+            for ( auto& cRead : cReads )
+                cWords.push_back ( cRead.value() );
         }
 
-        std::pair<std::string, uint32_t> cPair ( pRegNode, pVal );
-        fStackReg.push_back ( cPair );
+        return cWords;
+    }
+
+    uhal::ValWord<uint32_t> RegManager::queueRead ( RegHandle pHandle )
+    {
+        return pHandle->read();
+    }
+
+    void RegManager::queueWrite ( RegHandle pHandle, uint32_t pVal )
+    {
+        pHandle->write ( pVal );
+    }
+
+    uhal::ValVector<uint32_t> RegManager::queueReadBlock ( RegHandle pHandle, uint32_t pBlocksize, uint32_t pBlockOffset )
+    {
+        if ( pBlockOffset == 0 ) return pHandle->readBlock ( pBlocksize );
+        else return pHandle->readBlockOffset ( pBlocksize, pBlockOffset );
+    }
+
+    void RegManager::queueWriteBlock ( RegHandle pHandle, const std::vector< uint32_t >& pValues )
+    {
+        pHandle->writeBlock ( pValues );
+    }
+
+    void RegManager::dispatch()
+    {
+        fBoard->dispatch();
+    }
+
+    RegHandle RegManager::resolve ( const std::string& pRegNode )
+    {
+        //the uHAL node references stay valid as long as fBoard lives, so they can be cached by path
+        auto cNode = fNodeCache.find ( pRegNode );
+
+        if ( cNode != std::end ( fNodeCache ) )
+            return cNode->second;
+
+        RegHandle cHandle = &fBoard->getNode ( pRegNode );
+        fNodeCache.emplace ( pRegNode, cHandle );
+        return cHandle;
+    }
+
+    void RegManager::StackReg ( const std::string& pRegNode, const uint32_t& pVal, bool pSend )
+    {
+        // a register already in the stack only gets its value updated
+        auto cIndex = fStackRegIndex.find ( pRegNode );
+
+        if ( cIndex != std::end ( fStackRegIndex ) )
+            fStackReg.at ( cIndex->second ).second = pVal;
+        else
+        {
+            fStackRegIndex.emplace ( pRegNode, fStackReg.size() );
+            fStackReg.push_back ( std::make_pair ( pRegNode, pVal ) );
+        }
 
         if ( pSend || fStackReg.size() == 100 )
         {
             WriteStackReg ( fStackReg );
             fStackReg.clear();
+            fStackRegIndex.clear();
         }
     }
 
@@ -344,7 +436,76 @@ namespace Ph2_HwInterface {
     const uhal::Node& RegManager::getUhalNode ( const std::string& pStrPath )
     {
         //std::lock_guard<std::mutex> cGuard (fBoardMutex);
-        return fBoard->getNode ( pStrPath );
+        return *resolve ( pStrPath );
+    }
+
+    RegTransaction::RegTransaction ( RegManager* pRegManager ) :
+        fRegManager ( pRegManager ),
+        fNQueued ( 0 )
+    {}
+
+    void RegTransaction::WriteReg ( RegHandle pHandle, const uint32_t& pVal )
+    {
+        fRegManager->queueWrite ( pHandle, pVal );
+        fNQueued++;
+    }
+
+    void RegTransaction::WriteReg ( const std::string& pRegNode, const uint32_t& pVal )
+    {
+        WriteReg ( fRegManager->resolve ( pRegNode ), pVal );
+    }
+
+    void RegTransaction::WriteStackReg ( const std::vector<std::pair<std::string, uint32_t> >& pVecReg )
+    {
+        for ( auto const& v : pVecReg )
+            WriteReg ( fRegManager->resolve ( v.first ), v.second );
+    }
+
+    void RegTransaction::WriteBlockReg ( RegHandle pHandle, const std::vector< uint32_t >& pValues )
+    {
+        fRegManager->queueWriteBlock ( pHandle, pValues );
+        fNQueued++;
+    }
+
+    void RegTransaction::WriteBlockReg ( const std::string& pRegNode, const std::vector< uint32_t >& pValues )
+    {
+        WriteBlockReg ( fRegManager->resolve ( pRegNode ), pValues );
+    }
+
+    uhal::ValWord<uint32_t> RegTransaction::ReadReg ( RegHandle pHandle )
+    {
+        fNQueued++;
+        return fRegManager->queueRead ( pHandle );
+    }
+
+    uhal::ValWord<uint32_t> RegTransaction::ReadReg ( const std::string& pRegNode )
+    {
+        return ReadReg ( fRegManager->resolve ( pRegNode ) );
+    }
+
+    uhal::ValVector<uint32_t> RegTransaction::ReadBlockReg ( RegHandle pHandle, const uint32_t& pBlocksize )
+    {
+        fNQueued++;
+        return fRegManager->queueReadBlock ( pHandle, pBlocksize, 0 );
+    }
+
+    uhal::ValVector<uint32_t> RegTransaction::ReadBlockReg ( const std::string& pRegNode, const uint32_t& pBlocksize )
+    {
+        return ReadBlockReg ( fRegManager->resolve ( pRegNode ), pBlocksize );
+    }
+
+    uhal::ValVector<uint32_t> RegTransaction::ReadBlockRegOffset ( RegHandle pHandle, const uint32_t& pBlocksize, const uint32_t& pBlockOffset )
+    {
+        fNQueued++;
+        return fRegManager->queueReadBlock ( pHandle, pBlocksize, pBlockOffset );
+    }
+
+    void RegTransaction::Dispatch()
+    {
+        if ( fNQueued == 0 ) return;
+
+        fRegManager->dispatch();
+        fNQueued = 0;
     }
 
 }
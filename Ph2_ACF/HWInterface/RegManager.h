@@ -13,6 +13,7 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 #include <thread>
@@ -26,6 +27,11 @@
  * \brief Namespace regrouping all the interfaces to the hardware
  */
 namespace Ph2_HwInterface {
+    /*!
+     * \brief Pre-resolved uHAL node of a register, obtained once with RegManager::resolve() and valid for the lifetime of the uHAL HwInterface
+     */
+    using RegHandle = const uhal::Node*;
+
     /*!
      * \class RegManager
      * \brief Permit connection to given boards and r/w given registers
@@ -36,6 +42,8 @@ namespace Ph2_HwInterface {
         uhal::HwInterface* fBoard;         /*!< Board in use*/
         const char* fUHalConfigFileName;         /*!< path of the uHal Config File*/
         std::vector< std::pair<std::string, uint32_t> > fStackReg;        /*!< Stack of registers*/
+        std::unordered_map<std::string, size_t> fStackRegIndex;        /*!< Position of each register in fStackReg*/
+        std::unordered_map<std::string, RegHandle> fNodeCache;        /*!< Nodes already resolved from their path, to avoid the hierarchical uHAL lookup on every access*/
         //std::thread fThread;         [>!< Thread for timeout stack writing<]
         //bool fDeactiveThread;         [>!< Bool to terminate the thread in the destructor<]
         //std::mutex fBoardMutex;         [>!< Mutex to avoid conflict btw threads on shared resources<]
@@ -70,6 +78,13 @@ namespace Ph2_HwInterface {
         */
         virtual bool WriteReg ( const std::string& pRegNode, const uint32_t& pVal );
         /*!
+        * \brief Write a register through a pre-resolved handle
+        * \param pHandle : Handle of the register to write, see resolve()
+        * \param pVal : Value to write
+        * \return boolean confirming the writing
+        */
+        bool WriteReg ( RegHandle pHandle, const uint32_t& pVal );
+        /*!
         * \brief Write a stack of registers
         * \param pVecReg : vector containing the registers and the associated values to write
         * \return boolean confirming the writing
@@ -82,6 +97,13 @@ namespace Ph2_HwInterface {
         * \return boolean confirming the writing
         */
         virtual bool WriteBlockReg ( const std::string& pRegNode, const std::vector< uint32_t >& pValues );
+        /*!
+        * \brief Write a block of values in a register through a pre-resolved handle
+        * \param pHandle : Handle of the register to write, see resolve()
+        * \param pValues : Block of values to write
+        * \return boolean confirming the writing
+        */
+        bool WriteBlockReg ( RegHandle pHandle, const std::vector< uint32_t >& pValues );
         /** \brief Write a block of values at a given address
          * \param uAddr 32-bit address
         * \param pValues : Block of values to write
@@ -96,6 +118,12 @@ namespace Ph2_HwInterface {
         */
         virtual uhal::ValWord<uint32_t> ReadReg ( const std::string& pRegNode );
         /*!
+        * \brief Read a value in a register through a pre-resolved handle
+        * \param pHandle : Handle of the register to read, see resolve()
+        * \return ValWord value of the register
+        */
+        uhal::ValWord<uint32_t> ReadReg ( RegHandle pHandle );
+        /*!
         * \brief Read a value at a given address
         * \param uAddr 32-bit address
         * \param uMask 32-bit mask
@@ -110,6 +138,13 @@ namespace Ph2_HwInterface {
         */
         virtual uhal::ValVector<uint32_t> ReadBlockReg ( const std::string& pRegNode, const uint32_t& pBlocksize );
         /*!
+        * \brief Read a block of values in a register through a pre-resolved handle
+        * \param pHandle : Handle of the register to read, see resolve()
+        * \param pBlocksize : Size of the block to read
+        * \return ValVector block values of the register
+        */
+        uhal::ValVector<uint32_t> ReadBlockReg ( RegHandle pHandle, const uint32_t& pBlocksize );
+        /*!
         * \brief Read a block of values in a register
         * \param pRegNode : Node of the register to read
         * \param pBlocksize : Size of the block to read
@@ -118,11 +153,59 @@ namespace Ph2_HwInterface {
         */
         virtual uhal::ValVector<uint32_t> ReadBlockRegOffset ( const std::string& pRegNode, const uint32_t& pBlocksize, const uint32_t& pBlockOffset );
         /*!
+        * \brief Read a block of values in a register through a pre-resolved handle
+        * \param pHandle : Handle of the register to read, see resolve()
+        * \param pBlocksize : Size of the block to read
+        * \param pBlockOffset : Offset of the block
+        * \return ValVector block values of the register
+        */
+        uhal::ValVector<uint32_t> ReadBlockRegOffset ( RegHandle pHandle, const uint32_t& pBlocksize, const uint32_t& pBlockOffset );
+        /*!
+        * \brief Pop a number of words from a FIFO port in a single dispatch
+        * \param pHandle : Handle of the FIFO port, see resolve()
+        * \param pNWords : Number of words to read
+        * \return the words, in the order they left the FIFO
+        * \details A block read if the node is declared non-incremental in the address table, else a queue of single reads of the port
+        */
+        std::vector<uint32_t> ReadFifoReg ( RegHandle pHandle, const uint32_t& pNWords );
+        /*!
+        * \brief Resolve a register node once and keep it for later accesses
+        * \param pRegNode : Node of the register
+        * \return Handle to be passed to the handle based read/write methods
+        */
+        RegHandle resolve ( const std::string& pRegNode );
+        /*!
         * \brief Time Out for sending the register/value stack in the writting.
         * \brief It has only to be set in a detached thread from the one you're working on
         */
         void StackWriteTimeOut();
 
+      protected:
+        /*!
+        * \brief Queue the read of a node, the ValWord is filled at the next dispatch()
+        * \details Every register access of RegManager and RegTransaction goes through queueRead(), queueWrite(), queueReadBlock(),
+        * queueWriteBlock() and dispatch(), which use the uHAL client. A derived class can override them to serve the accesses without a board.
+        */
+        virtual uhal::ValWord<uint32_t> queueRead ( RegHandle pHandle );
+        /*!
+        * \brief Queue the write of a node
+        */
+        virtual void queueWrite ( RegHandle pHandle, uint32_t pVal );
+        /*!
+        * \brief Queue the read of a block of pBlocksize words of a node, starting pBlockOffset words after its address
+        */
+        virtual uhal::ValVector<uint32_t> queueReadBlock ( RegHandle pHandle, uint32_t pBlocksize, uint32_t pBlockOffset );
+        /*!
+        * \brief Queue the write of a block of values to a node
+        */
+        virtual void queueWriteBlock ( RegHandle pHandle, const std::vector< uint32_t >& pValues );
+        /*!
+        * \brief Send the queued accesses
+        */
+        virtual void dispatch();
+
+        friend class RegTransaction;
+
       public:
         /*!
          * \brief Reset the HW Interface with different Id, Uri and Address Table
@@ -131,6 +214,8 @@ namespace Ph2_HwInterface {
         {
             if (fBoard)
             {
+                // the cached nodes belong to the old HwInterface
+                fNodeCache.clear();
                 delete fBoard;
                 fBoard = new uhal::HwInterface ( uhal::ConnectionManager::getDevice ( pId, pUri, pAddressTable ) );
             }
@@ -175,6 +260,80 @@ namespace Ph2_HwInterface {
          */
         const uhal::Node& getUhalNode ( const std::string& pStrPath );
     };
+
+    /*!
+     * \class RegTransaction
+     * \brief Queue reads and writes on a RegManager and send them to the board in a single IPbus dispatch
+     *
+     * The ValWord/ValVector returned by the read methods only become valid after Dispatch().
+     * Operations still queued when the transaction goes out of scope are sent with the next dispatch of the board.
+     */
+    class RegTransaction
+    {
+      private:
+        RegManager* fRegManager;
+        uint32_t fNQueued;         /*!< Number of operations waiting for Dispatch()*/
+
+      public:
+        /*!
+         * \brief Constructor of the RegTransaction class
+         * \param pRegManager : RegManager of the board to talk to
+         */
+        RegTransaction ( RegManager* pRegManager );
+        /*!
+        * \brief Queue the write of a register
+        * \param pHandle : Handle of the register to write
+        * \param pVal : Value to write
+        */
+        void WriteReg ( RegHandle pHandle, const uint32_t& pVal );
+        void WriteReg ( const std::string& pRegNode, const uint32_t& pVal );
+        /*!
+        * \brief Queue the write of a stack of registers
+        * \param pVecReg : vector containing the registers and the associated values to write
+        */
+        void WriteStackReg ( const std::vector<std::pair<std::string, uint32_t> >& pVecReg );
+        /*!
+        * \brief Queue the write of a block of values in a register
+        * \param pHandle : Handle of the register to write
+        * \param pValues : Block of values to write
+        */
+        void WriteBlockReg ( RegHandle pHandle, const std::vector< uint32_t >& pValues );
+        void WriteBlockReg ( const std::string& pRegNode, const std::vector< uint32_t >& pValues );
+        /*!
+        * \brief Queue the read of a register
+        * \param pHandle : Handle of the register to read
+        * \return ValWord filled at Dispatch()
+        */
+        uhal::ValWord<uint32_t> ReadReg ( RegHandle pHandle );
+        uhal::ValWord<uint32_t> ReadReg ( const std::string& pRegNode );
+        /*!
+        * \brief Queue the read of a block of values in a register
+        * \param pHandle : Handle of the register to read
+        * \param pBlocksize : Size of the block to read
+        * \return ValVector filled at Dispatch()
+        */
+        uhal::ValVector<uint32_t> ReadBlockReg ( RegHandle pHandle, const uint32_t& pBlocksize );
+        uhal::ValVector<uint32_t> ReadBlockReg ( const std::string& pRegNode, const uint32_t& pBlocksize );
+        /*!
+        * \brief Queue the read of a block of values in a register, starting at an offset
+        * \param pHandle : Handle of the register to read
+        * \param pBlocksize : Size of the block to read
+        * \param pBlockOffset : Offset of the block
+        * \return ValVector filled at Dispatch()
+        */
+        uhal::ValVector<uint32_t> ReadBlockRegOffset ( RegHandle pHandle, const uint32_t& pBlocksize, const uint32_t& pBlockOffset );
+        /*!
+        * \brief Send all the queued operations in one go, does nothing if the queue is empty
+        */
+        void Dispatch();
+        /*!
+        * \brief Number of operations waiting for Dispatch()
+        */
+        uint32_t size() const
+        {
+            return fNQueued;
+        }
+    };
 }
 
 #endif
@@ -23,7 +23,8 @@ SSAInterface::SSAInterface( const BeBoardFWMap& pBoardMap ) :
     fBoardFW( nullptr ),
     prevBoardIdentifier( 65535 ),
     fRegisterCount( 0 ),
-    fTransactionCount( 0 )
+    fTransactionCount( 0 ),
+    fI2CWordsSaved( 0 )
 {
 #ifdef COUNT_FLAG
     std::cout << "Counting number of Transactions!" << std::endl;
@@ -106,7 +107,7 @@ void SSAInterface::setFileHandler (FileHandler* pHandler)
 /// END MAIN POEWR ON/OFF BLOCK
 
 /// CONFIGURE SSA:
-	bool SSAInterface::ConfigureSSA (const SSA* pSSA, bool pVerifLoop)
+	bool SSAInterface::ConfigureSSA (SSA* pSSA, bool pVerifLoop, RegWriteMode pMode)
 	{
 	    LOG (INFO) << YELLOW << "--- Trying to configure one of the SSAs: "<< RESET;
 	    //first, identify the correct BeBoardFWInterface
@@ -114,20 +115,31 @@ void SSAInterface::setFileHandler (FileHandler* pHandler)
 
 	    //vector to encode all the registers into
 	    std::vector<uint32_t> cVec;
+	    //helper vector with the stored items of what is written
+	    std::vector<RegItem*> cWritten;
 
 	    //Deal with the RegItems and encode them
 
-	    SSARegMap cSSARegMap = pSSA->getRegMap();
+	    SSARegMap& cSSARegMap = pSSA->getRegMap();
 
 	    for ( auto& cRegItem : cSSARegMap )
 	    {
+		if ( pMode == RegWriteMode::DELTA_ONLY && cRegItem.second.hwHolds ( cRegItem.second.fValue ) )
+		{
+		    fI2CWordsSaved++;
+		    continue;
+		}
+
 		LOG (INFO) << BOLDBLUE << cRegItem.first << RESET;
 		fBoardFW->EncodeReg (cRegItem.second, pSSA->getFeId(), pSSA->getSSAId(), cVec, pVerifLoop, true);
+		cWritten.push_back ( &cRegItem.second );
 	#ifdef COUNT_FLAG
 		fRegisterCount++;
 	#endif
 	    }
 
+	    if ( cVec.empty() ) return true;
+
 	    // write the registers, the answer will be in the same cVec
 	    // the number of times the write operation has been attempted is given by cWriteAttempts
 	    uint8_t cWriteAttempts = 0 ;
@@ -137,6 +149,13 @@ void SSAInterface::setFileHandler (FileHandler* pHandler)
 	    fTransactionCount++;
 	#endif
 
+	    // on failure it is not known which of the registers made it to the chip
+	    for ( auto cRegItem : cWritten )
+	    {
+		if ( cSuccess ) cRegItem->setHwValue ( cRegItem->fValue );
+		else cRegItem->fHwValid = false;
+	    }
+
 	    return cSuccess;
 	}
 /// END CONFIGURE SSA
@@ -156,7 +175,8 @@ void SSAInterface::setFileHandler (FileHandler* pHandler)
 	    setBoard ( pSSA->getBeBoardIdentifier() );
 
 	    //next, get the reg item
-	    RegItem cRegItem = pSSA->getRegItem ( pRegNode );
+	    RegItem& cStored = pSSA->getRegItem ( pRegNode );
+	    RegItem cRegItem = cStored;
 	    cRegItem.fValue = pValue;
 
 	    //vector for transaction
@@ -171,7 +191,12 @@ void SSAInterface::setFileHandler (FileHandler* pHandler)
 
 	    //update the HWDescription object
 	    if (cSuccess)
-		pSSA->setReg ( pRegNode, pValue );
+	    {
+		cStored.fValue = pValue;
+		cStored.setHwValue ( pValue );
+	    }
+	    else
+		cStored.fHwValid = false;
 
 	#ifdef COUNT_FLAG
 	    fRegisterCount++;
@@ -199,7 +224,12 @@ void SSAInterface::setFileHandler (FileHandler* pHandler)
 	    uint8_t cSSAId;
 	    fBoardFW->DecodeReg ( cRegItem, cSSAId, cVecReq[0], cRead, cFailed );
 
-	    if (!cFailed) pSSA->setReg ( pRegNode, cRegItem.fValue );
+	    if (!cFailed)
+	    {
+		RegItem& cStored = pSSA->getRegItem ( pRegNode );
+		cStored.fValue = cRegItem.fValue;
+		cStored.setHwValue ( cRegItem.fValue );
+	    }
 
 	    return cRegItem.fValue;
 	}
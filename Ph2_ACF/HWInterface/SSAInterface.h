@@ -41,6 +41,7 @@ namespace Ph2_HwInterface
 
 		uint16_t fRegisterCount;                                /*!< Counter for the number of Registers written */
 		uint16_t fTransactionCount;         /*!< Counter for the number of Transactions */
+		uint32_t fI2CWordsSaved;            /*!< Counter for the register writes skipped by RegWriteMode::DELTA_ONLY, one I2C word each */
 
 
 	  private:
@@ -67,7 +68,14 @@ namespace Ph2_HwInterface
 		void PowerOn(float VDDPST = 1.2, float DVDD = 1.0, float AVDD = 1.2, float VBG = 0.3, uint8_t mpaid = 0 , uint8_t ssaid = 0);
 		void MainPowerOn(uint8_t mpaid = 0, uint8_t ssaid = 0);
 		void MainPowerOff();
-		bool ConfigureSSA (const SSA* pSSA , bool pVerifLoop = true);
+		bool ConfigureSSA (SSA* pSSA , bool pVerifLoop = true, RegWriteMode pMode = RegWriteMode::FULL);
+		/*!
+		 * \brief Number of register writes skipped so far because the SSAs already held the values
+		 */
+		uint32_t getI2CWordsSaved() const
+		{
+		    return fI2CWordsSaved;
+		}
 		
 		bool WriteSSAReg ( SSA* pSSA, const std::string& pRegNode, uint8_t pValue, bool pVerifLoop = true );
    		uint8_t ReadSSAReg ( SSA* pSSA, const std::string& pRegNode );
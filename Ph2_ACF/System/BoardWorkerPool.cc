@@ -0,0 +1,199 @@
+/*
+
+        FileName :                    BoardWorkerPool.cc
+        Content :                     One worker thread per BeBoard to configure, trigger, read and decode all boards concurrently
+
+ */
+
+#include "BoardWorkerPool.h"
+#include "../Utils/ConsoleColor.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+namespace Ph2_System {
+
+    void BoardContext::addTime ( const std::string& pStage, double pTime )
+    {
+        StageTiming& cTiming = fTiming[pStage];
+        cTiming.fNCalls++;
+        cTiming.fTime += pTime;
+        cTiming.fMaxTime = std::max ( cTiming.fMaxTime, pTime );
+    }
+
+    BoardWorkerPool::BoardWorkerPool ( const std::vector<BeBoard*>& pBoards, const BeBoardFWMap& pBeBoardFWMap ) :
+        fTask ( nullptr ),
+        fGeneration ( 0 ),
+        fNPending ( 0 ),
+        fExit ( false )
+    {
+        for ( auto cBoard : pBoards )
+        {
+            auto cFWInterface = pBeBoardFWMap.find ( cBoard->getBeBoardIdentifier() );
+
+            if ( cFWInterface == std::end ( pBeBoardFWMap ) )
+            {
+                LOG (ERROR) << BOLDRED << "No FW interface for board " << +cBoard->getBeId() << ", it is not served by the worker pool" << RESET;
+                continue;
+            }
+
+            // the interfaces only see this board
+            BeBoardFWMap cBoardMap;
+            cBoardMap[cFWInterface->first] = cFWInterface->second;
+
+            std::unique_ptr<BoardContext> cContext ( new BoardContext );
+            cContext->fBoard = cBoard;
+            cContext->fFWInterface = cFWInterface->second;
+            cContext->fBeBoardInterface.reset ( new BeBoardInterface ( cBoardMap ) );
+            cContext->fCbcInterface.reset ( new CbcInterface ( cBoardMap ) );
+            cContext->fMPAInterface.reset ( new MPAInterface ( cBoardMap ) );
+            cContext->fSSAInterface.reset ( new SSAInterface ( cBoardMap ) );
+            fContexts.push_back ( std::move ( cContext ) );
+        }
+
+        fTaskTimes.resize ( fContexts.size(), 0 );
+        fExceptions.resize ( fContexts.size() );
+
+        if ( fContexts.size() > 1 )
+        {
+            for ( size_t cIndex = 0; cIndex < fContexts.size(); cIndex++ )
+                fThreads.emplace_back ( &BoardWorkerPool::workerLoop, this, cIndex );
+        }
+    }
+
+    BoardWorkerPool::~BoardWorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> cLock ( fMutex );
+            fExit = true;
+        }
+        fStartCondition.notify_all();
+
+        for ( auto& cThread : fThreads )
+            if ( cThread.joinable() ) cThread.join();
+    }
+
+    void BoardWorkerPool::run ( const std::string& pStage, const BoardTask& pTask )
+    {
+        auto cStart = std::chrono::steady_clock::now();
+
+        {
+            std::unique_lock<std::mutex> cLock ( fMutex );
+            fTask = &pTask;
+            fStage = pStage;
+
+            for ( auto& cException : fExceptions )
+                cException = nullptr;
+
+            if ( fThreads.empty() )
+            {
+                cLock.unlock();
+
+                for ( size_t cIndex = 0; cIndex < fContexts.size(); cIndex++ )
+                    runTask ( cIndex );
+
+                cLock.lock();
+            }
+            else
+            {
+                fNPending = fContexts.size();
+                fGeneration++;
+                fStartCondition.notify_all();
+                fDoneCondition.wait ( cLock, [this] { return fNPending == 0; } );
+            }
+
+            fTask = nullptr;
+        }
+
+        // whatever a board did not spend in its own task it spent waiting for the others
+        double cWallTime = std::chrono::duration<double> ( std::chrono::steady_clock::now() - cStart ).count();
+
+        for ( size_t cIndex = 0; cIndex < fContexts.size(); cIndex++ )
+            fContexts.at ( cIndex )->fTiming[pStage].fIdleTime += std::max ( 0., cWallTime - fTaskTimes.at ( cIndex ) );
+
+        for ( auto& cException : fExceptions )
+            if ( cException ) std::rethrow_exception ( cException );
+    }
+
+    void BoardWorkerPool::workerLoop ( size_t pIndex )
+    {
+        uint64_t cGeneration = 0;
+
+        while ( true )
+        {
+            {
+                std::unique_lock<std::mutex> cLock ( fMutex );
+                fStartCondition.wait ( cLock, [&] { return fExit || fGeneration != cGeneration; } );
+
+                if ( fExit ) return;
+
+                cGeneration = fGeneration;
+            }
+
+            runTask ( pIndex );
+
+            {
+                std::lock_guard<std::mutex> cLock ( fMutex );
+
+                if ( --fNPending == 0 ) fDoneCondition.notify_one();
+            }
+        }
+    }
+
+    void BoardWorkerPool::runTask ( size_t pIndex )
+    {
+        BoardContext& cContext = *fContexts.at ( pIndex );
+        auto cStart = std::chrono::steady_clock::now();
+
+        try
+        {
+            ( *fTask ) ( cContext );
+        }
+        catch ( ... )
+        {
+            fExceptions.at ( pIndex ) = std::current_exception();
+        }
+
+        fTaskTimes.at ( pIndex ) = std::chrono::duration<double> ( std::chrono::steady_clock::now() - cStart ).count();
+        cContext.addTime ( fStage, fTaskTimes.at ( pIndex ) );
+    }
+
+    BoardTiming BoardWorkerPool::getTiming ( const BeBoard* pBoard ) const
+    {
+        for ( auto& cContext : fContexts )
+            if ( cContext->fBoard == pBoard ) return cContext->fTiming;
+
+        return BoardTiming();
+    }
+
+    void BoardWorkerPool::resetTiming()
+    {
+        for ( auto& cContext : fContexts )
+        {
+            cContext->fTiming.clear();
+            cContext->fFWInterface->resetReadoutTiming();
+        }
+    }
+
+    void BoardWorkerPool::printTiming ( std::ostream& os ) const
+    {
+        for ( auto& cContext : fContexts )
+        {
+            os << BOLDBLUE << "Board " << +cContext->fBoard->getBeId() << RESET << std::endl;
+
+            for ( auto& cStage : cContext->fTiming )
+            {
+                const StageTiming& cTiming = cStage.second;
+                os << "    " << std::left << std::setw ( 16 ) << cStage.first << std::right
+                   << " calls " << std::setw ( 8 ) << cTiming.fNCalls
+                   << " total " << std::fixed << std::setprecision ( 3 ) << std::setw ( 10 ) << cTiming.fTime << " s"
+                   << " max " << std::setw ( 8 ) << cTiming.fMaxTime << " s"
+                   << " barrier wait " << std::setw ( 8 ) << cTiming.fIdleTime << " s" << std::endl;
+            }
+
+            const ReadoutTiming& cReadout = cContext->fFWInterface->getReadoutTiming();
+            os << "    readout: waiting " << std::fixed << std::setprecision ( 3 ) << cReadout.fWaitTime << " s in " << cReadout.fNPolls << " polls, transferring "
+               << cReadout.fTransferTime << " s in " << cReadout.fNTransfers << " transfers (" << cReadout.fNWords << " words, " << cReadout.fNWordsDropped << " dropped)" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,133 @@
+/*!
+
+        \file                    BoardWorkerPool.h
+        \brief                   One worker thread per BeBoard to configure, trigger, read and decode all boards concurrently
+
+*/
+
+#ifndef __BOARDWORKERPOOL_H__
+#define __BOARDWORKERPOOL_H__
+
+#include "../HWInterface/BeBoardInterface.h"
+#include "../HWInterface/BeBoardFWInterface.h"
+#include "../HWInterface/CbcInterface.h"
+#include "../HWInterface/MPAInterface.h"
+#include "../HWInterface/SSAInterface.h"
+#include "../HWDescription/BeBoard.h"
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Ph2_HwDescription;
+using namespace Ph2_HwInterface;
+
+namespace Ph2_System {
+
+    /*!
+     * \struct StageTiming
+     * \brief Time one board spent in one stage, summed over all the calls of run()
+     */
+    struct StageTiming
+    {
+        uint64_t fNCalls = 0;
+        double fTime = 0;               /*!< seconds spent in the task of this board*/
+        double fMaxTime = 0;            /*!< slowest single call*/
+        double fIdleTime = 0;           /*!< seconds this board waited at the barrier for the slower boards*/
+    };
+
+    using BoardTiming = std::map<std::string, StageTiming>;     /*!< Timing per stage name */
+
+    /*!
+     * \struct BoardContext
+     * \brief What a task may touch on the worker of one board
+     *
+     * The interfaces are private to the worker and only know this board, so their setBoard() state is never shared between threads.
+     */
+    struct BoardContext
+    {
+        BeBoard* fBoard = nullptr;
+        BeBoardFWInterface* fFWInterface = nullptr;
+        std::unique_ptr<BeBoardInterface> fBeBoardInterface;
+        std::unique_ptr<CbcInterface> fCbcInterface;
+        std::unique_ptr<MPAInterface> fMPAInterface;
+        std::unique_ptr<SSAInterface> fSSAInterface;
+        BoardTiming fTiming;
+
+        /*!
+         * \brief Book time for a sub-stage of a task, e.g. the decoding inside a readout task
+         */
+        void addTime ( const std::string& pStage, double pTime );
+    };
+
+    using BoardTask = std::function<void ( BoardContext& )>;
+
+    /*!
+     * \class BoardWorkerPool
+     * \brief Persistent worker per BeBoard; run() hands the same task to every worker and returns once all of them are done
+     *
+     * run() is a barrier: the caller continues only when every board finished, so a tool loop can set a scan point, take data
+     * on all boards in parallel and then fill its histograms serially. The first exception thrown by a task is rethrown by run().
+     * With a single board the task runs on the calling thread.
+     */
+    class BoardWorkerPool
+    {
+      public:
+        /*!
+         * \brief Constructor of the BoardWorkerPool class
+         * \param pBoards : the boards, one worker each
+         * \param pBeBoardFWMap : FW interfaces of the boards
+         */
+        BoardWorkerPool ( const std::vector<BeBoard*>& pBoards, const BeBoardFWMap& pBeBoardFWMap );
+        ~BoardWorkerPool();
+
+        /*!
+         * \brief Run pTask for every board in parallel and wait for all of them, not reentrant
+         * \param pStage : name under which the time is booked
+         * \param pTask : the task
+         */
+        void run ( const std::string& pStage, const BoardTask& pTask );
+        /*!
+         * \brief Number of boards served by the pool
+         */
+        size_t size() const
+        {
+            return fContexts.size();
+        }
+        /*!
+         * \brief Timing breakdown of one board, empty if the board is not in the pool
+         */
+        BoardTiming getTiming ( const BeBoard* pBoard ) const;
+        void resetTiming();
+        /*!
+         * \brief Print the timing per stage and per board, with the wait/transfer split of the readout
+         */
+        void printTiming ( std::ostream& os ) const;
+
+      private:
+        void workerLoop ( size_t pIndex );
+        void runTask ( size_t pIndex );
+
+        std::vector<std::unique_ptr<BoardContext>> fContexts;
+        std::vector<std::thread> fThreads;
+        std::vector<double> fTaskTimes;
+        std::vector<std::exception_ptr> fExceptions;
+
+        std::mutex fMutex;
+        std::condition_variable fStartCondition;
+        std::condition_variable fDoneCondition;
+        const BoardTask* fTask;
+        std::string fStage;
+        uint64_t fGeneration;
+        size_t fNPending;
+        bool fExit;
+    };
+}
+
+#endif
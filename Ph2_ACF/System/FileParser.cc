@@ -108,6 +108,8 @@ namespace Ph2_System {
                     pBeBoardFWMap[cBeBoard->getBeBoardIdentifier()] =  new ICFc7FWInterface ( cId.c_str(), cUri.c_str(), cAddressTable.c_str() );
                 else if (cBeBoard->getBoardType() == BoardType::CBC3FC7)
                     pBeBoardFWMap[cBeBoard->getBeBoardIdentifier()] =  new Cbc3Fc7FWInterface ( cId.c_str(), cUri.c_str(), cAddressTable.c_str() );
+                else if (cBeBoard->getBoardType() == BoardType::D19C && D19cEmulatorFWInterface::isEmulatorUri ( cUri ) )
+                    pBeBoardFWMap[cBeBoard->getBeBoardIdentifier()] =  new D19cEmulatorFWInterface ( cId.c_str(), cUri.c_str(), cAddressTable.c_str() );
                 else if (cBeBoard->getBoardType() == BoardType::D19C)
                     pBeBoardFWMap[cBeBoard->getBeBoardIdentifier()] =  new D19cFWInterface ( cId.c_str(), cUri.c_str(), cAddressTable.c_str() );
                 else if (cBeBoard->getBoardType() == BoardType::MPAlightGLIB)
@@ -23,6 +23,7 @@
 #include "../HWInterface/ICFc7FWInterface.h"
 #include "../HWInterface/Cbc3Fc7FWInterface.h"
 #include "../HWInterface/D19cFWInterface.h"
+#include "../HWInterface/D19cEmulatorFWInterface.h"
 #include "../HWInterface/MPAlightGlibFWInterface.h"
 #include "../HWDescription/Definition.h"
 #include "../Utils/Utilities.h"
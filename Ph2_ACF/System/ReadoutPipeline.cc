@@ -0,0 +1,169 @@
+/*
+
+        FileName :                    ReadoutPipeline.cc
+        Content :                     Asynchronous readout -> decoding -> consumer pipeline over all the boards
+
+ */
+
+#include "ReadoutPipeline.h"
+#include "../HWInterface/ReadoutWait.h"
+#include "../Utils/ConsoleColor.h"
+
+namespace Ph2_System {
+
+    ReadoutPipeline::ReadoutPipeline ( const std::vector<BeBoard*>& pBoards, const BeBoardFWMap& pBeBoardFWMap, uint32_t pDepth, uint32_t pNDecoders ) :
+        fBoards ( pBoards ),
+        fBeBoardFWMap ( pBeBoardFWMap ),
+        fNDecoders ( std::max ( pNDecoders, 1u ) ),
+        fRawQueue ( pDepth ),
+        fBatchQueue ( pDepth ),
+        fRunning ( false )
+    {
+    }
+
+    ReadoutPipeline::~ReadoutPipeline()
+    {
+        Stop();
+    }
+
+    void ReadoutPipeline::Start()
+    {
+        if ( fRunning || !fDecodeThreads.empty() ) return;
+
+        fRunning = true;
+        fRawQueue.reopen();
+        fBatchQueue.reopen();
+
+        for ( auto cBoard : fBoards )
+        {
+            auto cFWInterface = fBeBoardFWMap.find ( cBoard->getBeBoardIdentifier() );
+
+            if ( cFWInterface == std::end ( fBeBoardFWMap ) )
+            {
+                LOG (ERROR) << BOLDRED << "No FW interface for board " << +cBoard->getBeId() << ", it is not read by the pipeline" << RESET;
+                continue;
+            }
+
+            fReadoutThreads.emplace_back ( &ReadoutPipeline::readoutLoop, this, cBoard, cFWInterface->second );
+        }
+
+        for ( uint32_t cDecoder = 0; cDecoder < fNDecoders; cDecoder++ )
+            fDecodeThreads.emplace_back ( &ReadoutPipeline::decodeLoop, this );
+    }
+
+    void ReadoutPipeline::Stop()
+    {
+        StopReadout();
+        Drain();
+    }
+
+    void ReadoutPipeline::StopReadout()
+    {
+        fRunning = false;
+        // the consumer calling Stop() may not pop anymore: lift the capacity so that no readout thread stays blocked on a full ring
+        // and nothing read from the boards is dropped
+        fRawQueue.unbound();
+
+        // the readout threads push their last packet and leave, nobody talks to the FW interfaces afterwards
+        for ( auto& cThread : fReadoutThreads )
+            if ( cThread.joinable() ) cThread.join();
+
+        fReadoutThreads.clear();
+    }
+
+    void ReadoutPipeline::Drain()
+    {
+        fBatchQueue.unbound();
+        fRawQueue.close();
+
+        // the decoders drain the raw ring
+        for ( auto& cThread : fDecodeThreads )
+            if ( cThread.joinable() ) cThread.join();
+
+        fDecodeThreads.clear();
+
+        // every packet read is now decoded, GetNextBatch() returns them and then false
+        fBatchQueue.close();
+    }
+
+    bool ReadoutPipeline::GetNextBatch ( EventBatch& pBatch )
+    {
+        return fBatchQueue.pop ( pBatch );
+    }
+
+    PipelineStats ReadoutPipeline::getStats() const
+    {
+        std::lock_guard<std::mutex> cLock ( fStatsMutex );
+        PipelineStats cStats = fStats;
+        cStats.fRawQueue = fRawQueue.getStats();
+        cStats.fBatchQueue = fBatchQueue.getStats();
+        return cStats;
+    }
+
+    void ReadoutPipeline::readoutLoop ( BeBoard* pBoard, BeBoardFWInterface* pFWInterface )
+    {
+        uint64_t cSequence = 0;
+        ReadoutWaitPolicy cIdlePolicy;
+        std::unique_ptr<ReadoutWait> cWait;
+
+        while ( fRunning )
+        {
+            RawPacket cPacket;
+            cPacket.fBoard = pBoard;
+
+            // never block in ReadData, otherwise Stop() could wait forever for a trigger
+            auto cStart = std::chrono::steady_clock::now();
+            cPacket.fNEvents = pFWInterface->ReadData ( pBoard, false, cPacket.fData, false );
+            double cReadoutTime = std::chrono::duration<double> ( std::chrono::steady_clock::now() - cStart ).count();
+
+            if ( cPacket.fNEvents == 0 || cPacket.fData.empty() )
+            {
+                if ( !cWait ) cWait.reset ( new ReadoutWait ( cIdlePolicy ) );
+
+                cWait->wait();
+                continue;
+            }
+
+            cWait.reset();
+            cPacket.fSequence = cSequence++;
+
+            {
+                std::lock_guard<std::mutex> cLock ( fStatsMutex );
+                fStats.fNPackets++;
+                fStats.fNEventsRead += cPacket.fNEvents;
+                fStats.fReadoutTime += cReadoutTime;
+            }
+
+            if ( !fRawQueue.push ( std::move ( cPacket ) ) ) break;
+        }
+    }
+
+    void ReadoutPipeline::decodeLoop()
+    {
+        RawPacket cPacket;
+
+        while ( fRawQueue.pop ( cPacket ) )
+        {
+            auto cStart = std::chrono::steady_clock::now();
+
+            EventBatch cBatch;
+            cBatch.fBoard = cPacket.fBoard;
+            cBatch.fSequence = cPacket.fSequence;
+            cBatch.fData = std::make_shared<Data>();
+            // the decoders already run in parallel, ZS events are decoded on this thread
+            cBatch.fData->setNThreads ( 1 );
+            // already on a worker thread, so decode synchronously instead of through Data::Set
+            cBatch.fData->privateSet ( cPacket.fBoard, cPacket.fData, cPacket.fNEvents, cPacket.fBoard->getBoardType() );
+            cBatch.fRawData = std::move ( cPacket.fData );
+            uint64_t cNEvents = cBatch.GetEvents().size();
+
+            {
+                std::lock_guard<std::mutex> cLock ( fStatsMutex );
+                fStats.fNEventsDecoded += cNEvents;
+                fStats.fDecodeTime += std::chrono::duration<double> ( std::chrono::steady_clock::now() - cStart ).count();
+            }
+
+            if ( !fBatchQueue.push ( std::move ( cBatch ) ) ) break;
+        }
+    }
+}
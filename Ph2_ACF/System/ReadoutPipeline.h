@@ -0,0 +1,136 @@
+/*!
+
+        \file                    ReadoutPipeline.h
+        \brief                   Asynchronous readout -> decoding -> consumer pipeline over all the boards
+
+*/
+
+#ifndef __READOUTPIPELINE_H__
+#define __READOUTPIPELINE_H__
+
+#include "../HWInterface/BeBoardInterface.h"
+#include "../HWInterface/BeBoardFWInterface.h"
+#include "../HWDescription/BeBoard.h"
+#include "../Utils/Data.h"
+#include "../Utils/BoundedQueue.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Ph2_HwDescription;
+using namespace Ph2_HwInterface;
+
+namespace Ph2_System {
+
+    /*!
+     * \struct RawPacket
+     * \brief Words read from one board in one ReadData call
+     */
+    struct RawPacket
+    {
+        BeBoard* fBoard = nullptr;
+        uint64_t fSequence = 0;         /*!< packet number on this board*/
+        uint32_t fNEvents = 0;
+        std::vector<uint32_t> fData;
+    };
+
+    /*!
+     * \struct EventBatch
+     * \brief Decoded events of one RawPacket
+     */
+    struct EventBatch
+    {
+        BeBoard* fBoard = nullptr;
+        uint64_t fSequence = 0;         /*!< packet number on this board, batches of a board can come out of order with several decoders*/
+        std::vector<uint32_t> fRawData;
+        std::shared_ptr<Data> fData;
+
+        const std::vector<Event*>& GetEvents() const
+        {
+            return fData->GetEvents ( fBoard );
+        }
+    };
+
+    /*!
+     * \struct PipelineStats
+     * \brief Queue levels and throughput of the pipeline, to see which stage saturates
+     */
+    struct PipelineStats
+    {
+        QueueStats fRawQueue;           /*!< readout threads -> decoders*/
+        QueueStats fBatchQueue;         /*!< decoders -> consumers*/
+        uint64_t fNPackets = 0;
+        uint64_t fNEventsRead = 0;
+        uint64_t fNEventsDecoded = 0;
+        double fReadoutTime = 0;        /*!< seconds spent in ReadData, summed over the readout threads*/
+        double fDecodeTime = 0;         /*!< seconds spent decoding, summed over the decoders*/
+    };
+
+    /*!
+     * \class ReadoutPipeline
+     * \brief One readout thread per BeBoard feeds a bounded ring of raw packets, a pool of decoders turns them into EventBatch objects for the consumers
+     *
+     * A full ring blocks the stage in front of it, so a slow consumer throttles the decoding and then the readout.
+     */
+    class ReadoutPipeline
+    {
+      public:
+        /*!
+         * \brief Constructor of the ReadoutPipeline class
+         * \param pBoards : the boards to read
+         * \param pBeBoardFWMap : FW interfaces of the boards, each readout thread only talks to its own
+         * \param pDepth : capacity of the raw packet and of the decoded batch rings
+         * \param pNDecoders : number of decoding threads
+         */
+        ReadoutPipeline ( const std::vector<BeBoard*>& pBoards, const BeBoardFWMap& pBeBoardFWMap, uint32_t pDepth = 16, uint32_t pNDecoders = 2 );
+        ~ReadoutPipeline();
+
+        /*!
+         * \brief Launch the readout and decoding threads, the boards have to be started separately
+         */
+        void Start();
+        /*!
+         * \brief Stop reading, the packets already read are decoded before returning and can still be fetched with GetNextBatch()
+         */
+        void Stop();
+        /*!
+         * \brief First half of Stop(): stop and join the readout threads, the FW interfaces are free for the caller afterwards
+         */
+        void StopReadout();
+        /*!
+         * \brief Second half of Stop(): decode the packets left in the raw ring and close the batch ring
+         */
+        void Drain();
+        /*!
+         * \brief Get the next decoded batch, waits until one is available
+         * \param pBatch : the batch
+         * \return false once the pipeline is stopped and drained
+         */
+        bool GetNextBatch ( EventBatch& pBatch );
+        /*!
+         * \brief Snapshot of the queue levels and counters
+         */
+        PipelineStats getStats() const;
+
+      private:
+        void readoutLoop ( BeBoard* pBoard, BeBoardFWInterface* pFWInterface );
+        void decodeLoop();
+
+        std::vector<BeBoard*> fBoards;
+        BeBoardFWMap fBeBoardFWMap;
+        uint32_t fNDecoders;
+
+        BoundedQueue<RawPacket> fRawQueue;
+        BoundedQueue<EventBatch> fBatchQueue;
+
+        std::vector<std::thread> fReadoutThreads;
+        std::vector<std::thread> fDecodeThreads;
+        std::atomic<bool> fRunning;
+
+        mutable std::mutex fStatsMutex;
+        PipelineStats fStats;
+    };
+}
+
+#endif
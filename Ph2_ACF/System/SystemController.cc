@@ -10,6 +10,7 @@
  */
 
 #include "SystemController.h"
+#include <chrono>
 
 using namespace Ph2_HwDescription;
 using namespace Ph2_HwInterface;
@@ -22,14 +23,19 @@ namespace Ph2_System {
         fBoardVector(),
         fSettingsMap(),
         fFileHandler (nullptr),
+        fRawFileReader (nullptr),
         fRawFileName (""),
         fWriteHandlerEnabled (false),
-        fData (nullptr)
+        fData (nullptr),
+        fPipeline (nullptr),
+        fWorkerPool (nullptr)
     {
     }
 
     SystemController::~SystemController()
     {
+        // the pool is never shared by Inherit, so it can go even if Destroy() is left to another controller
+        if (fWorkerPool) delete fWorkerPool;
     }
 
     void SystemController::Inherit (SystemController* pController)
@@ -40,10 +46,24 @@ namespace Ph2_System {
         fBeBoardFWMap = pController->fBeBoardFWMap;
         fSettingsMap = pController->fSettingsMap;
         fFileHandler = pController->fFileHandler;
+        fRawFileReader = pController->fRawFileReader;
     }
 
     void SystemController::Destroy()
     {
+        if (fPipeline)
+        {
+            fPipeline->Stop();
+            delete fPipeline;
+            fPipeline = nullptr;
+        }
+
+        if (fWorkerPool)
+        {
+            delete fWorkerPool;
+            fWorkerPool = nullptr;
+        }
+
         if (fFileHandler)
         {
             if (fFileHandler->file_open() ) fFileHandler->closeFile();
@@ -51,6 +71,12 @@ namespace Ph2_System {
             if (fFileHandler) delete fFileHandler;
         }
 
+        if (fRawFileReader)
+        {
+            delete fRawFileReader;
+            fRawFileReader = nullptr;
+        }
+
         if (fBeBoardInterface) delete fBeBoardInterface;
 
         if (fCbcInterface) delete fCbcInterface;
@@ -63,16 +89,27 @@ namespace Ph2_System {
 
         fBoardVector.clear();
 
-        if (fData) delete fData;
+        for ( auto& cData : fBoardData )
+        {
+            cData.second->Wait();
+            delete cData.second;
+        }
+
+        fBoardData.clear();
+        fData = nullptr;
     }
 
-    void SystemController::addFileHandler ( const std::string& pFilename, char pOption )
+    void SystemController::addFileHandler ( const std::string& pFilename, char pOption, bool pUseIndexCache )
     {
         //if the opion is read, create a handler object and use it to read the
         //file in the method below!
 
         if (pOption == 'r')
+        {
             fFileHandler = new FileHandler ( pFilename, pOption );
+            // the data directories are often shared or archived, the index is only written there on request
+            fRawFileReader = new RawFileReader ( pFilename, pUseIndexCache );
+        }
         //if the option is w, remember the filename and construct a new
         //fileHandler for every Interface
         else if (pOption == 'w')
@@ -93,6 +130,12 @@ namespace Ph2_System {
 
             fFileHandler = nullptr;
         }
+
+        if (fRawFileReader)
+        {
+            delete fRawFileReader;
+            fRawFileReader = nullptr;
+        }
     }
 
     void SystemController::readFile ( std::vector<uint32_t>& pVec, uint32_t pNWords32 )
@@ -101,12 +144,32 @@ namespace Ph2_System {
         else pVec = fFileHandler->readFileChunks (pNWords32);
     }
 
-    void SystemController::setData (BeBoard* pBoard, std::vector<uint32_t>& pData, uint32_t pNEvents)
+    uint32_t SystemController::readEvents ( std::vector<uint32_t>& pVec, uint32_t pNEvents )
     {
-        //reset the data object
-        if (fData) delete fData;
+        if (fRawFileReader == nullptr)
+        {
+            pVec.clear();
+            return 0;
+        }
+
+        return fRawFileReader->readEvents (pVec, pNEvents);
+    }
+
+    Data* SystemController::getBoardData (const BeBoard* pBoard)
+    {
+        Data*& cData = fBoardData[pBoard];
+
+        if (cData == nullptr) cData = new Data();
+
+        return cData;
+    }
 
-        fData = new Data();
+    void SystemController::setData (BeBoard* pBoard, std::vector<uint32_t>& pData, uint32_t pNEvents)
+    {
+        //reset the data object, the events of the previous acquisition on this board are recycled
+        fData = this->getBoardData (pBoard);
+        fData->Wait();
+        fData->Reset();
 
         //pass data by reference to set and let it know what board we are dealing with
         fData->Set (pBoard, pData, pNEvents, pBoard->getBoardType () );
@@ -134,7 +197,7 @@ namespace Ph2_System {
 
     void SystemController::ConfigureHw ( bool bIgnoreI2c )
     {
-        LOG (INFO) << BOLDBLUE << "Configuring HW parsed from .xml file: " << RESET;
+        LOG (INFO) << BOLDBLUE << "Configuring HW parsed from .xml file, all boards in parallel: " << RESET;
 
         bool cHoleMode = false;
         bool cCheck = false;
@@ -150,49 +213,85 @@ namespace Ph2_System {
         }
         else cCheck = false;
 
-        for (auto& cBoard : fBoardVector)
+        // how to wait for data during the readout, the defaults of ReadoutWaitPolicy apply to what is not in the settings
+        ReadoutWaitPolicy cWaitPolicy;
+        auto cWaitMode = fSettingsMap.find ( "ReadoutWaitMode" );
+        auto cSpinTime = fSettingsMap.find ( "ReadoutSpinTime" );
+        auto cMinSleep = fSettingsMap.find ( "ReadoutMinSleep" );
+        auto cMaxSleep = fSettingsMap.find ( "ReadoutMaxSleep" );
+
+        if ( cWaitMode != fSettingsMap.end() ) cWaitPolicy.fMode = ( cWaitMode->second == 0 ) ? WaitMode::Fixed : WaitMode::Adaptive;
+
+        if ( cSpinTime != fSettingsMap.end() ) cWaitPolicy.fSpinTime = cSpinTime->second;
+
+        if ( cMinSleep != fSettingsMap.end() ) cWaitPolicy.fMinSleep = cMinSleep->second;
+
+        if ( cMaxSleep != fSettingsMap.end() ) cWaitPolicy.fMaxSleep = cMaxSleep->second;
+
+        // every board is configured by its own worker with interfaces that only know this board
+        this->RunOnAllBoards ("Configure", [&] (BoardContext & pContext)
         {
-            //fBeBoardInterface->CbcHardReset ( cBoard );
-            fBeBoardInterface->ConfigureBoard ( cBoard );
-            //fBeBoardInterface->CbcFastReset ( cBoard );
+            BeBoard* cBoard = pContext.fBoard;
+            //pContext.fBeBoardInterface->CbcHardReset ( cBoard );
+            pContext.fBeBoardInterface->setReadoutWaitPolicy ( cBoard, cWaitPolicy );
+            pContext.fBeBoardInterface->ConfigureBoard ( cBoard );
+
+            //pContext.fBeBoardInterface->CbcFastReset ( cBoard );
             if ( cCheck && cBoard->getBoardType() == BoardType::GLIB)
             {
-                fBeBoardInterface->WriteBoardReg ( cBoard, "pc_commands2.negative_logic_CBC", ( ( cHoleMode ) ? 0 : 1 ) );
+                pContext.fBeBoardInterface->WriteBoardReg ( cBoard, "pc_commands2.negative_logic_CBC", ( ( cHoleMode ) ? 0 : 1 ) );
                 LOG (INFO) << GREEN << "Overriding GLIB register values for signal polarity with value from settings node!" << RESET;
             }
 
             LOG (INFO) << GREEN << "Successfully configured Board " << int ( cBoard->getBeId() ) << RESET;
 
-            for (auto& cFe : cBoard->fModuleVector)
+            if ( !bIgnoreI2c )
+                this->configureChips ( pContext, RegWriteMode::FULL );
+
+            //CbcFastReset as per recommendation of Mark Raymond
+            pContext.fBeBoardInterface->CbcFastReset ( cBoard );
+        } );
+    }
+
+    void SystemController::ConfigureChips ( RegWriteMode pMode )
+    {
+        LOG (INFO) << BOLDBLUE << "Configuring the chips, all boards in parallel" << ( ( pMode == RegWriteMode::DELTA_ONLY ) ? ", changed registers only: " : ": " ) << RESET;
+
+        this->RunOnAllBoards ("ConfigureChips", [&] (BoardContext & pContext)
+        {
+            this->configureChips ( pContext, pMode );
+        } );
+    }
+
+    void SystemController::configureChips ( BoardContext& pContext, RegWriteMode pMode )
+    {
+        uint32_t cSaved = pContext.fCbcInterface->getI2CWordsSaved() + pContext.fMPAInterface->getI2CWordsSaved() + pContext.fSSAInterface->getI2CWordsSaved();
+
+        for (auto& cFe : pContext.fBoard->fModuleVector)
+        {
+            for (auto& cCbc : cFe->fCbcVector)
             {
-                for (auto& cCbc : cFe->fCbcVector)
-                {
-                    if ( !bIgnoreI2c )
-                    {
-                        fCbcInterface->ConfigureCbc ( cCbc );
-                        LOG (INFO) << GREEN <<  "Successfully configured Cbc " << int ( cCbc->getCbcId() ) << RESET;
-                    }
-                }
-                for (auto& cMPA : cFe->fMPAVector)
-                {
-                    if ( !bIgnoreI2c )
-                    {
-                        fMPAInterface->ConfigureMPA ( cMPA );
-                        LOG (INFO) << GREEN <<  "Successfully configured MPA " << int ( cMPA->getMPAId() ) << RESET;
-                    }
-                }
-                for (auto& cSSA : cFe->fSSAVector)
-                {
-                    if ( !bIgnoreI2c )
-                    {
-                        fSSAInterface->ConfigureSSA ( cSSA );
-                        LOG (INFO) << GREEN <<  "Successfully configured SSA " << int ( cSSA->getSSAId() ) << RESET;
-                    }
-                }
+                pContext.fCbcInterface->ConfigureCbc ( cCbc, true, 310, pMode );
+                LOG (INFO) << GREEN <<  "Successfully configured Cbc " << int ( cCbc->getCbcId() ) << RESET;
             }
 
-            //CbcFastReset as per recommendation of Mark Raymond
-            fBeBoardInterface->CbcFastReset ( cBoard );
+            for (auto& cMPA : cFe->fMPAVector)
+            {
+                pContext.fMPAInterface->ConfigureMPA ( cMPA, true, pMode );
+                LOG (INFO) << GREEN <<  "Successfully configured MPA " << int ( cMPA->getMPAId() ) << RESET;
+            }
+
+            for (auto& cSSA : cFe->fSSAVector)
+            {
+                pContext.fSSAInterface->ConfigureSSA ( cSSA, true, pMode );
+                LOG (INFO) << GREEN <<  "Successfully configured SSA " << int ( cSSA->getSSAId() ) << RESET;
+            }
+        }
+
+        if ( pMode == RegWriteMode::DELTA_ONLY )
+        {
+            cSaved = pContext.fCbcInterface->getI2CWordsSaved() + pContext.fMPAInterface->getI2CWordsSaved() + pContext.fSSAInterface->getI2CWordsSaved() - cSaved;
+            LOG (INFO) << GREEN << "Board " << int ( pContext.fBoard->getBeId() ) << ": " << cSaved << " register writes skipped, the chips already held the values" << RESET;
         }
     }
 
@@ -310,23 +409,31 @@ namespace Ph2_System {
 
     void SystemController::Start()
     {
-        for (auto& cBoard : fBoardVector)
-            fBeBoardInterface->Start (cBoard);
+        this->RunOnAllBoards ("Start", [] (BoardContext & pContext)
+        {
+            pContext.fBeBoardInterface->Start (pContext.fBoard);
+        } );
     }
     void SystemController::Stop()
     {
-        for (auto& cBoard : fBoardVector)
-            fBeBoardInterface->Stop (cBoard);
+        this->RunOnAllBoards ("Stop", [] (BoardContext & pContext)
+        {
+            pContext.fBeBoardInterface->Stop (pContext.fBoard);
+        } );
     }
     void SystemController::Pause()
     {
-        for (auto& cBoard : fBoardVector)
-            fBeBoardInterface->Pause (cBoard);
+        this->RunOnAllBoards ("Pause", [] (BoardContext & pContext)
+        {
+            pContext.fBeBoardInterface->Pause (pContext.fBoard);
+        } );
     }
     void SystemController::Resume()
     {
-        for (auto& cBoard : fBoardVector)
-            fBeBoardInterface->Resume (cBoard);
+        this->RunOnAllBoards ("Resume", [] (BoardContext & pContext)
+        {
+            pContext.fBeBoardInterface->Resume (pContext.fBoard);
+        } );
     }
 
     void SystemController::Start (BeBoard* pBoard)
@@ -368,10 +475,10 @@ namespace Ph2_System {
     // for OTSDAQ
     uint32_t SystemController::ReadData (BeBoard* pBoard, std::vector<uint32_t>& pData, bool pWait)
     {
-        //reset the data object
-        if (fData) delete fData;
-
-        fData = new Data();
+        //reset the data object, the events of the previous acquisition on this board are recycled
+        fData = this->getBoardData (pBoard);
+        fData->Wait();
+        fData->Reset();
 
         //read the data and get it by reference
         uint32_t cNPackets = fBeBoardInterface->ReadData (pBoard, false, pData, pWait);
@@ -383,8 +490,80 @@ namespace Ph2_System {
 
     void SystemController::ReadData (bool pWait)
     {
+        //the workers must not insert into fBoardData
         for (auto cBoard : fBoardVector)
-            this->ReadData (cBoard, pWait);
+            this->getBoardData (cBoard);
+
+        this->RunOnAllBoards ("ReadData", [&] (BoardContext & pContext)
+        {
+            std::vector<uint32_t> cData;
+            uint32_t cNPackets = pContext.fBeBoardInterface->ReadData (pContext.fBoard, false, cData, pWait);
+            this->decodeOnWorker (pContext, cData, cNPackets);
+        } );
+
+        if (!fBoardVector.empty() ) fData = this->getBoardData (fBoardVector.back() );
+    }
+
+    uint32_t SystemController::readUntil (BeBoardInterface* pInterface, BeBoard* pBoard, uint32_t pNEvents, std::vector<uint32_t>& pData, uint32_t pTimeout)
+    {
+        uint32_t cNEvents = 0;
+        std::vector<uint32_t> cPacket;
+        pData.clear();
+
+        pInterface->Start (pBoard);
+        auto cLastEvent = std::chrono::steady_clock::now();
+
+        while (cNEvents < pNEvents)
+        {
+            uint32_t cNPackets = pInterface->ReadData (pBoard, false, cPacket, true);
+
+            if (cNPackets == 0 || cPacket.empty() )
+            {
+                LOG (INFO) << BOLDRED << "..... Read back 0 events from board " << +pBoard->getBeId() << "!! Why?!" << RESET ;
+
+                if (std::chrono::steady_clock::now() - cLastEvent >= std::chrono::milliseconds (pTimeout) )
+                {
+                    LOG (ERROR) << BOLDRED << "Error: no event from board " << +pBoard->getBeId() << " for " << pTimeout << " ms, stopping with " << cNEvents << " events whereas " << pNEvents << " are expected!" << RESET;
+                    break;
+                }
+
+                continue;
+            }
+
+            pData.insert (pData.end(), cPacket.begin(), cPacket.end() );
+            cNEvents += cNPackets;
+            cLastEvent = std::chrono::steady_clock::now();
+        }
+
+        pInterface->Stop (pBoard);
+        return cNEvents;
+    }
+
+    uint32_t SystemController::ReadDataUntil (BeBoard* pBoard, uint32_t pNEvents, uint32_t pTimeout)
+    {
+        fData = this->getBoardData (pBoard);
+        fData->Wait();
+        fData->Reset();
+
+        std::vector<uint32_t> cData;
+        uint32_t cNEvents = this->readUntil (fBeBoardInterface, pBoard, pNEvents, cData, pTimeout);
+        fData->Set (pBoard, cData, cNEvents, fBeBoardInterface->getBoardType (pBoard) );
+        return cNEvents;
+    }
+
+    void SystemController::ReadDataUntil (uint32_t pNEvents, uint32_t pTimeout)
+    {
+        for (auto cBoard : fBoardVector)
+            this->getBoardData (cBoard);
+
+        this->RunOnAllBoards ("ReadDataUntil", [&] (BoardContext & pContext)
+        {
+            std::vector<uint32_t> cData;
+            uint32_t cNEvents = this->readUntil (pContext.fBeBoardInterface.get(), pContext.fBoard, pNEvents, cData, pTimeout);
+            this->decodeOnWorker (pContext, cData, cNEvents);
+        } );
+
+        if (!fBoardVector.empty() ) fData = this->getBoardData (fBoardVector.back() );
     }
 
     //standalone
@@ -397,10 +576,10 @@ namespace Ph2_System {
     //for OTSDAQ
     void SystemController::ReadNEvents (BeBoard* pBoard, uint32_t pNEvents, std::vector<uint32_t>& pData, bool pWait)
     {
-        //reset the data object
-        if (fData) delete fData;
-
-        fData = new Data();
+        //reset the data object, the events of the previous acquisition on this board are recycled
+        fData = this->getBoardData (pBoard);
+        fData->Wait();
+        fData->Reset();
         //read the data and get it by reference
         fBeBoardInterface->ReadNEvents (pBoard, pNEvents, pData, pWait);
         //pass data by reference to set and let it know what board we are dealing with
@@ -411,6 +590,92 @@ namespace Ph2_System {
     void SystemController::ReadNEvents (uint32_t pNEvents)
     {
         for (auto cBoard : fBoardVector)
-            this->ReadNEvents (cBoard, pNEvents);
+            this->getBoardData (cBoard);
+
+        this->RunOnAllBoards ("ReadNEvents", [&] (BoardContext & pContext)
+        {
+            std::vector<uint32_t> cData;
+            pContext.fBeBoardInterface->ReadNEvents (pContext.fBoard, pNEvents, cData, true);
+            this->decodeOnWorker (pContext, cData, pNEvents);
+        } );
+
+        if (!fBoardVector.empty() ) fData = this->getBoardData (fBoardVector.back() );
+    }
+
+    void SystemController::decodeOnWorker (BoardContext& pContext, const std::vector<uint32_t>& pData, uint32_t pNEvents)
+    {
+        auto cStart = std::chrono::steady_clock::now();
+        Data* cData = fBoardData.at (pContext.fBoard);
+        cData->Wait();
+        cData->Reset();
+
+        if (!pData.empty() && pNEvents != 0)
+            cData->privateSet (pContext.fBoard, pData, pNEvents, pContext.fBoard->getBoardType() );
+
+        pContext.addTime ("Decode", std::chrono::duration<double> (std::chrono::steady_clock::now() - cStart).count() );
+    }
+
+    void SystemController::RunOnAllBoards (const std::string& pStage, const BoardTask& pTask)
+    {
+        if (fWorkerPool == nullptr) fWorkerPool = new BoardWorkerPool (fBoardVector, fBeBoardFWMap);
+
+        fWorkerPool->run (pStage, pTask);
+    }
+
+    BoardTiming SystemController::getBoardTiming (const BeBoard* pBoard) const
+    {
+        return (fWorkerPool) ? fWorkerPool->getTiming (pBoard) : BoardTiming();
+    }
+
+    void SystemController::printBoardTiming (std::ostream& os) const
+    {
+        if (fWorkerPool) fWorkerPool->printTiming (os);
+    }
+
+    void SystemController::resetBoardTiming()
+    {
+        if (fWorkerPool) fWorkerPool->resetTiming();
+    }
+
+    void SystemController::StartPipeline (uint32_t pDepth, uint32_t pNDecoders)
+    {
+        if (pDepth == 0)
+        {
+            auto cSetting = fSettingsMap.find ("PipelineDepth");
+            pDepth = (cSetting != std::end (fSettingsMap) ) ? cSetting->second : 16;
+        }
+
+        if (pNDecoders == 0)
+        {
+            auto cSetting = fSettingsMap.find ("PipelineDecoders");
+            pNDecoders = (cSetting != std::end (fSettingsMap) ) ? cSetting->second : 2;
+        }
+
+        if (fPipeline) delete fPipeline;
+
+        fPipeline = new ReadoutPipeline (fBoardVector, fBeBoardFWMap, pDepth, pNDecoders);
+
+        this->Start();
+        fPipeline->Start();
+    }
+
+    void SystemController::StopPipeline()
+    {
+        // the readout threads use the same FW interfaces as the board stop, they have to be gone first
+        if (fPipeline) fPipeline->StopReadout();
+
+        this->Stop();
+
+        if (fPipeline) fPipeline->Drain();
+    }
+
+    bool SystemController::GetNextBatch (EventBatch& pBatch)
+    {
+        return (fPipeline) ? fPipeline->GetNextBatch (pBatch) : false;
+    }
+
+    PipelineStats SystemController::getPipelineStats() const
+    {
+        return (fPipeline) ? fPipeline->getStats() : PipelineStats();
     }
 }
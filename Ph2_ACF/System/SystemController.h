@@ -14,6 +14,8 @@
 #define __SYSTEMCONTROLLER_H__
 
 #include "FileParser.h"
+#include "ReadoutPipeline.h"
+#include "BoardWorkerPool.h"
 #include "../HWInterface/CbcInterface.h"
 #include "../HWInterface/MPAlightInterface.h"
 #include "../HWInterface/SSAInterface.h"
@@ -31,6 +33,7 @@
 #include "../Utils/Data.h"
 #include "../Utils/Utilities.h"
 #include "../Utils/FileHandler.h"
+#include "../Utils/RawFileReader.h"
 #include "../Utils/ConsoleColor.h"
 #include "../Utils/easylogging++.h"
 #include <iostream>
@@ -69,13 +72,46 @@ namespace Ph2_System {
         SettingsMap             fSettingsMap;                          /*!< Maps the settings */
         //for reading single files
         FileHandler*            fFileHandler;
+        //indexed access to the same file, for playback
+        RawFileReader*          fRawFileReader;
         //for writing 1 file for each FED
         std::string             fRawFileName;
         bool                    fWriteHandlerEnabled;
 
+        static const uint32_t READ_UNTIL_TIMEOUT = 10000;              /*!< ms without a new event before ReadDataUntil gives up */
+
       private:
         FileParser fParser;
-        Data* fData;
+        Data* fData;                                                   /*!< Data of the last acquisition, owned by fBoardData */
+        std::map<const BeBoard*, Data*> fBoardData;                     /*!< Data per board, reused across acquisitions */
+        ReadoutPipeline* fPipeline;
+        BoardWorkerPool* fWorkerPool;
+
+        /*!
+         * \brief Data object of pBoard, created on first use; not thread safe, the parallel methods create them all before dispatching
+         */
+        Data* getBoardData (const BeBoard* pBoard);
+        /*!
+         * \brief Data to serve events of pBoard from: the board's own if it was read, else the last acquisition
+         */
+        Data* getData (const BeBoard* pBoard) const
+        {
+            auto cData = fBoardData.find (pBoard);
+            return (cData != std::end (fBoardData) ) ? cData->second : fData;
+        }
+        /*!
+         * \brief Decode pData of one board synchronously, used from the workers where Data::Set() would only add another thread
+         */
+        void decodeOnWorker (BoardContext& pContext, const std::vector<uint32_t>& pData, uint32_t pNEvents);
+        /*!
+         * \brief Start pBoard, call ReadData until at least pNEvents arrived or none came for pTimeout ms, and stop it
+         * \return the number of events in pData
+         */
+        uint32_t readUntil (BeBoardInterface* pInterface, BeBoard* pBoard, uint32_t pNEvents, std::vector<uint32_t>& pData, uint32_t pTimeout);
+        /*!
+         * \brief Write the register maps of the Cbcs, MPAs and SSAs of the board of pContext, from its worker
+         */
+        void configureChips (BoardContext& pContext, RegWriteMode pMode);
 
       public:
         /*!
@@ -98,8 +134,9 @@ namespace Ph2_System {
         /*!
         * \brief create a FileHandler object with
          * \param pFilename : the filename of the binary file
+         * \param pUseIndexCache : in read mode, keep the event index in <file>.idx next to the data, for playback tools reopening the same file
         */
-        void addFileHandler ( const std::string& pFilename, char pOption );
+        void addFileHandler ( const std::string& pFilename, char pOption, bool pUseIndexCache = false );
         void closeFileHandler();
 
         FileHandler* getFileHandler()
@@ -122,6 +159,12 @@ namespace Ph2_System {
         */
         void readFile ( std::vector<uint32_t>& pVec, uint32_t pNWords32 = 0 );
         /*!
+        * \brief read the next pNEvents whole events from the file opened with addFileHandler, works for variable size (zero suppressed) events
+         * \param pVec : the data vector
+         * \return the number of events read, 0 at the end of the file
+        */
+        uint32_t readEvents ( std::vector<uint32_t>& pVec, uint32_t pNEvents );
+        /*!
         * \brief set the Data read from file in the previous Method to the interanl data object
          * \param pVec : the data vector
          * \param pBoard : the BeBoard
@@ -156,6 +199,11 @@ namespace Ph2_System {
          * \brief Configure the Hardware with XML file indicated values
          */
         void ConfigureHw ( bool bIgnoreI2c = false );
+        /*!
+         * \brief Write the register maps of all the chips again, without touching the boards
+         * \param pMode : RegWriteMode::DELTA_ONLY only writes what the chips do not hold already, e.g. after loading other register files between scans
+         */
+        void ConfigureChips ( RegWriteMode pMode = RegWriteMode::DELTA_ONLY );
         /*!
          * \brief Run a DAQ
          * \param pBeBoard
@@ -178,9 +226,23 @@ namespace Ph2_System {
         uint32_t ReadData (BeBoard* pBoard, std::vector<uint32_t>& pData, bool pWait = true);
 
         /*!
-         * \brief Read Data from all boards
+         * \brief Read Data from all boards, in parallel
          */
         void ReadData (bool pWait = true);
+        /*!
+         * \brief Start pBoard, read until at least pNEvents were received, stop it and decode everything at once
+         * \param pBeBoard
+         * \param pNEvents
+         * \param pTimeout : ms without a new event before giving up with what was read
+         * \return: number of events read
+         */
+        uint32_t ReadDataUntil (BeBoard* pBoard, uint32_t pNEvents, uint32_t pTimeout = READ_UNTIL_TIMEOUT);
+        /*!
+         * \brief Start, read at least pNEvents and stop on all boards, in parallel
+         * \param pNEvents
+         * \param pTimeout : ms without a new event before a board gives up with what it read
+         */
+        void ReadDataUntil (uint32_t pNEvents, uint32_t pTimeout = READ_UNTIL_TIMEOUT);
 
         void Start();
         void Stop();
@@ -210,11 +272,48 @@ namespace Ph2_System {
         void ReadNEvents (BeBoard* pBoard, uint32_t pNEvents, std::vector<uint32_t>& pData, bool pWait = true);
 
         /*!
-         * \brief Read N Events from all boards
+         * \brief Read N Events from all boards, in parallel
          * \param pNEvents
          */
         void ReadNEvents (uint32_t pNEvents);
 
+        /*!
+         * \brief Run pTask on every board in parallel, one worker per board, and wait until all are done
+         * \param pStage: name the time is booked under in the per board timing
+         * \param pTask: the task, it must only use the interfaces of the BoardContext it gets
+         */
+        void RunOnAllBoards (const std::string& pStage, const BoardTask& pTask);
+        /*!
+         * \brief Time spent per stage by pBoard in RunOnAllBoards
+         */
+        BoardTiming getBoardTiming (const BeBoard* pBoard) const;
+        /*!
+         * \brief Print the per board timing breakdown
+         */
+        void printBoardTiming (std::ostream& os = std::cout) const;
+        void resetBoardTiming();
+
+        /*!
+         * \brief Start all boards and read them asynchronously: one readout thread per board, decoding on a pool of threads
+         * \param pDepth: capacity of the raw and decoded rings, default from the PipelineDepth setting or 16
+         * \param pNDecoders: number of decoding threads, default from the PipelineDecoders setting or 2
+         */
+        void StartPipeline (uint32_t pDepth = 0, uint32_t pNDecoders = 0);
+        /*!
+         * \brief Stop all boards and the pipeline
+         */
+        void StopPipeline();
+        /*!
+         * \brief Get the next decoded batch of events from the pipeline, waits until one is available
+         * \param pBatch: the batch
+         * \return false if the pipeline is not running or stopped and drained
+         */
+        bool GetNextBatch (EventBatch& pBatch);
+        /*!
+         * \brief Queue levels and throughput of the pipeline
+         */
+        PipelineStats getPipelineStats() const;
+
         const BeBoard* getBoard (int index) const
         {
             return (index < (int) fBoardVector.size() ) ? fBoardVector.at (index) : nullptr;
@@ -226,15 +325,15 @@ namespace Ph2_System {
          */
         const Event* GetNextEvent ( const BeBoard* pBoard )
         {
-            return fData->GetNextEvent ( pBoard );
+            return getData ( pBoard )->GetNextEvent ( pBoard );
         }
         const Event* GetEvent ( const BeBoard* pBoard, int i ) const
         {
-            return fData->GetEvent ( pBoard, i );
+            return getData ( pBoard )->GetEvent ( pBoard, i );
         }
         const std::vector<Event*>& GetEvents ( const BeBoard* pBoard ) const
         {
-            return fData->GetEvents ( pBoard );
+            return getData ( pBoard )->GetEvents ( pBoard );
         }
     };
 }
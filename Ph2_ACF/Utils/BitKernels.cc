@@ -0,0 +1,466 @@
+/*
+
+    FileName :                     BitKernels.cc
+    Content :                      Vectorized bit manipulation for the CBC channel data
+
+ */
+
+#include "BitKernels.h"
+#include <immintrin.h>
+#include <algorithm>
+
+namespace {
+
+    enum class ISA {Scalar, SSSE3, AVX2};
+
+    ISA isa()
+    {
+        static const ISA cISA = [] ()
+        {
+            __builtin_cpu_init();
+
+            if ( __builtin_cpu_supports ( "avx2" ) ) return ISA::AVX2;
+
+            if ( __builtin_cpu_supports ( "ssse3" ) ) return ISA::SSSE3;
+
+            return ISA::Scalar;
+        } ();
+        return cISA;
+    }
+
+    bool hasBMI2()
+    {
+        static const bool cBMI2 = [] ()
+        {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports ( "bmi2" );
+        } ();
+        return cBMI2;
+    }
+
+    // spread the 32 bits of x to the even bits of a 64 bit word
+    inline uint64_t spreadBits ( uint32_t x )
+    {
+        uint64_t n = x;
+        n = ( n | ( n << 16 ) ) & 0x0000FFFF0000FFFFULL;
+        n = ( n | ( n << 8 ) ) & 0x00FF00FF00FF00FFULL;
+        n = ( n | ( n << 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+        n = ( n | ( n << 2 ) ) & 0x3333333333333333ULL;
+        n = ( n | ( n << 1 ) ) & 0x5555555555555555ULL;
+        return n;
+    }
+
+    void interleaveBitsScalar ( const uint32_t* pEvenBits, const uint32_t* pOddBits, uint64_t* pOut, size_t pNWords )
+    {
+        for ( size_t i = 0; i < pNWords; i++ )
+            pOut[i] = spreadBits ( pEvenBits[i] ) | ( spreadBits ( pOddBits[i] ) << 1 );
+    }
+
+    // one PDEP per word and parity instead of the five shift and mask steps; PDEP is microcoded and slow on AMD before Zen 3
+    __attribute__ ( ( target ( "bmi2" ) ) )
+    void interleaveBitsBMI2 ( const uint32_t* pEvenBits, const uint32_t* pOddBits, uint64_t* pOut, size_t pNWords )
+    {
+        for ( size_t i = 0; i < pNWords; i++ )
+            pOut[i] = _pdep_u64 ( pEvenBits[i], 0x5555555555555555ULL ) | _pdep_u64 ( pOddBits[i], 0xAAAAAAAAAAAAAAAAULL );
+    }
+
+    // gather the even bits of a 64 bit word, the inverse of spreadBits
+    inline uint32_t compactBits ( uint64_t n )
+    {
+        n &= 0x5555555555555555ULL;
+        n = ( n | ( n >> 1 ) ) & 0x3333333333333333ULL;
+        n = ( n | ( n >> 2 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+        n = ( n | ( n >> 4 ) ) & 0x00FF00FF00FF00FFULL;
+        n = ( n | ( n >> 8 ) ) & 0x0000FFFF0000FFFFULL;
+        n = ( n | ( n >> 16 ) ) & 0x00000000FFFFFFFFULL;
+        return uint32_t ( n );
+    }
+
+    void deinterleaveBitsScalar ( const uint64_t* pIn, uint32_t* pEvenBits, uint32_t* pOddBits, size_t pNWords )
+    {
+        for ( size_t i = 0; i < pNWords; i++ )
+        {
+            pEvenBits[i] = compactBits ( pIn[i] );
+            pOddBits[i] = compactBits ( pIn[i] >> 1 );
+        }
+    }
+
+    __attribute__ ( ( target ( "bmi2" ) ) )
+    void deinterleaveBitsBMI2 ( const uint64_t* pIn, uint32_t* pEvenBits, uint32_t* pOddBits, size_t pNWords )
+    {
+        for ( size_t i = 0; i < pNWords; i++ )
+        {
+            pEvenBits[i] = _pext_u64 ( pIn[i], 0x5555555555555555ULL );
+            pOddBits[i] = _pext_u64 ( pIn[i], 0xAAAAAAAAAAAAAAAAULL );
+        }
+    }
+
+    inline uint64_t reverseBits64 ( uint64_t n )
+    {
+        return uint64_t ( reverseBits32 ( uint32_t ( n ) ) ) << 32 | reverseBits32 ( uint32_t ( n >> 32 ) );
+    }
+
+    void reverseBitsScalar ( uint32_t* pWords, size_t pNWords )
+    {
+        for ( size_t i = 0; i < pNWords; i++ )
+            pWords[i] = reverseBits32 ( pWords[i] );
+    }
+
+    // reverse the nibbles with a lookup table, then swap the nibbles and the bytes
+    __attribute__ ( ( target ( "ssse3" ) ) )
+    void reverseBitsSSSE3 ( uint32_t* pWords, size_t pNWords )
+    {
+        const __m128i cLUT = _mm_setr_epi8 ( 0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF );
+        const __m128i cByteSwap = _mm_setr_epi8 ( 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 );
+        const __m128i cLowNibble = _mm_set1_epi8 ( 0x0F );
+        size_t i = 0;
+
+        for ( ; i + 4 <= pNWords; i += 4 )
+        {
+            __m128i cWords = _mm_loadu_si128 ( reinterpret_cast<const __m128i*> ( pWords + i ) );
+            __m128i cLow = _mm_shuffle_epi8 ( cLUT, _mm_and_si128 ( cWords, cLowNibble ) );
+            __m128i cHigh = _mm_shuffle_epi8 ( cLUT, _mm_and_si128 ( _mm_srli_epi16 ( cWords, 4 ), cLowNibble ) );
+            __m128i cReversed = _mm_or_si128 ( _mm_slli_epi16 ( cLow, 4 ), cHigh );
+            _mm_storeu_si128 ( reinterpret_cast<__m128i*> ( pWords + i ), _mm_shuffle_epi8 ( cReversed, cByteSwap ) );
+        }
+
+        reverseBitsScalar ( pWords + i, pNWords - i );
+    }
+
+    __attribute__ ( ( target ( "avx2" ) ) )
+    void reverseBitsAVX2 ( uint32_t* pWords, size_t pNWords )
+    {
+        const __m256i cLUT = _mm256_setr_epi8 ( 0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF,
+                                                0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF );
+        const __m256i cByteSwap = _mm256_setr_epi8 ( 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                                     3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 );
+        const __m256i cLowNibble = _mm256_set1_epi8 ( 0x0F );
+        size_t i = 0;
+
+        for ( ; i + 8 <= pNWords; i += 8 )
+        {
+            __m256i cWords = _mm256_loadu_si256 ( reinterpret_cast<const __m256i*> ( pWords + i ) );
+            __m256i cLow = _mm256_shuffle_epi8 ( cLUT, _mm256_and_si256 ( cWords, cLowNibble ) );
+            __m256i cHigh = _mm256_shuffle_epi8 ( cLUT, _mm256_and_si256 ( _mm256_srli_epi16 ( cWords, 4 ), cLowNibble ) );
+            __m256i cReversed = _mm256_or_si256 ( _mm256_slli_epi16 ( cLow, 4 ), cHigh );
+            _mm256_storeu_si256 ( reinterpret_cast<__m256i*> ( pWords + i ), _mm256_shuffle_epi8 ( cReversed, cByteSwap ) );
+        }
+
+        reverseBitsSSSE3 ( pWords + i, pNWords - i );
+    }
+
+    // sparse words: walk the set bits
+    inline void addWordCountsSparse ( uint64_t pWord, uint32_t pNBits, uint32_t* pCounters )
+    {
+        if ( pNBits < 64 ) pWord &= ( uint64_t (1) << pNBits ) - 1;
+
+        while ( pWord != 0 )
+        {
+            pCounters[__builtin_ctzll ( pWord )]++;
+            pWord &= pWord - 1;
+        }
+    }
+
+    void addBitmapCountsScalar ( const uint64_t* pBitmap, uint32_t pNBits, uint32_t* pCounters )
+    {
+        for ( uint32_t i = 0; 64 * i < pNBits; i++ )
+            addWordCountsSparse ( pBitmap[i], std::min ( pNBits - 64 * i, 64u ), pCounters + 64 * i );
+    }
+
+    // dense words: each group of bits is broadcast to the lanes, the lanes whose bit is set compare to -1 and are subtracted
+    __attribute__ ( ( target ( "ssse3" ) ) )
+    void addWordCountsSSSE3 ( uint64_t pWord, uint32_t pNBits, uint32_t* pCounters )
+    {
+        const __m128i cBits = _mm_setr_epi32 ( 0x1, 0x2, 0x4, 0x8 );
+        uint32_t i = 0;
+
+        for ( ; i + 4 <= pNBits; i += 4 )
+        {
+            __m128i cSet = _mm_cmpeq_epi32 ( _mm_and_si128 ( _mm_set1_epi32 ( ( pWord >> i ) & 0xF ), cBits ), cBits );
+            __m128i* cCounters = reinterpret_cast<__m128i*> ( pCounters + i );
+            _mm_storeu_si128 ( cCounters, _mm_sub_epi32 ( _mm_loadu_si128 ( cCounters ), cSet ) );
+        }
+
+        if ( i < pNBits ) addWordCountsSparse ( pWord >> i, pNBits - i, pCounters + i );
+    }
+
+    __attribute__ ( ( target ( "avx2" ) ) )
+    void addWordCountsAVX2 ( uint64_t pWord, uint32_t pNBits, uint32_t* pCounters )
+    {
+        const __m256i cBits = _mm256_setr_epi32 ( 0x1, 0x2, 0x4, 0x8, 0x10, 0x20, 0x40, 0x80 );
+        uint32_t i = 0;
+
+        for ( ; i + 8 <= pNBits; i += 8 )
+        {
+            __m256i cSet = _mm256_cmpeq_epi32 ( _mm256_and_si256 ( _mm256_set1_epi32 ( ( pWord >> i ) & 0xFF ), cBits ), cBits );
+            __m256i* cCounters = reinterpret_cast<__m256i*> ( pCounters + i );
+            _mm256_storeu_si256 ( cCounters, _mm256_sub_epi32 ( _mm256_loadu_si256 ( cCounters ), cSet ) );
+        }
+
+        if ( i < pNBits ) addWordCountsSparse ( pWord >> i, pNBits - i, pCounters + i );
+    }
+
+    // the MPA sends a counter as 15 bits spread over its five SLVS lines: lines 1 to 3 are bytes 0 to 2 of the
+    // fifo1 word, lines 4 and 5 bytes 0 and 1 of the fifo2 word, and a word is valid if bit 7 of lines 1 and 4 is set
+    const uint32_t MPA_COUNTER_VALID = 0x80;
+
+    template<int SHIFT>
+    inline uint32_t moveBits ( uint32_t pWord, uint32_t pMask )
+    {
+        return SHIFT >= 0 ? ( pWord & pMask ) << ( SHIFT >= 0 ? SHIFT : 0 ) : ( pWord & pMask ) >> ( SHIFT < 0 ? -SHIFT : 0 );
+    }
+
+    inline uint32_t mpaCounterWord ( uint32_t pFifo1, uint32_t pFifo2 )
+    {
+        return moveBits<1> ( pFifo1, 0x2000 ) | moveBits < -8 > ( pFifo1, 0x200000 ) | moveBits<7> ( pFifo2, 0x20 ) | moveBits < -2 > ( pFifo2, 0x2000 )
+               | moveBits<6> ( pFifo1, 0x10 ) | moveBits < -3 > ( pFifo1, 0x1000 ) | moveBits < -12 > ( pFifo1, 0x100000 ) | moveBits<3> ( pFifo2, 0x10 )
+               | moveBits < -9 > ( pFifo2, 0x8000 ) | moveBits < -1 > ( pFifo1, 0x40 ) | moveBits < -10 > ( pFifo1, 0x4000 ) | moveBits < -19 > ( pFifo1, 0x400000 )
+               | moveBits < -4 > ( pFifo2, 0x40 ) | moveBits < -13 > ( pFifo2, 0x4000 ) | moveBits < -5 > ( pFifo1, 0x20 );
+    }
+
+    size_t decodeMPACountersScalar ( const uint32_t* pFifo1, const uint32_t* pFifo2, size_t pNWords, uint16_t* pCounters, size_t pMaxCounters )
+    {
+        size_t cNCounters = 0;
+
+        for ( size_t i = 0; i < pNWords && cNCounters < pMaxCounters; i++ )
+        {
+            if ( ( pFifo1[i] & pFifo2[i] & MPA_COUNTER_VALID ) == 0 ) continue;
+
+            uint32_t cWord = mpaCounterWord ( pFifo1[i], pFifo2[i] );
+
+            if ( cWord != 0 ) pCounters[cNCounters++] = cWord - 1;
+        }
+
+        return cNCounters;
+    }
+
+    template<int SHIFT>
+    __attribute__ ( ( target ( "avx2" ) ) )
+    inline __m256i moveBitsAVX2 ( __m256i pWords, uint32_t pMask )
+    {
+        __m256i cBits = _mm256_and_si256 ( pWords, _mm256_set1_epi32 ( pMask ) );
+        return SHIFT >= 0 ? _mm256_slli_epi32 ( cBits, SHIFT >= 0 ? SHIFT : 0 ) : _mm256_srli_epi32 ( cBits, SHIFT < 0 ? -SHIFT : 0 );
+    }
+
+    // the same shuffle on 8 words at a time, the invalid and empty words are masked out and the rest compacted
+    __attribute__ ( ( target ( "avx2" ) ) )
+    size_t decodeMPACountersAVX2 ( const uint32_t* pFifo1, const uint32_t* pFifo2, size_t pNWords, uint16_t* pCounters, size_t pMaxCounters )
+    {
+        const __m256i cValid = _mm256_set1_epi32 ( MPA_COUNTER_VALID );
+        size_t cNCounters = 0;
+        size_t i = 0;
+        alignas ( 32 ) uint32_t cWords[8];
+
+        for ( ; i + 8 <= pNWords && cNCounters + 8 <= pMaxCounters; i += 8 )
+        {
+            __m256i a = _mm256_loadu_si256 ( reinterpret_cast<const __m256i*> ( pFifo1 + i ) );
+            __m256i b = _mm256_loadu_si256 ( reinterpret_cast<const __m256i*> ( pFifo2 + i ) );
+
+            __m256i cWord = _mm256_or_si256 ( _mm256_or_si256 ( _mm256_or_si256 ( moveBitsAVX2<1> ( a, 0x2000 ), moveBitsAVX2 < -8 > ( a, 0x200000 ) ),
+                                                                _mm256_or_si256 ( moveBitsAVX2<7> ( b, 0x20 ), moveBitsAVX2 < -2 > ( b, 0x2000 ) ) ),
+                                              _mm256_or_si256 ( _mm256_or_si256 ( moveBitsAVX2<6> ( a, 0x10 ), moveBitsAVX2 < -3 > ( a, 0x1000 ) ),
+                                                                _mm256_or_si256 ( moveBitsAVX2 < -12 > ( a, 0x100000 ), moveBitsAVX2<3> ( b, 0x10 ) ) ) );
+            cWord = _mm256_or_si256 ( cWord, _mm256_or_si256 ( _mm256_or_si256 ( moveBitsAVX2 < -9 > ( b, 0x8000 ), moveBitsAVX2 < -1 > ( a, 0x40 ) ),
+                                                               _mm256_or_si256 ( moveBitsAVX2 < -10 > ( a, 0x4000 ), moveBitsAVX2 < -19 > ( a, 0x400000 ) ) ) );
+            cWord = _mm256_or_si256 ( cWord, _mm256_or_si256 ( _mm256_or_si256 ( moveBitsAVX2 < -4 > ( b, 0x40 ), moveBitsAVX2 < -13 > ( b, 0x4000 ) ),
+                                                               moveBitsAVX2 < -5 > ( a, 0x20 ) ) );
+
+            __m256i cIsValid = _mm256_cmpeq_epi32 ( _mm256_and_si256 ( _mm256_and_si256 ( a, b ), cValid ), cValid );
+            cWord = _mm256_and_si256 ( cWord, cIsValid );
+
+            uint32_t cEmpty = _mm256_movemask_ps ( _mm256_castsi256_ps ( _mm256_cmpeq_epi32 ( cWord, _mm256_setzero_si256() ) ) );
+            uint32_t cKeep = ~cEmpty & 0xFF;
+
+            if ( cKeep == 0 ) continue;
+
+            _mm256_store_si256 ( reinterpret_cast<__m256i*> ( cWords ), cWord );
+
+            while ( cKeep != 0 )
+            {
+                pCounters[cNCounters++] = cWords[__builtin_ctz ( cKeep )] - 1;
+                cKeep &= cKeep - 1;
+            }
+        }
+
+        return cNCounters + decodeMPACountersScalar ( pFifo1 + i, pFifo2 + i, pNWords - i, pCounters + cNCounters, pMaxCounters - cNCounters );
+    }
+
+    // below this many hits in a 64 bit word, walking the bits is cheaper than expanding all of them
+    const int DENSE_WORD_HITS = 12;
+
+    template<void ( *DenseKernel ) ( uint64_t, uint32_t, uint32_t* )>
+    void addBitmapCountsSIMD ( const uint64_t* pBitmap, uint32_t pNBits, uint32_t* pCounters )
+    {
+        for ( uint32_t i = 0; 64 * i < pNBits; i++ )
+        {
+            uint32_t cNBits = std::min ( pNBits - 64 * i, 64u );
+
+            if ( __builtin_popcountll ( pBitmap[i] ) < DENSE_WORD_HITS ) addWordCountsSparse ( pBitmap[i], cNBits, pCounters + 64 * i );
+            else DenseKernel ( pBitmap[i], cNBits, pCounters + 64 * i );
+        }
+    }
+}
+
+void reverseBits ( uint32_t* pWords, size_t pNWords )
+{
+    switch ( isa() )
+    {
+        case ISA::AVX2:
+            reverseBitsAVX2 ( pWords, pNWords );
+            break;
+
+        case ISA::SSSE3:
+            reverseBitsSSSE3 ( pWords, pNWords );
+            break;
+
+        default:
+            reverseBitsScalar ( pWords, pNWords );
+    }
+}
+
+void interleaveBits ( const uint32_t* pEvenBits, const uint32_t* pOddBits, uint64_t* pOut, size_t pNWords )
+{
+    if ( hasBMI2() ) interleaveBitsBMI2 ( pEvenBits, pOddBits, pOut, pNWords );
+    else interleaveBitsScalar ( pEvenBits, pOddBits, pOut, pNWords );
+}
+
+void deinterleaveBits ( const uint64_t* pIn, uint32_t* pEvenBits, uint32_t* pOddBits, size_t pNWords )
+{
+    if ( hasBMI2() ) deinterleaveBitsBMI2 ( pIn, pEvenBits, pOddBits, pNWords );
+    else deinterleaveBitsScalar ( pIn, pEvenBits, pOddBits, pNWords );
+}
+
+void insertBits ( uint64_t* pDst, uint32_t pPosition, const uint64_t* pSrc, uint32_t pNBits )
+{
+    uint64_t* cDst = pDst + pPosition / 64;
+    uint32_t cShift = pPosition % 64;
+    uint32_t cNWords = ( pNBits + 63 ) / 64;
+
+    for ( uint32_t i = 0; i < cNWords; i++ )
+    {
+        uint64_t cWord = pSrc[i];
+
+        if ( 64 * ( i + 1 ) > pNBits ) cWord &= ~uint64_t ( 0 ) >> ( 64 * ( i + 1 ) - pNBits );
+
+        cDst[i] |= cWord << cShift;
+
+        // the bits shifted out are below pPosition + pNBits, so the next word is only touched when it is in pDst
+        if ( cShift != 0 && ( cWord >> ( 64 - cShift ) ) != 0 ) cDst[i + 1] |= cWord >> ( 64 - cShift );
+    }
+}
+
+void d19cCbc3HitBitmap ( const uint32_t* pCbcData, uint64_t* pBitmap )
+{
+    // even channels 0..252 are bits 0..126 of words 3 (31 bits), 2, 1 and 0, odd channels 1..253 the same in words 7, 6, 5 and 4
+    uint32_t cEven[4] = { ( pCbcData[3] & 0x7FFFFFFF ) | ( pCbcData[2] << 31 ),
+                          ( pCbcData[2] >> 1 ) | ( pCbcData[1] << 31 ),
+                          ( pCbcData[1] >> 1 ) | ( pCbcData[0] << 31 ),
+                          ( pCbcData[0] >> 1 )
+                        };
+    uint32_t cOdd[4] = { ( pCbcData[7] & 0x7FFFFFFF ) | ( pCbcData[6] << 31 ),
+                         ( pCbcData[6] >> 1 ) | ( pCbcData[5] << 31 ),
+                         ( pCbcData[5] >> 1 ) | ( pCbcData[4] << 31 ),
+                         ( pCbcData[4] >> 1 )
+                       };
+
+    interleaveBits ( cEven, cOdd, pBitmap, CBC_HIT_BITMAP_SIZE_64 );
+}
+
+void d19cCbc3SLinkPayload ( const uint32_t* pCbcData, uint64_t* pPayload )
+{
+    // the SLink format lists the channels from the MSB, which is the linear bitmap read backwards word by word
+    d19cCbc3HitBitmap ( pCbcData, pPayload );
+
+    for ( uint32_t i = 0; i < CBC_HIT_BITMAP_SIZE_64; i++ )
+        pPayload[i] = reverseBits64 ( pPayload[i] );
+}
+
+uint32_t bitmapToHits ( const uint64_t* pBitmap, size_t pNWords, uint32_t* pHits )
+{
+    // hits are sparse, so skipping the empty words and walking the set bits beats any lane-wise expansion
+    uint32_t cNHits = 0;
+
+    for ( size_t i = 0; i < pNWords; i++ )
+    {
+        uint64_t cWord = pBitmap[i];
+
+        while ( cWord != 0 )
+        {
+            pHits[cNHits++] = 64 * i + __builtin_ctzll ( cWord );
+            cWord &= cWord - 1;
+        }
+    }
+
+    return cNHits;
+}
+
+uint32_t bitmapToRuns ( const uint64_t* pBitmap, size_t pNWords, uint32_t* pFirst, uint32_t* pWidth )
+{
+    // a run starts on a set bit whose lower neighbour is clear and ends on a set bit whose upper neighbour is clear,
+    // the neighbours across the word boundaries come from the previous and next words
+    uint32_t cNStarts = 0;
+    uint32_t cNEnds = 0;
+    uint64_t cCarry = 0;
+
+    for ( size_t i = 0; i < pNWords; i++ )
+    {
+        uint64_t cWord = pBitmap[i];
+        uint64_t cNext = ( i + 1 < pNWords ) ? ( pBitmap[i + 1] & 1 ) : 0;
+        uint64_t cStarts = cWord & ~ ( ( cWord << 1 ) | cCarry );
+        uint64_t cEnds = cWord & ~ ( ( cWord >> 1 ) | ( cNext << 63 ) );
+        cCarry = cWord >> 63;
+
+        while ( cStarts != 0 )
+        {
+            pFirst[cNStarts++] = 64 * i + __builtin_ctzll ( cStarts );
+            cStarts &= cStarts - 1;
+        }
+
+        while ( cEnds != 0 )
+        {
+            pWidth[cNEnds] = 64 * i + __builtin_ctzll ( cEnds ) + 1 - pFirst[cNEnds];
+            cNEnds++;
+            cEnds &= cEnds - 1;
+        }
+    }
+
+    return cNStarts;
+}
+
+void addBitmapCounts ( const uint64_t* pBitmap, uint32_t pNBits, uint32_t* pCounters )
+{
+    switch ( isa() )
+    {
+        case ISA::AVX2:
+            addBitmapCountsSIMD<addWordCountsAVX2> ( pBitmap, pNBits, pCounters );
+            break;
+
+        case ISA::SSSE3:
+            addBitmapCountsSIMD<addWordCountsSSSE3> ( pBitmap, pNBits, pCounters );
+            break;
+
+        default:
+            addBitmapCountsScalar ( pBitmap, pNBits, pCounters );
+    }
+}
+
+size_t decodeMPACounters ( const uint32_t* pFifo1, const uint32_t* pFifo2, size_t pNWords, uint16_t* pCounters, size_t pMaxCounters )
+{
+    if ( isa() == ISA::AVX2 ) return decodeMPACountersAVX2 ( pFifo1, pFifo2, pNWords, pCounters, pMaxCounters );
+    else return decodeMPACountersScalar ( pFifo1, pFifo2, pNWords, pCounters, pMaxCounters );
+}
+
+const char* bitKernelsISA()
+{
+    switch ( isa() )
+    {
+        case ISA::AVX2:
+            return hasBMI2() ? "avx2+bmi2" : "avx2";
+
+        case ISA::SSSE3:
+            return hasBMI2() ? "ssse3+bmi2" : "ssse3";
+
+        default:
+            return hasBMI2() ? "scalar+bmi2" : "scalar";
+    }
+}
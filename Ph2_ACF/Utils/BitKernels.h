@@ -0,0 +1,109 @@
+/*!
+
+    \file                          BitKernels.h
+    \brief                         Vectorized bit manipulation for the CBC channel data
+    \details                       The AVX2/SSE versions are picked at run time from the CPU flags, with a scalar fallback
+
+ */
+
+#ifndef __BITKERNELS_H__
+#define __BITKERNELS_H__
+
+#include <stdint.h>
+#include <cstddef>
+
+/*! \brief Number of 64 bit words of a linear 254 channel CBC hit bitmap */
+#define CBC_HIT_BITMAP_SIZE_64      4
+
+/*!
+ * \brief Reverse the bit order of a single word
+ */
+inline uint32_t reverseBits32 ( uint32_t n )
+{
+    n = ( (n >> 1) & 0x55555555) | ( (n << 1) & 0xaaaaaaaa) ;
+    n = ( (n >> 2) & 0x33333333) | ( (n << 2) & 0xcccccccc) ;
+    n = ( (n >> 4) & 0x0f0f0f0f) | ( (n << 4) & 0xf0f0f0f0) ;
+    return __builtin_bswap32 (n);
+}
+/*!
+ * \brief Reverse the bit order of each word of a buffer, in place
+ * \param pWords : first word
+ * \param pNWords : number of words
+ */
+void reverseBits ( uint32_t* pWords, size_t pNWords );
+/*!
+ * \brief Interleave two words bit by bit: bit i of pEvenBits[k] becomes bit 2i of pOut[k], bit i of pOddBits[k] bit 2i+1
+ * \param pEvenBits : words spread to the even bits
+ * \param pOddBits : words spread to the odd bits
+ * \param pOut : pNWords interleaved words
+ * \param pNWords : number of words
+ */
+void interleaveBits ( const uint32_t* pEvenBits, const uint32_t* pOddBits, uint64_t* pOut, size_t pNWords );
+/*!
+ * \brief Split words bit by bit, the inverse of interleaveBits: bit 2i of pIn[k] becomes bit i of pEvenBits[k], bit 2i+1 bit i of pOddBits[k]
+ * \param pIn : pNWords interleaved words
+ * \param pEvenBits : output, the even bits
+ * \param pOddBits : output, the odd bits
+ * \param pNWords : number of words
+ */
+void deinterleaveBits ( const uint64_t* pIn, uint32_t* pEvenBits, uint32_t* pOddBits, size_t pNWords );
+/*!
+ * \brief OR the first pNBits bits of pSrc into pDst, bit 0 of pSrc going to bit pPosition of pDst
+ * \param pDst : bitmap with room for pPosition + pNBits bits
+ * \param pPosition : first bit written in pDst
+ * \param pSrc : bits to insert, the bits above pNBits are ignored
+ * \param pNBits : number of bits to insert
+ */
+void insertBits ( uint64_t* pDst, uint32_t pPosition, const uint64_t* pSrc, uint32_t pNBits );
+/*!
+ * \brief Build the linear hit bitmap of a D19C CBC3 payload, bit i of the bitmap is channel i
+ * \param pCbcData : the CBC_EVENT_SIZE_32_CBC3 words of the CBC, even channels in words 3..0 and odd channels in words 7..4
+ * \param pBitmap : CBC_HIT_BITMAP_SIZE_64 words
+ */
+void d19cCbc3HitBitmap ( const uint32_t* pCbcData, uint64_t* pBitmap );
+/*!
+ * \brief Build the SLink channel data of a D19C CBC3 payload: channel 0 in the MSB of pPayload[0], channel 253 in bit 2 of pPayload[3], two zero bits of padding
+ * \param pCbcData : the CBC_EVENT_SIZE_32_CBC3 words of the CBC
+ * \param pPayload : CBC_HIT_BITMAP_SIZE_64 words
+ */
+void d19cCbc3SLinkPayload ( const uint32_t* pCbcData, uint64_t* pPayload );
+/*!
+ * \brief Convert a bitmap into the sorted list of the set bits
+ * \param pBitmap : bitmap
+ * \param pNWords : number of 64 bit words of the bitmap
+ * \param pHits : output, room for 64 * pNWords entries
+ * \return number of hits written
+ */
+uint32_t bitmapToHits ( const uint64_t* pBitmap, size_t pNWords, uint32_t* pHits );
+/*!
+ * \brief Find the runs of consecutive set bits of a bitmap, e.g. the strip clusters of a sensor
+ * \param pBitmap : bitmap
+ * \param pNWords : number of 64 bit words of the bitmap
+ * \param pFirst : output, first bit of each run, room for 32 * pNWords entries
+ * \param pWidth : output, number of bits of each run, room for 32 * pNWords entries
+ * \return number of runs, in increasing bit order
+ */
+uint32_t bitmapToRuns ( const uint64_t* pBitmap, size_t pNWords, uint32_t* pFirst, uint32_t* pWidth );
+/*!
+ * \brief Add a bitmap to per-bit counters: pCounters[i] += bit i
+ * \param pBitmap : bitmap
+ * \param pNBits : number of bits to add, pCounters has to hold as many entries
+ * \param pCounters : counters
+ */
+void addBitmapCounts ( const uint64_t* pBitmap, uint32_t pNBits, uint32_t* pCounters );
+/*!
+ * \brief Decode the raw SLVS debug FIFO words of an MPA counter readout, the valid non-zero words give the pixel counters in readout order
+ * \param pFifo1 : words of the debug fifo1, MPA lines 1 to 3 in bytes 0 to 2
+ * \param pFifo2 : words of the debug fifo2, MPA lines 4 and 5 in bytes 0 and 1
+ * \param pNWords : number of words of each FIFO
+ * \param pCounters : output counters
+ * \param pMaxCounters : room in pCounters, the decoding stops when it is full
+ * \return number of counters written
+ */
+size_t decodeMPACounters ( const uint32_t* pFifo1, const uint32_t* pFifo2, size_t pNWords, uint16_t* pCounters, size_t pMaxCounters );
+/*!
+ * \brief Name of the instruction set used by the kernels on this CPU (avx2, ssse3 or scalar), with +bmi2 when the bit interleaving uses PDEP
+ */
+const char* bitKernelsISA();
+
+#endif
@@ -0,0 +1,153 @@
+/*!
+        \file                BoundedQueue.h
+        \brief               Fixed capacity blocking queue between producer and consumer threads
+ */
+
+#ifndef __BOUNDEDQUEUE_H__
+#define __BOUNDEDQUEUE_H__
+
+#include <deque>
+#include <cstdint>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+/*!
+ * \struct QueueStats
+ * \brief Fill level and blocking time of a BoundedQueue
+ */
+struct QueueStats
+{
+    size_t fCapacity = 0;
+    size_t fDepth = 0;                  /*!< elements currently queued*/
+    size_t fMaxDepth = 0;               /*!< high watermark*/
+    uint64_t fNPushed = 0;
+    uint64_t fNPopped = 0;
+    double fPushBlockedTime = 0;        /*!< seconds producers waited on a full queue (back-pressure)*/
+    double fPopBlockedTime = 0;         /*!< seconds consumers waited on an empty queue (starvation)*/
+};
+
+/*!
+ * \class BoundedQueue
+ * \brief push() blocks while the queue is full, pop() blocks while it is empty, close() releases both
+ *
+ * unbound() lifts the capacity so that the producers can flush what they hold while nobody pops, used to drain a pipeline on stop.
+ */
+template<typename T>
+class BoundedQueue
+{
+  private:
+    std::deque<T> fQueue;
+    size_t fCapacity;
+    bool fClosed;
+    bool fUnbounded;
+    QueueStats fStats;
+    mutable std::mutex fMutex;
+    std::condition_variable fNotFull;
+    std::condition_variable fNotEmpty;
+
+  public:
+    BoundedQueue ( size_t pCapacity ) :
+        fCapacity ( pCapacity ),
+        fClosed ( false ),
+        fUnbounded ( false )
+    {
+        fStats.fCapacity = pCapacity;
+    }
+
+    /*!
+     * \brief Queue an element, waiting for room if the queue is full
+     * \return false if the queue was closed and the element was dropped
+     */
+    bool push ( T pElement )
+    {
+        std::unique_lock<std::mutex> cLock ( fMutex );
+
+        if ( fQueue.size() >= fCapacity && !fClosed && !fUnbounded )
+        {
+            auto cStart = std::chrono::steady_clock::now();
+            fNotFull.wait ( cLock, [this] { return fQueue.size() < fCapacity || fClosed || fUnbounded; } );
+            fStats.fPushBlockedTime += std::chrono::duration<double> ( std::chrono::steady_clock::now() - cStart ).count();
+        }
+
+        if ( fClosed ) return false;
+
+        fQueue.push_back ( std::move ( pElement ) );
+        fStats.fNPushed++;
+        fStats.fMaxDepth = std::max ( fStats.fMaxDepth, fQueue.size() );
+        cLock.unlock();
+        fNotEmpty.notify_one();
+        return true;
+    }
+
+    /*!
+     * \brief Take the oldest element, waiting for one if the queue is empty
+     * \return false once the queue is closed and drained
+     */
+    bool pop ( T& pElement )
+    {
+        std::unique_lock<std::mutex> cLock ( fMutex );
+
+        if ( fQueue.empty() && !fClosed )
+        {
+            auto cStart = std::chrono::steady_clock::now();
+            fNotEmpty.wait ( cLock, [this] { return !fQueue.empty() || fClosed; } );
+            fStats.fPopBlockedTime += std::chrono::duration<double> ( std::chrono::steady_clock::now() - cStart ).count();
+        }
+
+        if ( fQueue.empty() ) return false;
+
+        pElement = std::move ( fQueue.front() );
+        fQueue.pop_front();
+        fStats.fNPopped++;
+        cLock.unlock();
+        fNotFull.notify_one();
+        return true;
+    }
+
+    /*!
+     * \brief Refuse further pushes and wake up all waiting threads; queued elements can still be popped
+     */
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> cLock ( fMutex );
+            fClosed = true;
+        }
+        fNotFull.notify_all();
+        fNotEmpty.notify_all();
+    }
+
+    /*!
+     * \brief Stop applying the capacity: push() never waits anymore and wakes up the producers waiting for room
+     */
+    void unbound()
+    {
+        {
+            std::lock_guard<std::mutex> cLock ( fMutex );
+            fUnbounded = true;
+        }
+        fNotFull.notify_all();
+    }
+
+    /*!
+     * \brief Accept pushes again after close(), with the capacity applied again after unbound()
+     */
+    void reopen()
+    {
+        std::lock_guard<std::mutex> cLock ( fMutex );
+        fClosed = false;
+        fUnbounded = false;
+    }
+
+    QueueStats getStats() const
+    {
+        std::lock_guard<std::mutex> cLock ( fMutex );
+        QueueStats cStats = fStats;
+        cStats.fDepth = fQueue.size();
+        return cStats;
+    }
+};
+
+#endif
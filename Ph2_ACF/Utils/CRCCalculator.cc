@@ -1,4 +1,5 @@
 #include "CRCCalculator.h"
+#include <immintrin.h>
 
 const uint16_t crcTable[1024] =
 {
@@ -181,6 +182,12 @@ uint16_t CRCCalculator::compute (const uint8_t* buffer, size_t bufSize) const
 
 
 void CRCCalculator::compute (uint16_t& crc, const uint8_t* buffer, size_t bufSize) const
+{
+    computeCLMUL (crc, buffer, bufSize);
+}
+
+
+void CRCCalculator::computeTable (uint16_t& crc, const uint8_t* buffer, size_t bufSize) const
 {
     assert (0 == bufSize % 8);
 
@@ -212,6 +219,132 @@ void CRCCalculator::compute (uint16_t& crc, const uint8_t* buffer, size_t bufSiz
 }
 
 
+
+// Folding with carry-less multiplication, after Intel's "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction": a 128 bit block A followed by d bits of message
+// is replaced by A_hi * (x^(d+64) mod P) + A_lo * (x^d mod P), which leaves the CRC unchanged.
+// The message is read MSB first in 64 bit words, like computeCRC_32bit does.
+namespace {
+
+    // blocks folded in parallel in the main loop
+    const size_t CLMUL_LANES = 4;
+
+    // x^n mod P, with P = x^16 + x^15 + x^2 + 1
+    uint64_t xPowModP (unsigned n)
+    {
+        uint32_t r = 1;
+
+        for (unsigned i = 0; i < n; i++)
+        {
+            r <<= 1;
+
+            if (r & 0x10000) r ^= 0x18005;
+        }
+
+        return r;
+    }
+
+    // fold constants for the distances 128, 256, 384 and 512 bits
+    struct FoldConstants
+    {
+        uint64_t hi[CLMUL_LANES];
+        uint64_t lo[CLMUL_LANES];
+    };
+
+    const FoldConstants& foldConstants()
+    {
+        static const FoldConstants constants = [] ()
+        {
+            FoldConstants k;
+
+            for (size_t i = 0; i < CLMUL_LANES; i++)
+            {
+                k.hi[i] = xPowModP (128 * (i + 1) + 64);
+                k.lo[i] = xPowModP (128 * (i + 1) );
+            }
+
+            return k;
+        } ();
+        return constants;
+    }
+
+    __attribute__ ( (target ("pclmul") ) )
+    inline __m128i fold (__m128i x, __m128i k)
+    {
+        return _mm_xor_si128 (_mm_clmulepi64_si128 (x, k, 0x11), _mm_clmulepi64_si128 (x, k, 0x00) );
+    }
+
+    // 16 bytes of the buffer with the first 64 bit word in the upper half
+    __attribute__ ( (target ("pclmul") ) )
+    inline __m128i load128 (const uint8_t* buffer)
+    {
+        return _mm_shuffle_epi32 (_mm_loadu_si128 (reinterpret_cast<const __m128i*> (buffer) ), 0x4E);
+    }
+
+    // fold nBlocks >= CLMUL_LANES blocks of 16 bytes into one, crc goes into the first 16 bits of the message
+    __attribute__ ( (target ("pclmul") ) )
+    void foldCLMUL (uint16_t crc, const uint8_t* buffer, size_t nBlocks, uint64_t& hi, uint64_t& lo)
+    {
+        const FoldConstants& k = foldConstants();
+        __m128i k128 = _mm_set_epi64x (k.hi[0], k.lo[0]);
+        __m128i k256 = _mm_set_epi64x (k.hi[1], k.lo[1]);
+        __m128i k384 = _mm_set_epi64x (k.hi[2], k.lo[2]);
+        __m128i k512 = _mm_set_epi64x (k.hi[3], k.lo[3]);
+        __m128i x[CLMUL_LANES];
+
+        for (size_t j = 0; j < CLMUL_LANES; j++)
+            x[j] = load128 (buffer + 16 * j);
+
+        x[0] = _mm_xor_si128 (x[0], _mm_set_epi64x ( (uint64_t) crc << 48, 0) );
+        size_t i = CLMUL_LANES;
+
+        for (; i + CLMUL_LANES <= nBlocks; i += CLMUL_LANES)
+        {
+            for (size_t j = 0; j < CLMUL_LANES; j++)
+                x[j] = _mm_xor_si128 (fold (x[j], k512), load128 (buffer + 16 * (i + j) ) );
+        }
+
+        __m128i r = _mm_xor_si128 (_mm_xor_si128 (fold (x[0], k384), fold (x[1], k256) ), _mm_xor_si128 (fold (x[2], k128), x[3]) );
+
+        for (; i < nBlocks; i++)
+            r = _mm_xor_si128 (fold (r, k128), load128 (buffer + 16 * i) );
+
+        hi = _mm_cvtsi128_si64 (_mm_unpackhi_epi64 (r, r) );
+        lo = _mm_cvtsi128_si64 (r);
+    }
+}
+
+
+void CRCCalculator::computeCLMUL (uint16_t& crc, const uint8_t* buffer, size_t bufSize) const
+{
+    assert (0 == bufSize % 8);
+
+    // shorter buffers are not worth the setup
+    if (!havePCLMULQDQ_ || bufSize / 16 < CLMUL_LANES)
+    {
+        computeTable (crc, buffer, bufSize);
+        return;
+    }
+
+    if (bufSize % 16 == 8)
+    {
+        computeCRC_32bit (crc, ( (uint32_t*) buffer) [1]);
+        computeCRC_32bit (crc, ( (uint32_t*) buffer) [0]);
+        bufSize -= 8;
+        buffer += 8;
+    }
+
+    uint64_t hi, lo;
+    foldCLMUL (crc, buffer, bufSize / 16, hi, lo);
+
+    // the last 128 bits through the table, starting from 0 as the CRC so far is folded in
+    crc = 0;
+    computeCRC_32bit (crc, hi >> 32);
+    computeCRC_32bit (crc, hi & 0xFFFFFFFF);
+    computeCRC_32bit (crc, lo >> 32);
+    computeCRC_32bit (crc, lo & 0xFFFFFFFF);
+}
+
 //uint32_t CRCCalculator::crc32c (uint32_t crc, const unsigned char* buf, size_t len) const
 //{
 //return haveSSE42_ ? crc32c_hw (crc, buf, len) : crc32c_sw (crc, buf, len);
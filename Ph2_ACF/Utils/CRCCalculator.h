@@ -41,10 +41,24 @@ class CRCCalculator
     uint16_t compute (const uint8_t* buffer, size_t bufSize) const;
 
     /**
-     * Compute the CRC of the buffer updating the passed CRC value
+     * Compute the CRC of the buffer updating the passed CRC value, so a buffer can be
+     * processed in pieces of any multiple of 8 bytes while it is being filled
+     * Uses carry-less multiplication if the CPU has PCLMULQDQ
      */
     void compute (uint16_t& crc, const uint8_t* buffer, size_t bufSize) const;
 
+    /**
+     * The two implementations behind compute(), for tests and benchmarks
+     * computeCLMUL falls back to the table if the CPU has no PCLMULQDQ
+     */
+    void computeTable (uint16_t& crc, const uint8_t* buffer, size_t bufSize) const;
+    void computeCLMUL (uint16_t& crc, const uint8_t* buffer, size_t bufSize) const;
+
+    bool haveCLMUL() const
+    {
+        return havePCLMULQDQ_;
+    }
+
     /**
      * Compute CRC32-C
      */
@@ -73,15 +87,6 @@ class CRCCalculator
 
 };
 
-//extern "C"
-//{
-//uint16_t crc16_T10DIF_128x_extended
-//(
-//uint16_t init_crc,            // initial CRC value, 16 bits
-//const unsigned char* buffer,  // buffer pointer to calculate CRC on
-//size_t bufSize                // buffer length in bytes (64-bit data)
-//);
-//}
 
 
 //extern uint32_t crc32c_sw (uint32_t crc, const unsigned char* buf, size_t len);
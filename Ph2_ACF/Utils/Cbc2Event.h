@@ -23,7 +23,7 @@ namespace Ph2_HwInterface {
      * \class Cbc2Event
      * \brief Event container to manipulate event flux from the Cbc2
      */
-    class Cbc2Event : public Event
+    class Cbc2Event final : public Event
     {
       public:
         /*!
@@ -24,7 +24,7 @@ namespace Ph2_HwInterface {
      * \class Cbc3Event
      * \brief Event container to manipulate event flux from the Cbc2
      */
-    class Cbc3Event : public Event
+    class Cbc3Event final : public Event
     {
       public:
 
@@ -0,0 +1,104 @@
+/*
+
+        FileName :                     ClusterFinder.cc
+        Content :                      Strip clusters of a whole module, across the CBC boundaries
+
+ */
+
+#include "ClusterFinder.h"
+#include "BitKernels.h"
+#include <algorithm>
+
+namespace Ph2_HwInterface {
+
+    ClusterFinder::ClusterFinder ( const Module* pModule ) :
+        fFeId ( pModule->getFeId() ),
+        fFirstCbcId ( 0 ),
+        fNStrips ( 0 )
+    {
+        for ( auto cCbc : pModule->fCbcVector )
+            fCbcIds.push_back ( cCbc->getCbcId() );
+
+        if ( !fCbcIds.empty() )
+        {
+            // disabled CBCs in between keep their place, so that a strip number is a position on the sensor
+            fFirstCbcId = *std::min_element ( fCbcIds.begin(), fCbcIds.end() );
+            fNStrips = ( *std::max_element ( fCbcIds.begin(), fCbcIds.end() ) - fFirstCbcId + 1 ) * STRIPS_PER_CBC;
+        }
+
+        size_t cNWords = ( fNStrips + 63 ) / 64;
+
+        for ( auto& cBitmap : fSensorBitmap )
+            cBitmap.assign ( cNWords, 0 );
+
+        fFirst.resize ( 32 * cNWords );
+        fWidth.resize ( 32 * cNWords );
+    }
+
+    void ClusterFinder::fill ( const Event* pEvent )
+    {
+        for ( auto& cBitmap : fSensorBitmap )
+            std::fill ( cBitmap.begin(), cBitmap.end(), 0 );
+
+        uint64_t cHits[CBC_HIT_BITMAP_SIZE_64];
+        uint32_t cEven[CBC_HIT_BITMAP_SIZE_64];
+        uint32_t cOdd[CBC_HIT_BITMAP_SIZE_64];
+
+        for ( auto cCbcId : fCbcIds )
+        {
+            if ( !pEvent->GetHitBitmap ( fFeId, cCbcId, cHits ) ) continue;
+
+            // channel 2i is strip i of sensor 0, channel 2i + 1 strip i of sensor 1
+            deinterleaveBits ( cHits, cEven, cOdd, CBC_HIT_BITMAP_SIZE_64 );
+            uint64_t cStrips[2][CBC_HIT_BITMAP_SIZE_64 / 2];
+
+            for ( uint32_t i = 0; i < CBC_HIT_BITMAP_SIZE_64 / 2; i++ )
+            {
+                cStrips[0][i] = cEven[2 * i] | uint64_t ( cEven[2 * i + 1] ) << 32;
+                cStrips[1][i] = cOdd[2 * i] | uint64_t ( cOdd[2 * i + 1] ) << 32;
+            }
+
+            uint32_t cPosition = ( cCbcId - fFirstCbcId ) * STRIPS_PER_CBC;
+            insertBits ( fSensorBitmap[0].data(), cPosition, cStrips[0], STRIPS_PER_CBC );
+            insertBits ( fSensorBitmap[1].data(), cPosition, cStrips[1], STRIPS_PER_CBC );
+        }
+    }
+
+    uint32_t ClusterFinder::findClusters ( const Event* pEvent, std::vector<Cluster>& pClusters )
+    {
+        this->fill ( pEvent );
+        uint32_t cNClusters = 0;
+
+        for ( uint8_t cSensor = 0; cSensor < 2; cSensor++ )
+        {
+            uint32_t cNRuns = bitmapToRuns ( fSensorBitmap[cSensor].data(), fSensorBitmap[cSensor].size(), fFirst.data(), fWidth.data() );
+
+            for ( uint32_t i = 0; i < cNRuns; i++ )
+            {
+                Cluster cCluster;
+                cCluster.fSensor = cSensor;
+                cCluster.fFirstStrip = fFirst[i];
+                cCluster.fClusterWidth = fWidth[i];
+                pClusters.push_back ( cCluster );
+            }
+
+            cNClusters += cNRuns;
+        }
+
+        return cNClusters;
+    }
+
+    uint32_t ClusterFinder::findClusters ( const std::vector<Event*>& pEvents, std::vector<std::vector<Cluster>>& pClusters )
+    {
+        pClusters.resize ( pEvents.size() );
+        uint32_t cNClusters = 0;
+
+        for ( size_t cIndex = 0; cIndex < pEvents.size(); cIndex++ )
+        {
+            pClusters[cIndex].clear();
+            cNClusters += this->findClusters ( pEvents[cIndex], pClusters[cIndex] );
+        }
+
+        return cNClusters;
+    }
+}
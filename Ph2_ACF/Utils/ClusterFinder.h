@@ -0,0 +1,95 @@
+/*!
+
+        \file                          ClusterFinder.h
+        \brief                         Strip clusters of a whole module, across the CBC boundaries
+
+ */
+
+#ifndef __CLUSTERFINDER_H__
+#define __CLUSTERFINDER_H__
+
+#include <vector>
+#include "Event.h"
+#include "../HWDescription/Module.h"
+#include "../HWDescription/Definition.h"
+
+using namespace Ph2_HwDescription;
+
+namespace Ph2_HwInterface {
+
+    /*!
+     * \class ClusterFinder
+     * \brief Finds the strip clusters of a module on its two sensors, so that a cluster shared by two neighbouring CBCs is not split
+     *
+     * The hit bitmap of each CBC is split in its two sensors, even channels on sensor 0 and odd channels on sensor 1, and the
+     * CBCs are put end to end: CBC k of the module, counted from its first CBC like in the EUDAQ producer, covers the strips
+     * [127 k, 127 (k + 1) ). The clusters are the runs of set bits of the sensor bitmaps, found a 64 bit word at a time.
+     * The layout of the module is taken once at construction, the finder then only reads the events.
+     */
+    class ClusterFinder
+    {
+      public:
+        /*! \brief Strips of a sensor read out by one CBC */
+        static const uint32_t STRIPS_PER_CBC = NCHANNELS / 2;
+
+        /*!
+         * \brief Constructor of the ClusterFinder class
+         * \param pModule : the module, its CBCs give the sensor length
+         */
+        ClusterFinder ( const Module* pModule );
+
+        /*!
+         * \brief Number of strips of each sensor
+         */
+        uint32_t getNStrips() const
+        {
+            return fNStrips;
+        }
+        /*!
+         * \brief Id of the CBC reading a strip
+         */
+        uint8_t getCbcId ( uint32_t pStrip ) const
+        {
+            return fFirstCbcId + pStrip / STRIPS_PER_CBC;
+        }
+        /*!
+         * \brief Load the hits of the module in an event into the sensor bitmaps
+         * \param pEvent : the event
+         */
+        void fill ( const Event* pEvent );
+        /*!
+         * \brief Bitmap of a sensor after fill(), bit i is strip i
+         * \param pSensor : 0 for the even channels, 1 for the odd channels
+         */
+        const uint64_t* getSensorBitmap ( uint8_t pSensor ) const
+        {
+            return fSensorBitmap[pSensor].data();
+        }
+        /*!
+         * \brief Find the clusters of the module in an event
+         * \param pEvent : the event
+         * \param pClusters : output, the clusters are appended, sensor 0 first and by increasing strip
+         * \return number of clusters appended
+         */
+        uint32_t findClusters ( const Event* pEvent, std::vector<Cluster>& pClusters );
+        /*!
+         * \brief Find the clusters of the module in all the events of an acquisition
+         * \param pEvents : the events
+         * \param pClusters : output, resized to one cluster vector per event
+         * \return total number of clusters
+         */
+        uint32_t findClusters ( const std::vector<Event*>& pEvents, std::vector<std::vector<Cluster>>& pClusters );
+
+      private:
+        uint8_t fFeId;
+        uint8_t fFirstCbcId;
+        std::vector<uint8_t> fCbcIds;
+        uint32_t fNStrips;
+        std::vector<uint64_t> fSensorBitmap[2];
+        // run buffers of bitmapToRuns, kept to not allocate per event
+        std::vector<uint32_t> fFirst;
+        std::vector<uint32_t> fWidth;
+    };
+}
+
+#endif
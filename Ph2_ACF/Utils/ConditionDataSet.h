@@ -47,13 +47,17 @@ class ConditionDataSet
     bool fHasTDC;
 
     ConditionDataSet() :
-        fDebugMode (SLinkDebugMode::SUMMARY)
+        fDebugMode (SLinkDebugMode::SUMMARY),
+        fHasI2C (false),
+        fHasTDC (false)
     {
         fCondDataVector.clear();
     }
 
     ConditionDataSet (SLinkDebugMode pMode, bool pCondData) :
-        fDebugMode (pMode)
+        fDebugMode (pMode),
+        fHasI2C (false),
+        fHasTDC (false)
     {
         fCondDataVector.clear();
     }
@@ -10,6 +10,8 @@
  */
 
 #include "../Utils/D19cCbc3Event.h"
+#include "../Utils/BitKernels.h"
+#include "../Utils/SLinkEncoder.h"
 
 using namespace Ph2_HwDescription;
 
@@ -22,6 +24,11 @@ namespace Ph2_HwInterface {
         SetEvent ( pBoard, pNbCbc, list );
     }
 
+    D19cCbc3Event::D19cCbc3Event ( const BeBoard* pBoard,  uint32_t pNbCbc, const EventBuffer& pBuffer, uint32_t pOffset )
+    {
+        SetEvent ( pBoard, pNbCbc, pBuffer, pOffset );
+    }
+
 
     //D19cCbc3Event::D19cCbc3Event ( const Event& pEvent ) :
     //fBunch ( pEvent.fBunch ),
@@ -37,23 +44,40 @@ namespace Ph2_HwInterface {
     //}
 
     void D19cCbc3Event::SetEvent ( const BeBoard* pBoard, uint32_t pNbCbc, const std::vector<uint32_t>& list )
+    {
+        if ( (0x0000FFFF & list.at (0) ) != list.size() )
+            LOG (ERROR) << "Vector size doesnt match the BLOCK_SIZE in Header1";
+
+        // the event owns a copy of its words, shared by nobody else
+        SetEvent ( pBoard, pNbCbc, std::make_shared<const std::vector<uint32_t>> (list), 0 );
+    }
+
+    void D19cCbc3Event::SetEvent ( const BeBoard* pBoard, uint32_t pNbCbc, const EventBuffer& pBuffer, uint32_t pOffset )
     {
         // these two values come from width of the hybrid/cbc enabled mask
-        uint8_t fMaxHybrids = 8;
-        uint8_t fMaxCBCs = 8;
+        uint8_t fMaxHybrids = EventView::MAX_FE;
+        uint8_t fMaxCBCs = EventView::MAX_CHIP;
 
-        fEventSize = 0x0000FFFF & list.at (0);
+        Clear();
+        fEventSize = 0x0000FFFF & pBuffer->at (pOffset);
 
-        if (fEventSize != list.size() )
-            LOG (ERROR) << "Vector size doesnt match the BLOCK_SIZE in Header1";
+        if (fEventSize < D19C_EVENT_HEADER1_SIZE_32 || pOffset + fEventSize > pBuffer->size() )
+        {
+            LOG (ERROR) << "BLOCK_SIZE in Header1 (" << fEventSize << ") doesnt fit in the readout buffer";
+            fEventSize = 0;
+            return;
+        }
 
-        uint8_t header1_size = (0xFF000000 & list.at (0) ) >> 24;
+        fView.set (pBuffer, pOffset, fEventSize);
+        const uint32_t* list = fView.data();
+
+        uint8_t header1_size = (0xFF000000 & list[0] ) >> 24;
 
         if (header1_size != D19C_EVENT_HEADER1_SIZE_32)
             LOG (ERROR) << "Header1 size doesnt correspond to the one sent from firmware";
 
         uint8_t cNFe_software = static_cast<uint8_t> (pBoard->getNFe() );
-        uint8_t cFeMask = static_cast<uint8_t> ( (0x00FF0000 & list.at (0) ) >> 16);
+        uint8_t cFeMask = static_cast<uint8_t> ( (0x00FF0000 & list[0] ) >> 16);
         uint8_t cNFe_event = 0;
 
         for (uint8_t bit = 0; bit < fMaxHybrids; bit++)
@@ -65,15 +89,15 @@ namespace Ph2_HwInterface {
         if (cNFe_software != cNFe_event)
             LOG (ERROR) << "Number of Modules in event header (" << cNFe_event << ") doesnt match the amount of modules defined in firmware.";
 
-        fDummySize = 0x000000FF & list.at (1);
-        fEventCount = 0x00FFFFFF &  list.at (2);
-        fBunch = 0xFFFFFFFF & list.at (3);
-        fTDC = 0x000000FF & list.at (4);
-        fTLUTriggerID = (0x00FFFF00 & list.at (4) ) >> 8;
+        fDummySize = 0x000000FF & list[1];
+        fEventCount = 0x00FFFFFF &  list[2];
+        fBunch = 0xFFFFFFFF & list[3];
+        fTDC = 0x000000FF & list[4];
+        fTLUTriggerID = (0x00FFFF00 & list[4] ) >> 8;
 
         fBeId = pBoard->getBeId();
         fBeFWType = 0;
-        fCBCDataType = (0x0000FF00 & list.at(1)) >> 8;
+        fCBCDataType = (0x0000FF00 & list[1]) >> 8;
         fBeStatus = 0;
         fNCbc = pNbCbc;
         fEventDataSize = fEventSize;
@@ -86,8 +110,13 @@ namespace Ph2_HwInterface {
         {
             if ( (cFeMask >> cFeId) & 1)
             {
+                if (address_offset + D19C_EVENT_HEADER2_SIZE_32 > fEventSize)
+                {
+                    LOG (ERROR) << "Header2 of FE " << +cFeId << " is beyond the BLOCK_SIZE in Header1";
+                    break;
+                }
 
-                uint8_t chip_data_mask = static_cast<uint8_t> ( ( (0xFF000000) & list.at (address_offset + 0) ) >> 24);
+                uint8_t chip_data_mask = static_cast<uint8_t> ( ( (0xFF000000) & list[address_offset + 0] ) >> 24);
                 uint8_t chips_with_data_nbr = 0;
 
                 for (uint8_t bit = 0; bit < 8; bit++)
@@ -96,12 +125,12 @@ namespace Ph2_HwInterface {
                         chips_with_data_nbr ++;
                 }
 
-                uint8_t header2_size = (0x00FF0000 & list.at (address_offset + 0) ) >> 16;
+                uint8_t header2_size = (0x00FF0000 & list[address_offset + 0] ) >> 16;
 
                 if (header2_size != D19C_EVENT_HEADER2_SIZE_32)
                     LOG (ERROR) << "Header2 size doesnt correspond to the one sent from firmware";
 
-                uint16_t fe_data_size = (0x0000FFFF & list.at (address_offset + 0) );
+                uint16_t fe_data_size = (0x0000FFFF & list[address_offset + 0] );
 
                 if (fe_data_size != CBC_EVENT_SIZE_32_CBC3 * chips_with_data_nbr + D19C_EVENT_HEADER2_SIZE_32)
                     LOG (ERROR) << "Event size doesnt correspond to the one sent from firmware";
@@ -114,20 +143,18 @@ namespace Ph2_HwInterface {
                     // check if we have data from this chip
                     if ( (chip_data_mask >> cCbcId) & 1)
                     {
+                        if (data_offset + CBC_EVENT_SIZE_32_CBC3 > fEventSize)
+                        {
+                            LOG (ERROR) << "Data of FE " << +cFeId << " CBC " << +cCbcId << " is beyond the BLOCK_SIZE in Header1";
+                            break;
+                        }
 
                         //check the sync bit
-			uint8_t cSyncBit = (0x00000008 & list.at(data_offset+10)) >> 3;
+			uint8_t cSyncBit = (0x00000008 & list[data_offset+10]) >> 3;
 
                         if (!cSyncBit) LOG (INFO) << BOLDRED << "Warning, sync bit not 1, data frame probably misaligned!" << RESET;
 
-                        uint16_t cKey = encodeId (cFeId, cCbcId);
-
-                        uint32_t begin = data_offset;
-                        uint32_t end = begin + CBC_EVENT_SIZE_32_CBC3;
-
-                        std::vector<uint32_t> cCbcData (std::next (std::begin (list), begin), std::next (std::begin (list), end) );
-
-                        fEventDataMap[cKey] = cCbcData;
+                        fView.setChip (cFeId, cCbcId, data_offset);
 
                         data_offset += CBC_EVENT_SIZE_32_CBC3;
                     }
@@ -199,13 +226,12 @@ namespace Ph2_HwInterface {
 
     uint32_t D19cCbc3Event::Error ( uint8_t pFeId, uint8_t pCbcId ) const
     {
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
+        const uint32_t* cData = fView.chip (pFeId, pCbcId);
 
-        if (cData != std::end (fEventDataMap) )
+        if (cData != nullptr)
         {
             // buf overflow and lat error
-            uint32_t cError = ( (cData->second.at (8) & 0x00000003) >> 0 );;
+            uint32_t cError = ( (cData[8] & 0x00000003) >> 0 );;
             return cError;
         }
         else
@@ -217,12 +243,11 @@ namespace Ph2_HwInterface {
 
     uint32_t D19cCbc3Event::PipelineAddress ( uint8_t pFeId, uint8_t pCbcId ) const
     {
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
+        const uint32_t* cData = fView.chip (pFeId, pCbcId);
 
-        if (cData != std::end (fEventDataMap) )
+        if (cData != nullptr)
         {
-            uint32_t cPipeAddress = ( (cData->second.at (8) & 0x00001FF0) >> 4 );
+            uint32_t cPipeAddress = ( (cData[8] & 0x00001FF0) >> 4 );
             return cPipeAddress;
         }
         else
@@ -232,39 +257,11 @@ namespace Ph2_HwInterface {
         }
     }
 
-    bool D19cCbc3Event::DataBit ( uint8_t pFeId, uint8_t pCbcId, uint32_t i ) const
-    {
-        if ( i >= NCHANNELS )
-            return 0;
-
-        uint32_t cWordP = 0;
-        uint32_t cBitP = 0;
-        calculate_address (cWordP, cBitP, i);
-
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
-
-        if (cData != std::end (fEventDataMap) )
-        {
-            if (cWordP >= cData->second.size() ) return false;
-
-            return ( (cData->second.at (cWordP) >> (cBitP) ) & 0x1);
-        }
-        else
-        {
-            LOG (INFO) << "Event: FE " << +pFeId << " CBC " << +pCbcId << " is not found." ;
-            return false;
-        }
-
-        //return Bit ( pFeId, pCbcId, i + OFFSET_CBCDATA );
-    }
-
     std::string D19cCbc3Event::DataBitString ( uint8_t pFeId, uint8_t pCbcId ) const
     {
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
+        const uint32_t* cData = fView.chip (pFeId, pCbcId);
 
-        if (cData != std::end (fEventDataMap) )
+        if (cData != nullptr)
         {
             std::ostringstream os;
 
@@ -275,9 +272,9 @@ namespace Ph2_HwInterface {
                 uint32_t cBitP = 0;
                 calculate_address (cWordP, cBitP, i);
 
-                if ( cWordP >= cData->second.size() ) break;
+                if ( cWordP >= CBC_EVENT_SIZE_32_CBC3 ) break;
 
-                os << ( ( cData->second.at (cWordP) >> (cBitP ) ) & 0x1 );
+                os << ( ( cData[cWordP] >> (cBitP ) ) & 0x1 );
             }
 
             return os.str();
@@ -295,10 +292,9 @@ namespace Ph2_HwInterface {
     std::vector<bool> D19cCbc3Event::DataBitVector ( uint8_t pFeId, uint8_t pCbcId ) const
     {
         std::vector<bool> blist;
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
+        const uint32_t* cData = fView.chip (pFeId, pCbcId);
 
-        if (cData != std::end (fEventDataMap) )
+        if (cData != nullptr)
         {
             std::ostringstream os;
 
@@ -309,9 +305,9 @@ namespace Ph2_HwInterface {
                 uint32_t cBitP = 0;
                 calculate_address (cWordP, cBitP, i);
 
-                if ( cWordP >= cData->second.size() ) break;
+                if ( cWordP >= CBC_EVENT_SIZE_32_CBC3 ) break;
 
-                blist.push_back ( ( cData->second.at (cWordP) >> (cBitP ) ) & 0x1 );
+                blist.push_back ( ( cData[cWordP] >> (cBitP ) ) & 0x1 );
             }
         }
         else
@@ -324,10 +320,9 @@ namespace Ph2_HwInterface {
     {
         std::vector<bool> blist;
 
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
+        const uint32_t* cData = fView.chip (pFeId, pCbcId);
 
-        if (cData != std::end (fEventDataMap) )
+        if (cData != nullptr)
         {
             for ( auto i :  channelList )
             {
@@ -336,9 +331,9 @@ namespace Ph2_HwInterface {
                 uint32_t cBitP = 0;
                 calculate_address (cWordP, cBitP, i);
 
-                if ( cWordP >= cData->second.size() ) break;
+                if ( cWordP >= CBC_EVENT_SIZE_32_CBC3 ) break;
 
-                blist.push_back ( ( cData->second.at (cWordP) >> (cBitP ) ) & 0x1 );
+                blist.push_back ( ( cData[cWordP] >> (cBitP ) ) & 0x1 );
             }
         }
         else
@@ -371,14 +366,13 @@ namespace Ph2_HwInterface {
     bool D19cCbc3Event::StubBit ( uint8_t pFeId, uint8_t pCbcId ) const
     {
         //here just OR the stub positions
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
+        const uint32_t* cData = fView.chip (pFeId, pCbcId);
 
-        if (cData != std::end (fEventDataMap) )
+        if (cData != nullptr)
         {
-            uint8_t pos1 = (cData->second.at (9) & 0x000000FF);
-            uint8_t pos2 = (cData->second.at (9) & 0x0000FF00) >> 8;
-            uint8_t pos3 = (cData->second.at (9) & 0x00FF0000) >> 16;
+            uint8_t pos1 = (cData[9] & 0x000000FF);
+            uint8_t pos2 = (cData[9] & 0x0000FF00) >> 8;
+            uint8_t pos3 = (cData[9] & 0x00FF0000) >> 16;
             return (pos1 || pos2 || pos3);
         }
         else
@@ -388,93 +382,17 @@ namespace Ph2_HwInterface {
         }
     }
 
-    std::vector<Stub> D19cCbc3Event::StubVector (uint8_t pFeId, uint8_t pCbcId) const
+    bool D19cCbc3Event::chipNotFound ( uint8_t pFeId, uint8_t pCbcId ) const
     {
-        std::vector<Stub> cStubVec;
-        //here create stubs and return the vector
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
-
-        if (cData != std::end (fEventDataMap) )
-        {
-            uint8_t pos1 =  (cData->second.at (9) &  0x000000FF) ;
-            uint8_t pos2 =   (cData->second.at (9) & 0x0000FF00) >> 8;
-            uint8_t pos3 =   (cData->second.at (9) & 0x00FF0000) >> 16;
-            //LOG (DEBUG) << std::bitset<8> (pos1);
-            //LOG (DEBUG) << std::bitset<8> (pos2);
-            //LOG (DEBUG) << std::bitset<8> (pos3);
-            uint8_t bend1 = (cData->second.at (10) & 0x00000F00) >> 8;
-            uint8_t bend2 = (cData->second.at (10) & 0x000F0000) >> 16;
-            uint8_t bend3 = (cData->second.at (10) & 0x0F000000) >> 24;
-
-            if (pos1 != 0 ) cStubVec.emplace_back (pos1, bend1) ;
-
-            if (pos2 != 0 ) cStubVec.emplace_back (pos2, bend2) ;
-
-            if (pos3 != 0 ) cStubVec.emplace_back (pos3, bend3) ;
-        }
-        else
-            LOG (INFO) << "Event: FE " << +pFeId << " CBC " << +pCbcId << " is not found." ;
-
-        return cStubVec;
-    }
-
-    uint32_t D19cCbc3Event::GetNHits (uint8_t pFeId, uint8_t pCbcId) const
-    {
-        uint32_t cNHits = 0;
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
-
-
-        if (cData != std::end (fEventDataMap) )
-        {
-            cNHits += __builtin_popcount ( cData->second.at (7) & 0x7FFFFFFF);
-            cNHits += __builtin_popcount ( cData->second.at (6) & 0xFFFFFFFF);
-            cNHits += __builtin_popcount ( cData->second.at (5) & 0xFFFFFFFF);
-            cNHits += __builtin_popcount ( cData->second.at (4) & 0xFFFFFFFF);
-
-            cNHits += __builtin_popcount ( cData->second.at (3) & 0x7FFFFFFF);
-            cNHits += __builtin_popcount ( cData->second.at (2) & 0xFFFFFFFF);
-            cNHits += __builtin_popcount ( cData->second.at (1) & 0xFFFFFFFF);
-            cNHits += __builtin_popcount ( cData->second.at (0) & 0xFFFFFFFF);
-        }
-        else
-            LOG (INFO) << "Event: FE " << +pFeId << " CBC " << +pCbcId << " is not found." ;
-
-        return cNHits;
-    }
-
-    std::vector<uint32_t> D19cCbc3Event::GetHits (uint8_t pFeId, uint8_t pCbcId) const
-    {
-        std::vector<uint32_t> cHits;
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
-
-        if (cData != std::end (fEventDataMap) )
-        {
-            for ( uint32_t i = 0; i < NCHANNELS; ++i )
-            {
-                uint32_t cWordP = 0;
-                uint32_t cBitP = 0;
-                calculate_address (cWordP, cBitP, i);
-
-                if ( cWordP >= cData->second.size() ) break;
-
-                if ( ( cData->second.at (cWordP) >> ( cBitP ) ) & 0x1) cHits.push_back (i);
-            }
-        }
-        else
-            LOG (INFO) << "Event: FE " << +pFeId << " CBC " << +pCbcId << " is not found." ;
-
-        return cHits;
+        LOG (INFO) << "Event: FE " << +pFeId << " CBC " << +pCbcId << " is not found." ;
+        return false;
     }
 
     void D19cCbc3Event::printCbcHeader (std::ostream& os, uint8_t pFeId, uint8_t pCbcId) const
     {
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
+        const uint32_t* cData = fView.chip (pFeId, pCbcId);
 
-        if (cData != std::end (fEventDataMap) )
+        if (cData != nullptr)
         {
             uint8_t cBeId =  0;
             uint8_t cFeId =  pFeId;
@@ -509,11 +427,12 @@ namespace Ph2_HwInterface {
         const int LAST_LINE_WIDTH = 8;
 
 
-        for (auto const& cKey : this->fEventDataMap)
+        for (uint16_t cIndex = 0; cIndex < EventView::MAX_FE * EventView::MAX_CHIP; cIndex++)
         {
-            uint8_t cFeId;
-            uint8_t cCbcId;
-            this->decodeId (cKey.first, cFeId, cCbcId);
+            uint8_t cFeId = cIndex / EventView::MAX_CHIP;
+            uint8_t cCbcId = cIndex % EventView::MAX_CHIP;
+
+            if (!fView.hasChip (cFeId, cCbcId) ) continue;
 
             //here display the Cbc Header manually
             this->printCbcHeader (os, cFeId, cCbcId);
@@ -642,138 +561,10 @@ namespace Ph2_HwInterface {
     }
     SLinkEvent D19cCbc3Event::GetSLinkEvent (  BeBoard* pBoard) const
     {
-        uint16_t cCbcCounter = 0;
-        std::set<uint8_t> cEnabledFe;
-
-        //payload for the status bits
-        GenericPayload cStatusPayload;
-        //for the payload and the stubs
-        GenericPayload cPayload;
-        GenericPayload cStubPayload;
-
-        for (auto cFe : pBoard->fModuleVector)
-        {
-            uint8_t cFeId = cFe->getFeId();
-
-            // firt get the list of enabled front ends
-            if (cEnabledFe.find (cFeId) == std::end (cEnabledFe) )
-                cEnabledFe.insert (cFeId);
-
-            //now on to the payload
-            uint16_t cCbcPresenceWord = 0;
-            int cFirstBitFePayload = cPayload.get_current_write_position();
-            int cFirstBitFeStub = cStubPayload.get_current_write_position();
-            //stub counter per FE
-            uint8_t cFeStubCounter = 0;
-
-            for (auto cCbc : cFe->fCbcVector)
-            {
-                uint8_t cCbcId = cCbc->getCbcId();
-                uint16_t cKey = encodeId (cFeId, cCbcId);
-                EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
-
-                if (cData != std::end (fEventDataMap) )
-                {
-                    uint16_t cError = ( cData->second.at (8) & 0x00000003 );
-
-                    //now get the CBC status summary
-                    if (pBoard->getConditionDataSet()->getDebugMode() == SLinkDebugMode::ERROR)
-                        cStatusPayload.append ( (cError != 0) ? 1 : 0);
-
-                    else if (pBoard->getConditionDataSet()->getDebugMode() == SLinkDebugMode::FULL)
-                    {
-                        //assemble the error bits (63, 62, pipeline address and L1A counter) into a status word
-                        uint16_t cPipeAddress = (cData->second.at (8) & 0x00001FF0) >> 4;
-                        uint16_t cL1ACounter = (cData->second.at (8) &  0x01FF0000) >> 16;
-                        uint32_t cStatusWord = cError << 18 | cPipeAddress << 9 | cL1ACounter;
-                        cStatusPayload.append (cStatusWord, 20);
-                    }
-
-                    //generate the payload
-                    //the first line sets the cbc presence bits
-                    cCbcPresenceWord |= 1 << cCbcId;
-
-                    //first CBC3 channel data word
-                    //since the D19C FW splits in even and odd channels, I need to
-                    //Morton-encode these bits into words of the double size
-                    //but first I need to reverse the bit order
-                    uint32_t cFirstChanWordEven = reverse_bits (cData->second.at (3) ) >> 1;
-                    uint32_t cFirstChanWordOdd = reverse_bits (cData->second.at (7) ) >> 1;
-                    //now both words are swapped to have channel 0/1 at bit 30 and channel 60/61 at bit 0
-                    //I can now interleave/morton encode and append them but only the 62 LSBs
-                    cPayload.appendD19CData (cFirstChanWordEven, cFirstChanWordOdd, 62);
-
-                    for (size_t i = 3; i > 0; i--)
-                    {
-                        uint32_t cEvenWord = reverse_bits (cData->second.at (i - 1) );
-                        uint32_t cOddWord = reverse_bits (cData->second.at (i + 3) );
-                        cPayload.appendD19CData (cEvenWord, cOddWord);
-                    }
-
-                    //don't forget the two padding 0s
-                    cPayload.padZero (2);
-
-                    //stubs
-                    uint8_t pos1 =  (cData->second.at (9) &  0x000000FF) ;
-                    uint8_t pos2 =   (cData->second.at (9) & 0x0000FF00) >> 8;
-                    uint8_t pos3 =   (cData->second.at (9) & 0x00FF0000) >> 16;
-                    uint8_t bend1 = (cData->second.at (10) & 0x00000F00) >> 8;
-                    uint8_t bend2 = (cData->second.at (10) & 0x000F0000) >> 16;
-                    uint8_t bend3 = (cData->second.at (10) & 0x0F000000) >> 24;
-
-                    if (pos1 != 0)
-                    {
-                        cStubPayload.append ( uint16_t ( (cCbcId & 0x0F) << 12 | pos1 << 4 | (bend1 & 0xF)) );
-                        cFeStubCounter++;
-                    }
-
-                    if (pos2 != 0)
-                    {
-                        cStubPayload.append ( uint16_t ( (cCbcId & 0x0F) << 12 | pos2 << 4 | (bend2 & 0xF)) );
-                        cFeStubCounter++;
-                    }
-
-                    if (pos3 != 0)
-                    {
-                        cStubPayload.append ( uint16_t ( (cCbcId & 0x0F) << 12 | pos3 << 4 | (bend3 & 0xF)) );
-                        cFeStubCounter++;
-                    }
-                }
-
-                cCbcCounter++;
-            } // end of CBC loop
-
-            //for the payload, I need to insert the status word at the index I remembered before
-            cPayload.insert (cCbcPresenceWord, cFirstBitFePayload );
-
-            //for the stubs for this FE, I need to prepend a 5 bit counter shifted by 1 to the right (to account for the 0 bit)
-            cStubPayload.insert ( (cFeStubCounter & 0x1F) << 1, cFirstBitFeStub, 6);
-
-        } // end of Fe loop
-
-        uint32_t cEvtCount = this->GetEventCount();
-        uint16_t cBunch = static_cast<uint16_t> (this->GetBunch() );
-        uint32_t cBeStatus = this->fBeStatus;
-        SLinkEvent cEvent (EventType::VR, pBoard->getConditionDataSet()->getDebugMode(), ChipType::CBC3, cEvtCount, cBunch, SOURCE_ID );
-        cEvent.generateTkHeader (cBeStatus, cCbcCounter, cEnabledFe, pBoard->getConditionDataSet()->getCondDataEnabled(), false);  // Be Status, total number CBC, condition data?, fake data?
-
-        //generate a vector of uint64_t with the chip status
-        if (pBoard->getConditionDataSet()->getDebugMode() != SLinkDebugMode::SUMMARY) // do nothing
-            cEvent.generateStatus (cStatusPayload.Data<uint64_t>() );
-
-        //PAYLOAD
-        cEvent.generatePayload (cPayload.Data<uint64_t>() );
-
-        //STUBS
-        cEvent.generateStubs (cStubPayload.Data<uint64_t>() );
-
-        // condition data, first update the values in the vector for I2C values
-        uint32_t cTDC = this->GetTDC();
-        pBoard->updateCondData (cTDC);
-        cEvent.generateConditionData (pBoard->getConditionDataSet() );
-
-        cEvent.generateDAQTrailer();
-
-        return cEvent;
+        // to encode many events, use one SLinkEncoder for all of them
+        SLinkEncoder cEncoder (pBoard);
+        std::vector<uint64_t> cData (cEncoder.getSize64 (*this) );
+        cEncoder.encode (*this, cData.data() );
+        return SLinkEvent (EventType::VR, cEncoder.getDebugMode(), ChipType::CBC3, std::move (cData) );
     }
 }
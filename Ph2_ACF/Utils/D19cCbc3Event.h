@@ -13,6 +13,7 @@
 #define __D19cCbc3Event_H__
 
 #include "Event.h"
+#include "EventView.h"
 
 
 using namespace Ph2_HwDescription;
@@ -23,8 +24,11 @@ namespace Ph2_HwInterface {
      * \class Cbc3Event
      * \brief Event container to manipulate event flux from the Cbc2
      */
-    class D19cCbc3Event : public Event
+    class D19cCbc3Event final : public Event
     {
+        // reads the CBC data in place
+        friend class SLinkEncoder;
+
       public:
         /*!
          * \brief Constructor of the Event Class
@@ -33,6 +37,14 @@ namespace Ph2_HwInterface {
          * \param pEventBuf : the pointer to the raw Event buffer of this Event
          */
         D19cCbc3Event ( const BeBoard* pBoard, uint32_t pNbCbc, const std::vector<uint32_t>& list );
+        /*!
+         * \brief Constructor of the Event Class, without copying the event data
+         * \param pBoard : Board to work with
+         * \param pNbCbc
+         * \param pBuffer : raw readout buffer, shared with the other events of the same readout
+         * \param pOffset : first word of this Event in pBuffer
+         */
+        D19cCbc3Event ( const BeBoard* pBoard, uint32_t pNbCbc, const EventBuffer& pBuffer, uint32_t pOffset );
         /*!
          * \brief Copy Constructor of the Event Class
          */
@@ -49,6 +61,19 @@ namespace Ph2_HwInterface {
          * \return Aknowledgement of the Event setting (1/0)
          */
         void SetEvent ( const BeBoard* pBoard, uint32_t pNbCbc, const std::vector<uint32_t>& list ) override;
+        /*!
+         * \brief Set the Event as a view over a shared raw buffer
+         * \param pBuffer : raw readout buffer
+         * \param pOffset : first word of this Event in pBuffer
+         */
+        void SetEvent ( const BeBoard* pBoard, uint32_t pNbCbc, const EventBuffer& pBuffer, uint32_t pOffset );
+        /*!
+         * \brief Release the raw buffer, the Event can then be set again
+         */
+        void Clear() override
+        {
+            fView = EventView();
+        }
 
         /*!
          * \brief Get the Cbc Event counter
@@ -126,7 +151,21 @@ namespace Ph2_HwInterface {
          * \param i : pixel bit data number i
          * \return Data Bit
          */
-        bool DataBit ( uint8_t pFeId, uint8_t pCbcId, uint32_t i ) const override;
+        bool DataBit ( uint8_t pFeId, uint8_t pCbcId, uint32_t i ) const override
+        {
+            if ( i >= NCHANNELS )
+                return false;
+
+            const uint32_t* cData = fView.chip (pFeId, pCbcId);
+
+            if (cData == nullptr)
+                return chipNotFound (pFeId, pCbcId);
+
+            uint32_t cWordP = 0;
+            uint32_t cBitP = 0;
+            calculate_address (cWordP, cBitP, i);
+            return ( (cData[cWordP] >> cBitP) & 0x1);
+        }
         /*!
          * \brief Function to get bit string of CBC data
          * \param pFeId : FE Id
@@ -168,7 +207,27 @@ namespace Ph2_HwInterface {
         * \param pFeId : FE Id
         * \param pCbcId : Cbc Id
         */
-        std::vector<Stub> StubVector (uint8_t pFeId, uint8_t pCbcId ) const override;
+        std::vector<Stub> StubVector (uint8_t pFeId, uint8_t pCbcId ) const override
+        {
+            std::vector<Stub> cStubVec;
+            const uint32_t* cData = fView.chip (pFeId, pCbcId);
+
+            if (cData == nullptr)
+            {
+                chipNotFound (pFeId, pCbcId);
+                return cStubVec;
+            }
+
+            // up to 3 stubs, position in the bytes of word 9 and bend in the nibbles of word 10
+            for (uint32_t cStub = 0; cStub < 3; cStub++)
+            {
+                uint8_t cPosition = (cData[9] >> (8 * cStub) ) & 0xFF;
+
+                if (cPosition != 0) cStubVec.emplace_back (cPosition, (cData[10] >> (8 * cStub + 8) ) & 0xF);
+            }
+
+            return cStubVec;
+        }
 
         /*!
         * \brief Function to count the Hits in this event
@@ -176,29 +235,89 @@ namespace Ph2_HwInterface {
         * \param pCbcId : Cbc Id
         * \return number of hits
         */
-        uint32_t GetNHits (uint8_t pFeId, uint8_t pCbcId) const override;
+        uint32_t GetNHits (uint8_t pFeId, uint8_t pCbcId) const override
+        {
+            const uint32_t* cData = fView.chip (pFeId, pCbcId);
+
+            if (cData == nullptr)
+                return chipNotFound (pFeId, pCbcId);
+
+            // words 3 and 7 hold 31 channels each, the other words 32
+            uint32_t cNHits = __builtin_popcount (cData[3] & 0x7FFFFFFF) + __builtin_popcount (cData[7] & 0x7FFFFFFF);
+
+            for (uint32_t cWord : {0, 1, 2, 4, 5, 6})
+                cNHits += __builtin_popcount (cData[cWord]);
+
+            return cNHits;
+        }
         /*!
         * \brief Function to get a sparsified hit vector
         * \param pFeId : FE Id
         * \param pCbcId : Cbc Id
         * \return vector with hit channels
         */
-        std::vector<uint32_t> GetHits (uint8_t pFeId, uint8_t pCbcId) const override;
+        std::vector<uint32_t> GetHits (uint8_t pFeId, uint8_t pCbcId) const override
+        {
+            std::vector<uint32_t> cHits;
+            uint64_t cBitmap[CBC_HIT_BITMAP_SIZE_64];
+
+            if (this->GetHitBitmap (pFeId, pCbcId, cBitmap) )
+            {
+                cHits.resize (64 * CBC_HIT_BITMAP_SIZE_64);
+                cHits.resize (bitmapToHits (cBitmap, CBC_HIT_BITMAP_SIZE_64, cHits.data() ) );
+            }
+
+            return cHits;
+        }
+        /*!
+        * \brief Function to get the hits as a bitmap, bit i is channel i
+        * \param pFeId : FE Id
+        * \param pCbcId : Cbc Id
+        * \param pBitmap : CBC_HIT_BITMAP_SIZE_64 words
+        * \return false if the CBC is not in the event
+        */
+        bool GetHitBitmap (uint8_t pFeId, uint8_t pCbcId, uint64_t* pBitmap) const override
+        {
+            const uint32_t* cData = fView.chip (pFeId, pCbcId);
+
+            if (cData == nullptr)
+                return chipNotFound (pFeId, pCbcId);
+
+            d19cCbc3HitBitmap (cData, pBitmap);
+            return true;
+        }
 
         std::vector<Cluster> getClusters ( uint8_t pFeId, uint8_t pCbcId) const override;
 
         void print (std::ostream& out) const override;
 
-      private:
-        uint32_t reverse_bits ( uint32_t n) const
+      protected:
+        const uint32_t* GetCbcWords ( uint8_t pFeId, uint8_t pCbcId, uint32_t& pSize ) const override
         {
-            n = ( (n >> 1) & 0x55555555) | ( (n << 1) & 0xaaaaaaaa) ;
-            n = ( (n >> 2) & 0x33333333) | ( (n << 2) & 0xcccccccc) ;
-            n = ( (n >> 4) & 0x0f0f0f0f) | ( (n << 4) & 0xf0f0f0f0) ;
-            n = ( (n >> 8) & 0x00ff00ff) | ( (n << 8) & 0xff00ff00) ;
-            n = ( (n >> 16) & 0x0000ffff) | ( (n << 16) & 0xffff0000) ;
-            return n;
+            pSize = CBC_EVENT_SIZE_32_CBC3;
+            return fView.chip (pFeId, pCbcId);
+        }
+
+        void GetCbcKeys ( std::vector<uint16_t>& pKeys ) const override
+        {
+            pKeys.clear();
+
+            for (uint8_t cFeId = 0; cFeId < EventView::MAX_FE; cFeId++)
+            {
+                for (uint8_t cCbcId = 0; cCbcId < EventView::MAX_CHIP; cCbcId++)
+                {
+                    if (fView.hasChip (cFeId, cCbcId) ) pKeys.push_back (encodeId (cFeId, cCbcId) );
+                }
+            }
         }
+
+      private:
+        // the CBC data is not copied to fEventDataMap, it is read in place from the raw buffer
+        EventView fView;
+
+        // kept out of line so that the inline accessors stay small, always returns false
+        bool chipNotFound ( uint8_t pFeId, uint8_t pCbcId ) const;
+
         void calculate_address (uint32_t& cWordP, uint32_t& cBitP, uint32_t i) const
         {
             // we have odd and even channels, so let's first define the oddness.
@@ -227,7 +346,7 @@ namespace Ph2_HwInterface {
             else if (i >= 126 && i <= 189)
             {
                 cWordP = cWordP - 2;
-                cBitP = (int) ( (i - 62) / 2);
+                cBitP = (int) ( (i - 126) / 2);
             }
             else if (i >= 190)
             {
@@ -131,7 +131,8 @@ namespace Ph2_HwInterface {
 
                 }
 
-                address_offset = address_offset + fe_data_size;
+                // fe_data_size counts the header2 that was already skipped
+                address_offset = address_offset + fe_data_size - D19C_EVENT_HEADER2_SIZE_32;
 
             }
 
@@ -23,7 +23,7 @@ namespace Ph2_HwInterface {
      * \class Cbc3Event
      * \brief Event container to manipulate event flux from the Cbc2
      */
-    class D19cCbc3EventZS : public Event
+    class D19cCbc3EventZS final : public Event
     {
       public:
         /*!
@@ -23,7 +23,7 @@ namespace Ph2_HwInterface {
      * \class MPAEvent
      * \brief Event container to manipulate event flux from the MPA2
      */
-    class D19cMPAEvent : public Event
+    class D19cMPAEvent final : public Event
     {
       public:
         /*!
@@ -10,7 +10,65 @@
  */
 
 #include "../Utils/Data.h"
+#include "../Utils/BitKernels.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace {
+    // below this many ZS events per thread, starting the thread costs more than it saves
+    const size_t MIN_ZS_EVENTS_PER_THREAD = 64;
+
+    // extra ZS decoding threads running in the process: the decodings of all the boards and pipeline decoders
+    // share one thread per core, so that concurrent Data::Set calls do not oversubscribe the machine
+    std::atomic<uint32_t> gNZSThreads ( 0 );
+
+    // take up to pNThreads from the shared budget, returns how many were granted
+    uint32_t reserveZSThreads ( uint32_t pNThreads )
+    {
+        uint32_t cBudget = std::max ( 1u, std::thread::hardware_concurrency() ) - 1;
+        uint32_t cUsed = gNZSThreads.load();
+        uint32_t cGranted = 0;
+
+        do
+        {
+            cGranted = ( cUsed < cBudget ) ? std::min ( pNThreads, cBudget - cUsed ) : 0;
+        }
+        while ( cGranted > 0 && !gNZSThreads.compare_exchange_weak ( cUsed, cUsed + cGranted ) );
+
+        return cGranted;
+    }
+
+    // event class built by Data::decodeFixedSize, the GLIB family (CBC2) by default
+    template<BoardType B, ChipType C, EventType E>
+    struct FixedSizeEvent
+    {
+        using type = Ph2_HwInterface::Cbc2Event;
+    };
+
+    template<ChipType C>
+    struct FixedSizeEvent<BoardType::CBC3FC7, C, EventType::VR>
+    {
+        using type = Ph2_HwInterface::Cbc3Event;
+    };
+
+    template<>
+    struct FixedSizeEvent<BoardType::D19C, ChipType::MPA, EventType::VR>
+    {
+        using type = Ph2_HwInterface::D19cMPAEvent;
+    };
+
+    // ZS readout of the older boards, their events still have a fixed size
+    template<BoardType B, ChipType C>
+    struct FixedSizeEvent<B, C, EventType::ZS>
+    {
+        using type = Ph2_HwInterface::D19cCbc3EventZS;
+    };
+}
 
 namespace Ph2_HwInterface {
     //Data Class
@@ -22,7 +80,9 @@ namespace Ph2_HwInterface {
         fNevents ( pD.fNevents ),
         fCurrentEvent ( pD.fCurrentEvent ),
         fNCbc ( pD.fNCbc ),
-        fEventSize ( pD.fEventSize )
+        fEventSize ( pD.fEventSize ),
+        fPooledEvents ( false ),
+        fNThreads ( pD.fNThreads )
     {
     }
 
@@ -36,6 +96,39 @@ namespace Ph2_HwInterface {
     }
 
 
+    template<BoardType B, ChipType C, EventType E>
+    void Data::decodeFixedSize (const BeBoard* pBoard, const std::vector<uint32_t>& pData, uint32_t pNChips)
+    {
+        using EventT = typename FixedSizeEvent<B, C, E>::type;
+
+        if (fEventSize == 0) return;
+
+        std::vector<uint32_t> cEventData (fEventSize);
+        fEventList.reserve (fNevents);
+
+        for (size_t cOffset = 0; cOffset + fEventSize <= pData.size() && fEventList.size() < fNevents; cOffset += fEventSize)
+        {
+            std::copy (pData.begin() + cOffset, pData.begin() + cOffset + fEventSize, cEventData.begin() );
+
+            // the Strasbourg supervisor sends the words byte swapped
+            if (B == BoardType::SUPERVISOR)
+            {
+                for (auto& cWord : cEventData)
+                    this->setStrasbourgSupervisor (cWord);
+            }
+
+#ifdef __CBCDAQ_DEV__
+
+            for (uint32_t cWordIndex = 0; cWordIndex < fEventSize; cWordIndex++)
+                LOG (DEBUG) << std::setw (3) << "Original " << cOffset + cWordIndex << " ### " << std::bitset<32> (pData.at (cOffset + cWordIndex) );
+
+#endif
+            fEventList.push_back ( new EventT ( pBoard, pNChips, cEventData ) );
+        }
+
+        fAllocStats.fNEventsAllocated += fEventList.size();
+    }
+
     void Data::privateSet (const BeBoard* pBoard, const std::vector<uint32_t>& pData, uint32_t pNevents, BoardType pType)
     {
         Reset();
@@ -63,108 +156,279 @@ namespace Ph2_HwInterface {
         else if (pType == BoardType::CBC3FC7) fNCbc = (fEventSize - (EVENT_HEADER_SIZE_32_CBC3) ) / (CBC_EVENT_SIZE_32_CBC3);
         else fNCbc = ( fEventSize - ( EVENT_HEADER_TDC_SIZE_32 ) ) / ( CBC_EVENT_SIZE_32 );
 
-        // to fill fEventList
-        std::vector<uint32_t> lvec;
+        // D19C CBC3 events only keep offsets into one shared copy of the readout, nothing is copied per event
+        if (pType == BoardType::D19C && fEventType != EventType::ZS && pBoard->getChipType() == ChipType::CBC3)
+        {
+            // the pooled events released their views in Reset(), so the buffer can be refilled unless someone kept an event copy
+            if (fBuffer && fBuffer.use_count() == 1)
+            {
+                fBuffer->assign (pData.begin(), pData.end() );
+                fAllocStats.fNBuffersReused++;
+            }
+            else
+            {
+                fBuffer = std::make_shared<std::vector<uint32_t>> (pData);
+                fAllocStats.fNBuffersAllocated++;
+            }
+
+            EventBuffer cBuffer = fBuffer;
+            fPooledEvents = true;
+            fEventList.reserve (fNevents);
+
+            for (uint32_t cOffset = 0; cOffset + fEventSize <= pData.size() && fEventList.size() < fNevents; cOffset += fEventSize)
+            {
+                if (fEventList.size() < fD19cCbc3Pool.size() )
+                {
+                    D19cCbc3Event* cEvent = fD19cCbc3Pool.at (fEventList.size() ).get();
+                    cEvent->SetEvent ( pBoard, fNCbc, cBuffer, cOffset );
+                    fEventList.push_back ( cEvent );
+                    fAllocStats.fNEventsReused++;
+                }
+                else
+                {
+                    fD19cCbc3Pool.emplace_back ( new D19cCbc3Event ( pBoard, fNCbc, cBuffer, cOffset ) );
+                    fEventList.push_back ( fD19cCbc3Pool.back().get() );
+                    fAllocStats.fNEventsAllocated++;
+                }
+            }
 
-        //use a SwapIndex to decide wether to swap a word or not
-        //use a WordIndex to pick events apart
-        uint32_t cWordIndex = 0;
-        uint32_t cSwapIndex = 0;
-        // index of the word inside the event (ZS)
-        uint32_t fZSEventSize = 0;
-        uint32_t cZSWordIndex = 0;
+            return;
+        }
 
-        for ( auto word : pData )
+        // ZS events have their own size: the boundaries are found first, then the events are built in parallel
+        if (pType == BoardType::D19C && fEventType == EventType::ZS)
         {
-            //if the SwapIndex is greater than 0 and a multiple of the event size in 32 bit words, reset SwapIndex to 0
-            if (cSwapIndex > 0 && cSwapIndex % fEventSize == 0) cSwapIndex = 0;
+            std::vector<size_t> cOffsets;
+            this->scanD19cEvents (pData, fNevents, cOffsets);
+            this->decodeD19cZS (pBoard, pData, cOffsets);
+            return;
+        }
 
-            if (pType == BoardType::ICGLIB || pType == BoardType::ICFC7)
-                this->setIC (word, cWordIndex, cSwapIndex);
-            else if (pType == BoardType::SUPERVISOR)
-                this->setStrasbourgSupervisor (word);
+        // the IC firmware sends the channel data bit reversed, whole events are flipped at once
+        std::vector<uint32_t> cICData;
 
-            //else if (pType == BoardType::CBC3FC7)
-            //this->setCbc3Fc7 (word);
+        if (pType == BoardType::ICGLIB || pType == BoardType::ICFC7)
+        {
+            cICData = pData;
+            this->setIC (cICData);
+        }
 
-#ifdef __CBCDAQ_DEV__
-            //TODO
-            LOG (DEBUG) << std::setw (3) << "Original " << cWordIndex << " ### " << std::bitset<32> (pData.at (cWordIndex) );
-            //LOG (DEBUG) << std::setw (3) << "Treated  " << cWordIndex << " ### " << std::bitset<32> (word);
+        const std::vector<uint32_t>& cData = cICData.empty() ? pData : cICData;
+        bool cZS = (fEventType == EventType::ZS);
 
-            if ( (cWordIndex + 1) % fEventSize == 0 && cWordIndex > 0 ) LOG (DEBUG) << std::endl << std::endl;
+        // the decoder is picked once for the acquisition, the chip type only matters for the D19C
+        switch (pType)
+        {
+            case BoardType::D19C:
+                // CBC3 and ZS events are handled above
+                if (pBoard->getChipType() == ChipType::MPA)
+                    this->decodeFixedSize<BoardType::D19C, ChipType::MPA, EventType::VR> (pBoard, cData, fNMPA);
 
-#endif
+                break;
 
-            lvec.push_back ( word );
+            case BoardType::CBC3FC7:
+                if (cZS) this->decodeFixedSize<BoardType::CBC3FC7, ChipType::CBC3, EventType::ZS> (pBoard, cData, fEventSize);
+                else this->decodeFixedSize<BoardType::CBC3FC7, ChipType::CBC3, EventType::VR> (pBoard, cData, fNCbc);
 
-            if (fEventType == EventType::ZS)
-            {
-                if ( cZSWordIndex == fZSEventSize - 1 )
-                {
-                    //LOG(INFO) << "Packing event # " << fEventList.size() << ", Event size is " << fZSEventSize << " words";
-                    if (pType == BoardType::D19C)
-                        fEventList.push_back ( new D19cCbc3EventZS ( pBoard, fZSEventSize, lvec ) );
-                    else
-                        fEventList.push_back ( new D19cCbc3EventZS ( pBoard, fZSEventSize, lvec ) );
+                break;
 
-                    lvec.clear();
+            case BoardType::SUPERVISOR:
+                if (cZS) this->decodeFixedSize<BoardType::SUPERVISOR, ChipType::CBC2, EventType::ZS> (pBoard, cData, fEventSize);
+                else this->decodeFixedSize<BoardType::SUPERVISOR, ChipType::CBC2, EventType::VR> (pBoard, cData, fNCbc);
 
-                    if (fEventList.size() >= fNevents) break;
-                }
-                else if ( cZSWordIndex == fZSEventSize )
-                {
-                    // get next event size
-                    cZSWordIndex = 0;
+                break;
 
-                    if (pType == BoardType::D19C) fZSEventSize = (0x0000FFFF & word);
-                    else fZSEventSize = fEventSize;
+            default:
+                if (cZS) this->decodeFixedSize<BoardType::GLIB, ChipType::CBC2, EventType::ZS> (pBoard, cData, fEventSize);
+                else this->decodeFixedSize<BoardType::GLIB, ChipType::CBC2, EventType::VR> (pBoard, cData, fNCbc);
 
-                    if (fZSEventSize > pData.size() )
-                    {
-                        LOG (ERROR) << "Missaligned data, not accepted";
-                        break;
-                    }
+                break;
+        }
+    }
 
-                }
+    bool Data::validateD19cEvent (const std::vector<uint32_t>& pData, size_t pOffset)
+    {
+        uint32_t cHeader = pData[pOffset];
+        uint32_t cEventSize = cHeader & 0x0000FFFF;
+
+        if ( (cHeader >> 24) != D19C_EVENT_HEADER1_SIZE_32 || cEventSize < D19C_EVENT_HEADER1_SIZE_32 || pOffset + cEventSize > pData.size() )
+            return false;
+
+        // the hybrid blocks and the DDR3 dummy words have to fill the event exactly
+        uint32_t cNDummy = pData[pOffset + 1] & 0x000000FF;
+
+        if (cNDummy > cEventSize - D19C_EVENT_HEADER1_SIZE_32) return false;
+
+        uint8_t cFeMask = (cHeader & 0x00FF0000) >> 16;
+        size_t cPosition = pOffset + D19C_EVENT_HEADER1_SIZE_32;
+        size_t cEnd = pOffset + cEventSize - cNDummy;
+
+        for (uint8_t cFeId = 0; cFeId < 8; cFeId++)
+        {
+            if ( ( (cFeMask >> cFeId) & 1) == 0) continue;
+
+            if (cPosition >= cEnd) return false;
+
+            uint32_t cHeader2 = pData[cPosition];
+            uint32_t cFeSize = cHeader2 & 0x0000FFFF;
+
+            if ( ( (cHeader2 & 0x00FF0000) >> 16) != D19C_EVENT_HEADER2_SIZE_32 || cFeSize < D19C_EVENT_HEADER2_SIZE_32) return false;
+
+            cPosition += cFeSize;
+        }
+
+        return cPosition == cEnd;
+    }
+
+    void Data::scanD19cEvents (const std::vector<uint32_t>& pData, uint32_t pNevents, std::vector<size_t>& pOffsets) const
+    {
+        pOffsets.clear();
+        pOffsets.reserve (pNevents);
 
+        size_t cOffset = 0;
+        size_t cNSkipped = 0;
+        uint32_t cNResync = 0;
+
+        while (cOffset < pData.size() && pOffsets.size() < pNevents)
+        {
+            if (validateD19cEvent (pData, cOffset) )
+            {
+                pOffsets.push_back (cOffset);
+                cOffset += pData[cOffset] & 0x0000FFFF;
+                continue;
             }
-            else
+
+            // misaligned: resynchronise on the next word that starts a valid event
+            size_t cNext = cOffset + 1;
+
+            while (cNext < pData.size() && !validateD19cEvent (pData, cNext) )
+                cNext++;
+
+            cNSkipped += cNext - cOffset;
+            cNResync++;
+            cOffset = cNext;
+        }
+
+        if (cNResync > 0)
+            LOG (ERROR) << "Missaligned data: skipped " << cNSkipped << " words in " << cNResync << " places, " << pOffsets.size() << " valid events kept";
+    }
+
+    void Data::decodeD19cZS (const BeBoard* pBoard, const std::vector<uint32_t>& pData, const std::vector<size_t>& pOffsets)
+    {
+        fEventList.assign (pOffsets.size(), nullptr);
+
+        // an exception must not leave a thread: the first one is kept and rethrown once all of them are joined
+        std::vector<std::exception_ptr> cErrors;
+        std::mutex cErrorMutex;
+
+        auto cDecode = [&] (size_t pFirst, size_t pLast)
+        {
+            try
             {
-                if ( cWordIndex > 0 &&  (cWordIndex + 1) % fEventSize == 0 )
+                for (size_t cIndex = pFirst; cIndex < pLast; cIndex++)
                 {
-                    if (pType == BoardType::D19C) {
-                        if (pBoard->getChipType() == ChipType::CBC3) fEventList.push_back ( new D19cCbc3Event ( pBoard, fNCbc, lvec ) );
-                        else if (pBoard->getChipType() == ChipType::MPA) fEventList.push_back ( new D19cMPAEvent ( pBoard, fNMPA, lvec ) );
-                    }
-                    else if (pType == BoardType::CBC3FC7)
-                        fEventList.push_back ( new Cbc3Event ( pBoard, fNCbc, lvec ) );
-                    else
-                        fEventList.push_back ( new Cbc2Event ( pBoard, fNCbc, lvec ) );
-
-                    lvec.clear();
-
-                    if (fEventList.size() >= fNevents) break;
+                    auto cBegin = pData.begin() + pOffsets[cIndex];
+                    uint32_t cEventSize = pData[pOffsets[cIndex]] & 0x0000FFFF;
+                    fEventList[cIndex] = new D19cCbc3EventZS ( pBoard, cEventSize, std::vector<uint32_t> (cBegin, cBegin + cEventSize) );
                 }
             }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> cLock (cErrorMutex);
+                cErrors.push_back (std::current_exception() );
+            }
+        };
+
+        // setNThreads(1) decodes on the calling thread, which is what the pipeline decoders want
+        size_t cNThreads = (fNThreads == 0) ? std::max (1u, std::thread::hardware_concurrency() ) : fNThreads;
+        cNThreads = std::max<size_t> (1, std::min<size_t> (cNThreads, pOffsets.size() / MIN_ZS_EVENTS_PER_THREAD) );
+        uint32_t cNExtra = (cNThreads > 1) ? reserveZSThreads (cNThreads - 1) : 0;
+        cNThreads = cNExtra + 1;
+        size_t cEventsPerThread = (pOffsets.size() + cNThreads - 1) / cNThreads;
+        std::vector<std::thread> cThreads;
+
+        for (size_t cThread = 1; cThread < cNThreads; cThread++)
+        {
+            size_t cFirst = std::min (pOffsets.size(), cThread * cEventsPerThread);
+            size_t cLast = std::min (pOffsets.size(), cFirst + cEventsPerThread);
+
+            try
+            {
+                cThreads.emplace_back (cDecode, cFirst, cLast);
+            }
+            catch (const std::system_error&)
+            {
+                // out of threads, this part is done here
+                cDecode (cFirst, cLast);
+            }
+        }
+
+        cDecode (0, std::min (pOffsets.size(), cEventsPerThread) );
+
+        for (auto& cThread : cThreads)
+            cThread.join();
 
-            cWordIndex++;
-            cSwapIndex++;
-            cZSWordIndex++;
+        gNZSThreads -= cNExtra;
 
+        if (!cErrors.empty() )
+        {
+            // no half decoded acquisition: the events built so far are freed, Wait() rethrows
+            this->Reset();
+            std::rethrow_exception (cErrors.front() );
         }
+
+        fAllocStats.fNEventsAllocated += pOffsets.size();
     }
 
     void Data::Reset()
     {
-        for ( auto& pevt : fEventList )
-            if (pevt) delete pevt;
+        if (fPooledEvents)
+        {
+            // keep the events for the next acquisition but let go of the raw buffer
+            for ( auto& pevt : fEventList )
+                pevt->Clear();
+        }
+        else
+        {
+            for ( auto& pevt : fEventList )
+                if (pevt) delete pevt;
+        }
 
+        fPooledEvents = false;
         fEventList.clear();
         fCurrentEvent = 0;
     }
 
-    void Data::setIC (uint32_t& pWord, uint32_t pWordIndex, uint32_t pSwapIndex)
+    void Data::setIC (std::vector<uint32_t>& pData)
+    {
+        uint32_t cChannelDataEnd = std::min (EVENT_HEADER_SIZE_32 + CBC_EVENT_SIZE_32 * fNCbc, fEventSize);
+        std::vector<std::pair<uint32_t, uint32_t>> cRows;
+
+        for ( uint32_t cEventStart = 0; cEventStart + fEventSize <= pData.size(); cEventStart += fEventSize )
+        {
+            uint32_t* cEvent = pData.data() + cEventStart;
+
+            // the first and last rows of the CBC blocks keep some bits in place, save them before the block reversal
+            cRows.clear();
+
+            for ( uint32_t cIndex = 0; cIndex < fEventSize; cIndex++ )
+            {
+                if (this->is_channel_first_row (cIndex) || this->is_channel_last_row (cIndex) )
+                    cRows.emplace_back (cIndex, cEvent[cIndex]);
+            }
+
+            if (cChannelDataEnd > EVENT_HEADER_SIZE_32)
+                reverseBits (cEvent + EVENT_HEADER_SIZE_32, cChannelDataEnd - EVENT_HEADER_SIZE_32);
+
+            for ( auto& cRow : cRows )
+            {
+                cEvent[cRow.first] = cRow.second;
+                this->setICRow (cEvent[cRow.first], cRow.first);
+            }
+        }
+    }
+
+    void Data::setICRow (uint32_t& pWord, uint32_t pSwapIndex)
     {
 
         if (this->is_channel_first_row (pSwapIndex) )
@@ -173,7 +437,7 @@ namespace Ph2_HwInterface {
             //uint8_t cErrors = word & 0x00000003;
             uint8_t cPipeAddress = (pWord & 0x000003FC) >> 2;
             //next I need to reverse the bit order and mask out the corresponding bits for errors & pipe address
-            pWord = this->reverse_bits (pWord) & 0xC03FFFFF;;
+            pWord = reverseBits32 (pWord) & 0xC03FFFFF;;
             //now just need to shift the Errors & Pipe address back in
             pWord |=  cPipeAddress << 22;
         }
@@ -186,13 +450,13 @@ namespace Ph2_HwInterface {
             //uint16_t cGlibFlag = (word & 0x000FFF00) >> 8;
             //reverse the bit order and mask stuff out
             //word = reverse_bits (word) & 0xFF000000;
-            pWord = this->reverse_bits (pWord) & 0xFFFFF000;
+            pWord = reverseBits32 (pWord) & 0xFFFFF000;
             //now shift the GlibFlag and the StubWord back in
             //word |= ( ( (cGlibFlag & 0x0FFF ) << 12) | (cStubWord & 0x0FFF) );
             pWord |= (cStubWord & 0x0FFF);
         }
         //is_channel_data will also be true for first and last word but since it's an else if, it should be ok
-        else if ( this->is_channel_data (pSwapIndex) ) pWord = this->reverse_bits (pWord);
+        else if ( this->is_channel_data (pSwapIndex) ) pWord = reverseBits32 (pWord);
     }
 
     void Data::setStrasbourgSupervisor (uint32_t& pWord)
@@ -32,6 +32,18 @@
 using namespace Ph2_HwDescription;
 namespace Ph2_HwInterface {
 
+    /*!
+     * \struct DataAllocStats
+     * \brief Allocations done by a Data object, summed over all its acquisitions
+     */
+    struct DataAllocStats
+    {
+        uint64_t fNEventsAllocated = 0; /*!< events created with new*/
+        uint64_t fNEventsReused = 0;    /*!< events taken from the pool*/
+        uint64_t fNBuffersAllocated = 0;/*!< raw buffers allocated for the event views*/
+        uint64_t fNBuffersReused = 0;   /*!< raw buffers refilled in place*/
+    };
+
     /*!
      * \class Data
      * \brief Data buffer class for CBC data
@@ -52,6 +64,14 @@ namespace Ph2_HwInterface {
         std::vector<Event*> fEventList;
         std::future<void> fFuture;
 
+        // D19C CBC3 events are recycled across acquisitions instead of new/delete each time,
+        // fEventList then points into the pool and must not be deleted
+        std::vector<std::unique_ptr<D19cCbc3Event>> fD19cCbc3Pool;
+        bool fPooledEvents;
+        std::shared_ptr<std::vector<uint32_t>> fBuffer;
+        DataAllocStats fAllocStats;
+        uint32_t fNThreads;             /*! Threads for the ZS decoding, 0 for one per core <*/
+
       private:
 
         uint32_t swap_bytes ( uint32_t& n)
@@ -59,16 +79,6 @@ namespace Ph2_HwInterface {
             return __builtin_bswap32 (n);
         }
 
-        uint32_t reverse_bits ( uint32_t& n)
-        {
-            n = ( (n >> 1) & 0x55555555) | ( (n << 1) & 0xaaaaaaaa) ;
-            n = ( (n >> 2) & 0x33333333) | ( (n << 2) & 0xcccccccc) ;
-            n = ( (n >> 4) & 0x0f0f0f0f) | ( (n << 4) & 0xf0f0f0f0) ;
-            n = ( (n >> 8) & 0x00ff00ff) | ( (n << 8) & 0xff00ff00) ;
-            n = ( (n >> 16) & 0x0000ffff) | ( (n << 16) & 0xffff0000) ;
-            return n;
-        }
-
         bool is_channel_data (uint32_t pIndex)
         {
             // return true if the word is channel data and not the first or last row of a CBC block, false if not!
@@ -88,8 +98,20 @@ namespace Ph2_HwInterface {
             return fChannelLastRows.find (pIndex) != std::end (fChannelLastRows);
         }
 
+        // offsets of the D19C events in pData, the events that do not pass validateD19cEvent are skipped up to the next valid header
+        void scanD19cEvents ( const std::vector<uint32_t>& pData, uint32_t pNevents, std::vector<size_t>& pOffsets ) const;
+        // pOffset is the header1 of a complete event whose hybrid blocks add up to its size
+        static bool validateD19cEvent ( const std::vector<uint32_t>& pData, size_t pOffset );
+        // build the ZS events of the offset table, spread over the decoding threads
+        void decodeD19cZS ( const BeBoard* pBoard, const std::vector<uint32_t>& pData, const std::vector<size_t>& pOffsets );
+
+        // cut pData in events of fEventSize words, one instantiation per board, chip and readout type: nothing is tested per word
+        template<BoardType B, ChipType C, EventType E>
+        void decodeFixedSize ( const BeBoard* pBoard, const std::vector<uint32_t>& pData, uint32_t pNChips );
+
         //private methods to be used in set according to the BoardType enum
-        void setIC (uint32_t& pWord, uint32_t pWordIndex, uint32_t pSwapIndex);
+        void setIC (std::vector<uint32_t>& pData);
+        void setICRow (uint32_t& pWord, uint32_t pSwapIndex);
         void setCbc3Fc7 (uint32_t& pWord);
         void setStrasbourgSupervisor (uint32_t& pWord);
 
@@ -98,7 +120,7 @@ namespace Ph2_HwInterface {
          * \brief Constructor of the Data class
          * \param pNbCbc
          */
-        Data( ) :  fCurrentEvent ( 0 ), fEventSize ( 0 )
+        Data( ) :  fCurrentEvent ( 0 ), fEventSize ( 0 ), fPooledEvents ( false ), fNThreads ( 0 )
         {
         }
         /*!
@@ -110,10 +132,7 @@ namespace Ph2_HwInterface {
          */
         ~Data()
         {
-            for ( auto pevt : fEventList )
-                if (pevt) delete pevt;
-
-            fEventList.clear();
+            Reset();
         }
         /*!
          * \brief Set the data in the data map
@@ -126,9 +145,30 @@ namespace Ph2_HwInterface {
         void privateSet ( const BeBoard* pBoard, const std::vector<uint32_t>& pData, uint32_t pNevents, BoardType pType);
 
         /*!
-         * \brief Reset the data structure
+         * \brief Reset the data structure, pooled events are kept for the next acquisition
          */
         void Reset();
+        /*!
+         * \brief Wait for the decoding started by Set() to finish, before the object is refilled
+         */
+        void Wait()
+        {
+            if ( fFuture.valid() ) fFuture.get();
+        }
+        /*!
+         * \brief Set the number of threads decoding the ZS events of an acquisition, 0 for one per core
+         */
+        void setNThreads ( uint32_t pNThreads )
+        {
+            fNThreads = pNThreads;
+        }
+        /*!
+         * \brief Get the allocation counters
+         */
+        const DataAllocStats& getAllocStats() const
+        {
+            return fAllocStats;
+        }
         /*!
          * \brief Get the next Event
          * \param pBoard: pointer to BeBoard
@@ -138,19 +178,19 @@ namespace Ph2_HwInterface {
         const Event* GetNextEvent ( const BeBoard* pBoard )
         {
             //fFuture.wait();
-            fFuture.get();
+            if ( fFuture.valid() ) fFuture.get();
             return ( ( fCurrentEvent >= fEventList.size() ) ? nullptr : fEventList.at ( fCurrentEvent++ ) );
         }
         const Event* GetEvent ( const BeBoard* pBoard, int i )
         {
             //fFuture.wait();
-            fFuture.get();
+            if ( fFuture.valid() ) fFuture.get();
             return ( ( i >= (int) fEventList.size() ) ? nullptr : fEventList.at ( i ) );
         }
         const std::vector<Event*>& GetEvents ( const BeBoard* pBoard )
         {
             //fFuture.wait();
-            fFuture.get();
+            if ( fFuture.valid() ) fFuture.get();
             return fEventList;
         }
     };
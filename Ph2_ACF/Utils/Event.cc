@@ -10,6 +10,9 @@
  */
 
 #include "../Utils/Event.h"
+#include "../Utils/D19cCbc3Event.h"
+#include <algorithm>
+#include <typeinfo>
 
 using namespace Ph2_HwDescription;
 
@@ -46,21 +49,39 @@ namespace Ph2_HwInterface {
     // Event implementation
     bool Event::operator== (const Event& pEvent) const
     {
-        return fEventDataMap == pEvent.fEventDataMap;
+        // through GetCbcWords, the events reading their data in place have an empty fEventDataMap
+        std::vector<uint16_t> cKeys;
+        std::vector<uint16_t> cOtherKeys;
+        GetCbcKeys (cKeys);
+        pEvent.GetCbcKeys (cOtherKeys);
+
+        if (cKeys != cOtherKeys) return false;
+
+        for (auto cKey : cKeys)
+        {
+            uint8_t cFeId, cCbcId;
+            decodeId (cKey, cFeId, cCbcId);
+
+            uint32_t cSize = 0;
+            uint32_t cOtherSize = 0;
+            const uint32_t* cData = GetCbcWords (cFeId, cCbcId, cSize);
+            const uint32_t* cOtherData = pEvent.GetCbcWords (cFeId, cCbcId, cOtherSize);
+
+            if (cSize != cOtherSize || !std::equal (cData, cData + cSize, cOtherData) ) return false;
+        }
+
+        return true;
     }
 
     void Event::GetCbcEvent ( const uint8_t& pFeId, const uint8_t& pCbcId, std::vector< uint32_t >& cbcData )  const
     {
         cbcData.clear();
 
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
+        uint32_t cSize = 0;
+        const uint32_t* cData = GetCbcWords (pFeId, pCbcId, cSize);
 
-        if (cData != std::end (fEventDataMap) )
-        {
-            cbcData.reserve (cData->second.size() );
-            cbcData.assign (cData->second.begin(), cData->second.end() );
-        }
+        if (cData != nullptr)
+            cbcData.assign (cData, cData + cSize);
         else
             LOG (INFO) << "Event: FE " << +pFeId << " CBC " << +pCbcId << " is not found." ;
     }
@@ -69,17 +90,19 @@ namespace Ph2_HwInterface {
     {
         cbcData.clear();
 
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
+        uint32_t cSize = 0;
+        const uint32_t* cData = GetCbcWords (pFeId, pCbcId, cSize);
 
-        if (cData != std::end (fEventDataMap) )
+        if (cData != nullptr)
         {
-            for (const auto& cWord : cData->second)
+            cbcData.reserve (4 * cSize);
+
+            for (uint32_t cIndex = 0; cIndex < cSize; cIndex++)
             {
-                cbcData.push_back ( (cWord >> 24) & 0xFF);
-                cbcData.push_back ( (cWord >> 16) & 0xFF);
-                cbcData.push_back ( (cWord >> 8) & 0xFF);
-                cbcData.push_back ( (cWord ) & 0xFF);
+                cbcData.push_back ( (cData[cIndex] >> 24) & 0xFF);
+                cbcData.push_back ( (cData[cIndex] >> 16) & 0xFF);
+                cbcData.push_back ( (cData[cIndex] >> 8) & 0xFF);
+                cbcData.push_back ( (cData[cIndex] ) & 0xFF);
             }
         }
         else
@@ -91,14 +114,14 @@ namespace Ph2_HwInterface {
         uint32_t cWordP = pPosition / 32;
         uint32_t cBitP = pPosition % 32;
 
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
+        uint32_t cSize = 0;
+        const uint32_t* cData = GetCbcWords (pFeId, pCbcId, cSize);
 
-        if (cData != std::end (fEventDataMap) )
+        if (cData != nullptr)
         {
-            if (cWordP >= cData->second.size() ) return false;
+            if (cWordP >= cSize ) return false;
 
-            return ( (cData->second.at (cWordP) >> (31 - cBitP) ) & 0x1);
+            return ( (cData[cWordP] >> (31 - cBitP) ) & 0x1);
         }
         else
         {
@@ -110,10 +133,10 @@ namespace Ph2_HwInterface {
 
     std::string Event::BitString ( uint8_t pFeId, uint8_t pCbcId, uint32_t pOffset, uint32_t pWidth ) const
     {
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
+        uint32_t cSize = 0;
+        const uint32_t* cData = GetCbcWords (pFeId, pCbcId, cSize);
 
-        if (cData != std::end (fEventDataMap) )
+        if (cData != nullptr)
         {
             std::ostringstream os;
 
@@ -123,10 +146,10 @@ namespace Ph2_HwInterface {
                 uint32_t cWordP = pos / 32;
                 uint32_t cBitP = pos % 32;
 
-                if ( cWordP >= cData->second.size() ) break;
+                if ( cWordP >= cSize ) break;
 
                 //os << ((cbcData[cByteP] & ( 1 << ( 7 - cBitP ) ))?"1":"0");
-                os << ( ( cData->second[cWordP] >> ( 31 - cBitP ) ) & 0x1 );
+                os << ( ( cData[cWordP] >> ( 31 - cBitP ) ) & 0x1 );
             }
 
             return os.str();
@@ -142,22 +165,20 @@ namespace Ph2_HwInterface {
     std::vector<bool> Event::BitVector ( uint8_t pFeId, uint8_t pCbcId, uint32_t pOffset, uint32_t pWidth ) const
     {
         std::vector<bool> blist;
-        uint16_t cKey = encodeId (pFeId, pCbcId);
-        EventDataMap::const_iterator cData = fEventDataMap.find (cKey);
+        uint32_t cSize = 0;
+        const uint32_t* cData = GetCbcWords (pFeId, pCbcId, cSize);
 
-        if (cData != std::end (fEventDataMap) )
+        if (cData != nullptr)
         {
-            std::ostringstream os;
-
             for ( uint32_t i = 0; i < pWidth; ++i )
             {
                 uint32_t pos = i + pOffset;
                 uint32_t cWordP = pos / 32;
                 uint32_t cBitP = pos % 32;
 
-                if ( cWordP >= cData->second.size() ) break;
+                if ( cWordP >= cSize ) break;
 
-                blist.push_back ( ( cData->second[cWordP] >> ( 31 - cBitP ) ) & 0x1 );
+                blist.push_back ( ( cData[cWordP] >> ( 31 - cBitP ) ) & 0x1 );
             }
         }
         else
@@ -167,4 +188,55 @@ namespace Ph2_HwInterface {
     }
 
 
+    bool Event::GetHitBitmap ( uint8_t pFeId, uint8_t pCbcId, uint64_t* pBitmap ) const
+    {
+        // generic version on top of GetHits, the event types with a fixed channel layout build the bitmap directly
+        std::fill ( pBitmap, pBitmap + CBC_HIT_BITMAP_SIZE_64, 0 );
+
+        for ( auto cHit : GetHits ( pFeId, pCbcId ) )
+            if ( cHit < NCHANNELS ) pBitmap[cHit / 64] |= uint64_t (1) << (cHit % 64);
+
+        return true;
+    }
+
+    uint32_t Event::countMaskedHits ( uint64_t* pBitmap, uint32_t* pCounters, const ChannelMask& pMask )
+    {
+        uint32_t cNHits = 0;
+
+        for ( uint32_t i = 0; i < CBC_HIT_BITMAP_SIZE_64; i++ )
+        {
+            pBitmap[i] &= pMask[i];
+            cNHits += __builtin_popcountll ( pBitmap[i] );
+        }
+
+        if ( pCounters != nullptr && cNHits != 0 ) addBitmapCounts ( pBitmap, NCHANNELS, pCounters );
+
+        return cNHits;
+    }
+
+    uint32_t Event::accumulateOccupancy ( uint8_t pFeId, uint8_t pCbcId, uint32_t* pCounters, const ChannelMask& pMask ) const
+    {
+        uint64_t cBitmap[CBC_HIT_BITMAP_SIZE_64];
+
+        if ( !GetHitBitmap ( pFeId, pCbcId, cBitmap ) ) return 0;
+
+        return countMaskedHits ( cBitmap, pCounters, pMask );
+    }
+
+    uint32_t Event::accumulateOccupancy ( const std::vector<Event*>& pEvents, uint8_t pFeId, uint8_t pCbcId, uint32_t* pCounters, const ChannelMask& pMask )
+    {
+        if ( pEvents.empty() ) return 0;
+
+        // the events of an acquisition are all built by the same decoder, so the class is checked once
+        if ( typeid ( *pEvents.front() ) == typeid ( D19cCbc3Event ) )
+            return accumulateOccupancyAs<D19cCbc3Event> ( pEvents, pFeId, pCbcId, pCounters, pMask );
+
+        uint32_t cNHits = 0;
+
+        for ( auto cEvent : pEvents )
+            cNHits += cEvent->accumulateOccupancy ( pFeId, pCbcId, pCounters, pMask );
+
+        return cNHits;
+    }
+
 }
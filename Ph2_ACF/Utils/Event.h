@@ -17,7 +17,9 @@
 #include <sstream>
 #include <cstring>
 #include <iomanip>
+#include <array>
 #include "ConsoleColor.h"
+#include "BitKernels.h"
 #include "../Utils/easylogging++.h"
 #include "../HWDescription/Definition.h"
 #include "../HWDescription/BeBoard.h"
@@ -29,6 +31,34 @@ using namespace Ph2_HwDescription;
 namespace Ph2_HwInterface {
 
     using EventDataMap = std::map<uint16_t, std::vector<uint32_t>>;
+    /*! \brief Channel selection for the occupancy accumulation, bit i is channel i */
+    using ChannelMask = std::array<uint64_t, CBC_HIT_BITMAP_SIZE_64>;
+
+    /*!
+     * \brief Build a ChannelMask
+     * \param pChannels : channels to select, e.g. a test group
+     */
+    inline ChannelMask makeChannelMask ( const std::vector<uint8_t>& pChannels )
+    {
+        ChannelMask cMask {};
+
+        for ( auto cChannel : pChannels )
+            if ( cChannel < NCHANNELS ) cMask[cChannel / 64] |= uint64_t (1) << (cChannel % 64);
+
+        return cMask;
+    }
+    /*!
+     * \brief ChannelMask with all the NCHANNELS channels
+     */
+    inline ChannelMask allChannelsMask()
+    {
+        ChannelMask cMask {};
+
+        for ( uint32_t cChannel = 0; cChannel < NCHANNELS; cChannel++ )
+            cMask[cChannel / 64] |= uint64_t (1) << (cChannel % 64);
+
+        return cMask;
+    }
 
     /*!
      * \class Cluster
@@ -38,8 +68,9 @@ namespace Ph2_HwInterface {
     {
       public:
         uint8_t fSensor;
-        uint8_t fFirstStrip;
-        uint8_t fClusterWidth;
+        // 16 bits, the module level clusters of ClusterFinder go beyond the 127 strips of a CBC
+        uint16_t fFirstStrip;
+        uint16_t fClusterWidth;
         double getBaricentre();
     };
 
@@ -140,6 +171,9 @@ namespace Ph2_HwInterface {
 
       protected:
 
+        // apply pMask to pBitmap, add the remaining hits to pCounters and count them
+        static uint32_t countMaskedHits ( uint64_t* pBitmap, uint32_t* pCounters, const ChannelMask& pMask );
+
         uint16_t encodeId (const uint8_t& pFeId, const uint8_t& pCbcId) const
         {
             return (pFeId << 8 | pCbcId);
@@ -151,6 +185,34 @@ namespace Ph2_HwInterface {
             pCbcId = pKey & 0xFF;
         }
 
+        /*!
+         * \brief Get the words of a CBC, to be overridden by the events that do not keep their data in fEventDataMap
+         * \param pFeId : FE Id
+         * \param pCbcId : Cbc Id
+         * \param pSize : number of words
+         * \return pointer to the first word, nullptr if the CBC is not in the event
+         */
+        virtual const uint32_t* GetCbcWords ( uint8_t pFeId, uint8_t pCbcId, uint32_t& pSize ) const
+        {
+            EventDataMap::const_iterator cData = fEventDataMap.find (encodeId (pFeId, pCbcId) );
+
+            if (cData == std::end (fEventDataMap) ) return nullptr;
+
+            pSize = cData->second.size();
+            return cData->second.data();
+        }
+        /*!
+         * \brief Get the keys (encodeId) of the CBCs in the event, in increasing order, to be overridden together with GetCbcWords
+         * \param pKeys : output
+         */
+        virtual void GetCbcKeys ( std::vector<uint16_t>& pKeys ) const
+        {
+            pKeys.clear();
+
+            for ( auto& cData : fEventDataMap )
+                pKeys.push_back ( cData.first );
+        }
+
       public:
         /*!
          * \brief Constructor of the Event Class
@@ -172,7 +234,7 @@ namespace Ph2_HwInterface {
         /*!
          * \brief Clear the Event Map
          */
-        void Clear()
+        virtual void Clear()
         {
             fEventDataMap.clear();
         }
@@ -284,11 +346,54 @@ namespace Ph2_HwInterface {
         unsigned char Char ( uint8_t pFeId, uint8_t pCbcId, uint32_t pBytePosition );
 
 
+        /*!
+         * \brief Get the CBC data copied out of the raw buffer
+         * \return the data map, empty for the events that read their data in place (D19cCbc3Event): use GetCbcEvent() instead
+         */
         const EventDataMap& GetEventDataMap() const
         {
             return fEventDataMap;
         }
+        /*!
+         * \brief Add the hits of a CBC to per-channel counters
+         * \param pFeId : FE Id
+         * \param pCbcId : Cbc Id
+         * \param pCounters : NCHANNELS counters, can be nullptr to only count the hits
+         * \param pMask : channels to consider
+         * \return number of hits in the selected channels
+         */
+        uint32_t accumulateOccupancy ( uint8_t pFeId, uint8_t pCbcId, uint32_t* pCounters, const ChannelMask& pMask ) const;
+        /*!
+         * \brief Add the hits of a CBC to per-channel counters, for all the events of an acquisition
+         * \param pEvents : the events of one acquisition, they must all be of the same class
+         * \param pFeId : FE Id
+         * \param pCbcId : Cbc Id
+         * \param pCounters : NCHANNELS counters, can be nullptr to only count the hits
+         * \param pMask : channels to consider
+         * \return number of hits in the selected channels
+         */
+        static uint32_t accumulateOccupancy ( const std::vector<Event*>& pEvents, uint8_t pFeId, uint8_t pCbcId, uint32_t* pCounters, const ChannelMask& pMask );
+        /*!
+         * \brief Same as accumulateOccupancy, for events that are all of the final class EventT: the hit bitmaps are read with direct, inlined calls
+         */
+        template<class EventT>
+        static uint32_t accumulateOccupancyAs ( const std::vector<Event*>& pEvents, uint8_t pFeId, uint8_t pCbcId, uint32_t* pCounters, const ChannelMask& pMask )
+        {
+            uint64_t cBitmap[CBC_HIT_BITMAP_SIZE_64];
+            uint32_t cNHits = 0;
+
+            for ( auto cEvent : pEvents )
+            {
+                if ( static_cast<const EventT*> ( cEvent )->GetHitBitmap ( pFeId, pCbcId, cBitmap ) )
+                    cNHits += countMaskedHits ( cBitmap, pCounters, pMask );
+            }
+
+            return cNHits;
+        }
 
+        /*!
+         * \brief Compare the data of all the CBCs, whether it is kept in fEventDataMap or read in place
+         */
         bool operator== (const Event& pEvent) const;
 
 
@@ -409,6 +514,14 @@ namespace Ph2_HwInterface {
         */
         virtual std::vector<uint32_t> GetHits (uint8_t pFeId, uint8_t pCbcId) const = 0;
         /*!
+        * \brief Function to get the hits as a bitmap, bit i is channel i
+        * \param pFeId : FE Id
+        * \param pCbcId : Cbc Id
+        * \param pBitmap : CBC_HIT_BITMAP_SIZE_64 words
+        * \return false if the CBC is not in the event, the generic version built on GetHits() cannot tell
+        */
+        virtual bool GetHitBitmap (uint8_t pFeId, uint8_t pCbcId, uint64_t* pBitmap) const;
+        /*!
         * \brief Function to get an encoded SLinkEvent object
         * \param pBoard : pointer to BeBoard
         * \param pSet : set of condition data parsed from config file
@@ -0,0 +1,115 @@
+/*!
+
+        \file                          EventView.h
+        \brief                         Offsets of one event inside a shared raw readout buffer
+
+ */
+
+#ifndef __EVENTVIEW_H__
+#define __EVENTVIEW_H__
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+
+namespace Ph2_HwInterface {
+
+    using EventBuffer = std::shared_ptr<const std::vector<uint32_t>>;
+
+    /*!
+     * \class EventView
+     * \brief Zero-copy access to the words of one event: the raw buffer is shared by all the events of a readout, the view only keeps the offset of the event and of each chip
+     *
+     * Chips are found through a fixed (FeId, ChipId) table, so a lookup is a single array access.
+     */
+    class EventView
+    {
+      public:
+        static const uint8_t MAX_FE = 8;
+        static const uint8_t MAX_CHIP = 8;
+
+      private:
+        // offsets are relative to the start of the event, 0 is the event header so it flags a missing chip
+        static const uint16_t NO_CHIP = 0;
+
+        EventBuffer fBuffer;
+        const uint32_t* fEvent;
+        uint32_t fSize;
+        uint16_t fChipOffset[MAX_FE][MAX_CHIP];
+
+      public:
+        EventView() :
+            fEvent ( nullptr ),
+            fSize ( 0 )
+        {
+            clearChips();
+        }
+
+        /*!
+         * \brief Point the view to an event
+         * \param pBuffer : raw buffer holding the event
+         * \param pOffset : first word of the event in the buffer
+         * \param pSize : number of words of the event
+         */
+        void set ( const EventBuffer& pBuffer, uint32_t pOffset, uint32_t pSize )
+        {
+            fBuffer = pBuffer;
+            fEvent = pBuffer->data() + pOffset;
+            fSize = pSize;
+            clearChips();
+        }
+
+        /*!
+         * \brief Register the data of a chip
+         * \param pOffset : first word of the chip data, relative to the start of the event
+         */
+        void setChip ( uint8_t pFeId, uint8_t pChipId, uint16_t pOffset )
+        {
+            if ( pFeId < MAX_FE && pChipId < MAX_CHIP ) fChipOffset[pFeId][pChipId] = pOffset;
+        }
+
+        void clearChips()
+        {
+            std::memset ( fChipOffset, 0, sizeof ( fChipOffset ) );
+        }
+
+        /*!
+         * \brief Data of a chip
+         * \return pointer to the first word of the chip data, nullptr if the chip is not in the event
+         */
+        const uint32_t* chip ( uint8_t pFeId, uint8_t pChipId ) const
+        {
+            if ( pFeId >= MAX_FE || pChipId >= MAX_CHIP || fChipOffset[pFeId][pChipId] == NO_CHIP ) return nullptr;
+
+            return fEvent + fChipOffset[pFeId][pChipId];
+        }
+
+        bool hasChip ( uint8_t pFeId, uint8_t pChipId ) const
+        {
+            return chip ( pFeId, pChipId ) != nullptr;
+        }
+
+        uint32_t word ( uint32_t pIndex ) const
+        {
+            return fEvent[pIndex];
+        }
+
+        const uint32_t* data() const
+        {
+            return fEvent;
+        }
+
+        uint32_t size() const
+        {
+            return fSize;
+        }
+
+        const EventBuffer& buffer() const
+        {
+            return fBuffer;
+        }
+    };
+}
+
+#endif
@@ -1,10 +1,25 @@
 #include "FileHandler.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+
+// O_DIRECT needs the buffer, the offsets and the sizes aligned to the logical block size of the device
+#define DIRECT_IO_ALIGNMENT 4096
 
 //Constructor
-FileHandler::FileHandler ( const std::string& pBinaryFileName, char pOption ) :
+FileHandler::FileHandler ( const std::string& pBinaryFileName, char pOption, const FileWriterOptions& pOptions ) :
     fBinaryFileName ( pBinaryFileName ),
     fOption ( pOption ),
+    fQueue ( pOptions.fQueueDepth ),
     fFileIsOpened ( false ),
+    fOptions ( pOptions ),
+    fFd ( -1 ),
+    fWriteBuffer ( nullptr ),
+    fWriteBufferFill ( 0 ),
+    fFileOffset ( 0 ),
+    fWriteFailing ( false ),
     fHeader (),
     fHeaderPresent (false)
 {
@@ -17,10 +32,17 @@ FileHandler::FileHandler ( const std::string& pBinaryFileName, char pOption ) :
     }
 }
 
-FileHandler::FileHandler ( const std::string& pBinaryFileName, char pOption, FileHeader pHeader ) :
+FileHandler::FileHandler ( const std::string& pBinaryFileName, char pOption, FileHeader pHeader, const FileWriterOptions& pOptions ) :
     fBinaryFileName ( pBinaryFileName ),
     fOption ( pOption ),
+    fQueue ( pOptions.fQueueDepth ),
     fFileIsOpened ( false ),
+    fOptions ( pOptions ),
+    fFd ( -1 ),
+    fWriteBuffer ( nullptr ),
+    fWriteBufferFill ( 0 ),
+    fFileOffset ( 0 ),
+    fWriteFailing ( false ),
     fHeader ( pHeader ),
     fHeaderPresent (true)
 {
@@ -50,11 +72,51 @@ FileHandler::~FileHandler()
     this->closeFile();
 }
 
-void FileHandler::set ( std::vector<uint32_t> pVector )
+void FileHandler::set ( const std::vector<uint32_t>& pVector )
+{
+    set ( std::vector<uint32_t> ( pVector ) );
+}
+
+void FileHandler::set ( std::vector<uint32_t>&& pVector )
 {
+    if ( fOption != 'w' || !fFileIsOpened.load() || pVector.empty() ) return;
+
+    // several boards may share the handler, the mutex keeps a single producer on the queue
     std::lock_guard<std::mutex> cLock (fMutex);
-    fQueue.push (pVector);
-    fSet.notify_one();
+
+    // the writer is behind: wait for a free slot instead of growing without bound
+    if ( !fQueue.tryPush ( std::move ( pVector ) ) )
+    {
+        {
+            std::lock_guard<std::mutex> cStatsLock (fStatsMutex);
+            fStats.fNFullWaits++;
+        }
+
+        while ( !fQueue.tryPush ( std::move ( pVector ) ) )
+        {
+            // the writer retries a failed write, do not stall the readout on it: whole packets are dropped, the file stays readable
+            if ( fWriteFailing.load() )
+            {
+                std::lock_guard<std::mutex> cStatsLock (fStatsMutex);
+                fStats.fBytesDropped += pVector.size() * sizeof ( uint32_t );
+                return;
+            }
+
+            std::this_thread::sleep_for (std::chrono::microseconds (50) );
+        }
+    }
+}
+
+FileWriterStats FileHandler::getWriterStats() const
+{
+    std::lock_guard<std::mutex> cLock (fStatsMutex);
+    FileWriterStats cStats = fStats;
+    cStats.fQueueHighWater = fQueue.highWater();
+
+    if ( fFileIsOpened.load() )
+        cStats.fElapsed = std::chrono::duration<double> ( std::chrono::steady_clock::now() - fOpenTime ).count();
+
+    return cStats;
 }
 
 bool FileHandler::openFile( )
@@ -67,7 +129,8 @@ bool FileHandler::openFile( )
 
         if ( fOption == 'w' )
         {
-            fBinaryFile.open ( ( getFilename() ).c_str(), std::fstream::trunc | std::fstream::out | std::fstream::binary );
+            if ( !openWriteFile() )
+                return false;
 
             // if the header is null or not valid, continue without and delete the header
             if ( fHeader.fValid == false )
@@ -78,7 +141,7 @@ bool FileHandler::openFile( )
             else if ( fHeader.fValid)
             {
                 std::vector<uint32_t> cHeaderVec = fHeader.encodeHeader();
-                fBinaryFile.write ( ( char* ) &cHeaderVec.at (0), cHeaderVec.size() * sizeof ( uint32_t ) );
+                stage ( ( char* ) &cHeaderVec.at (0), cHeaderVec.size() * sizeof ( uint32_t ) );
                 fHeaderPresent = true;
             }
         }
@@ -120,18 +183,29 @@ bool FileHandler::openFile( )
 void FileHandler::closeFile()
 {
     if (fFileIsOpened.load() )
-    {
         fFileIsOpened = false;
 
-        if (fOption == 'w' && fThread.joinable() )
-            fThread.join();
-    }
+    // the writer thread drains the queue before returning
+    if (fOption == 'w' && fThread.joinable() )
+        fThread.join();
 
     //std::lock_guard<std::mutex> cLock (fMemberMutex);
 
     if (fBinaryFile.is_open() )
         fBinaryFile.close();
 
+    if ( fFd >= 0 )
+    {
+        ::close ( fFd );
+        fFd = -1;
+    }
+
+    if ( fWriteBuffer != nullptr )
+    {
+        std::free ( fWriteBuffer );
+        fWriteBuffer = nullptr;
+    }
+
     //if (fFileIsOpened.load() )
     //fFileIsOpened = false;
 
@@ -217,53 +291,216 @@ std::vector<uint32_t> FileHandler::readFileTail ( long pNbytes )
     return cVector;
 }
 
-void FileHandler::writeFile()
+bool FileHandler::openWriteFile()
 {
-    //new implementation using queue
-    //this needs to run in an infinite loop, otherwise it will end after the first data was processed and the second on is not ready I think
-    //anyway, dequeue will block this thread as long as fQueue is empty, if it is not, the first element will immediately be extracted
-    //while (true)
-    while (fFileIsOpened.load() )
+    int cFlags = O_WRONLY | O_CREAT | O_TRUNC;
+    fFd = -1;
+
+#ifdef O_DIRECT
+
+    if ( fOptions.fDirectIO )
     {
-        if (!fFileIsOpened.load() )
-            break;
+        fFd = ::open ( getFilename().c_str(), cFlags | O_DIRECT, 0644 );
 
-        else
-        {
-            // a local data handle
-            std::vector<uint32_t> cData;
-            //populate the local handle with values from the queue -
-            //this method blocks this thread until it receives data
-            bool cDataPresent = this->dequeue (cData);
+        if ( fFd < 0 )
+            LOG (INFO) << "FileHandler: O_DIRECT not supported for " << fBinaryFileName << " (" << strerror ( errno ) << "), using buffered writes" ;
+    }
+
+#endif
+
+    if ( fFd < 0 )
+    {
+        fOptions.fDirectIO = false;
+        fFd = ::open ( getFilename().c_str(), cFlags, 0644 );
+    }
+
+    if ( fFd < 0 )
+    {
+        LOG (ERROR) << "FileHandler: Error, cannot open " << fBinaryFileName << " for writing: " << strerror ( errno ) ;
+        return false;
+    }
 
-            if (cDataPresent)
+    // whole blocks only, so that full buffers can always go out with O_DIRECT
+    fOptions.fBufferSize = std::max<size_t> ( DIRECT_IO_ALIGNMENT, ( fOptions.fBufferSize + DIRECT_IO_ALIGNMENT - 1 ) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT );
+
+    if ( posix_memalign ( ( void** ) &fWriteBuffer, DIRECT_IO_ALIGNMENT, fOptions.fBufferSize ) != 0 )
+    {
+        LOG (ERROR) << "FileHandler: Error, cannot allocate the " << fOptions.fBufferSize << " byte write buffer" ;
+        fWriteBuffer = nullptr;
+        ::close ( fFd );
+        fFd = -1;
+        return false;
+    }
+
+    fWriteBufferFill = 0;
+    fFileOffset = 0;
+    fWriteFailing = false;
+    fStats = FileWriterStats();
+    fOpenTime = std::chrono::steady_clock::now();
+    return true;
+}
+
+void FileHandler::stage ( const char* pData, size_t pSize )
+{
+    while ( pSize > 0 )
+    {
+        size_t cSize = std::min ( pSize, fOptions.fBufferSize - fWriteBufferFill );
+        std::memcpy ( fWriteBuffer + fWriteBufferFill, pData, cSize );
+        fWriteBufferFill += cSize;
+        pData += cSize;
+        pSize -= cSize;
+
+        if ( fWriteBufferFill == fOptions.fBufferSize )
+            writeBuffer ( false );
+
+        // a failed write keeps the buffer full: retry while the file is open, set() waits on the full queue meanwhile;
+        // once it is closed the data is dropped, the file then ends with the last block written
+        while ( fWriteBufferFill == fOptions.fBufferSize )
+        {
+            if ( !fFileIsOpened.load() )
             {
-                std::lock_guard<std::mutex> cLock (fMemberMutex);
-                //write the vector - this is guaranteed by the standard
-                fBinaryFile.write ( ( char* ) &cData.at (0), cData.size() * sizeof ( uint32_t ) );
-                fBinaryFile.flush();
+                std::lock_guard<std::mutex> cLock (fStatsMutex);
+                fStats.fBytesDropped += pSize;
+                return;
             }
+
+            std::this_thread::sleep_for (std::chrono::milliseconds (fOptions.fFlushInterval) );
+            writeBuffer ( false );
         }
     }
 }
 
-bool FileHandler::dequeue (std::vector<uint32_t>& pData)
+void FileHandler::writeBuffer ( bool pFinal )
 {
-    std::unique_lock<std::mutex> cLock (fMutex);
-    bool cQueueEmpty = fSet.wait_for (cLock, std::chrono::microseconds (100), [&] { return  FileHandler::fQueue.empty();});
+    size_t cSize = fWriteBufferFill;
+
+    if ( fOptions.fDirectIO )
+    {
+        // O_DIRECT can only write whole blocks: keep the incomplete one for later, the last one goes out without O_DIRECT
+        if ( pFinal )
+        {
+#ifdef O_DIRECT
+            fcntl ( fFd, F_SETFL, fcntl ( fFd, F_GETFL ) & ~O_DIRECT );
+#endif
+        }
+        else
+            cSize -= cSize % DIRECT_IO_ALIGNMENT;
+    }
+
+    size_t cWritten = 0;
+    uint64_t cNWrites = 0;
+    int cError = 0;
+
+    while ( cWritten < cSize )
+    {
+        ssize_t cResult = ::pwrite ( fFd, fWriteBuffer + cWritten, cSize - cWritten, fFileOffset + cWritten );
+        cNWrites++;
+
+        if ( cResult < 0 )
+        {
+            if ( errno == EINTR ) continue;
+
+            cError = errno;
 
-    if (!cQueueEmpty)
+            if ( !fWriteFailing )
+                LOG (ERROR) << "FileHandler: Error writing " << fBinaryFileName << ": " << strerror ( cError ) << " - keeping " << cSize - cWritten << " bytes to write them again" ;
+
+            break;
+        }
+
+        cWritten += cResult;
+    }
+
+    if ( cError == 0 && fWriteFailing && cSize > 0 )
+        LOG (INFO) << "FileHandler: Writing " << fBinaryFileName << " again" ;
+
+    fWriteFailing = ( cError != 0 );
+
+#ifdef O_DIRECT
+
+    // a short write leaves the next offset off the block boundary, which O_DIRECT cannot write
+    if ( fOptions.fDirectIO && cWritten % DIRECT_IO_ALIGNMENT != 0 )
     {
-        pData = fQueue.front();
-        fQueue.pop();
+        fcntl ( fFd, F_SETFL, fcntl ( fFd, F_GETFL ) & ~O_DIRECT );
+        fOptions.fDirectIO = false;
     }
 
-    return !cQueueEmpty;
-    //std::unique_lock<std::mutex> cLock (fMutex);
+#endif
+
+    // only what reached the file leaves the buffer, the rest (incomplete O_DIRECT block or failed write) moves to the
+    // front, which keeps the buffer aligned for O_DIRECT, and no hole is left in the file
+    fFileOffset += cWritten;
+    fWriteBufferFill -= cWritten;
+
+    if ( fWriteBufferFill > 0 )
+        std::memmove ( fWriteBuffer, fWriteBuffer + cWritten, fWriteBufferFill );
+
+    std::lock_guard<std::mutex> cLock (fStatsMutex);
+    fStats.fBytesWritten += cWritten;
+    fStats.fNWrites += cNWrites;
+
+    if ( cError != 0 )
+    {
+        fStats.fNWriteErrors++;
+        fStats.fWriteError = cError;
+    }
+
+    // nothing comes after the final write
+    if ( pFinal && fWriteBufferFill > 0 )
+    {
+        fStats.fBytesDropped += fWriteBufferFill;
+        fWriteBufferFill = 0;
+    }
+}
+
+void FileHandler::writeFile()
+{
+    // drain the queue into the staging buffer, which is written when full or when data has waited for fFlushInterval;
+    // after closeFile() whatever is still queued gets written before the thread returns
+    std::vector<uint32_t> cData;
+    std::chrono::steady_clock::time_point cLastWrite = std::chrono::steady_clock::now();
+    std::chrono::milliseconds cFlushInterval ( fOptions.fFlushInterval );
+    uint64_t cNPackets = 0;
+
+    while ( fFileIsOpened.load() || !fQueue.empty() )
+    {
+        bool cDataPresent = fQueue.tryPop ( cData );
+
+        if ( cDataPresent )
+        {
+            uint64_t cNWrites = fStats.fNWrites;
+            stage ( ( char* ) cData.data(), cData.size() * sizeof ( uint32_t ) );
+            cNPackets++;
+
+            if ( fStats.fNWrites != cNWrites )
+                cLastWrite = std::chrono::steady_clock::now();
+        }
+
+        if ( !cDataPresent || ( cNPackets & 0xFF ) == 0 )
+        {
+            std::chrono::steady_clock::time_point cNow = std::chrono::steady_clock::now();
+
+            if ( fWriteBufferFill > 0 && cNow - cLastWrite >= cFlushInterval )
+            {
+                writeBuffer ( false );
+                cLastWrite = cNow;
+            }
+
+            std::lock_guard<std::mutex> cLock (fStatsMutex);
+            fStats.fNPackets = cNPackets;
+        }
+
+        if ( !cDataPresent )
+            std::this_thread::sleep_for (std::chrono::microseconds (100) );
+    }
+
+    writeBuffer ( true );
+
+    std::lock_guard<std::mutex> cLock (fStatsMutex);
 
-    //while (fQueue.empty() )
-    //fSet.wait (cLock);
+    if ( fStats.fBytesDropped > 0 )
+        LOG (ERROR) << "FileHandler: " << fStats.fBytesDropped << " bytes could not be written to " << fBinaryFileName << ", the file ends after " << fFileOffset << " bytes" ;
 
-    //pData = fQueue.front();
-    //fQueue.pop();
+    fStats.fNPackets = cNPackets;
+    fStats.fElapsed = std::chrono::duration<double> ( std::chrono::steady_clock::now() - fOpenTime ).count();
 }
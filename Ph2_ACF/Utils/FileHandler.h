@@ -8,16 +8,50 @@
 #include <vector>
 #include <bitset>
 #include <mutex>
-#include <queue>
 #include <atomic>
-#include <condition_variable>
 #include <thread>
+#include <chrono>
+#include <sys/types.h>
 #include "FileHeader.h"
+#include "SPSCQueue.h"
 #include "../Utils/easylogging++.h"
 
+/*!
+ * \brief Tuning of the FileHandler writer thread
+ */
+struct FileWriterOptions
+{
+    size_t fBufferSize = 4 << 20;   /*!< size of the staging buffer in bytes, one write() per full buffer, multiple of 4096*/
+    size_t fQueueDepth = 1024;      /*!< number of packets the queue holds before set() has to wait*/
+    uint32_t fFlushInterval = 100;  /*!< a partly filled buffer is written after this many ms without filling up*/
+    bool fDirectIO = false;         /*!< open the file with O_DIRECT, bypassing the page cache*/
+};
+
+/*!
+ * \brief Counters of the FileHandler writer thread
+ */
+struct FileWriterStats
+{
+    uint64_t fNPackets = 0;         /*!< number of packets written*/
+    uint64_t fBytesWritten = 0;     /*!< number of bytes written, header included*/
+    uint64_t fNWrites = 0;          /*!< number of write system calls*/
+    uint64_t fNFullWaits = 0;       /*!< number of times set() found the queue full*/
+    uint64_t fNWriteErrors = 0;     /*!< number of failed write system calls, the data is kept and written again*/
+    int fWriteError = 0;            /*!< errno of the last failed write, 0 if none failed*/
+    uint64_t fBytesDropped = 0;     /*!< bytes not written: packets set() could not queue while writes failed, data left at close*/
+    size_t fQueueHighWater = 0;     /*!< maximum number of packets waiting in the queue*/
+    double fElapsed = 0;            /*!< seconds since the file was opened*/
+
+    double bytesPerSecond() const
+    {
+        return ( fElapsed > 0 ) ? fBytesWritten / fElapsed : 0;
+    }
+};
+
 /*!
  * \class FileHandler
  * \brief Class to write Data objects in binary file using multithreading
+ * \details In write mode set() moves the packets into a lock-free queue, the writer thread packs them into a large aligned buffer which is written with pwrite() once full or after FileWriterOptions::fFlushInterval
 */
 
 
@@ -33,11 +67,20 @@ class FileHandler
 
     std::string fBinaryFileName;
     std::thread fThread;/*!< a thread for the multitrading */
-    mutable std::mutex fMutex;/*!< Mutex for the queue */
+    mutable std::mutex fMutex;/*!< Mutex serializing the producers, the queue itself has a single producer */
     mutable std::mutex fMemberMutex;/*!< Mutex for members */
-    std::queue<std::vector<uint32_t>> fQueue; /*!<Queue to populate from set() and depopulate in writeFile() */
+    SPSCQueue<std::vector<uint32_t>> fQueue; /*!<Queue to populate from set() and depopulate in writeFile() */
     std::atomic<bool> fFileIsOpened ;/*!< to check if the file is opened */
-    std::condition_variable fSet;/*!< condition variable to notify writer thread of new data*/
+
+    FileWriterOptions fOptions;/*!< writer settings */
+    int fFd;/*!< raw file descriptor of the file in write mode */
+    char* fWriteBuffer;/*!< aligned staging buffer of the writer thread */
+    size_t fWriteBufferFill;/*!< number of bytes in fWriteBuffer */
+    off_t fFileOffset;/*!< file offset of the first byte of fWriteBuffer */
+    std::atomic<bool> fWriteFailing;/*!< the last write failed, set() then drops the packets it cannot queue */
+    std::chrono::steady_clock::time_point fOpenTime;/*!< time the file was opened, for the rate */
+    mutable std::mutex fStatsMutex;/*!< Mutex for fStats */
+    FileWriterStats fStats;/*!< writer counters */
 
 
   public:
@@ -49,14 +92,16 @@ class FileHandler
     * \brief constructor for the class
     * \param pBinaryFileName: set the fbinaryFileName to pbinaryFileName
     * \param  pOption: set fOption to pOption
+    * \param  pOptions: writer settings, only used in write mode
     */
-    FileHandler ( const std::string& pBinaryFileName, char pOption );
+    FileHandler ( const std::string& pBinaryFileName, char pOption, const FileWriterOptions& pOptions = FileWriterOptions() );
     /*!
     * \brief constructor for the class for write access with header object
     * \param pBinaryFileName: set the fbinaryFileName to pbinaryFileName
     * \param  pHeader: a const reference to a FileHeader object
+    * \param  pOptions: writer settings, only used in write mode
     */
-    FileHandler ( const std::string& pBinaryFileName, char pOption, FileHeader pHeader );
+    FileHandler ( const std::string& pBinaryFileName, char pOption, FileHeader pHeader, const FileWriterOptions& pOptions = FileWriterOptions() );
 
     /*!
     * \brief destructor
@@ -89,9 +134,18 @@ class FileHandler
     }
 
     /*!
-    * \brief set fData to pVector
+    * \brief queue a copy of pVector for writing
+    */
+    void set ( const std::vector<uint32_t>& pVector );
+    /*!
+    * \brief queue pVector for writing, without copy; pVector is left empty
+    */
+    void set ( std::vector<uint32_t>&& pVector );
+
+    /*!
+    * \brief get the writer counters
     */
-    void set ( std::vector<uint32_t> pVector );
+    FileWriterStats getWriterStats() const;
 
 
     /*!
@@ -151,7 +205,9 @@ class FileHandler
     void writeFile() ;
 
   private:
-    bool dequeue (std::vector<uint32_t>& pData);
+    bool openWriteFile();
+    void stage ( const char* pData, size_t pSize );
+    void writeBuffer ( bool pFinal );
 };
 
 #endif
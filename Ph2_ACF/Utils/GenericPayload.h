@@ -5,18 +5,20 @@
 #include <bitset>
 #include <vector>
 
+#include "BitKernels.h"
 #include "easylogging++.h"
 
 #define WORDSIZE 64
 
 template<typename T>
-std::vector<T> split_vec64 (std::vector<uint64_t> pVec)
+std::vector<T> split_vec64 (const std::vector<uint64_t>& pVec)
 {
     size_t aSize = sizeof (T);
     size_t aSizeBits = 8 * aSize;
     size_t tSize = sizeof (uint64_t);
 
     std::vector<T> cVec;
+    cVec.reserve (pVec.size() * (tSize / aSize) );
 
     for (auto pWord : pVec)
     {
@@ -59,6 +61,15 @@ class GenericPayload
         fWriteBitIndex (0)
     {
     }
+    //reserve the memory for pNBits up front so that appending does not reallocate
+    explicit GenericPayload (size_t pNBits) :
+        fData (1, 0),
+        fBitCount (0),
+        fWordIndex (0),
+        fWriteBitIndex (0)
+    {
+        fData.reserve ( (pNBits + WORDSIZE - 1) / WORDSIZE);
+    }
     ~GenericPayload()
     {
         fData.clear();
@@ -421,22 +432,9 @@ class GenericPayload
     {
         //this method is specific to the d19c Firmware as it spits out the data
         //sensor by sensor, so even channels first and then odd channels
-        //the process is called morton encoding and the code comes from here:
-        //https://stackoverflow.com/questions/22101273/how-to-combine-two-16bit-words-into-one-32bit-word-bit-by-bit-efficiently
-        uint64_t A, B;
-        A = ( (pOddWord & 0x00000000FFFF0000ull) << 16) | (pOddWord & 0x000000000000FFFFull);
-        A = ( (A & 0x0000FF000000FF00ull) <<  8) | (A & 0x000000FF000000FFull);
-        A = ( (A & 0xF0F0F0F0F0F0F0F0ull) <<  4) | (A & 0x0F0F0F0F0F0F0F0Full);
-        A = ( (A & 0xCCCCCCCCCCCCCCCCull) <<  2) | (A & 0x0333333333333333ull);
-        A = ( (A & 0xAAAAAAAAAAAAAAAAull) <<  1) | (A & 0x5555555555555555ull);
-
-        B = ( (pEvenWord & 0x00000000FFFF0000ull) << 16) | (pEvenWord & 0x000000000000FFFFull);
-        B = ( (B & 0x0000FF000000FF00ull) <<  8) | (B & 0x000000FF000000FFull);
-        B = ( (B & 0xF0F0F0F0F0F0F0F0ull) <<  4) | (B & 0x0F0F0F0F0F0F0F0Full);
-        B = ( (B & 0xCCCCCCCCCCCCCCCCull) <<  2) | (B & 0x0333333333333333ull);
-        B = ( (B & 0xAAAAAAAAAAAAAAAAull) <<  1) | (B & 0x5555555555555555ull);
-
-        uint64_t cResultWord = A | (B << 1);
+        //the process is called morton encoding, the odd word goes to the even bits
+        uint64_t cResultWord;
+        interleaveBits (&pOddWord, &pEvenWord, &cResultWord, 1);
         this->append (cResultWord, pNLSBs);
     }
 
@@ -0,0 +1,281 @@
+#include "RawFileReader.h"
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace Ph2_HwDescription;
+using namespace Ph2_HwInterface;
+
+// "P2ACFIDX" and the layout version of the index file
+#define RAW_INDEX_MAGIC   0x5032414346494458ULL
+#define RAW_INDEX_VERSION 1
+
+RawFileReader::RawFileReader ( const std::string& pFileName, bool pUseIndexCache ) :
+    fFileName ( pFileName ),
+    fHeader (),
+    fFd ( -1 ),
+    fWords ( nullptr ),
+    fMapSize ( 0 ),
+    fFileSize ( 0 ),
+    fModificationTime ( 0 ),
+    fCurrentEvent ( 0 )
+{
+    if ( !mapFile() ) return;
+
+    std::string cIndexName = fFileName + ".idx";
+
+    if ( pUseIndexCache && loadIndex ( cIndexName ) )
+    {
+        LOG (INFO) << "RawFileReader: " << getNEvents() << " events in " << fFileName << " (index from " << cIndexName << ")" ;
+        return;
+    }
+
+    buildIndex();
+    LOG (INFO) << "RawFileReader: " << getNEvents() << " events in " << fFileName ;
+
+    if ( pUseIndexCache ) saveIndex ( cIndexName );
+}
+
+RawFileReader::~RawFileReader()
+{
+    if ( fWords != nullptr ) munmap ( const_cast<uint32_t*> ( fWords ), fMapSize );
+
+    if ( fFd >= 0 ) ::close ( fFd );
+}
+
+bool RawFileReader::mapFile()
+{
+    fFd = ::open ( fFileName.c_str(), O_RDONLY );
+    struct stat cStat;
+
+    if ( fFd < 0 || fstat ( fFd, &cStat ) != 0 )
+    {
+        LOG (ERROR) << "RawFileReader: Error, cannot open " << fFileName << ": " << strerror ( errno ) ;
+        return false;
+    }
+
+    fFileSize = cStat.st_size;
+    fModificationTime = int64_t ( cStat.st_mtim.tv_sec ) * 1000000000 + cStat.st_mtim.tv_nsec;
+    fMapSize = fFileSize - fFileSize % sizeof ( uint32_t );
+
+    if ( fMapSize == 0 )
+    {
+        LOG (INFO) << "RawFileReader: " << fFileName << " is empty" ;
+        return false;
+    }
+
+    void* cMap = mmap ( nullptr, fMapSize, PROT_READ, MAP_SHARED, fFd, 0 );
+
+    if ( cMap == MAP_FAILED )
+    {
+        LOG (ERROR) << "RawFileReader: Error, cannot map " << fFileName << ": " << strerror ( errno ) ;
+        return false;
+    }
+
+    // playback and index building go front to back
+    madvise ( cMap, fMapSize, MADV_SEQUENTIAL );
+    fWords = static_cast<const uint32_t*> ( cMap );
+
+    size_t cNWords = fMapSize / sizeof ( uint32_t );
+
+    if ( cNWords >= FileHeader::fHeaderSize32 )
+        fHeader.decodeHeader ( std::vector<uint32_t> ( fWords, fWords + FileHeader::fHeaderSize32 ) );
+
+    return true;
+}
+
+void RawFileReader::buildIndex()
+{
+    uint64_t cNWords = fMapSize / sizeof ( uint32_t );
+    uint64_t cOffset = fHeader.fValid ? FileHeader::fHeaderSize32 : 0;
+    bool cD19C = !fHeader.fValid || fHeader.getBoardType() == BoardType::D19C;
+    uint64_t cFixedSize = fHeader.fValid ? fHeader.fEventSize32 : 0;
+
+    if ( !cD19C && cFixedSize == 0 )
+    {
+        LOG (ERROR) << "RawFileReader: Error, no event size in the header of " << fFileName << " - cannot index it" ;
+        return;
+    }
+
+    fOffsets.clear();
+    fOffsets.reserve ( cD19C ? cNWords / 64 : cNWords / cFixedSize + 1 );
+
+    while ( cOffset < cNWords )
+    {
+        // BLOCK_SIZE of Header1
+        uint64_t cSize = cD19C ? ( 0x0000FFFF & fWords[cOffset] ) : cFixedSize;
+
+        if ( cD19C && cSize < D19C_EVENT_HEADER1_SIZE_32 )
+        {
+            LOG (ERROR) << "RawFileReader: Error, corrupted Header1 at word " << cOffset << " of " << fFileName << " - ignoring the rest of the file" ;
+            break;
+        }
+
+        if ( cOffset + cSize > cNWords )
+        {
+            LOG (INFO) << "RawFileReader: " << fFileName << " ends in the middle of an event, " << cNWords - cOffset << " words dropped" ;
+            break;
+        }
+
+        fOffsets.push_back ( cOffset );
+        cOffset += cSize;
+    }
+
+    fOffsets.push_back ( cOffset );
+}
+
+bool RawFileReader::loadIndex ( const std::string& pIndexName )
+{
+    std::ifstream cFile ( pIndexName, std::ios::binary );
+
+    if ( !cFile ) return false;
+
+    uint64_t cPreamble[5];
+
+    if ( !cFile.read ( reinterpret_cast<char*> ( cPreamble ), sizeof ( cPreamble ) ) ) return false;
+
+    // stale if the data file changed since
+    if ( cPreamble[0] != RAW_INDEX_MAGIC || cPreamble[1] != RAW_INDEX_VERSION || cPreamble[2] != fFileSize || int64_t ( cPreamble[3] ) != fModificationTime || cPreamble[4] == 0 )
+        return false;
+
+    // a corrupted count must not allocate more offsets than there are words
+    uint64_t cNWords = fMapSize / sizeof ( uint32_t );
+
+    if ( cPreamble[4] > cNWords + 1 )
+    {
+        LOG (ERROR) << "RawFileReader: Error, " << pIndexName << " claims " << cPreamble[4] << " offsets for " << cNWords << " words - rebuilding the index" ;
+        return false;
+    }
+
+    fOffsets.resize ( cPreamble[4] );
+
+    if ( !cFile.read ( reinterpret_cast<char*> ( fOffsets.data() ), fOffsets.size() * sizeof ( uint64_t ) ) )
+    {
+        LOG (ERROR) << "RawFileReader: Error, " << pIndexName << " is truncated - rebuilding the index" ;
+        fOffsets.clear();
+        return false;
+    }
+
+    // the events are read straight from the map through these offsets: they have to be increasing and inside the file
+    uint64_t cFirst = fHeader.fValid ? FileHeader::fHeaderSize32 : 0;
+
+    for ( size_t cIndex = 0; cIndex < fOffsets.size(); cIndex++ )
+    {
+        bool cValid = ( cIndex == 0 ) ? fOffsets[0] >= cFirst : fOffsets[cIndex] > fOffsets[cIndex - 1];
+
+        if ( !cValid || fOffsets[cIndex] > cNWords )
+        {
+            LOG (ERROR) << "RawFileReader: Error, offset " << cIndex << " of " << pIndexName << " is out of order or beyond the end of " << fFileName << " - rebuilding the index" ;
+            fOffsets.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void RawFileReader::saveIndex ( const std::string& pIndexName ) const
+{
+    std::ofstream cFile ( pIndexName, std::ios::binary | std::ios::trunc );
+    uint64_t cPreamble[5] = {RAW_INDEX_MAGIC, RAW_INDEX_VERSION, fFileSize, uint64_t ( fModificationTime ), fOffsets.size() };
+
+    if ( cFile )
+    {
+        cFile.write ( reinterpret_cast<const char*> ( cPreamble ), sizeof ( cPreamble ) );
+        cFile.write ( reinterpret_cast<const char*> ( fOffsets.data() ), fOffsets.size() * sizeof ( uint64_t ) );
+    }
+
+    // a read-only data directory only costs the index build next time
+    if ( !cFile )
+        LOG (INFO) << "RawFileReader: could not write the index " << pIndexName ;
+}
+
+const uint32_t* RawFileReader::getEvent ( uint64_t pEvent, uint32_t& pSize ) const
+{
+    if ( pEvent >= getNEvents() )
+    {
+        pSize = 0;
+        return nullptr;
+    }
+
+    pSize = fOffsets[pEvent + 1] - fOffsets[pEvent];
+    return fWords + fOffsets[pEvent];
+}
+
+RawEventRange RawFileReader::getRange ( uint64_t pFirst, uint64_t pNEvents ) const
+{
+    uint64_t cNEvents = getNEvents();
+
+    if ( pFirst >= cNEvents ) return RawEventRange ( fWords, fOffsets.empty() ? nullptr : &fOffsets.back(), 0 );
+
+    return RawEventRange ( fWords, &fOffsets[pFirst], std::min ( pNEvents, cNEvents - pFirst ) );
+}
+
+uint32_t RawFileReader::readEvents ( std::vector<uint32_t>& pVec, uint32_t pNEvents )
+{
+    RawEventRange cRange = getRange ( fCurrentEvent, pNEvents );
+
+    if ( cRange.size() == 0 )
+    {
+        pVec.clear();
+        return 0;
+    }
+
+    pVec.assign ( cRange.data(), cRange.data() + cRange.nWords() );
+    fCurrentEvent += cRange.size();
+    return cRange.size();
+}
+
+uint32_t RawFileReader::decodeRange ( Data& pData, const BeBoard* pBoard, uint64_t pFirst, uint32_t pNEvents, std::vector<uint32_t>& pScratch ) const
+{
+    RawEventRange cRange = getRange ( pFirst, pNEvents );
+
+    if ( cRange.size() == 0 ) return 0;
+
+    pScratch.assign ( cRange.data(), cRange.data() + cRange.nWords() );
+    pData.privateSet ( pBoard, pScratch, cRange.size(), pBoard->getBoardType() );
+    return cRange.size();
+}
+
+void RawFileReader::decodeParallel ( const BeBoard* pBoard, uint32_t pEventsPerChunk, uint32_t pNThreads, const std::function<void ( uint64_t, const std::vector<Event*>& ) >& pCallback ) const
+{
+    if ( pEventsPerChunk == 0 ) pEventsPerChunk = 1;
+
+    if ( pNThreads == 0 ) pNThreads = std::max ( 1u, std::thread::hardware_concurrency() );
+
+    uint64_t cNChunks = ( getNEvents() + pEventsPerChunk - 1 ) / pEventsPerChunk;
+    pNThreads = std::min<uint64_t> ( pNThreads, cNChunks );
+
+    // the chunks are handed out one at a time, each thread keeps its Data object and buffer across its chunks
+    std::atomic<uint64_t> cNextChunk ( 0 );
+    auto cWorker = [&] ()
+    {
+        Data cData;
+        std::vector<uint32_t> cScratch;
+
+        for ( uint64_t cChunk = cNextChunk++; cChunk < cNChunks; cChunk = cNextChunk++ )
+        {
+            uint64_t cFirst = cChunk * pEventsPerChunk;
+
+            if ( decodeRange ( cData, pBoard, cFirst, pEventsPerChunk, cScratch ) > 0 )
+                pCallback ( cFirst, cData.GetEvents ( pBoard ) );
+        }
+    };
+
+    std::vector<std::thread> cThreads;
+
+    for ( uint32_t cThread = 1; cThread < pNThreads; cThread++ )
+        cThreads.emplace_back ( cWorker );
+
+    if ( pNThreads > 0 ) cWorker();
+
+    for ( auto& cThread : cThreads )
+        cThread.join();
+}
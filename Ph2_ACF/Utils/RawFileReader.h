@@ -0,0 +1,184 @@
+/*!
+        \file                RawFileReader.h
+        \brief               Memory mapped, indexed reader for the .raw files written by FileHandler
+ */
+
+#ifndef __RAWFILEREADER_H__
+#define __RAWFILEREADER_H__
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <iterator>
+#include "FileHeader.h"
+#include "Data.h"
+#include "../Utils/easylogging++.h"
+
+/*!
+ * \brief One event inside the mapped file
+ */
+struct RawEvent
+{
+    const uint32_t* fData;
+    uint32_t fSize;  /*!< in 32 bit words*/
+};
+
+/*!
+ * \class RawEventRange
+ * \brief Consecutive events of the mapped file, iterating over it yields RawEvent without copying anything
+ */
+class RawEventRange
+{
+  public:
+    class const_iterator : public std::iterator<std::forward_iterator_tag, RawEvent>
+    {
+      private:
+        const uint32_t* fWords;
+        const uint64_t* fOffset;
+
+      public:
+        const_iterator ( const uint32_t* pWords, const uint64_t* pOffset ) : fWords ( pWords ), fOffset ( pOffset ) {}
+
+        RawEvent operator*() const
+        {
+            return RawEvent { fWords + fOffset[0], static_cast<uint32_t> ( fOffset[1] - fOffset[0] ) };
+        }
+        const_iterator& operator++()
+        {
+            ++fOffset;
+            return *this;
+        }
+        bool operator== ( const const_iterator& pOther ) const
+        {
+            return fOffset == pOther.fOffset;
+        }
+        bool operator!= ( const const_iterator& pOther ) const
+        {
+            return fOffset != pOther.fOffset;
+        }
+    };
+
+  private:
+    const uint32_t* fWords;
+    const uint64_t* fFirst;  /*!< offsets of the events, one past the last event included*/
+    uint64_t fNEvents;
+
+  public:
+    RawEventRange ( const uint32_t* pWords, const uint64_t* pFirst, uint64_t pNEvents ) : fWords ( pWords ), fFirst ( pFirst ), fNEvents ( pNEvents ) {}
+
+    const_iterator begin() const
+    {
+        return const_iterator ( fWords, fFirst );
+    }
+    const_iterator end() const
+    {
+        return const_iterator ( fWords, fFirst + fNEvents );
+    }
+    uint64_t size() const
+    {
+        return fNEvents;
+    }
+    /*!
+     * \brief the events are contiguous in the file: first word and number of words of the whole range
+     */
+    const uint32_t* data() const
+    {
+        return fWords + fFirst[0];
+    }
+    uint64_t nWords() const
+    {
+        return fFirst[fNEvents] - fFirst[0];
+    }
+};
+
+/*!
+ * \class RawFileReader
+ * \brief Map a raw data file in memory and index its events
+ * \details D19C events are found from the BLOCK_SIZE of Header1, so zero suppressed events of any size work; the other boards use the fixed event size of the file header.
+ * The index is cached next to the data file as <file>.idx and rebuilt when the data file changes.
+ */
+class RawFileReader
+{
+  private:
+    std::string fFileName;
+    FileHeader fHeader;
+    int fFd;
+    const uint32_t* fWords;     /*!< the mapped file */
+    size_t fMapSize;            /*!< in bytes */
+    uint64_t fFileSize;
+    int64_t fModificationTime;  /*!< in ns, to detect a stale index */
+    std::vector<uint64_t> fOffsets; /*!< word offset of every event, followed by the end of the last one */
+    uint64_t fCurrentEvent;     /*!< for readEvents() */
+
+  public:
+    /*!
+     * \brief constructor, maps the file and loads or builds the index
+     * \param pFileName: the .raw file
+     * \param pUseIndexCache: read and write <file>.idx
+     */
+    RawFileReader ( const std::string& pFileName, bool pUseIndexCache = true );
+    ~RawFileReader();
+
+    RawFileReader ( const RawFileReader& ) = delete;
+    RawFileReader& operator= ( const RawFileReader& ) = delete;
+
+    bool isOpen() const
+    {
+        return fWords != nullptr;
+    }
+    const FileHeader& getHeader() const
+    {
+        return fHeader;
+    }
+    std::string getFilename() const
+    {
+        return fFileName;
+    }
+    uint64_t getNEvents() const
+    {
+        return fOffsets.empty() ? 0 : fOffsets.size() - 1;
+    }
+
+    /*!
+     * \brief random access to one event
+     * \param pEvent: event index, starting at 0
+     * \param pSize: set to the event size in 32 bit words
+     * \return pointer into the mapped file, nullptr if pEvent is out of range
+     */
+    const uint32_t* getEvent ( uint64_t pEvent, uint32_t& pSize ) const;
+    /*!
+     * \brief events [pFirst, pFirst + pNEvents), clipped to the end of the file
+     */
+    RawEventRange getRange ( uint64_t pFirst, uint64_t pNEvents ) const;
+
+    /*!
+     * \brief playback: copy the next pNEvents events to pVec
+     * \return number of events copied, 0 at the end of the file
+     */
+    uint32_t readEvents ( std::vector<uint32_t>& pVec, uint32_t pNEvents );
+    void rewind()
+    {
+        fCurrentEvent = 0;
+    }
+
+    /*!
+     * \brief decode events [pFirst, pFirst + pNEvents) into pData
+     * \param pScratch: reused to hand the words to Data
+     * \return number of events decoded
+     */
+    uint32_t decodeRange ( Ph2_HwInterface::Data& pData, const Ph2_HwDescription::BeBoard* pBoard, uint64_t pFirst, uint32_t pNEvents, std::vector<uint32_t>& pScratch ) const;
+    /*!
+     * \brief decode the whole file in chunks of pEventsPerChunk events on pNThreads threads
+     * \param pCallback: called with the index of the first event of the chunk and its events; it runs on the worker threads, concurrently, and the events are only valid during the call
+     * \param pNThreads: 0 for one thread per core
+     */
+    void decodeParallel ( const Ph2_HwDescription::BeBoard* pBoard, uint32_t pEventsPerChunk, uint32_t pNThreads, const std::function<void ( uint64_t, const std::vector<Ph2_HwInterface::Event*>& ) >& pCallback ) const;
+
+  private:
+    bool mapFile();
+    void buildIndex();
+    bool loadIndex ( const std::string& pIndexName );
+    void saveIndex ( const std::string& pIndexName ) const;
+};
+
+#endif
@@ -0,0 +1,331 @@
+/*
+
+        FileName :                     SLinkEncoder.cc
+        Content :                      Batched SLink encoding of D19C CBC3 events into caller provided buffers
+
+ */
+
+#include "SLinkEncoder.h"
+#include "D19cCbc3Event.h"
+#include "BitKernels.h"
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+    // MSB first writer into a zeroed buffer, the bit order of GenericPayload but without any bookkeeping of the size
+    class BitWriter
+    {
+      public:
+        BitWriter ( uint64_t* pBuffer ) :
+            fBuffer ( pBuffer ),
+            fPosition ( 0 )
+        {
+        }
+
+        size_t position() const
+        {
+            return fPosition;
+        }
+
+        void skip ( size_t pNBits )
+        {
+            fPosition += pNBits;
+        }
+
+        void append ( uint64_t pWord, uint32_t pNBits )
+        {
+            write ( fPosition, pWord, pNBits );
+            fPosition += pNBits;
+        }
+
+        // write the pNBits LSBs of pWord at pPosition, which has to be still 0
+        void write ( size_t pPosition, uint64_t pWord, uint32_t pNBits )
+        {
+            if ( pNBits < 64 ) pWord &= ( uint64_t ( 1 ) << pNBits ) - 1;
+
+            uint64_t* cWord = fBuffer + pPosition / 64;
+            uint32_t cFreeBits = 64 - pPosition % 64;
+
+            if ( pNBits <= cFreeBits )
+                cWord[0] |= pWord << ( cFreeBits - pNBits );
+            else
+            {
+                cWord[0] |= pWord >> ( pNBits - cFreeBits );
+                cWord[1] |= pWord << ( 64 - ( pNBits - cFreeBits ) );
+            }
+        }
+
+      private:
+        uint64_t* fBuffer;
+        size_t fPosition;
+    };
+
+    // a block of the event always has at least one word, even if it is empty
+    inline uint32_t words64 ( size_t pNBits )
+    {
+        return std::max<size_t> ( 1, ( pNBits + 63 ) / 64 );
+    }
+
+    inline uint32_t nStubs ( const uint32_t* pCbcData )
+    {
+        return ( ( pCbcData[9] & 0x000000FF ) != 0 ) + ( ( pCbcData[9] & 0x0000FF00 ) != 0 ) + ( ( pCbcData[9] & 0x00FF0000 ) != 0 );
+    }
+
+    // below this many events per thread, starting the thread costs more than it saves
+    const size_t MIN_EVENTS_PER_THREAD = 64;
+}
+
+namespace Ph2_HwInterface {
+
+    SLinkEncoder::SLinkEncoder ( BeBoard* pBoard ) :
+        fBoard ( pBoard ),
+        fBatched ( pBoard->getBoardType() == BoardType::D19C && pBoard->getEventType() != EventType::ZS && pBoard->getChipType() == ChipType::CBC3 ),
+        fDebugMode ( SLinkDebugMode::SUMMARY ),
+        fTkHeader1 ( 0 ),
+        fTkHeader2 ( 0 )
+    {
+        ConditionDataSet* cSet = pBoard->getConditionDataSet();
+        bool cCondData = false;
+
+        if ( cSet != nullptr )
+        {
+            fDebugMode = cSet->getDebugMode();
+            cCondData = cSet->getCondDataEnabled();
+
+            // the I2C values are the same for all the events of the acquisition, only the TDC items are set per event
+            uint32_t cTDC = 0;
+            pBoard->updateCondData ( cTDC );
+
+            if ( cCondData )
+            {
+                fCondData.push_back ( cSet->fCondDataVector.size() );
+
+                for ( auto& cCondItem : cSet->fCondDataVector )
+                {
+                    if ( cCondItem.fUID == 3 && cSet->testEffort() ) fTDCItems.push_back ( fCondData.size() );
+
+                    fCondData.push_back ( ( ( uint64_t ) cCondItem.fFeId & 0xFF ) << 56 | ( ( uint64_t ) cCondItem.fCbcId & 0xF ) << 52 | ( ( uint64_t ) cCondItem.fPage & 0xF ) << 48 | ( ( uint64_t ) cCondItem.fRegister & 0xFF ) << 40 | ( ( uint64_t ) cCondItem.fUID & 0xFF ) << 32 | cCondItem.fValue );
+                }
+            }
+        }
+
+        uint64_t cNCbc = 0;
+
+        for ( auto cFe : pBoard->fModuleVector )
+        {
+            FeLayout cFeLayout;
+            cFeLayout.fFeId = cFe->getFeId();
+
+            for ( auto cCbc : cFe->fCbcVector )
+                cFeLayout.fCbcIds.push_back ( cCbc->getCbcId() );
+
+            cNCbc += cFeLayout.fCbcIds.size();
+
+            if ( cFeLayout.fFeId < 64 ) fTkHeader2 |= ( uint64_t ) 1 << cFeLayout.fFeId;
+            else fTkHeader1 |= ( uint64_t ) 1 << ( cFeLayout.fFeId - 64 );
+
+            fFeLayout.push_back ( cFeLayout );
+        }
+
+        // version | format | event type | condition data | real data | BeStatus (per event) | NChips | Fe Status
+        fTkHeader1 |= ( ( uint64_t ) 0x2 & 0xF ) << 60 | ( ( uint64_t ) fDebugMode & 0x03 ) << 58 | ( ( uint64_t ) EventType::VR & 0x03 ) << 56 | ( uint64_t ) cCondData << 55 | ( uint64_t ) 1 << 54 | ( cNCbc & 0xFFFF ) << 8;
+    }
+
+    SLinkEncoder::EventLayout SLinkEncoder::getLayout ( const D19cCbc3Event& pEvent ) const
+    {
+        // the status of a CBC is 20 bits in FULL mode and the error flag in ERROR mode, which has always been written as a 32 bit int
+        uint32_t cStatusBits = ( fDebugMode == SLinkDebugMode::ERROR ) ? 32 : 20;
+        size_t cNStatusBits = 0;
+        size_t cNPayloadBits = 0;
+        size_t cNStubBits = 0;
+
+        for ( auto& cFe : fFeLayout )
+        {
+            // CBC presence word and stub counter
+            cNPayloadBits += 16;
+            cNStubBits += 6;
+
+            for ( auto cCbcId : cFe.fCbcIds )
+            {
+                const uint32_t* cData = pEvent.fView.chip ( cFe.fFeId, cCbcId );
+
+                if ( cData == nullptr ) continue;
+
+                cNStatusBits += cStatusBits;
+                cNPayloadBits += 64 * CBC_HIT_BITMAP_SIZE_64;
+                cNStubBits += 16 * nStubs ( cData );
+            }
+        }
+
+        EventLayout cLayout;
+        cLayout.fNStatus = ( fDebugMode == SLinkDebugMode::SUMMARY ) ? 0 : words64 ( cNStatusBits );
+        cLayout.fNPayload = words64 ( cNPayloadBits );
+        cLayout.fNStubs = words64 ( cNStubBits );
+        // DAQ header, 2 tracker header words, the blocks, the condition data and the DAQ trailer
+        cLayout.fNWords = 3 + cLayout.fNStatus + cLayout.fNPayload + cLayout.fNStubs + fCondData.size() + 1;
+        return cLayout;
+    }
+
+    uint32_t SLinkEncoder::getSize64 ( const D19cCbc3Event& pEvent ) const
+    {
+        return getLayout ( pEvent ).fNWords;
+    }
+
+    uint32_t SLinkEncoder::encode ( const D19cCbc3Event& pEvent, uint64_t* pBuffer ) const
+    {
+        EventLayout cLayout = getLayout ( pEvent );
+        std::fill ( pBuffer, pBuffer + cLayout.fNWords, 0 );
+
+        //BOE_1 | EVENT_TYPE | L1 ID | BX ID | SOURCE ID | FOV
+        uint64_t cLV1Id = pEvent.GetEventCount();
+        uint64_t cBXId = static_cast<uint16_t> ( pEvent.GetBunch() );
+        pBuffer[0] = ( ( uint64_t ) BOE_1 & 0xF ) << 60 | ( ( uint64_t ) EVENT_TYPE & 0xF ) << 56 | ( cLV1Id & 0x00FFFFFF ) << 32 | ( cBXId & 0x0FFF ) << 20 | ( ( uint64_t ) SOURCE_ID & 0x0FFF ) << 8 | ( FOV & 0xF ) << 4;
+        pBuffer[1] = fTkHeader1 | ( ( uint64_t ) pEvent.fBeStatus & 0x3FFFFFFF ) << 24;
+        pBuffer[2] = fTkHeader2;
+        // the CRC follows the event as its parts are completed, while they are still in the cache
+        uint16_t cCRC = 0xFFFF;
+        SLinkEvent::updateCRC ( cCRC, pBuffer, 3 );
+
+        uint64_t* cStatus = pBuffer + 3;
+        uint64_t* cPayload = cStatus + cLayout.fNStatus;
+        uint64_t* cStubs = cPayload + cLayout.fNPayload;
+        uint64_t* cCondData = cStubs + cLayout.fNStubs;
+        BitWriter cStatusWriter ( cStatus );
+        BitWriter cPayloadWriter ( cPayload );
+        BitWriter cStubWriter ( cStubs );
+
+        for ( auto& cFe : fFeLayout )
+        {
+            // the presence word and the stub counter are only known after the CBCs, leave room for them
+            size_t cPresencePosition = cPayloadWriter.position();
+            size_t cStubCounterPosition = cStubWriter.position();
+            cPayloadWriter.skip ( 16 );
+            cStubWriter.skip ( 6 );
+            uint16_t cCbcPresenceWord = 0;
+            uint8_t cFeStubCounter = 0;
+
+            for ( auto cCbcId : cFe.fCbcIds )
+            {
+                const uint32_t* cData = pEvent.fView.chip ( cFe.fFeId, cCbcId );
+
+                if ( cData == nullptr ) continue;
+
+                uint32_t cError = ( cData[8] & 0x00000003 );
+
+                if ( fDebugMode == SLinkDebugMode::ERROR )
+                    cStatusWriter.append ( ( cError != 0 ) ? 1 : 0, 32 );
+                else if ( fDebugMode == SLinkDebugMode::FULL )
+                {
+                    //error bits, pipeline address and L1A counter
+                    uint32_t cPipeAddress = ( cData[8] & 0x00001FF0 ) >> 4;
+                    uint32_t cL1ACounter = ( cData[8] & 0x01FF0000 ) >> 16;
+                    cStatusWriter.append ( cError << 18 | cPipeAddress << 9 | cL1ACounter, 20 );
+                }
+
+                cCbcPresenceWord |= 1 << cCbcId;
+
+                // channel 0 first, with the two padding 0s at the end
+                uint64_t cChannels[CBC_HIT_BITMAP_SIZE_64];
+                d19cCbc3SLinkPayload ( cData, cChannels );
+
+                for ( uint32_t cWord = 0; cWord < CBC_HIT_BITMAP_SIZE_64; cWord++ )
+                    cPayloadWriter.append ( cChannels[cWord], 64 );
+
+                for ( uint32_t cStub = 0; cStub < 3; cStub++ )
+                {
+                    uint8_t cPosition = ( cData[9] >> ( 8 * cStub ) ) & 0xFF;
+                    uint8_t cBend = ( cData[10] >> ( 8 + 8 * cStub ) ) & 0xF;
+
+                    if ( cPosition == 0 ) continue;
+
+                    cStubWriter.append ( ( cCbcId & 0x0F ) << 12 | cPosition << 4 | cBend, 16 );
+                    cFeStubCounter++;
+                }
+            }
+
+            cPayloadWriter.write ( cPresencePosition, cCbcPresenceWord, 16 );
+            // 5 bit counter followed by a 0
+            cStubWriter.write ( cStubCounterPosition, ( cFeStubCounter & 0x1F ) << 1, 6 );
+        }
+
+        SLinkEvent::updateCRC ( cCRC, cStatus, cLayout.fNStatus + cLayout.fNPayload + cLayout.fNStubs );
+
+        std::copy ( fCondData.begin(), fCondData.end(), cCondData );
+
+        for ( auto cIndex : fTDCItems )
+            cCondData[cIndex] = ( cCondData[cIndex] & 0xFFFFFFFF00000000 ) | pEvent.GetTDC();
+
+        //EOE_1 | EvtLength | CRC | Event Stat | TTS, the CRC is computed with its own field at 0
+        uint64_t& cTrailer = pBuffer[cLayout.fNWords - 1];
+        cTrailer = ( ( uint64_t ) EOE_1 & 0xFF ) << 56 | ( ( uint64_t ) cLayout.fNWords & 0x00FFFFFF ) << 32 | ( TTS_VALUE & 0xF ) << 4;
+        SLinkEvent::updateCRC ( cCRC, cCondData, fCondData.size() + 1 );
+        cTrailer |= ( uint64_t ) cCRC << 16;
+
+        return cLayout.fNWords;
+    }
+
+    size_t SLinkEncoder::encode ( const std::vector<Event*>& pEvents, std::vector<uint32_t>& pData, uint32_t pNThreads ) const
+    {
+        size_t cFirstWord = pData.size();
+
+        if ( !fBatched )
+        {
+            for ( auto cEvent : pEvents )
+            {
+                SLinkEvent cSLinkEvent = cEvent->GetSLinkEvent ( fBoard );
+                size_t cOffset = pData.size();
+                pData.resize ( cOffset + 2 * cSLinkEvent.getSize64() );
+                cSLinkEvent.copyData32 ( pData.data() + cOffset );
+            }
+
+            return pData.size() - cFirstWord;
+        }
+
+        // sizes first, so that every event has its place in the output before any thread starts
+        std::vector<size_t> cOffsets ( pEvents.size() + 1, cFirstWord );
+
+        for ( size_t cIndex = 0; cIndex < pEvents.size(); cIndex++ )
+            cOffsets.at ( cIndex + 1 ) = cOffsets.at ( cIndex ) + 2 * getSize64 ( static_cast<const D19cCbc3Event&> ( *pEvents.at ( cIndex ) ) );
+
+        pData.resize ( cOffsets.back() );
+
+        if ( pNThreads == 0 ) pNThreads = std::max ( 1u, std::thread::hardware_concurrency() );
+
+        pNThreads = std::max<size_t> ( 1, std::min<size_t> ( pNThreads, pEvents.size() / MIN_EVENTS_PER_THREAD ) );
+        size_t cEventsPerThread = ( pEvents.size() + pNThreads - 1 ) / pNThreads;
+        std::vector<std::thread> cThreads;
+
+        for ( uint32_t cThread = 1; cThread < pNThreads; cThread++ )
+        {
+            size_t cFirst = std::min ( pEvents.size(), cThread * cEventsPerThread );
+            size_t cLast = std::min ( pEvents.size(), cFirst + cEventsPerThread );
+            cThreads.emplace_back ( &SLinkEncoder::encodeRange, this, std::cref ( pEvents ), cFirst, cLast, std::cref ( cOffsets ), pData.data() );
+        }
+
+        encodeRange ( pEvents, 0, std::min ( pEvents.size(), cEventsPerThread ), cOffsets, pData.data() );
+
+        for ( auto& cThread : cThreads )
+            cThread.join();
+
+        return pData.size() - cFirstWord;
+    }
+
+    void SLinkEncoder::encodeRange ( const std::vector<Event*>& pEvents, size_t pFirst, size_t pLast, const std::vector<size_t>& pOffsets, uint32_t* pData ) const
+    {
+        std::vector<uint64_t> cEvent;
+
+        for ( size_t cIndex = pFirst; cIndex < pLast; cIndex++ )
+        {
+            cEvent.resize ( ( pOffsets.at ( cIndex + 1 ) - pOffsets.at ( cIndex ) ) / 2 );
+            encode ( static_cast<const D19cCbc3Event&> ( *pEvents.at ( cIndex ) ), cEvent.data() );
+            uint32_t* cOut = pData + pOffsets.at ( cIndex );
+
+            for ( auto cWord : cEvent )
+            {
+                *cOut++ = cWord >> 32;
+                *cOut++ = cWord & 0xFFFFFFFF;
+            }
+        }
+    }
+}
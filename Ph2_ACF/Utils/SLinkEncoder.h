@@ -0,0 +1,101 @@
+/*!
+
+        \file                          SLinkEncoder.h
+        \brief                         Batched SLink encoding of D19C CBC3 events into caller provided buffers
+
+ */
+
+#ifndef __SLINKENCODER_H__
+#define __SLINKENCODER_H__
+
+#include <vector>
+#include "Event.h"
+#include "SLinkEvent.h"
+#include "../HWDescription/BeBoard.h"
+#include "../HWDescription/Definition.h"
+
+using namespace Ph2_HwDescription;
+
+namespace Ph2_HwInterface {
+
+    class D19cCbc3Event;
+
+    /*!
+     * \class SLinkEncoder
+     * \brief Encodes events of one board in the SLink format without going through GenericPayload
+     *
+     * The board layout, debug mode and condition data are taken once at construction, so encode() only reads the board and the
+     * events and can run on several threads. The size of an event is computed before it is written, the bits are then put in
+     * place in a zeroed buffer and the even/odd channel merge uses the interleaving kernel of BitKernels.
+     * Events of other boards than D19C with CBC3 in VR mode fall back to Event::GetSLinkEvent(), serially.
+     */
+    class SLinkEncoder
+    {
+      public:
+        /*!
+         * \brief Constructor of the SLinkEncoder class, refreshes the I2C values of the condition data of pBoard
+         * \param pBoard : the board the events belong to
+         */
+        SLinkEncoder ( BeBoard* pBoard );
+
+        /*!
+         * \brief true if the events of the board are encoded here, false if they fall back to GetSLinkEvent()
+         */
+        bool isBatched() const
+        {
+            return fBatched;
+        }
+        SLinkDebugMode getDebugMode() const
+        {
+            return fDebugMode;
+        }
+        /*!
+         * \brief Number of 64 bit words of the SLink event of pEvent
+         */
+        uint32_t getSize64 ( const D19cCbc3Event& pEvent ) const;
+        /*!
+         * \brief Encode one event
+         * \param pEvent : the event
+         * \param pBuffer : getSize64 (pEvent) words, overwritten
+         * \return number of 64 bit words written
+         */
+        uint32_t encode ( const D19cCbc3Event& pEvent, uint64_t* pBuffer ) const;
+        /*!
+         * \brief Encode a whole acquisition and append it to pData as 32 bit words, most significant half first like SLinkEvent::getData<uint32_t>()
+         * \param pEvents : the events, in the order they are written
+         * \param pData : output, resized once
+         * \param pNThreads : threads to encode on, 0 for one per core
+         * \return number of 32 bit words appended
+         */
+        size_t encode ( const std::vector<Event*>& pEvents, std::vector<uint32_t>& pData, uint32_t pNThreads = 0 ) const;
+
+      private:
+        struct FeLayout
+        {
+            uint8_t fFeId;
+            std::vector<uint8_t> fCbcIds;
+        };
+
+        struct EventLayout
+        {
+            uint32_t fNStatus = 0;
+            uint32_t fNPayload = 0;
+            uint32_t fNStubs = 0;
+            uint32_t fNWords = 0;
+        };
+
+        EventLayout getLayout ( const D19cCbc3Event& pEvent ) const;
+        void encodeRange ( const std::vector<Event*>& pEvents, size_t pFirst, size_t pLast, const std::vector<size_t>& pOffsets, uint32_t* pData ) const;
+
+        BeBoard* fBoard;
+        bool fBatched;
+        SLinkDebugMode fDebugMode;
+        std::vector<FeLayout> fFeLayout;
+        uint64_t fTkHeader1;                    /*!< tracker header words without the BE status */
+        uint64_t fTkHeader2;
+        std::vector<uint64_t> fCondData;        /*!< count and items of the condition data */
+        std::vector<size_t> fTDCItems;          /*!< index in fCondData of the items that take the TDC of the event */
+    };
+}
+
+#endif
@@ -33,6 +33,18 @@ SLinkEvent::SLinkEvent (std::vector<uint64_t>& pDataVec) :
     //fCRCVal = ;
 }
 
+SLinkEvent::SLinkEvent (EventType pEventType, SLinkDebugMode pMode, ChipType pChipType, std::vector<uint64_t>&& pDataVec) :
+    fChipType (pChipType),
+    fEventType (pEventType),
+    fDebugMode (pMode),
+    fData (std::move (pDataVec) ),
+    fSize (fData.size() ),
+    fCRCVal ( (fData.size() != 0) ? (fData.back() >> 16) & 0xFFFF : 0),
+    fCondData (0),
+    fFake (0)
+{
+}
+
 //template<typename T>
 //std::vector<T> SLinkEvent::getData()
 //{
@@ -95,19 +107,19 @@ void SLinkEvent::generateTkHeader (uint32_t& pBeStatus, uint16_t& pNChips, std::
     fSize += 2;
 }
 
-void SLinkEvent::generateStatus (std::vector<uint64_t> pStatusVec)
+void SLinkEvent::generateStatus (const std::vector<uint64_t>& pStatusVec)
 {
     fData.insert (fData.begin() + 3, pStatusVec.begin(), pStatusVec.end() );
     fSize += pStatusVec.size();
 }
 
-void SLinkEvent::generatePayload (std::vector<uint64_t> pPayloadVec)
+void SLinkEvent::generatePayload (const std::vector<uint64_t>& pPayloadVec)
 {
     fData.insert (fData.end(), pPayloadVec.begin(), pPayloadVec.end() );
     fSize += pPayloadVec.size();
 }
 
-void SLinkEvent::generateStubs (std::vector<uint64_t> pStubVec)
+void SLinkEvent::generateStubs (const std::vector<uint64_t>& pStubVec)
 {
     fData.insert (fData.end(), pStubVec.begin(), pStubVec.end() );
     fSize += pStubVec.size();
@@ -168,6 +180,25 @@ uint32_t SLinkEvent::getSize64()
     return fData.size();
 }
 
+void SLinkEvent::copyData32 (uint32_t* pBuffer) const
+{
+    for (auto cWord : fData)
+    {
+        *pBuffer++ = cWord >> 32;
+        *pBuffer++ = cWord & 0xFFFFFFFF;
+    }
+}
+
+uint16_t SLinkEvent::computeCRC (const uint64_t* pWords, size_t pNWords)
+{
+    return fCalculator.compute (reinterpret_cast<const uint8_t*> (pWords), pNWords * sizeof (uint64_t) );
+}
+
+void SLinkEvent::updateCRC (uint16_t& pCRC, const uint64_t* pWords, size_t pNWords)
+{
+    fCalculator.compute (pCRC, reinterpret_cast<const uint8_t*> (pWords), pNWords * sizeof (uint64_t) );
+}
+
 void SLinkEvent::calculateCRC ()
 {
     //original code before CRC Calculator
@@ -203,7 +234,6 @@ void SLinkEvent::calculateCRC ()
     //}
 
     //fCRCVal = cCRC;
-    //CRCCalculator needs an array of unsigned char
-    std::vector<uint8_t> cData = this->getData<uint8_t>();
-    fCRCVal = fCalculator.compute (&cData[0], sizeof (&cData) );
+    //the CRC covers the whole event, the calculator takes the 64 bit words as they are in memory
+    fCRCVal = computeCRC (fData.data(), fData.size() );
 }
@@ -28,6 +28,8 @@ class SLinkEvent
     SLinkEvent ();
     SLinkEvent (EventType pEventType, SLinkDebugMode pMode, ChipType pChipType, uint32_t& pLV1Id, uint16_t& pBXId, int pSourceId = SOURCE_ID);
     SLinkEvent (std::vector<uint64_t>& pDataVec); //playback Constructor
+    //takes over an event that was already encoded, e.g. by the SLinkEncoder
+    SLinkEvent (EventType pEventType, SLinkDebugMode pMode, ChipType pChipType, std::vector<uint64_t>&& pDataVec);
 
     ~SLinkEvent()
     {
@@ -37,9 +39,9 @@ class SLinkEvent
     void generateDAQHeader (uint32_t& pLV1Id, uint16_t& pBXId, int pSourceId);
     void generateTkHeader (uint32_t& pBeStatus, uint16_t& pNChips, std::set<uint8_t>& pEnabledFe, bool pCondData = false, bool pFake = false);
     // the following 4 are dumb methods in that they just insert a vector of 64 bit words
-    void generateStatus (std::vector<uint64_t> pStatusVec);
-    void generatePayload (std::vector<uint64_t> pPayloadVec);
-    void generateStubs (std::vector<uint64_t> pStubVec);
+    void generateStatus (const std::vector<uint64_t>& pStatusVec);
+    void generatePayload (const std::vector<uint64_t>& pPayloadVec);
+    void generateStubs (const std::vector<uint64_t>& pStubVec);
     // kind of important
     void generateConditionData (ConditionDataSet* pSet);
     void generateDAQTrailer();
@@ -54,6 +56,18 @@ class SLinkEvent
     {
         return split_vec64<T> (fData);
     }
+    //the 64 bit words of the event, without a copy
+    const std::vector<uint64_t>& getData64() const
+    {
+        return fData;
+    }
+    //copy the event as 32 bit words, most significant half first like getData<uint32_t>(), to a buffer of 2 * getSize64() words
+    void copyData32 (uint32_t* pBuffer) const;
+
+    //CRC of a complete event whose trailer has the CRC field still at 0
+    static uint16_t computeCRC (const uint64_t* pWords, size_t pNWords);
+    //continue pCRC (0xFFFF at the start of the event) over the next pNWords words, to compute it while the event is written
+    static void updateCRC (uint16_t& pCRC, const uint64_t* pWords, size_t pNWords);
 
     void print (std::ostream& out = std::cout) const;
 
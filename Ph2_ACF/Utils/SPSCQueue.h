@@ -0,0 +1,103 @@
+/*!
+        \file                SPSCQueue.h
+        \brief               Lock-free ring buffer between exactly one producer thread and one consumer thread
+ */
+
+#ifndef __SPSCQUEUE_H__
+#define __SPSCQUEUE_H__
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+/*!
+ * \class SPSCQueue
+ * \brief Fixed capacity ring, elements are moved in and out; tryPush() fails when full and tryPop() when empty, nothing blocks
+ */
+template<typename T>
+class SPSCQueue
+{
+  private:
+    std::vector<T> fSlots;
+    size_t fMask;
+    // head and tail on their own cache lines, they are written by different threads
+    alignas ( 64 ) std::atomic<size_t> fHead;   /*!< next slot to pop, written by the consumer*/
+    alignas ( 64 ) std::atomic<size_t> fTail;   /*!< next slot to push, written by the producer*/
+    std::atomic<size_t> fHighWater;             /*!< maximum number of queued elements, written by the producer*/
+
+  public:
+    /*!
+     * \brief Constructor
+     * \param pCapacity : number of slots, rounded up to a power of 2
+     */
+    SPSCQueue ( size_t pCapacity ) :
+        fHead ( 0 ),
+        fTail ( 0 ),
+        fHighWater ( 0 )
+    {
+        size_t cCapacity = 1;
+
+        while ( cCapacity < pCapacity ) cCapacity <<= 1;
+
+        fSlots.resize ( cCapacity );
+        fMask = cCapacity - 1;
+    }
+
+    /*!
+     * \brief Move an element in, producer side
+     * \return false if the queue is full, pElement is then left untouched
+     */
+    bool tryPush ( T&& pElement )
+    {
+        size_t cTail = fTail.load ( std::memory_order_relaxed );
+        size_t cHead = fHead.load ( std::memory_order_acquire );
+
+        if ( cTail - cHead == fSlots.size() ) return false;
+
+        fSlots[cTail & fMask] = std::move ( pElement );
+        fTail.store ( cTail + 1, std::memory_order_release );
+
+        if ( cTail + 1 - cHead > fHighWater.load ( std::memory_order_relaxed ) )
+            fHighWater.store ( cTail + 1 - cHead, std::memory_order_relaxed );
+
+        return true;
+    }
+
+    /*!
+     * \brief Move the oldest element out, consumer side
+     * \return false if the queue is empty
+     */
+    bool tryPop ( T& pElement )
+    {
+        size_t cHead = fHead.load ( std::memory_order_relaxed );
+        size_t cTail = fTail.load ( std::memory_order_acquire );
+
+        if ( cHead == cTail ) return false;
+
+        pElement = std::move ( fSlots[cHead & fMask] );
+        fHead.store ( cHead + 1, std::memory_order_release );
+        return true;
+    }
+
+    bool empty() const
+    {
+        return fHead.load ( std::memory_order_acquire ) == fTail.load ( std::memory_order_acquire );
+    }
+
+    size_t size() const
+    {
+        return fTail.load ( std::memory_order_acquire ) - fHead.load ( std::memory_order_acquire );
+    }
+
+    size_t capacity() const
+    {
+        return fSlots.size();
+    }
+
+    size_t highWater() const
+    {
+        return fHighWater.load ( std::memory_order_relaxed );
+    }
+};
+
+#endif
@@ -23,7 +23,7 @@ namespace Ph2_HwInterface {
      * \class SSAEvent
      * \brief Event container to manipulate event flux from the SSA
      */
-    class SSAEvent : public Event
+    class SSAEvent final : public Event
     {
       public:
         /*!
@@ -0,0 +1,174 @@
+/*
+
+        FileName :                     BenchmarkFixtures.cc
+        Content :                      Generated data, boards and allocation counter shared by the benchmark executables
+
+ */
+
+#include "BenchmarkFixtures.h"
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include <random>
+#include <algorithm>
+#include "../HWDescription/Module.h"
+#include "../HWDescription/Cbc.h"
+#include "../Utils/ConditionDataSet.h"
+
+// count every heap allocation of the process
+static std::atomic<uint64_t> gNAllocations ( 0 );
+
+void* operator new ( std::size_t pSize )
+{
+    gNAllocations++;
+
+    if ( void* cPtr = std::malloc ( pSize ) ) return cPtr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete ( void* pPtr ) noexcept
+{
+    std::free ( pPtr );
+}
+
+uint64_t getNAllocations()
+{
+    return gNAllocations;
+}
+
+std::vector<uint32_t> makeD19cData ( uint32_t pNEvents, uint32_t pNFe, uint32_t pNChip, uint32_t pChipSize, bool pCbc3 )
+{
+    std::vector<uint32_t> cData;
+    std::mt19937 cGenerator ( 42 );
+    uint32_t cFeSize = D19C_EVENT_HEADER2_SIZE_32 + pNChip * pChipSize;
+    uint32_t cEventSize = D19C_EVENT_HEADER1_SIZE_32 + pNFe * cFeSize;
+    uint32_t cFeMask = ( 1 << pNFe ) - 1;
+    uint32_t cChipMask = ( 1 << pNChip ) - 1;
+
+    for ( uint32_t cEvent = 0; cEvent < pNEvents; cEvent++ )
+    {
+        cData.push_back ( D19C_EVENT_HEADER1_SIZE_32 << 24 | cFeMask << 16 | cEventSize );
+        cData.push_back ( 0 );
+        cData.push_back ( cEvent + 1 );
+        cData.push_back ( 0 );
+        cData.push_back ( 0 );
+
+        for ( uint32_t cFe = 0; cFe < pNFe; cFe++ )
+        {
+            cData.push_back ( cChipMask << 24 | D19C_EVENT_HEADER2_SIZE_32 << 16 | cFeSize );
+
+            for ( uint32_t cChip = 0; cChip < pNChip; cChip++ )
+            {
+                for ( uint32_t cWord = 0; cWord < pChipSize; cWord++ )
+                    cData.push_back ( cGenerator() & cGenerator() & cGenerator() );
+
+                if ( pCbc3 )
+                {
+                    cData[cData.size() - 3] &= 0x01FF1FF3;
+                    cData[cData.size() - 1] = ( cData.back() & 0x0F0F0F00 ) | 0x00000008;
+                }
+            }
+        }
+    }
+
+    return cData;
+}
+
+std::vector<uint32_t> makeD19cZSData ( uint32_t pNEvents, uint32_t pNFe, uint32_t pNCbc )
+{
+    std::vector<uint32_t> cData;
+    std::mt19937 cGenerator ( 42 );
+    uint32_t cFeMask = ( 1 << pNFe ) - 1;
+    uint32_t cCbcMask = ( 1 << pNCbc ) - 1;
+
+    for ( uint32_t cEvent = 0; cEvent < pNEvents; cEvent++ )
+    {
+        size_t cStart = cData.size();
+        cData.resize ( cStart + D19C_EVENT_HEADER1_SIZE_32, 0 );
+        cData[cStart + 2] = cEvent + 1;
+
+        for ( uint32_t cFe = 0; cFe < pNFe; cFe++ )
+        {
+            size_t cHeader = cData.size();
+            cData.push_back ( 0 );
+
+            for ( uint32_t cCbc = 0; cCbc < pNCbc; cCbc++ )
+            {
+                uint32_t cChipBits = cCbc << 29;
+
+                // 0 to 3 clusters, two per word
+                for ( uint32_t cNClusters = cGenerator() % 4; cNClusters > 0; cNClusters -= std::min ( 2u, cNClusters ) )
+                {
+                    uint32_t cWord = cChipBits | ( 1 << 24 ) | ( ( cGenerator() % 240 ) << 3 ) | ( cGenerator() % 4 );
+
+                    if ( cNClusters > 1 ) cWord |= ( 1 << 25 ) | ( ( cGenerator() % 240 ) << 14 ) | ( ( cGenerator() % 4 ) << 11 );
+
+                    cData.push_back ( cWord );
+                }
+
+                cData.push_back ( cChipBits | ( 2 << 27 ) | ( ( ( cEvent + 1 ) & 0x1FF ) << 16 ) );
+            }
+
+            cData[cHeader] = cCbcMask << 24 | D19C_EVENT_HEADER2_SIZE_32 << 16 | ( cData.size() - cHeader );
+        }
+
+        cData[cStart] = D19C_EVENT_HEADER1_SIZE_32 << 24 | cFeMask << 16 | ( cData.size() - cStart );
+    }
+
+    return cData;
+}
+
+uint32_t countD19cEvents ( const std::vector<uint32_t>& pData )
+{
+    uint32_t cNEvents = 0;
+    size_t cOffset = 0;
+
+    while ( cOffset < pData.size() )
+    {
+        uint32_t cSize = pData[cOffset] & 0xFFFF;
+
+        if ( cSize == 0 || cOffset + cSize > pData.size() ) break;
+
+        cOffset += cSize;
+        cNEvents++;
+    }
+
+    return cNEvents;
+}
+
+BeBoard* makeBoard ( uint32_t pNFe, uint32_t pNChip, EventType pEventType, ChipType pChipType )
+{
+    BeBoard* cBoard = new BeBoard ( 0 );
+    cBoard->setBoardType ( BoardType::D19C );
+    cBoard->setEventType ( pEventType );
+    cBoard->setChipType ( pChipType );
+    cBoard->addConditionDataSet ( new ConditionDataSet ( SLinkDebugMode::FULL, false ) );
+
+    for ( uint32_t cFe = 0; cFe < pNFe; cFe++ )
+    {
+        Module* cModule = new Module ( 0, 0, cFe, cFe );
+
+        if ( pChipType == ChipType::CBC3 )
+        {
+            for ( uint32_t cCbc = 0; cCbc < pNChip; cCbc++ )
+                cModule->addCbc ( new Cbc ( 0, 0, cFe, cCbc, "settings/CbcFiles/CBC3_default.txt" ) );
+        }
+
+        cBoard->addModule ( cModule );
+    }
+
+    return cBoard;
+}
+
+void makeParentDirectory ( const std::string& pFileName )
+{
+    size_t cSlash = pFileName.find_last_of ( '/' );
+
+    if ( cSlash == std::string::npos || cSlash == 0 ) return;
+
+    std::string cCommand = "mkdir -p " + pFileName.substr ( 0, cSlash );
+
+    if ( system ( cCommand.c_str() ) != 0 )
+        LOG (ERROR) << "Could not create the directory of " << pFileName;
+}
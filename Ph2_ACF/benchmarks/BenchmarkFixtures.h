@@ -0,0 +1,51 @@
+/*!
+
+        \file                          BenchmarkFixtures.h
+        \brief                         Generated data, boards and allocation counter shared by the benchmark executables
+
+ */
+
+#ifndef __BENCHMARKFIXTURES_H__
+#define __BENCHMARKFIXTURES_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../HWDescription/BeBoard.h"
+#include "../HWDescription/Definition.h"
+
+using namespace Ph2_HwDescription;
+
+/*!
+ * \brief Number of heap allocations of the process so far, every benchmark linking BenchmarkFixtures.cc counts them
+ */
+uint64_t getNAllocations();
+
+/*!
+ * \brief Build pNEvents D19C events of pNFe hybrids with pNChip chips and random payload
+ * \param pChipSize : words per chip
+ * \param pCbc3 : CBC3 chip data, stubs in range and the sync bit set
+ */
+std::vector<uint32_t> makeD19cData ( uint32_t pNEvents, uint32_t pNFe, uint32_t pNChip, uint32_t pChipSize = CBC_EVENT_SIZE_32_CBC3, bool pCbc3 = true );
+
+/*!
+ * \brief Build pNEvents zero suppressed D19C CBC3 events: a few clusters and the L1 word per chip
+ */
+std::vector<uint32_t> makeD19cZSData ( uint32_t pNEvents, uint32_t pNFe, uint32_t pNCbc );
+
+/*!
+ * \brief Number of complete events at the start of recorded D19C data, following the size in each header
+ */
+uint32_t countD19cEvents ( const std::vector<uint32_t>& pData );
+
+/*!
+ * \brief D19C board of pNFe hybrids, with pNChip CBCs each for the CBC3 chip type and an SLink condition data set
+ */
+BeBoard* makeBoard ( uint32_t pNFe, uint32_t pNChip, EventType pEventType = EventType::VR, ChipType pChipType = ChipType::CBC3 );
+
+/*!
+ * \brief Create the directory of an output file, so that the benchmarks also run on a fresh checkout
+ */
+void makeParentDirectory ( const std::string& pFileName );
+
+#endif
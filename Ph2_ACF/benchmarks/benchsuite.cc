@@ -0,0 +1,432 @@
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include "../HWDescription/BeBoard.h"
+#include "../HWDescription/Module.h"
+#include "../HWDescription/Cbc.h"
+#include "../HWInterface/D19cEmulatorFWInterface.h"
+#include "../Utils/Data.h"
+#include "../Utils/CRCCalculator.h"
+#include "../Utils/FileHandler.h"
+#include "../Utils/BitKernels.h"
+#include "../Utils/ClusterFinder.h"
+#include "../Utils/Utilities.h"
+#include "../Utils/Timer.h"
+#include "../Utils/argvparser.h"
+#include "../Utils/ConsoleColor.h"
+#include "../tools/PedeNoise.h"
+#include "BenchmarkFixtures.h"
+#include "TROOT.h"
+
+using namespace Ph2_HwDescription;
+using namespace Ph2_HwInterface;
+using namespace Ph2_System;
+using namespace CommandLineProcessing;
+
+using namespace std;
+INITIALIZE_EASYLOGGINGPP
+
+// one line of the report, an "event" is whatever unit the benchmark processes
+struct BenchmarkResult
+{
+    std::string fName;
+    std::string fUnit;
+    double fNEvents;
+    double fTime;
+    uint64_t fNAllocations;
+};
+
+class BenchmarkReport
+{
+  public:
+    // run pBody once to warm up, then pRepetitions times on the clock; pBody handles pNEvents events per call
+    void measure ( const std::string& pName, const std::string& pUnit, uint64_t pNEvents, uint32_t pRepetitions, const std::function<void()>& pBody )
+    {
+        pBody();
+
+        uint64_t cAllocationsBefore = getNAllocations();
+        Timer t;
+        t.start();
+
+        for ( uint32_t cRepetition = 0; cRepetition < pRepetitions; cRepetition++ )
+            pBody();
+
+        t.stop();
+        add ( pName, pUnit, double ( pNEvents ) * pRepetitions, t.getElapsedTime(), getNAllocations() - cAllocationsBefore );
+    }
+
+    void add ( const std::string& pName, const std::string& pUnit, double pNEvents, double pTime, uint64_t pNAllocations )
+    {
+        fResults.push_back ( BenchmarkResult {pName, pUnit, pNEvents, pTime, pNAllocations} );
+        LOG (INFO) << std::left << std::setw ( 28 ) << pName << std::right << std::fixed
+                   << std::setprecision ( 1 ) << std::setw ( 14 ) << pNEvents / pTime << " " << pUnit << "/s"
+                   << std::setw ( 12 ) << 1e9 * pTime / pNEvents << " ns/" << pUnit
+                   << std::setprecision ( 3 ) << std::setw ( 10 ) << pNAllocations / pNEvents << " allocs/" << pUnit;
+    }
+
+    // one object per benchmark, the rates are derived so that a tracking script does not have to
+    bool writeJson ( const std::string& pFileName, const std::string& pSetup ) const
+    {
+        makeParentDirectory ( pFileName );
+        std::ofstream cFile ( pFileName );
+
+        if ( !cFile.is_open() ) return false;
+
+        std::time_t cNow = std::time ( nullptr );
+        char cDate[32];
+        std::strftime ( cDate, sizeof ( cDate ), "%Y-%m-%dT%H:%M:%S", std::localtime ( &cNow ) );
+
+        cFile << "{\n";
+        cFile << "  \"date\": \"" << cDate << "\",\n";
+        cFile << "  \"kernels\": \"" << bitKernelsISA() << "\",\n";
+        cFile << "  \"setup\": \"" << pSetup << "\",\n";
+        cFile << "  \"results\": [\n";
+
+        for ( size_t cIndex = 0; cIndex < fResults.size(); cIndex++ )
+        {
+            const BenchmarkResult& cResult = fResults[cIndex];
+            cFile << std::setprecision ( 10 );
+            cFile << "    {\"name\": \"" << cResult.fName << "\", \"unit\": \"" << cResult.fUnit << "\""
+                  << ", \"events\": " << cResult.fNEvents
+                  << ", \"seconds\": " << cResult.fTime
+                  << ", \"events_per_s\": " << cResult.fNEvents / cResult.fTime
+                  << ", \"ns_per_event\": " << 1e9 * cResult.fTime / cResult.fNEvents
+                  << ", \"allocations\": " << cResult.fNAllocations
+                  << ", \"allocations_per_event\": " << cResult.fNAllocations / cResult.fNEvents << "}"
+                  << ( cIndex + 1 < fResults.size() ? ",\n" : "\n" );
+        }
+
+        cFile << "  ]\n}\n";
+        return true;
+    }
+
+  private:
+    std::vector<BenchmarkResult> fResults;
+};
+
+// Data::Set on the three D19C event formats
+void runDecode ( BenchmarkReport& pReport, const std::vector<uint32_t>& pRaw, uint32_t pNEvents, uint32_t pNFe, uint32_t pNCbc, uint32_t pRepetitions )
+{
+    std::unique_ptr<BeBoard> cVRBoard ( makeBoard ( pNFe, pNCbc, EventType::VR, ChipType::CBC3 ) );
+    std::unique_ptr<BeBoard> cZSBoard ( makeBoard ( pNFe, pNCbc, EventType::ZS, ChipType::CBC3 ) );
+    std::unique_ptr<BeBoard> cMPABoard ( makeBoard ( pNFe, pNCbc, EventType::VR, ChipType::MPA ) );
+    std::vector<uint32_t> cZSRaw = makeD19cZSData ( pNEvents, pNFe, pNCbc );
+    std::vector<uint32_t> cMPARaw = makeD19cData ( pNEvents, pNFe, pNCbc, D19C_EVENT_SIZE_32_MPA, false );
+    Data cData;
+
+    pReport.measure ( "decode.d19c_cbc3_vr", "event", pNEvents, pRepetitions, [&]()
+    {
+        cData.privateSet ( cVRBoard.get(), pRaw, pNEvents, BoardType::D19C );
+    } );
+    pReport.measure ( "decode.d19c_cbc3_zs", "event", pNEvents, pRepetitions, [&]()
+    {
+        cData.privateSet ( cZSBoard.get(), cZSRaw, pNEvents, BoardType::D19C );
+    } );
+    pReport.measure ( "decode.d19c_mpa", "event", pNEvents, pRepetitions, [&]()
+    {
+        cData.privateSet ( cMPABoard.get(), cMPARaw, pNEvents, BoardType::D19C );
+    } );
+    cData.Reset();
+}
+
+// hit access on decoded events, SLink encoding and its CRC
+void runEvent ( BenchmarkReport& pReport, const std::vector<uint32_t>& pRaw, uint32_t pNEvents, uint32_t pNFe, uint32_t pNCbc, uint32_t pRepetitions )
+{
+    std::unique_ptr<BeBoard> cBoard ( makeBoard ( pNFe, pNCbc, EventType::VR, ChipType::CBC3 ) );
+    Data cData;
+    cData.privateSet ( cBoard.get(), pRaw, pNEvents, BoardType::D19C );
+    const std::vector<Event*>& cEvents = cData.GetEvents ( cBoard.get() );
+    uint64_t cNEvents = cEvents.size();
+    uint64_t cSink = 0;
+
+    pReport.measure ( "event.gethits", "event", cNEvents, pRepetitions, [&]()
+    {
+        for ( auto cEvent : cEvents )
+            for ( uint32_t cFe = 0; cFe < pNFe; cFe++ )
+                for ( uint32_t cCbc = 0; cCbc < pNCbc; cCbc++ )
+                    cSink += cEvent->GetHits ( cFe, cCbc ).size();
+    } );
+    pReport.measure ( "event.databit", "event", cNEvents, pRepetitions, [&]()
+    {
+        for ( auto cEvent : cEvents )
+            for ( uint32_t cFe = 0; cFe < pNFe; cFe++ )
+                for ( uint32_t cCbc = 0; cCbc < pNCbc; cCbc++ )
+                    for ( uint32_t cChannel = 0; cChannel < NCHANNELS; cChannel++ )
+                        cSink += cEvent->DataBit ( cFe, cCbc, cChannel );
+    } );
+
+    pReport.measure ( "event.getclusters", "event", cNEvents, pRepetitions, [&]()
+    {
+        for ( auto cEvent : cEvents )
+            for ( uint32_t cFe = 0; cFe < pNFe; cFe++ )
+                for ( uint32_t cCbc = 0; cCbc < pNCbc; cCbc++ )
+                    cSink += cEvent->getClusters ( cFe, cCbc ).size();
+    } );
+
+    std::vector<ClusterFinder> cFinders;
+    std::vector<std::vector<Cluster>> cClusters;
+
+    for ( auto cFe : cBoard->fModuleVector )
+        cFinders.emplace_back ( cFe );
+
+    pReport.measure ( "event.moduleclusters", "event", cNEvents, pRepetitions, [&]()
+    {
+        for ( auto& cFinder : cFinders )
+            cSink += cFinder.findClusters ( cEvents, cClusters );
+    } );
+
+    std::vector<std::vector<uint64_t>> cSLinkData ( cNEvents );
+
+    pReport.measure ( "slink.getslinkevent", "event", cNEvents, pRepetitions, [&]()
+    {
+        for ( uint64_t cIndex = 0; cIndex < cNEvents; cIndex++ )
+            cSLinkData[cIndex] = cEvents[cIndex]->GetSLinkEvent ( cBoard.get() ).getData64();
+    } );
+
+    CRCCalculator cCalculator;
+    uint64_t cNBytes = 0;
+
+    for ( auto& cWords : cSLinkData )
+        cNBytes += 8 * cWords.size();
+
+    pReport.measure ( "crc.compute", "event", cNEvents, pRepetitions, [&]()
+    {
+        for ( auto& cWords : cSLinkData )
+            cSink += cCalculator.compute ( reinterpret_cast<const uint8_t*> ( cWords.data() ), 8 * cWords.size() );
+    } );
+
+    LOG (DEBUG) << "SLink events of " << cNBytes / std::max<uint64_t> ( 1, cNEvents ) << " bytes, checksum " << cSink;
+}
+
+// one acquisition per FileHandler packet, written and read back
+void runFile ( BenchmarkReport& pReport, const std::vector<uint32_t>& pRaw, uint32_t pNEvents, uint32_t pRepetitions, const std::string& pFileName )
+{
+    FileHeader cHeader ( "CBC3", 0, 0, 0, 1, pRaw.size() / std::max ( 1u, pNEvents ) );
+    Timer t;
+    makeParentDirectory ( pFileName );
+    uint64_t cAllocationsBefore = getNAllocations();
+    t.start();
+
+    {
+        FileHandler cHandler ( pFileName, 'w', cHeader );
+
+        for ( uint32_t cRepetition = 0; cRepetition < pRepetitions; cRepetition++ )
+            cHandler.set ( pRaw );
+
+        cHandler.closeFile();
+    }
+
+    t.stop();
+    pReport.add ( "filehandler.write", "event", double ( pNEvents ) * pRepetitions, t.getElapsedTime(), getNAllocations() - cAllocationsBefore );
+
+    cAllocationsBefore = getNAllocations();
+    t.start();
+    FileHandler cReader ( pFileName, 'r' );
+    std::vector<uint32_t> cData = cReader.readFile();
+    cReader.closeFile();
+    t.stop();
+    pReport.add ( "filehandler.read", "event", double ( pNEvents ) * pRepetitions, t.getElapsedTime(), getNAllocations() - cAllocationsBefore );
+
+    if ( cData.size() != pRaw.size() * pRepetitions ) LOG (ERROR) << BOLDRED << "Read back " << cData.size() << " words instead of " << pRaw.size() * pRepetitions << RESET;
+
+    std::remove ( pFileName.c_str() );
+}
+
+// the I2C words of a full configuration of every Cbc
+void runEncode ( BenchmarkReport& pReport, BeBoardFWInterface* pFW, uint32_t pNFe, uint32_t pNCbc, uint32_t pRepetitions )
+{
+    std::unique_ptr<BeBoard> cBoard ( makeBoard ( pNFe, pNCbc, EventType::VR, ChipType::CBC3 ) );
+    std::vector<uint32_t> cVec;
+    uint64_t cNRegisters = 0;
+
+    for ( auto cFe : cBoard->fModuleVector )
+        for ( auto cCbc : cFe->fCbcVector )
+            cNRegisters += cCbc->getRegMap().size();
+
+    pReport.measure ( "cbcinterface.encodereg", "register", cNRegisters, pRepetitions, [&]()
+    {
+        cVec.clear();
+
+        for ( auto cFe : cBoard->fModuleVector )
+            for ( auto cCbc : cFe->fCbcVector )
+                for ( auto& cReg : cCbc->getRegMap() )
+                    pFW->EncodeReg ( cReg.second, cCbc->getFeId(), cCbc->getCbcId(), cVec, true, true );
+    } );
+}
+
+// configuration and noise scan of the emulated system of pHWFile
+void runPedeNoise ( BenchmarkReport& pReport, const std::string& pHWFile )
+{
+    gROOT->SetBatch ( true );
+
+    Tool cTool;
+    std::stringstream outp;
+    cTool.InitializeHw ( pHWFile, outp );
+    cTool.InitializeSettings ( pHWFile, outp );
+    LOG (DEBUG) << outp.str();
+    cTool.ConfigureHw();
+
+    std::vector<D19cEmulatorFWInterface*> cEmulators;
+    uint64_t cNCbc = 0;
+
+    for ( auto cBoard : cTool.fBoardVector )
+    {
+        D19cEmulatorFWInterface* cEmulator = dynamic_cast<D19cEmulatorFWInterface*> ( cTool.fBeBoardFWMap[cBoard->getBeBoardIdentifier()] );
+
+        if ( cEmulator == nullptr )
+        {
+            LOG (ERROR) << BOLDRED << "Board " << +cBoard->getBeId() << " of " << pHWFile << " is not emulated, the PedeNoise benchmark needs an emulator:// URI" << RESET;
+            cTool.Destroy();
+            return;
+        }
+
+        cEmulators.push_back ( cEmulator );
+
+        for ( auto cFe : cBoard->fModuleVector )
+            cNCbc += cFe->fCbcVector.size();
+    }
+
+    auto cNTriggers = [&]()
+    {
+        uint64_t cSum = 0;
+
+        for ( auto cEmulator : cEmulators )
+            cSum += cEmulator->getNTriggers();
+
+        return cSum;
+    };
+
+    pReport.measure ( "cbcinterface.configurecbc", "cbc", cNCbc, 1, [&]()
+    {
+        for ( auto cBoard : cTool.fBoardVector )
+            for ( auto cFe : cBoard->fModuleVector )
+                for ( auto cCbc : cFe->fCbcVector )
+                    cTool.fCbcInterface->ConfigureCbc ( cCbc );
+    } );
+
+    PedeNoise cPedeNoise;
+    cPedeNoise.Inherit ( &cTool );
+    cPedeNoise.Initialise ( false, true );
+
+    uint64_t cTriggersBefore = cNTriggers();
+    uint64_t cAllocationsBefore = getNAllocations();
+    Timer t;
+    t.start();
+    cPedeNoise.measureNoise();
+    t.stop();
+    pReport.add ( "pedenoise.measurenoise", "trigger", cNTriggers() - cTriggersBefore, t.getElapsedTime(), getNAllocations() - cAllocationsBefore );
+
+    cTool.Destroy();
+}
+
+int main ( int argc, char* argv[] )
+{
+    //configure the logger
+    el::Configurations conf ("settings/logger.conf");
+    el::Loggers::reconfigureAllLoggers (conf);
+
+    ArgvParser cmd;
+
+    // init
+    cmd.setIntroductoryDescription ( "CMS Ph2_ACF benchmark suite: decoding, hit access, SLink, CRC, file I/O, register encoding and a noise scan on an emulated board, with a JSON report for regression tracking" );
+    // error codes
+    cmd.addErrorCode ( 0, "Success" );
+    cmd.addErrorCode ( 1, "Error" );
+    // options
+    cmd.setHelpOption ( "h", "help", "Print this help page" );
+
+    cmd.defineOption ( "events", "Number of Events per acquisition. Default value: 1000", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "events", "e" );
+
+    cmd.defineOption ( "repetitions", "Number of acquisitions per benchmark. Default value: 20", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "repetitions", "n" );
+
+    cmd.defineOption ( "hybrids", "Number of hybrids in the generated events. Default value: 2", ArgvParser::OptionRequiresValue );
+
+    cmd.defineOption ( "cbcs", "Number of chips per hybrid in the generated events. Default value: 8", ArgvParser::OptionRequiresValue );
+
+    cmd.defineOption ( "raw", "Recorded D19C CBC3 VR raw file to use instead of generated events, with as many hybrids and CBCs as given above", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "raw", "r" );
+
+    cmd.defineOption ( "file", "Hw Description File of the emulated system for the configuration and PedeNoise benchmarks. Default value: settings/D19CEmulatorDescription.xml", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "file", "f" );
+
+    cmd.defineOption ( "json", "Write the results to this JSON file", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "json", "j" );
+
+    cmd.defineOption ( "micro", "Only run the micro-benchmarks, no emulated system", ArgvParser::NoOptionAttribute );
+    cmd.defineOptionAlternative ( "micro", "m" );
+
+    int result = cmd.parse ( argc, argv );
+
+    if ( result != ArgvParser::NoParserError )
+    {
+        LOG (INFO) << cmd.parseErrorDescription ( result );
+        exit ( 1 );
+    }
+
+    uint32_t cNEvents = ( cmd.foundOption ( "events" ) ) ? convertAnyInt ( cmd.optionValue ( "events" ).c_str() ) : 1000;
+    uint32_t cRepetitions = ( cmd.foundOption ( "repetitions" ) ) ? convertAnyInt ( cmd.optionValue ( "repetitions" ).c_str() ) : 20;
+    uint32_t cNFe = ( cmd.foundOption ( "hybrids" ) ) ? convertAnyInt ( cmd.optionValue ( "hybrids" ).c_str() ) : 2;
+    uint32_t cNCbc = ( cmd.foundOption ( "cbcs" ) ) ? convertAnyInt ( cmd.optionValue ( "cbcs" ).c_str() ) : 8;
+    std::string cHWFile = ( cmd.foundOption ( "file" ) ) ? cmd.optionValue ( "file" ) : "settings/D19CEmulatorDescription.xml";
+    bool cMicro = cmd.foundOption ( "micro" );
+
+    if ( cNFe < 1 || cNFe > 8 || cNCbc < 1 || cNCbc > 8 || cNEvents < 1 )
+    {
+        LOG (ERROR) << BOLDRED << "1 to 8 hybrids, 1 to 8 chips per hybrid and at least one event" << RESET;
+        exit ( 1 );
+    }
+
+    std::vector<uint32_t> cRaw;
+
+    if ( cmd.foundOption ( "raw" ) )
+    {
+        FileHandler cReader ( cmd.optionValue ( "raw" ), 'r' );
+        cRaw = cReader.readFile();
+        cReader.closeFile();
+        cNEvents = countD19cEvents ( cRaw );
+
+        if ( cNEvents == 0 )
+        {
+            LOG (ERROR) << BOLDRED << "No complete D19C event in " << cmd.optionValue ( "raw" ) << RESET;
+            exit ( 1 );
+        }
+
+        cRaw.resize ( cRaw.size() / cNEvents * cNEvents );
+    }
+    else cRaw = makeD19cData ( cNEvents, cNFe, cNCbc, CBC_EVENT_SIZE_32_CBC3, true );
+
+    std::stringstream cSetup;
+    cSetup << cNEvents << " events x " << cRepetitions << ", " << cNFe << " hybrids x " << cNCbc << " chips, " << ( cmd.foundOption ( "raw" ) ? cmd.optionValue ( "raw" ) : "generated" );
+    LOG (INFO) << BOLDBLUE << "Benchmarks: " << cSetup.str() << ", kernels: " << bitKernelsISA() << RESET;
+
+    BenchmarkReport cReport;
+    runDecode ( cReport, cRaw, cNEvents, cNFe, cNCbc, cRepetitions );
+    runEvent ( cReport, cRaw, cNEvents, cNFe, cNCbc, cRepetitions );
+    runFile ( cReport, cRaw, cNEvents, cRepetitions, "Results/benchsuite.raw" );
+
+    if ( !cMicro )
+    {
+        // the encoding only needs an interface with the D19C address table, no configured board
+        D19cEmulatorFWInterface cFW ( "benchmark", "emulator://benchmark", "file://settings/address_tables/d19c_address_table.xml" );
+        runEncode ( cReport, &cFW, cNFe, cNCbc, cRepetitions );
+        runPedeNoise ( cReport, cHWFile );
+    }
+
+    if ( cmd.foundOption ( "json" ) )
+    {
+        if ( !cReport.writeJson ( cmd.optionValue ( "json" ), cSetup.str() ) )
+        {
+            LOG (ERROR) << BOLDRED << "Could not write " << cmd.optionValue ( "json" ) << RESET;
+            return 1;
+        }
+
+        LOG (INFO) << "Results written to " << cmd.optionValue ( "json" );
+    }
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <cstdlib>
+#include <random>
+#include <iomanip>
+#include "../Utils/CRCCalculator.h"
+#include "../Utils/Utilities.h"
+#include "../Utils/Timer.h"
+#include "../Utils/argvparser.h"
+#include "../Utils/ConsoleColor.h"
+#include "../Utils/easylogging++.h"
+
+using namespace CommandLineProcessing;
+
+using namespace std;
+INITIALIZE_EASYLOGGINGPP
+
+// time pRepetitions CRCs of pNEvents buffers of pNWords 64 bit words with the table and the carry-less multiplication
+bool runCRC ( const CRCCalculator& pCalculator, uint32_t pNWords, uint32_t pNEvents, uint32_t pRepetitions )
+{
+    std::mt19937_64 cGenerator ( pNWords );
+    std::vector<uint64_t> cData ( uint64_t ( pNWords ) * pNEvents );
+
+    for ( auto& cWord : cData )
+        cWord = cGenerator();
+
+    std::vector<uint16_t> cTableCRC ( pNEvents );
+    std::vector<uint16_t> cCLMULCRC ( pNEvents );
+    Timer t;
+    t.start();
+
+    for ( uint32_t cRepetition = 0; cRepetition < pRepetitions; cRepetition++ )
+    {
+        for ( uint32_t cEvent = 0; cEvent < pNEvents; cEvent++ )
+        {
+            cTableCRC[cEvent] = 0xFFFF;
+            pCalculator.computeTable ( cTableCRC[cEvent], reinterpret_cast<const uint8_t*> ( &cData[cEvent * pNWords] ), 8 * pNWords );
+        }
+    }
+
+    t.stop();
+    double cTableTime = t.getElapsedTime() / ( double ( pRepetitions ) * pNEvents );
+    t.start();
+
+    for ( uint32_t cRepetition = 0; cRepetition < pRepetitions; cRepetition++ )
+    {
+        for ( uint32_t cEvent = 0; cEvent < pNEvents; cEvent++ )
+        {
+            cCLMULCRC[cEvent] = 0xFFFF;
+            pCalculator.computeCLMUL ( cCLMULCRC[cEvent], reinterpret_cast<const uint8_t*> ( &cData[cEvent * pNWords] ), 8 * pNWords );
+        }
+    }
+
+    t.stop();
+    double cCLMULTime = t.getElapsedTime() / ( double ( pRepetitions ) * pNEvents );
+
+    LOG (INFO) << std::setw ( 6 ) << pNWords << " words: table " << std::fixed << std::setprecision ( 1 ) << std::setw ( 9 ) << 1e9 * cTableTime << " ns "
+               << std::setw ( 6 ) << 8e-9 * pNWords / cTableTime << " GB/s, clmul " << std::setw ( 9 ) << 1e9 * cCLMULTime << " ns "
+               << std::setw ( 6 ) << 8e-9 * pNWords / cCLMULTime << " GB/s, speedup " << std::setprecision ( 2 ) << cTableTime / cCLMULTime;
+
+    if ( cTableCRC != cCLMULCRC )
+    {
+        LOG (ERROR) << BOLDRED << "The CRCs differ for events of " << pNWords << " words" << RESET;
+        return false;
+    }
+
+    return true;
+}
+
+int main ( int argc, char* argv[] )
+{
+    //configure the logger
+    el::Configurations conf ("settings/logger.conf");
+    el::Loggers::reconfigureAllLoggers (conf);
+
+    ArgvParser cmd;
+
+    // init
+    cmd.setIntroductoryDescription ( "CMS Ph2_ACF CRC benchmark: table driven and PCLMULQDQ CRC16 of the SLink events" );
+    // error codes
+    cmd.addErrorCode ( 0, "Success" );
+    cmd.addErrorCode ( 1, "Error" );
+    // options
+    cmd.setHelpOption ( "h", "help", "Print this help page" );
+
+    cmd.defineOption ( "events", "Number of events per size. Default value: 1000", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "events", "e" );
+
+    cmd.defineOption ( "repetitions", "Number of passes over the events. Default value: 100", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "repetitions", "n" );
+
+    int result = cmd.parse ( argc, argv );
+
+    if ( result != ArgvParser::NoParserError )
+    {
+        LOG (INFO) << cmd.parseErrorDescription ( result );
+        exit ( 1 );
+    }
+
+    uint32_t cNEvents = ( cmd.foundOption ( "events" ) ) ? convertAnyInt ( cmd.optionValue ( "events" ).c_str() ) : 1000;
+    uint32_t cRepetitions = ( cmd.foundOption ( "repetitions" ) ) ? convertAnyInt ( cmd.optionValue ( "repetitions" ).c_str() ) : 100;
+
+    CRCCalculator cCalculator;
+    LOG (INFO) << BOLDBLUE << "CRC16 of SLink events, PCLMULQDQ " << ( cCalculator.haveCLMUL() ? "available" : "not available, both columns use the table" ) << RESET;
+
+    // from a few words up to the events of a 2S module with 16 CBCs (about 80 words) and of a full board of 8 modules
+    bool cGood = true;
+
+    for ( uint32_t cNWords : {4, 8, 16, 32, 80, 160, 320, 640, 2048} )
+        cGood &= runCRC ( cCalculator, cNWords, cNEvents, cRepetitions );
+
+    return cGood ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+#include <cstring>
+#include <cstdlib>
+#include <iomanip>
+#include "../HWDescription/BeBoard.h"
+#include "../HWDescription/Module.h"
+#include "../Utils/Data.h"
+#include "../Utils/BitKernels.h"
+#include "../Utils/Utilities.h"
+#include "../Utils/Timer.h"
+#include "../Utils/argvparser.h"
+#include "../Utils/ConsoleColor.h"
+#include "BenchmarkFixtures.h"
+
+using namespace Ph2_HwDescription;
+using namespace Ph2_HwInterface;
+using namespace CommandLineProcessing;
+
+using namespace std;
+INITIALIZE_EASYLOGGINGPP
+
+// decode pRepetitions acquisitions, either with one Data object for all of them or with a new one each time
+void runDecode ( const BeBoard* pBoard, const std::vector<uint32_t>& pRaw, uint32_t pNEvents, uint32_t pRepetitions, bool pReuse, const std::string& pLabel )
+{
+    Data cReusedData;
+    uint64_t cNHits = 0;
+    uint64_t cAllocationsBefore = getNAllocations();
+    Timer t;
+    t.start();
+
+    for ( uint32_t cRepetition = 0; cRepetition < pRepetitions; cRepetition++ )
+    {
+        std::unique_ptr<Data> cNewData;
+
+        if ( !pReuse ) cNewData.reset ( new Data() );
+
+        Data& cData = pReuse ? cReusedData : *cNewData;
+        cData.privateSet ( pBoard, pRaw, pNEvents, BoardType::D19C );
+
+        for ( auto cEvent : cData.GetEvents ( pBoard ) )
+            cNHits += cEvent->GetNHits ( 0, 0 );
+    }
+
+    t.stop();
+    uint64_t cNAllocations = getNAllocations() - cAllocationsBefore;
+    double cNEvents = double ( pNEvents ) * pRepetitions;
+
+    LOG (INFO) << BOLDBLUE << pLabel << RESET;
+    LOG (INFO) << "    events/s        : " << std::fixed << std::setprecision (1) << cNEvents / t.getElapsedTime();
+    LOG (INFO) << "    us/event        : " << std::fixed << std::setprecision (3) << 1e6 * t.getElapsedTime() / cNEvents;
+    LOG (INFO) << "    allocations     : " << cNAllocations;
+    LOG (INFO) << "    allocations/evt : " << std::fixed << std::setprecision (3) << cNAllocations / cNEvents;
+
+    if ( pReuse )
+    {
+        const DataAllocStats& cStats = cReusedData.getAllocStats();
+        LOG (INFO) << "    events new/pool : " << cStats.fNEventsAllocated << " / " << cStats.fNEventsReused;
+        LOG (INFO) << "    buffers new/pool: " << cStats.fNBuffersAllocated << " / " << cStats.fNBuffersReused;
+    }
+
+    LOG (INFO) << "    (hits on FE0 CBC0: " << cNHits << ")";
+}
+
+// count the hits of one test group on all the CBCs, channel by channel with DataBit and with accumulateOccupancy
+void runOccupancy ( const BeBoard* pBoard, const std::vector<uint32_t>& pRaw, uint32_t pNEvents, uint32_t pNFe, uint32_t pNCbc, uint32_t pRepetitions )
+{
+    Data cData;
+    cData.privateSet ( pBoard, pRaw, pNEvents, BoardType::D19C );
+    const std::vector<Event*>& cEvents = cData.GetEvents ( pBoard );
+
+    // every 8th channel, like a test group
+    std::vector<uint8_t> cTestGroup;
+
+    for ( uint32_t cChannel = 0; cChannel < NCHANNELS; cChannel += 8 )
+        cTestGroup.push_back ( cChannel );
+
+    ChannelMask cMask = makeChannelMask ( cTestGroup );
+    std::vector<uint32_t> cCounts ( NCHANNELS, 0 );
+    uint64_t cNHitsDataBit = 0;
+    uint64_t cNHitsBulk = 0;
+
+    Timer t;
+    t.start();
+
+    for ( uint32_t cRepetition = 0; cRepetition < pRepetitions; cRepetition++ )
+    {
+        for ( auto cEvent : cEvents )
+            for ( uint32_t cFe = 0; cFe < pNFe; cFe++ )
+                for ( uint32_t cCbc = 0; cCbc < pNCbc; cCbc++ )
+                    for ( auto cChannel : cTestGroup )
+                        cNHitsDataBit += cEvent->DataBit ( cFe, cCbc, cChannel );
+    }
+
+    t.stop();
+    double cDataBitTime = t.getElapsedTime() / pRepetitions;
+    t.start();
+
+    for ( uint32_t cRepetition = 0; cRepetition < pRepetitions; cRepetition++ )
+    {
+        for ( uint32_t cFe = 0; cFe < pNFe; cFe++ )
+            for ( uint32_t cCbc = 0; cCbc < pNCbc; cCbc++ )
+                cNHitsBulk += Event::accumulateOccupancy ( cEvents, cFe, cCbc, cCounts.data(), cMask );
+    }
+
+    t.stop();
+    double cBulkTime = t.getElapsedTime() / pRepetitions;
+
+    LOG (INFO) << BOLDBLUE << "Occupancy of one test group, " << pNEvents << " events, kernels: " << bitKernelsISA() << RESET;
+    LOG (INFO) << "    DataBit loop        : " << std::fixed << std::setprecision (1) << 1e6 * cDataBitTime << " us/point, " << 1e6 * cDataBitTime / ( pNFe * pNCbc ) << " us/CBC";
+    LOG (INFO) << "    accumulateOccupancy : " << std::fixed << std::setprecision (1) << 1e6 * cBulkTime << " us/point, " << 1e6 * cBulkTime / ( pNFe * pNCbc ) << " us/CBC";
+    LOG (INFO) << "    (hits: " << cNHitsDataBit << " / " << cNHitsBulk << ")";
+}
+
+int main ( int argc, char* argv[] )
+{
+    //configure the logger
+    el::Configurations conf ("settings/logger.conf");
+    el::Loggers::reconfigureAllLoggers (conf);
+
+    ArgvParser cmd;
+
+    // init
+    cmd.setIntroductoryDescription ( "CMS Ph2_ACF decoding benchmark: allocations and throughput of Data::Set and occupancy counting on generated D19C CBC3 events" );
+    // error codes
+    cmd.addErrorCode ( 0, "Success" );
+    cmd.addErrorCode ( 1, "Error" );
+    // options
+    cmd.setHelpOption ( "h", "help", "Print this help page" );
+
+    cmd.defineOption ( "events", "Number of Events per acquisition. Default value: 1000", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "events", "e" );
+
+    cmd.defineOption ( "repetitions", "Number of acquisitions per mode. Default value: 200", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "repetitions", "n" );
+
+    cmd.defineOption ( "hybrids", "Number of hybrids in the events. Default value: 2", ArgvParser::OptionRequiresValue );
+
+    cmd.defineOption ( "cbcs", "Number of CBCs per hybrid. Default value: 8", ArgvParser::OptionRequiresValue );
+
+    int result = cmd.parse ( argc, argv );
+
+    if ( result != ArgvParser::NoParserError )
+    {
+        LOG (INFO) << cmd.parseErrorDescription ( result );
+        exit ( 1 );
+    }
+
+    uint32_t cNEvents = ( cmd.foundOption ( "events" ) ) ? convertAnyInt ( cmd.optionValue ( "events" ).c_str() ) : 1000;
+    uint32_t cRepetitions = ( cmd.foundOption ( "repetitions" ) ) ? convertAnyInt ( cmd.optionValue ( "repetitions" ).c_str() ) : 200;
+    uint32_t cNFe = ( cmd.foundOption ( "hybrids" ) ) ? convertAnyInt ( cmd.optionValue ( "hybrids" ).c_str() ) : 2;
+    uint32_t cNCbc = ( cmd.foundOption ( "cbcs" ) ) ? convertAnyInt ( cmd.optionValue ( "cbcs" ).c_str() ) : 8;
+
+    if ( cNFe < 1 || cNFe > 8 || cNCbc < 1 || cNCbc > 8 )
+    {
+        LOG (ERROR) << BOLDRED << "1 to 8 hybrids and 1 to 8 CBCs per hybrid" << RESET;
+        exit ( 1 );
+    }
+
+    std::unique_ptr<BeBoard> cBoard ( makeBoard ( cNFe, cNCbc ) );
+
+    std::vector<uint32_t> cRaw = makeD19cData ( cNEvents, cNFe, cNCbc );
+    LOG (INFO) << "Decoding " << cRepetitions << " x " << cNEvents << " events of " << cRaw.size() / cNEvents << " words";
+
+    runDecode ( cBoard.get(), cRaw, cNEvents, cRepetitions, false, "New Data object per acquisition" );
+    runDecode ( cBoard.get(), cRaw, cNEvents, cRepetitions, true, "Data object reused across acquisitions" );
+    runOccupancy ( cBoard.get(), cRaw, cNEvents, cNFe, cNCbc, 10 );
+
+    return 0;
+}
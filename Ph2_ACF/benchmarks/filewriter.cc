@@ -0,0 +1,109 @@
+#include <cstdlib>
+#include <iomanip>
+#include "../Utils/FileHandler.h"
+#include "../Utils/Utilities.h"
+#include "../Utils/Timer.h"
+#include "../Utils/argvparser.h"
+#include "../Utils/ConsoleColor.h"
+#include "BenchmarkFixtures.h"
+
+using namespace CommandLineProcessing;
+
+using namespace std;
+INITIALIZE_EASYLOGGINGPP
+
+// write pNPackets packets of pPacketSize words through a FileHandler and read the file back to check it
+bool runWriter ( const std::string& pFileName, uint32_t pNPackets, uint32_t pPacketSize, const FileWriterOptions& pOptions, const std::string& pLabel )
+{
+    FileHeader cHeader ( "CBC3", 0, 0, 0, 1, pPacketSize );
+    FileWriterStats cStats;
+    Timer t;
+    makeParentDirectory ( pFileName );
+    t.start();
+
+    {
+        FileHandler cHandler ( pFileName, 'w', cHeader, pOptions );
+
+        for ( uint32_t cPacket = 0; cPacket < pNPackets; cPacket++ )
+        {
+            std::vector<uint32_t> cData ( pPacketSize, cPacket );
+            cHandler.set ( std::move ( cData ) );
+        }
+
+        cHandler.closeFile();
+        cStats = cHandler.getWriterStats();
+    }
+
+    t.stop();
+
+    // read back: header, then the packets in order
+    FileHandler cReader ( pFileName, 'r' );
+    std::vector<uint32_t> cData = cReader.readFileChunks ( pNPackets * pPacketSize );
+    bool cGood = cData.size() == pNPackets * pPacketSize;
+
+    for ( uint32_t i = 0; cGood && i < cData.size(); i++ )
+        cGood = cData[i] == i / pPacketSize;
+
+    cReader.closeFile();
+    std::remove ( pFileName.c_str() );
+
+    LOG (INFO) << BOLDBLUE << pLabel << RESET;
+    LOG (INFO) << "    MB/s (set to close) : " << std::fixed << std::setprecision (1) << cStats.fBytesWritten / t.getElapsedTime() / 1e6;
+    LOG (INFO) << "    MB/s (writer)       : " << std::fixed << std::setprecision (1) << cStats.bytesPerSecond() / 1e6;
+    LOG (INFO) << "    packets / writes    : " << cStats.fNPackets << " / " << cStats.fNWrites;
+    LOG (INFO) << "    queue high water    : " << cStats.fQueueHighWater << ", full waits: " << cStats.fNFullWaits;
+    LOG (INFO) << "    read back           : " << ( cGood ? BOLDGREEN "OK" : BOLDRED "MISMATCH" ) << RESET;
+    return cGood;
+}
+
+int main ( int argc, char* argv[] )
+{
+    //configure the logger
+    el::Configurations conf ("settings/logger.conf");
+    el::Loggers::reconfigureAllLoggers (conf);
+
+    ArgvParser cmd;
+
+    // init
+    cmd.setIntroductoryDescription ( "CMS Ph2_ACF file writing benchmark: throughput of FileHandler in write mode" );
+    // error codes
+    cmd.addErrorCode ( 0, "Success" );
+    cmd.addErrorCode ( 1, "Error" );
+    // options
+    cmd.setHelpOption ( "h", "help", "Print this help page" );
+
+    cmd.defineOption ( "file", "Output file. Default value: Results/filewriter.raw", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "file", "f" );
+
+    cmd.defineOption ( "packets", "Number of packets. Default value: 20000", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "packets", "n" );
+
+    cmd.defineOption ( "size", "Packet size in 32 bit words. Default value: 2000", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "size", "s" );
+
+    cmd.defineOption ( "buffer", "Writer buffer size in MB. Default value: 4", ArgvParser::OptionRequiresValue );
+
+    int result = cmd.parse ( argc, argv );
+
+    if ( result != ArgvParser::NoParserError )
+    {
+        LOG (INFO) << cmd.parseErrorDescription ( result );
+        exit ( 1 );
+    }
+
+    std::string cFileName = ( cmd.foundOption ( "file" ) ) ? cmd.optionValue ( "file" ) : "Results/filewriter.raw";
+    uint32_t cNPackets = ( cmd.foundOption ( "packets" ) ) ? convertAnyInt ( cmd.optionValue ( "packets" ).c_str() ) : 20000;
+    uint32_t cPacketSize = ( cmd.foundOption ( "size" ) ) ? convertAnyInt ( cmd.optionValue ( "size" ).c_str() ) : 2000;
+    uint32_t cBufferSize = ( cmd.foundOption ( "buffer" ) ) ? convertAnyInt ( cmd.optionValue ( "buffer" ).c_str() ) : 4;
+
+    LOG (INFO) << "Writing " << cNPackets << " packets of " << cPacketSize << " words to " << cFileName;
+
+    FileWriterOptions cOptions;
+    cOptions.fBufferSize = size_t ( cBufferSize ) << 20;
+    bool cGood = runWriter ( cFileName, cNPackets, cPacketSize, cOptions, "Buffered" );
+
+    cOptions.fDirectIO = true;
+    cGood &= runWriter ( cFileName, cNPackets, cPacketSize, cOptions, "O_DIRECT" );
+
+    return cGood ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include <cstring>
+#include <iomanip>
+#include "../HWInterface/BeBoardInterface.h"
+#include "../HWInterface/D19cFWInterface.h"
+#include "../Utils/Utilities.h"
+#include "../Utils/Timer.h"
+#include "../Utils/argvparser.h"
+#include "../Utils/ConsoleColor.h"
+#include "../System/SystemController.h"
+
+using namespace Ph2_HwDescription;
+using namespace Ph2_HwInterface;
+using namespace Ph2_System;
+using namespace CommandLineProcessing;
+
+using namespace std;
+INITIALIZE_EASYLOGGINGPP
+
+// run pRepetitions x ReadNEvents of pNEvents and report the rates
+void runReadNEvents ( SystemController& pSystemController, BeBoard* pBoard, uint32_t pNEvents, uint32_t pRepetitions, const std::string& pLabel )
+{
+    pSystemController.fBeBoardInterface->resetReadoutTiming ( pBoard );
+    Timer t;
+    t.start();
+
+    for ( uint32_t cRepetition = 0; cRepetition < pRepetitions; cRepetition++ )
+    {
+        std::vector<uint32_t> cData;
+        pSystemController.fBeBoardInterface->ReadNEvents ( pBoard, pNEvents, cData );
+    }
+
+    t.stop();
+    const ReadoutTiming& cTiming = pSystemController.fBeBoardInterface->getReadoutTiming ( pBoard );
+    double cNEvents = double ( pNEvents ) * pRepetitions;
+
+    LOG (INFO) << BOLDBLUE << pLabel << RESET;
+    LOG (INFO) << "    events/s       : " << std::fixed << std::setprecision (1) << cNEvents / t.getElapsedTime();
+    LOG (INFO) << "    us/event       : " << std::fixed << std::setprecision (2) << 1e6 * t.getElapsedTime() / cNEvents;
+    LOG (INFO) << "    transfers/event: " << std::fixed << std::setprecision (3) << cTiming.fNTransfers / cNEvents;
+    LOG (INFO) << "    wait time      : " << std::fixed << std::setprecision (3) << cTiming.fWaitTime << " s in " << cTiming.fNPolls << " polls";
+    LOG (INFO) << "    transfer time  : " << std::fixed << std::setprecision (3) << cTiming.fTransferTime << " s for " << cTiming.fNWords << " words";
+}
+
+int main ( int argc, char* argv[] )
+{
+    //configure the logger
+    el::Configurations conf ("settings/logger.conf");
+    el::Loggers::reconfigureAllLoggers (conf);
+
+    SystemController cSystemController;
+    ArgvParser cmd;
+
+    // init
+    cmd.setIntroductoryDescription ( "CMS Ph2_ACF ReadNEvents benchmark: per event vs bulk readout on a D19C board" );
+    // error codes
+    cmd.addErrorCode ( 0, "Success" );
+    cmd.addErrorCode ( 1, "Error" );
+    // options
+    cmd.setHelpOption ( "h", "help", "Print this help page" );
+
+    cmd.defineOption ( "file", "Hw Description File . Default value: settings/D19CDescription.xml", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "file", "f" );
+
+    cmd.defineOption ( "events", "Number of Events per ReadNEvents call. Default value: 1000", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "events", "e" );
+
+    cmd.defineOption ( "repetitions", "Number of ReadNEvents calls per mode. Default value: 20", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "repetitions", "n" );
+
+    int result = cmd.parse ( argc, argv );
+
+    if ( result != ArgvParser::NoParserError )
+    {
+        LOG (INFO) << cmd.parseErrorDescription ( result );
+        exit ( 1 );
+    }
+
+    std::string cHWFile = ( cmd.foundOption ( "file" ) ) ? cmd.optionValue ( "file" ) : "settings/D19CDescription.xml";
+    uint32_t cNEvents = ( cmd.foundOption ( "events" ) ) ? convertAnyInt ( cmd.optionValue ( "events" ).c_str() ) : 1000;
+    uint32_t cRepetitions = ( cmd.foundOption ( "repetitions" ) ) ? convertAnyInt ( cmd.optionValue ( "repetitions" ).c_str() ) : 20;
+
+    std::stringstream outp;
+    cSystemController.InitializeHw ( cHWFile, outp );
+    cSystemController.InitializeSettings ( cHWFile, outp );
+    LOG (INFO) << outp.str();
+    cSystemController.ConfigureHw ();
+
+    BeBoard* pBoard = cSystemController.fBoardVector.at ( 0 );
+    D19cFWInterface* cFWInterface = dynamic_cast<D19cFWInterface*> ( cSystemController.fBeBoardFWMap[pBoard->getBeBoardIdentifier()] );
+
+    if ( cFWInterface == nullptr )
+    {
+        LOG (ERROR) << BOLDRED << "The first board is not a D19C board, aborting" << RESET;
+        exit ( 1 );
+    }
+
+    cFWInterface->setBulkReadout ( false );
+    runReadNEvents ( cSystemController, pBoard, cNEvents, cRepetitions, "Per event readout" );
+
+    cFWInterface->setBulkReadout ( true );
+    runReadNEvents ( cSystemController, pBoard, cNEvents, cRepetitions, "Bulk readout" );
+
+    cSystemController.Destroy();
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <cstring>
+#include <chrono>
+#include <iomanip>
+#include "../HWInterface/RegManager.h"
+#include "../Utils/Utilities.h"
+#include "../Utils/argvparser.h"
+#include "../Utils/ConsoleColor.h"
+#include "../Utils/easylogging++.h"
+
+using namespace Ph2_HwInterface;
+using namespace CommandLineProcessing;
+
+using namespace std;
+INITIALIZE_EASYLOGGINGPP
+
+// exposes the raw uHAL lookup that RegManager::resolve() caches
+class BenchRegManager : public RegManager
+{
+  public:
+    BenchRegManager ( const char* pId, const char* pUri, const char* pAddressTable ) :
+        RegManager ( pId, pUri, pAddressTable )
+    {}
+
+    RegHandle lookup ( const std::string& pRegNode )
+    {
+        return &fBoard->getNode ( pRegNode );
+    }
+};
+
+// time pIterations calls of pAccess and return the mean time per call in ns
+template<typename T>
+double measure ( uint32_t pIterations, T pAccess )
+{
+    auto cStart = std::chrono::steady_clock::now();
+
+    for ( uint32_t cIteration = 0; cIteration < pIterations; cIteration++ )
+        pAccess();
+
+    auto cStop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano> ( cStop - cStart ).count() / pIterations;
+}
+
+int main ( int argc, char* argv[] )
+{
+    //configure the logger
+    el::Configurations conf ("settings/logger.conf");
+    el::Loggers::reconfigureAllLoggers (conf);
+
+    ArgvParser cmd;
+
+    // init
+    cmd.setIntroductoryDescription ( "CMS Ph2_ACF register access benchmark: string path vs pre-resolved handle, to be run against a uHAL dummy hardware (e.g. DummyHardwareUdp.exe -p 50001 -v 2)" );
+    // error codes
+    cmd.addErrorCode ( 0, "Success" );
+    cmd.addErrorCode ( 1, "Error" );
+    // options
+    cmd.setHelpOption ( "h", "help", "Print this help page" );
+
+    cmd.defineOption ( "uri", "uHAL URI of the (dummy) board. Default value: ipbusudp-2.0://127.0.0.1:50001", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "uri", "u" );
+
+    cmd.defineOption ( "table", "Address table. Default value: file://settings/address_tables/d19c_address_table.xml", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "table", "t" );
+
+    cmd.defineOption ( "reg", "Register to access. Default value: fc7_daq_stat.readout_block.general.words_cnt", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "reg", "r" );
+
+    cmd.defineOption ( "iterations", "Number of accesses per measurement. Default value: 10000", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "iterations", "n" );
+
+    int result = cmd.parse ( argc, argv );
+
+    if ( result != ArgvParser::NoParserError )
+    {
+        LOG (INFO) << cmd.parseErrorDescription ( result );
+        exit ( 1 );
+    }
+
+    std::string cUri = ( cmd.foundOption ( "uri" ) ) ? cmd.optionValue ( "uri" ) : "ipbusudp-2.0://127.0.0.1:50001";
+    std::string cTable = ( cmd.foundOption ( "table" ) ) ? cmd.optionValue ( "table" ) : "file://settings/address_tables/d19c_address_table.xml";
+    std::string cReg = ( cmd.foundOption ( "reg" ) ) ? cmd.optionValue ( "reg" ) : "fc7_daq_stat.readout_block.general.words_cnt";
+    uint32_t cIterations = ( cmd.foundOption ( "iterations" ) ) ? convertAnyInt ( cmd.optionValue ( "iterations" ).c_str() ) : 10000;
+
+    BenchRegManager cRegManager ( "board", cUri.c_str(), cTable.c_str() );
+    RegHandle cHandle = cRegManager.resolve ( cReg );
+    volatile uint32_t cSink = 0;
+
+    // node lookup only, no IPbus traffic
+    double cLookupString = measure ( cIterations, [&] () { cSink = cRegManager.lookup ( cReg )->getAddress(); } );
+    double cLookupCached = measure ( cIterations, [&] () { cSink = cRegManager.resolve ( cReg )->getAddress(); } );
+
+    // full register access including the dispatch to the board
+    double cReadString = measure ( cIterations, [&] () { cSink = cRegManager.ReadReg ( cReg ); } );
+    double cReadHandle = measure ( cIterations, [&] () { cSink = cRegManager.ReadReg ( cHandle ); } );
+
+    // three reads of the register, one dispatch each vs a single transaction
+    double cReadSerial = measure ( cIterations, [&] ()
+    {
+        for ( int cRead = 0; cRead < 3; cRead++ )
+            cSink = cRegManager.ReadReg ( cHandle );
+    } );
+    double cReadTransaction = measure ( cIterations, [&] ()
+    {
+        RegTransaction cTransaction ( &cRegManager );
+        uhal::ValWord<uint32_t> cFirst = cTransaction.ReadReg ( cHandle );
+        uhal::ValWord<uint32_t> cSecond = cTransaction.ReadReg ( cHandle );
+        uhal::ValWord<uint32_t> cThird = cTransaction.ReadReg ( cHandle );
+        cTransaction.Dispatch();
+        cSink = cFirst.value() + cSecond.value() + cThird.value();
+    } );
+
+    LOG (INFO) << BOLDBLUE << "Register " << cReg << " on " << cUri << ", " << cIterations << " iterations" << RESET;
+    LOG (INFO) << "Lookup getNode (string)  : " << std::fixed << std::setprecision (1) << cLookupString << " ns";
+    LOG (INFO) << "Lookup resolve (cached)  : " << std::fixed << std::setprecision (1) << cLookupCached << " ns";
+    LOG (INFO) << "ReadReg (string)         : " << std::fixed << std::setprecision (1) << cReadString << " ns";
+    LOG (INFO) << "ReadReg (handle)         : " << std::fixed << std::setprecision (1) << cReadHandle << " ns";
+    LOG (INFO) << "3 x ReadReg (handle)     : " << std::fixed << std::setprecision (1) << cReadSerial << " ns";
+    LOG (INFO) << "3 x ReadReg (transaction): " << std::fixed << std::setprecision (1) << cReadTransaction << " ns";
+    LOG (INFO) << BOLDGREEN << "Speed-up of the handle access: " << std::setprecision (2) << cReadString / cReadHandle << RESET;
+    LOG (INFO) << BOLDGREEN << "Speed-up of the transaction: " << std::setprecision (2) << cReadSerial / cReadTransaction << RESET;
+
+    return 0;
+}
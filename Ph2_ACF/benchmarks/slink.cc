@@ -0,0 +1,138 @@
+#include <cstdlib>
+#include <iomanip>
+#include "../HWDescription/BeBoard.h"
+#include "../HWDescription/Module.h"
+#include "../HWDescription/Cbc.h"
+#include "../Utils/Data.h"
+#include "../Utils/SLinkEncoder.h"
+#include "../Utils/BitKernels.h"
+#include "../Utils/Utilities.h"
+#include "../Utils/Timer.h"
+#include "../Utils/argvparser.h"
+#include "../Utils/ConsoleColor.h"
+#include "BenchmarkFixtures.h"
+
+using namespace Ph2_HwDescription;
+using namespace Ph2_HwInterface;
+using namespace CommandLineProcessing;
+
+using namespace std;
+INITIALIZE_EASYLOGGINGPP
+
+int main ( int argc, char* argv[] )
+{
+    //configure the logger
+    el::Configurations conf ("settings/logger.conf");
+    el::Loggers::reconfigureAllLoggers (conf);
+
+    ArgvParser cmd;
+
+    // init
+    cmd.setIntroductoryDescription ( "CMS Ph2_ACF SLink benchmark: encoding of generated D19C CBC3 events event by event and as a whole acquisition" );
+    // error codes
+    cmd.addErrorCode ( 0, "Success" );
+    cmd.addErrorCode ( 1, "Error" );
+    // options
+    cmd.setHelpOption ( "h", "help", "Print this help page" );
+
+    cmd.defineOption ( "events", "Number of Events per acquisition. Default value: 1000", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "events", "e" );
+
+    cmd.defineOption ( "repetitions", "Number of acquisitions per mode. Default value: 20", ArgvParser::OptionRequiresValue );
+    cmd.defineOptionAlternative ( "repetitions", "n" );
+
+    cmd.defineOption ( "hybrids", "Number of hybrids in the events. Default value: 2", ArgvParser::OptionRequiresValue );
+
+    cmd.defineOption ( "cbcs", "Number of CBCs per hybrid. Default value: 8", ArgvParser::OptionRequiresValue );
+
+    cmd.defineOption ( "threads", "Number of threads for the batched encoding, 0 for one per core. Default value: 0", ArgvParser::OptionRequiresValue );
+
+    int result = cmd.parse ( argc, argv );
+
+    if ( result != ArgvParser::NoParserError )
+    {
+        LOG (INFO) << cmd.parseErrorDescription ( result );
+        exit ( 1 );
+    }
+
+    uint32_t cNEvents = ( cmd.foundOption ( "events" ) ) ? convertAnyInt ( cmd.optionValue ( "events" ).c_str() ) : 1000;
+    uint32_t cRepetitions = ( cmd.foundOption ( "repetitions" ) ) ? convertAnyInt ( cmd.optionValue ( "repetitions" ).c_str() ) : 20;
+    uint32_t cNFe = ( cmd.foundOption ( "hybrids" ) ) ? convertAnyInt ( cmd.optionValue ( "hybrids" ).c_str() ) : 2;
+    uint32_t cNCbc = ( cmd.foundOption ( "cbcs" ) ) ? convertAnyInt ( cmd.optionValue ( "cbcs" ).c_str() ) : 8;
+    uint32_t cNThreads = ( cmd.foundOption ( "threads" ) ) ? convertAnyInt ( cmd.optionValue ( "threads" ).c_str() ) : 0;
+
+    if ( cNFe < 1 || cNFe > 8 || cNCbc < 1 || cNCbc > 8 )
+    {
+        LOG (ERROR) << BOLDRED << "1 to 8 hybrids and 1 to 8 CBCs per hybrid" << RESET;
+        exit ( 1 );
+    }
+
+    std::unique_ptr<BeBoard> cBoard ( makeBoard ( cNFe, cNCbc ) );
+
+    std::vector<uint32_t> cRaw = makeD19cData ( cNEvents, cNFe, cNCbc );
+    Data cData;
+    cData.privateSet ( cBoard.get(), cRaw, cNEvents, BoardType::D19C );
+    const std::vector<Event*>& cEvents = cData.GetEvents ( cBoard.get() );
+
+    LOG (INFO) << "Encoding " << cRepetitions << " x " << cNEvents << " events of " << cNFe << " x " << cNCbc << " CBCs, kernels: " << bitKernelsISA();
+
+    // event by event through SLinkEvent objects, with an encoder and a copy per event
+    std::vector<uint32_t> cEventByEvent;
+    Timer t;
+    t.start();
+
+    for ( uint32_t cRepetition = 0; cRepetition < cRepetitions; cRepetition++ )
+    {
+        cEventByEvent.clear();
+
+        for ( auto cEvent : cEvents )
+        {
+            SLinkEvent cSLinkEvent = cEvent->GetSLinkEvent ( cBoard.get() );
+            std::vector<uint32_t> cWords = cSLinkEvent.getData<uint32_t>();
+            cEventByEvent.insert ( cEventByEvent.end(), cWords.begin(), cWords.end() );
+        }
+    }
+
+    t.stop();
+    double cEventByEventTime = t.getElapsedTime() / cRepetitions;
+
+    SLinkEncoder cEncoder ( cBoard.get() );
+    std::vector<uint32_t> cSingle;
+    std::vector<uint32_t> cBatched;
+
+    t.start();
+
+    for ( uint32_t cRepetition = 0; cRepetition < cRepetitions; cRepetition++ )
+    {
+        cSingle.clear();
+        cEncoder.encode ( cEvents, cSingle, 1 );
+    }
+
+    t.stop();
+    double cSingleTime = t.getElapsedTime() / cRepetitions;
+
+    t.start();
+
+    for ( uint32_t cRepetition = 0; cRepetition < cRepetitions; cRepetition++ )
+    {
+        cBatched.clear();
+        cEncoder.encode ( cEvents, cBatched, cNThreads );
+    }
+
+    t.stop();
+    double cBatchedTime = t.getElapsedTime() / cRepetitions;
+    double cMWords = cBatched.size() / 1e6;
+
+    LOG (INFO) << BOLDBLUE << "SLink encoding, " << cBatched.size() / cNEvents << " words/event" << RESET;
+    LOG (INFO) << "    GetSLinkEvent per event : " << std::fixed << std::setprecision (3) << 1e6 * cEventByEventTime / cNEvents << " us/event, " << cMWords / cEventByEventTime << " Mwords/s";
+    LOG (INFO) << "    SLinkEncoder, 1 thread  : " << std::fixed << std::setprecision (3) << 1e6 * cSingleTime / cNEvents << " us/event, " << cMWords / cSingleTime << " Mwords/s";
+    LOG (INFO) << "    SLinkEncoder, batched   : " << std::fixed << std::setprecision (3) << 1e6 * cBatchedTime / cNEvents << " us/event, " << cMWords / cBatchedTime << " Mwords/s";
+
+    if ( cEventByEvent != cSingle || cSingle != cBatched )
+    {
+        LOG (ERROR) << BOLDRED << "The encoded acquisitions differ" << RESET;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+# Include directories, libraries and defines of the optional external dependencies found by the top level CMakeLists.txt.
+# The defines change the layout of some classes (e.g. fHttpServer in Tool), so every directory building against
+# Ph2_Tools has to include this file to get the same ones. Appends to LIBS and CMAKE_CXX_FLAGS of the including directory.
+
+#check for ZMQ installed
+if(ZMQ_FOUND)
+    #here, now check for UsbInstLib
+    if(PH2_USBINSTLIB_FOUND)
+
+        #add include directoreis for ZMQ and USBINSTLIB
+        include_directories(${PH2_USBINSTLIB_INCLUDE_DIRS})
+        link_directories(${PH2_USBINSTLIB_LIBRARY_DIRS})
+        include_directories(${ZMQ_INCLUDE_DIRS})
+
+        #and link against the libs
+        set(LIBS ${LIBS} ${ZMQ_LIBRARIES} ${PH2_USBINSTLIB_LIBRARIES})
+        set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -D__ZMQ__ -D__USBINST__")
+    endif()
+endif()
+
+#check for AMC13 libraries
+if(${CACTUS_AMC13_FOUND})
+    include_directories(${PROJECT_SOURCE_DIR}/AMC13)
+    include_directories(${UHAL_AMC13_INCLUDE_PREFIX})
+    link_directories(${UHAL_AMC13_LIB_PREFIX})
+    set(LIBS ${LIBS} cactus_amc13_amc13 Ph2_Amc13)
+    set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -D__AMC13__")
+endif()
+
+#check for AntennaDriver
+if(${PH2_ANTENNA_FOUND})
+    include_directories(${PH2_ANTENNA_INCLUDE_DIRS})
+    link_directories(${PH2_ANTENNA_LIBRARY_DIRS})
+    set(LIBS ${LIBS} usb ${PH2_ANTENNA_LIBRARIES})
+    set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -D__ANTENNA__")
+endif()
+
+#last but not least, find root and link against it
+if(${ROOT_FOUND})
+    include_directories(${ROOT_INCLUDE_DIRS})
+    set(LIBS ${LIBS} ${ROOT_LIBRARIES})
+
+    #check for THttpServer
+    if(${ROOT_HAS_HTTP})
+        set(LIBS ${LIBS} ${ROOT_RHTTP_LIBRARY})
+        set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -D__HTTP__")
+    endif()
+endif()
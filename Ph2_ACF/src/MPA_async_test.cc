@@ -73,16 +73,18 @@ int main( int argc, char* argv[] )
 	fMPAInterface->Set_calibration(mpa1,50);
 
 	uint32_t npixtot = 0;
+	std::vector<std::pair<uint32_t, uint32_t>> pixels;
 	for(int row=rows.first; row<rows.second; row++)
 		{
 		for(int col=cols.first; col<cols.second; col++)
 			{
-				fMPAInterface->Enable_pix_counter(mpa1,row, col);
+				pixels.push_back({uint32_t(row), uint32_t(col)});
 				title = std::to_string(row)+","+std::to_string(col);
  				scurves.push_back(new TH1F(title.c_str(),title.c_str(),255,-0.5,254.5));
 				npixtot+=1;
 			}
 		}
+	fMPAInterface->Enable_pix_counter(mpa1, pixels);
 	std::cout <<"Numpix -- "<< npixtot <<std::endl;
 	uint32_t cdata = 0;
 	uint16_t counters[2040] = {0};
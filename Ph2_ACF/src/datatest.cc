@@ -14,6 +14,7 @@
 #include "../System/SystemController.h"
 #include "../Utils/CommonVisitors.h"
 #include "../Utils/SLinkEvent.h"
+#include "../Utils/SLinkEncoder.h"
 
 
 using namespace Ph2_HwDescription;
@@ -66,6 +67,11 @@ int main ( int argc, char* argv[] )
     cmd.defineOption ( "read", "Read the data from a raw file instead of the board.  ", ArgvParser::OptionRequiresValue );
     cmd.defineOptionAlternative ( "read", "r" );
 
+    cmd.defineOption ( "index", "With --read, keep the event index of the raw file in <file>.idx so that it opens faster the next time.  " );
+
+    cmd.defineOption ( "pipeline", "Read all the boards asynchronously and decode on a pool of threads (ReadoutPipeline), the events are taken from the decoded batches.  " );
+    cmd.defineOptionAlternative ( "pipeline", "p" );
+
     // cmd.defineOption( "option", "Define file access mode: w : write , a : append, w+ : write/update", ArgvParser::OptionRequiresValue );
     // cmd.defineOptionAlternative( "option", "o" );
 
@@ -80,6 +86,7 @@ int main ( int argc, char* argv[] )
 
     bool cSaveToFile = false;
     bool cReadFromFile = false;
+    bool cPipeline = cmd.foundOption ( "pipeline" ) && !cmd.foundOption ( "read" );
     std::string cOutputFile;
     std::string cInputFile;
 
@@ -104,7 +111,7 @@ int main ( int argc, char* argv[] )
     else if (cReadFromFile)
     {
         cInputFile = cmd.optionValue ("read");
-        cSystemController.addFileHandler ( cInputFile, 'r' );
+        cSystemController.addFileHandler ( cInputFile, 'r', cmd.foundOption ( "index" ) );
         LOG (INFO) << "Reading Binary Rawdata file from:   " << cInputFile ;
     }
 
@@ -156,8 +163,12 @@ int main ( int argc, char* argv[] )
     Counter cCbcCounter;
     pBoard->accept ( cCbcCounter );
     Data data;
+    // decoded batch of the pipeline, holds the events of the current acquisition
+    EventBatch cBatch;
 
-    if (!cmd.foundOption ( "read") )
+    if ( cPipeline )
+        cSystemController.StartPipeline();
+    else if (!cmd.foundOption ( "read") )
         cSystemController.fBeBoardInterface->Start ( pBoard );
     else
     {
@@ -182,14 +193,26 @@ int main ( int argc, char* argv[] )
         if (cmd.foundOption ( "read") )
         {
             std::vector<uint32_t> cReadVec;
-            //fFile->readFileChunks(
-            cSystemController.readFile (cReadVec, 10 * fPlaybackEventSize32);
-            //cSystemController.readFile (cReadVec);
-            size_t cCalcEvents = cReadVec.size() / fPlaybackEventSize32;
+            // whole events from the file index, zero suppressed events do not have fPlaybackEventSize32 words
+            uint32_t cCalcEvents = cSystemController.readEvents (cReadVec, 10);
+
+            if (cCalcEvents == 0)
+            {
+                LOG (INFO) << "End of file reached after " << cN - 1 << " events";
+                break;
+            }
+
             cSystemController.setData (pBoard, cReadVec, cCalcEvents);
             //pEvents = &data.GetEvents ( pBoard);
             pEvents = &cSystemController.GetEvents ( pBoard );
         }
+        else if ( cPipeline )
+        {
+            // the raw data is written to the save file by the readout threads
+            if ( !cSystemController.GetNextBatch ( cBatch ) ) break;
+
+            pEvents = &cBatch.GetEvents();
+        }
         else
         {
             uint32_t cPacketSize = cSystemController.ReadData ( pBoard );
@@ -204,13 +227,15 @@ int main ( int argc, char* argv[] )
         {
             LOG (INFO) << ">>> Event #" << cN++ ;
             LOG (INFO) << *ev;
+        }
 
-            if (cDAQFile)
-            {
-                SLinkEvent cSLev = ev->GetSLinkEvent (pBoard);
-                cDAQFileHandler->set (cSLev.getData<uint32_t>() );
-                cSLev.print (std::cout);
-            }
+        // the whole acquisition is encoded at once and handed to the writer without a copy
+        if (cDAQFile)
+        {
+            SLinkEncoder cEncoder ( (cPipeline) ? cBatch.fBoard : pBoard);
+            std::vector<uint32_t> cSLinkData;
+            cEncoder.encode (*pEvents, cSLinkData);
+            cDAQFileHandler->set (std::move (cSLinkData) );
         }
 
         cNthAcq++;
@@ -218,6 +243,20 @@ int main ( int argc, char* argv[] )
         itCounter++;
     }
 
+    if ( cPipeline )
+    {
+        cSystemController.StopPipeline();
+        uint32_t cNLeft = 0;
+
+        // the packets read while stopping are decoded by StopPipeline(), they are already in the raw file
+        while ( cSystemController.GetNextBatch ( cBatch ) )
+            cNLeft += cBatch.GetEvents().size();
+
+        PipelineStats cStats = cSystemController.getPipelineStats();
+        LOG (INFO) << "Pipeline: " << cStats.fNPackets << " packets, " << cStats.fNEventsRead << " events read, " << cStats.fNEventsDecoded << " decoded, " << cNLeft << " decoded after the stop not printed" ;
+        LOG (INFO) << "Pipeline: readout " << cStats.fReadoutTime << " s, decoding " << cStats.fDecodeTime << " s, raw ring max depth " << cStats.fRawQueue.fMaxDepth << ", batch ring max depth " << cStats.fBatchQueue.fMaxDepth ;
+    }
+
     t.stop();
     t.show ( "Time to take data:" );
 
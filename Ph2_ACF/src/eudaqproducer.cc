@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "../Utils/Utilities.h"
+#include "../Utils/ClusterFinder.h"
 #include "../System/SystemController.h"
 #include "../Utils/argvparser.h"
 
@@ -50,6 +51,8 @@ class Ph2Producer : public eudaq::Producer {
           fSystemController->Destroy();
           delete fSystemController;
       }
+      // the cluster finders point to the modules of the old hardware description
+      fClusterFinders.clear();
       fSystemController = new SystemController;
 
       std::stringstream outp;
@@ -197,36 +200,29 @@ class Ph2Producer : public eudaq::Producer {
 
             // parsing cbc data (cbc2 or cbc3)
             if (pBoard->getChipType() == ChipType::CBC3) {
-                uint32_t cFirstCbcId = cFe->fCbcVector.at(0)->getCbcId();
-                for(auto cCbc : cFe->fCbcVector) {
-                    int cChipId = (int)cCbc->getCbcId();
-                    const std::vector<uint32_t> cHitsVector = pPh2Event->GetHits(cCbc->getFeId(),cCbc->getCbcId());
-                    fHitsCounter += pPh2Event->GetNHits(cCbc->getFeId(),cCbc->getCbcId());
-                    for (auto hit : cHitsVector) {
-                            if( hit%2 == 0 ) {
-                                //top sensor
-                                top_channel_data.resize(top_offset+6);
-                                eudaq::setlittleendian<unsigned short>(&top_channel_data[top_offset + 0], ((cChipId-cFirstCbcId)*NCHANNELS/2) + hit/2);
-                                eudaq::setlittleendian<unsigned short>(&top_channel_data[top_offset + 2], 0);
-                                eudaq::setlittleendian<unsigned short>(&top_channel_data[top_offset + 4], 1);
-                                top_offset += 6;
-                            }
-                            else {
-                                //bottom sensor
-                                bottom_channel_data.resize(bottom_offset+6);
-                                eudaq::setlittleendian<unsigned short>(&bottom_channel_data[bottom_offset + 0], ((cChipId-cFirstCbcId)*NCHANNELS/2) + (hit-1)/2);
-                                eudaq::setlittleendian<unsigned short>(&bottom_channel_data[bottom_offset + 2], 0);
-                                eudaq::setlittleendian<unsigned short>(&bottom_channel_data[bottom_offset + 4], 1);
-                                bottom_offset += 6;
-                            }
-                    }
-
-                    //as we want to really know the position of hit, we'll not skip disabled chips, and set N cbc's to the maximal chip id.
-                    if (cChipId > cRealChipNumber) {
-                        cRealChipNumber = cChipId;
+                // the strips come from the clusters of the whole module, one finder per module keeps its layout
+                auto cFinder = fClusterFinders.find(cFe);
+                if (cFinder == fClusterFinders.end()) {
+                    cFinder = fClusterFinders.emplace(cFe, ClusterFinder(cFe)).first;
+                }
+                fClusters.clear();
+                cFinder->second.findClusters(pPh2Event, fClusters);
+                for (auto& cCluster : fClusters) {
+                    // even channels are the top sensor, odd channels the bottom one
+                    std::vector<unsigned char>& cChannelData = (cCluster.fSensor == 0) ? top_channel_data : bottom_channel_data;
+                    size_t& cOffset = (cCluster.fSensor == 0) ? top_offset : bottom_offset;
+                    cChannelData.resize(cOffset + 6*cCluster.fClusterWidth);
+                    for (uint32_t cStrip = cCluster.fFirstStrip; cStrip < uint32_t(cCluster.fFirstStrip + cCluster.fClusterWidth); cStrip++) {
+                        eudaq::setlittleendian<unsigned short>(&cChannelData[cOffset + 0], cStrip);
+                        eudaq::setlittleendian<unsigned short>(&cChannelData[cOffset + 2], 0);
+                        eudaq::setlittleendian<unsigned short>(&cChannelData[cOffset + 4], 1);
+                        cOffset += 6;
                     }
+                    fHitsCounter += cCluster.fClusterWidth;
                 }
-                cRealChipNumber = cRealChipNumber + 1 - cFirstCbcId;
+
+                //as we want to really know the position of hit, disabled chips are not skipped and the sensor goes up to the maximal chip id.
+                cRealChipNumber = cFinder->second.getNStrips() / ClusterFinder::STRIPS_PER_CBC;
 
                 eudaq::setlittleendian<unsigned short>(&top_data_final[0], (NCHANNELS/2) * cRealChipNumber);
                 eudaq::setlittleendian<unsigned short>(&top_data_final[2], 1);
@@ -364,6 +360,8 @@ class Ph2Producer : public eudaq::Producer {
     bool fHandshakeEnabled;
     uint32_t fHitsCounter;
     std::string fHWFile;
+    std::map<const Module*, ClusterFinder> fClusterFinders;
+    std::vector<Cluster> fClusters;
 };
 
 // The main function that will create a Producer instance and run it
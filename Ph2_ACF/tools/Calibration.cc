@@ -39,6 +39,8 @@ void Calibration::Initialise ( bool pAllChan, bool pDisableStubLogic )
     fTestPulseAmplitude = ( cSetting != std::end ( fSettingsMap ) ) ? cSetting->second : 0;
     cSetting = fSettingsMap.find ( "VerificationLoop" );
     fCheckLoop = ( cSetting != std::end ( fSettingsMap ) ) ? cSetting->second : 1;
+    cSetting = fSettingsMap.find ( "ParallelOffsetTuning" );
+    fParallelTrim = ( cSetting != std::end ( fSettingsMap ) ) ? cSetting->second : 1;
 
     if ( fTestPulseAmplitude == 0 ) fTestPulse = 0;
     else fTestPulse = 1;
@@ -401,81 +403,114 @@ void Calibration::FindOffsets()
     this->accept (cThresholdVisitor);
     // ok, done, all the offsets are at the starting value, VCth & Vplus are written
 
-    // now loop over test groups
-    for ( auto& cTGroup : fTestGroupChannelMap )
-    {
-        if (cTGroup.first != -1)
-        {
-            LOG (INFO) << GREEN << "Enabling Test Group...." << cTGroup.first << RESET ;
+    // the test groups only have to be tuned one after the other if a test pulse is injected into them,
+    // else the channels of all the groups are searched at once
+    std::vector<std::vector<int>> cPasses;
 
-            bitwiseOffset ( cTGroup.first );
+    if ( fAllChan ) cPasses.push_back ( { -1 } );
+    else
+    {
+        std::vector<int> cGroups;
 
-            if ( fCheckLoop )
-            {
-                // now all the bits are toggled or not, I still want to verify that the occupancy is ok
-                int cMultiple = 3;
-                LOG (INFO) << "Verifying Occupancy with final offsets by taking " << fEventsPerPoint* cMultiple << " Triggers!" ;
-                measureOccupancy ( fEventsPerPoint  * cMultiple, cTGroup.first );
-                // now find the occupancy for each channel and update the TProfile
-            }
+        for ( auto& cTGroup : fTestGroupChannelMap )
+            if ( cTGroup.first != -1 ) cGroups.push_back ( cTGroup.first );
 
-            updateHists ( "Occupancy" );
-            uint8_t cOffset = ( fHoleMode ) ? 0x00 : 0xFF;
-            setOffset ( cOffset, cTGroup.first );
-            LOG (INFO) << RED << "Disabling Test Group...." << cTGroup.first << RESET  ;
-        }
-        else if (cTGroup.first == -1 && fAllChan)
+        if ( fTestPulse || !fParallelTrim )
         {
-            LOG (INFO) << GREEN << "Enabling all channels ... Test Group Id " << cTGroup.first << RESET ;
+            for ( auto cGroup : cGroups )
+                cPasses.push_back ( { cGroup } );
+        }
+        else cPasses.push_back ( cGroups );
+    }
 
-            bitwiseOffset ( cTGroup.first );
+    TrimEngine cEngine ( fCbcInterface, [this] ( uint32_t pNEvents, std::map<Cbc*, std::vector<uint32_t>>& pCounts )
+    {
+        countChannelHits ( pNEvents, pCounts );
+    } );
 
-            if ( fCheckLoop )
-            {
-                // now all the bits are toggled or not, I still want to verify that the occupancy is ok
-                int cMultiple = 3;
-                LOG (INFO) << "Verifying Occupancy with final offsets by taking " << fEventsPerPoint* cMultiple << " Triggers!" ;
-                measureOccupancy ( fEventsPerPoint  * cMultiple, cTGroup.first );
-                // now find the occupancy for each channel and update the TProfile
-            }
+    for ( auto& cPass : cPasses )
+    {
+        // a pass over several groups is all the channels, which is group -1 for the histograms
+        int cTGroup = ( cPass.size() == 1 ) ? cPass.front() : -1;
 
-            updateHists ( "Occupancy" );
-            uint8_t cOffset = ( fHoleMode ) ? 0x00 : 0xFF;
-            setOffset ( cOffset, cTGroup.first );
-            LOG (INFO) << RED << "Disabling Test Group...." << cTGroup.first << RESET  ;
+        if ( cTGroup == -1 ) LOG (INFO) << GREEN << "Enabling all channels ... Test Group Id " << cTGroup << RESET ;
+        else LOG (INFO) << GREEN << "Enabling Test Group...." << cTGroup << RESET ;
+
+        bitwiseOffset ( cEngine, cPass );
+
+        if ( fCheckLoop )
+        {
+            // now all the bits are toggled or not, I still want to verify that the occupancy is ok
+            int cMultiple = 3;
+            LOG (INFO) << "Verifying Occupancy with final offsets by taking " << fEventsPerPoint* cMultiple << " Triggers!" ;
+            measureOccupancy ( fEventsPerPoint  * cMultiple, cTGroup );
+            // now find the occupancy for each channel and update the TProfile
         }
 
+        updateHists ( "Occupancy" );
+        uint8_t cOffset = ( fHoleMode ) ? 0x00 : 0xFF;
+        setOffset ( cOffset, cTGroup );
+        LOG (INFO) << RED << "Disabling Test Group...." << cTGroup << RESET  ;
+
         this->HttpServerProcess();
     }
 
+    LOG (INFO) << BOLDBLUE << "Offset tuning used " << cEngine.getNTriggers() << " triggers and " << cEngine.getNI2CWrites() << " offset register writes" << RESET;
+
     setRegValues();
 }
 
 
-void Calibration::bitwiseOffset ( int pTGroup )
+void Calibration::bitwiseOffset ( TrimEngine& pEngine, const std::vector<int>& pTGroups )
 {
-    //re-run the phase finding at least before every sweep
-    for (BeBoard* cBoard : fBoardVector)
-
-        //fBeBoardInterface->FindPhase (cBoard);
+    // the channels of the groups on all the CBCs, starting from the offsets in the histograms
+    pEngine.clearChannels();
 
-        // loop over the bits
-        for ( int iBit = 7; iBit >= 0; iBit-- )
+    for ( auto cBoard : fBoardVector )
+    {
+        for ( auto cFe : cBoard->fModuleVector )
         {
-            //LOG (INFO) << "Searching for the correct offsets by flipping bit " << iBit ;
-            // now, for all the channels in the group and for each cbc, toggle the MSB of the offset from the map
-            toggleOffset ( pTGroup, iBit, true );
+            for ( auto cCbc : cFe->fCbcVector )
+            {
+                TProfile* cOffsetHist = static_cast<TProfile*> ( getHist ( cCbc, "Offsets" ) );
+                std::vector<uint8_t> cChannels;
+                std::vector<uint8_t> cOffsets;
 
+                for ( auto cTGroup : pTGroups )
+                {
+                    for ( auto& cChannel : fTestGroupChannelMap[cTGroup] )
+                    {
+                        cChannels.push_back ( cChannel );
+                        cOffsets.push_back ( cOffsetHist->GetBinContent ( cOffsetHist->FindBin ( cChannel ) ) );
+                    }
+                }
 
-            // now the offset for the current group is changed
-            // now take data
-            measureOccupancy ( fEventsPerPoint, pTGroup );
+                pEngine.addChannels ( cCbc, cChannels, cOffsets );
+            }
+        }
+    }
 
+    pEngine.run ( fEventsPerPoint, 0.57 );
 
-            // now call toggleOffset again with pBegin = false; this method checks the occupancy and flips a bit back if necessary
-            toggleOffset ( pTGroup, iBit, false );
-            //updateHists ( "Offsets" );
+    for ( auto cBoard : fBoardVector )
+    {
+        for ( auto cFe : cBoard->fModuleVector )
+        {
+            for ( auto cCbc : cFe->fCbcVector )
+            {
+                TProfile* cOffsetHist = static_cast<TProfile*> ( getHist ( cCbc, "Offsets" ) );
+                const std::vector<uint8_t>& cChannels = pEngine.getChannels ( cCbc );
+                const std::vector<uint8_t>& cOffsets = pEngine.getOffsets ( cCbc );
+
+                for ( size_t cIndex = 0; cIndex < cChannels.size(); cIndex++ )
+                {
+                    int iBin = cOffsetHist->FindBin ( cChannels[cIndex] );
+                    cOffsetHist->SetBinContent ( iBin, cOffsets[cIndex] );
+                    cOffsetHist->SetBinEntries ( iBin, 1 );
+                }
+            }
         }
+    }
 
     updateHists ( "Occupancy" );
     updateHists ( "Offsets" );
@@ -484,29 +519,19 @@ void Calibration::bitwiseOffset ( int pTGroup )
 
 void Calibration::measureOccupancy ( uint32_t pNEvents, int pTGroup )
 {
+    // take the data on all boards at once, the histograms are filled afterwards on this thread
+    ReadNEvents (pNEvents);
+
     for ( BeBoard* pBoard : fBoardVector )
     {
+        const std::vector<Event*>& events = GetEvents ( pBoard );
 
-        uint32_t cN = 0;
-        uint32_t cNthAcq = 0;
-
-        ReadNEvents (pBoard, pNEvents);
-        std::vector<Event*> events = GetEvents ( pBoard );
-
-        // if this is for channelwise offset tuning, iterate the events and fill the occupancy histogram
-
-        for ( auto& cEvent : events )
+        // if this is for channelwise offset tuning, fill the occupancy histogram from all the events at once
+        for ( auto cFe : pBoard->fModuleVector )
         {
-            for ( auto cFe : pBoard->fModuleVector )
-            {
-                for ( auto cCbc : cFe->fCbcVector )
-                    fillOccupancyHist ( cCbc, pTGroup, cEvent );
-            }
-
-            cN++;
+            for ( auto cCbc : cFe->fCbcVector )
+                fillOccupancyHist ( cCbc, pTGroup, events );
         }
-
-        cNthAcq++;
     }
 }
 
@@ -519,22 +544,22 @@ float Calibration::findCbcOccupancy ( Cbc* pCbc, int pTGroup, int pEventsPerPoin
     return cOccupancy / ( static_cast<float> ( fTestGroupChannelMap[pTGroup].size() * pEventsPerPoint ) );
 }
 
-void Calibration::fillOccupancyHist ( Cbc* pCbc, int pTGroup, const Event* pEvent )
+void Calibration::fillOccupancyHist ( Cbc* pCbc, int pTGroup, const std::vector<Event*>& pEvents )
 {
     // Find the Occupancy histogram for the current Cbc
     TH1F* cOccHist = static_cast<TH1F*> ( getHist ( pCbc, "Occupancy" ) );
-    // iterate the channels in current group
-    int cHits = 0;
+    // count the hits of the channels in current group over all the events
+    std::vector<uint32_t> cCounts ( NCHANNELS, 0 );
+    uint32_t cHits = Event::accumulateOccupancy ( pEvents, pCbc->getFeId(), pCbc->getCbcId(), cCounts.data(), makeChannelMask ( fTestGroupChannelMap[pTGroup] ) );
 
     for ( auto& cChanId : fTestGroupChannelMap[pTGroup] )
     {
         // I am filling the occupancy profile for each CBC for the current test group
-        if ( pEvent->DataBit ( pCbc->getFeId(), pCbc->getCbcId(), cChanId ) )
-        {
-            cOccHist->Fill ( cChanId );
-            cHits++;
-        }
+        if ( cCounts[cChanId] != 0 )
+            cOccHist->AddBinContent ( cOccHist->FindBin ( cChanId ), cCounts[cChanId] );
     }
+
+    cOccHist->SetEntries ( cOccHist->GetEntries() + cHits );
 }
 
 void Calibration::clearOccupancyHists ( Cbc* pCbc )
@@ -558,6 +583,8 @@ void Calibration::clearVPlusMap()
 void Calibration::setOffset ( uint8_t pOffset, int  pGroup, bool pVPlus )
 {
     LOG (INFO) << "Setting offsets of Test Group " << pGroup << " to 0x" << std::hex << +pOffset << std::dec ;
+    // the offsets of all the Cbcs go out together, one I2C transaction per board
+    CbcRegBatch cBatch;
 
     for ( auto cBoard : fBoardVector )
     {
@@ -592,99 +619,12 @@ void Calibration::setOffset ( uint8_t pOffset, int  pGroup, bool pVPlus )
                     }
                 }
 
-                fCbcInterface->WriteCbcMultReg ( cCbc, cRegVec );
+                cBatch.write ( cCbc, cRegVec );
             }
         }
     }
-}
-
-void Calibration::toggleOffset ( int pTGroup, uint8_t pBit, bool pBegin )
-{
-    for ( auto cBoard : fBoardVector )
-    {
-        for ( auto cFe : cBoard->fModuleVector )
-        {
-            uint32_t cFeId = cFe->getFeId();
-
-            for ( auto cCbc : cFe->fCbcVector )
-            {
-                uint32_t cCbcId = cCbc->getCbcId();
-
-                // first, find the offset Histogram for this CBC
-                TProfile* cOffsetHist = static_cast<TProfile*> ( getHist ( cCbc, "Offsets" ) );
-                // find the TProfile for occupancy measurment of current channel
-                TH1F* cOccHist = static_cast<TH1F*> ( getHist ( cCbc, "Occupancy" ) );
-                // cOccHist->Scale( 1 / double( fEventsPerPoint ) );
-                RegisterVector cRegVec;   // vector of pairs for the write operation
-
-                // loop the channels of the current group and toggle bit i in the global map
-                for ( auto& cChannel : fTestGroupChannelMap[pTGroup] )
-                {
-                    TString cRegName = Form ( "Channel%03d", cChannel + 1 );
-
-                    if ( pBegin )
-                    {
-                        // get the offset
-                        // Fix suggested by B. Schneider
-                        int iBin = cOffsetHist->FindBin (cChannel);
-                        uint16_t cOffset = cOffsetHist->GetBinContent (iBin);
-                        //original
-                        //uint16_t cOffset = cOffsetHist->GetBinContent ( cChannel );
-
-                        // toggle Bit i
-                        toggleRegBit ( cOffset, pBit );
-
-                        // modify the histogram
-                        // original
-                        //cOffsetHist->SetBinContent ( cChannel, cOffset );
-                        //cOffsetHist->SetBinEntries ( cChannel, 1 );
-                        //suggested B. Schneider
-                        iBin = cOffsetHist->FindBin (cChannel);
-                        cOffsetHist->SetBinContent ( iBin, cOffset );
-                        cOffsetHist->SetBinEntries ( iBin, 1 );
 
-                        // push in a vector for CBC write transaction
-                        cRegVec.push_back ( {cRegName.Data(), static_cast<uint8_t> (cOffset) } );
-                    }
-                    else  //here it is interesting since now I will check if the occupancy is smaller or larger 50% and decide wether to toggle or not to toggle
-                    {
-                        // if the occupancy is larger than 50%, flip the bit back, if it is smaller, don't do anything
-                        // get the offset
-                        // original
-                        //uint16_t cOffset = cOffsetHist->GetBinContent ( cChannel );
-                        //suggested B. Schneider
-                        int iBin = cOffsetHist->FindBin (cChannel);
-                        uint16_t cOffset = cOffsetHist->GetBinContent ( iBin );
-
-                        // get the occupancy
-                        // original
-                        iBin = cOccHist->FindBin ( cChannel );
-                        float cOccupancy = cOccHist->GetBinContent ( iBin );
-                        //LOG (DEBUG) << "Bit " << +pBit << " Offset " << +cOffset << " Occupancy " << +cOccupancy;
-
-                        // only if the occupancy is too high I need to flip the bit back and write, if not, I can leave it
-                        if ( cOccupancy > 0.57 * fEventsPerPoint )
-                        {
-                            toggleRegBit ( cOffset, pBit ); // toggle the bit back that was previously flipped
-                            //sugested B. Schneider
-                            int iBin = cOffsetHist->FindBin (cChannel);
-                            cOffsetHist->SetBinContent ( iBin, cOffset );
-                            cOffsetHist->SetBinEntries ( iBin, 1 );
-                            //original
-                            //cOffsetHist->SetBinContent ( cChannel, cOffset );
-                            //cOffsetHist->SetBinEntries ( cChannel, 1 );
-                            cRegVec.push_back ( {cRegName.Data(), static_cast<uint16_t> (cOffset) } );
-                        }
-
-                        // since I extracted the info from the occupancy profile for this bit (this iteration), i need to clear the corresponding bins
-                        cOccHist->SetBinContent ( iBin, 0 );
-                    }
-                }
-
-                fCbcInterface->WriteCbcMultReg ( cCbc, cRegVec );
-            }
-        }
-    }
+    fCbcInterface->FlushCbcRegBatch ( cBatch, true, RegWriteMode::DELTA_ONLY );
 }
 
 void Calibration::updateHists ( std::string pHistname )
@@ -729,6 +669,9 @@ void Calibration::updateHists ( std::string pHistname )
 
 void Calibration::setRegValues()
 {
+    // final offsets and, for CBC3, the original stub logic settings: only what the Cbcs do not already hold is written
+    CbcRegBatch cBatch;
+
     for ( auto cBoard : fBoardVector )
     {
         for ( auto cFe : cBoard->fModuleVector )
@@ -764,11 +707,13 @@ void Calibration::setRegValues()
                     cRegVec.push_back ({"HIP&TestMode", fHIPCountValue[cCbc]});
                 }
 
-                fCbcInterface->WriteCbcMultReg ( cCbc, cRegVec );
+                cBatch.write ( cCbc, cRegVec );
             }
         }
     }
 
+    fCbcInterface->FlushCbcRegBatch ( cBatch, true, RegWriteMode::DELTA_ONLY );
+
     LOG (INFO) << BOLDGREEN << "Applying final offsets determined by tuning to chip - no re-configure necessary!" << RESET;
 }
 
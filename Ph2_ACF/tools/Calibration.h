@@ -14,6 +14,7 @@
 
 #include "Tool.h"
 #include "Channel.h"
+#include "TrimEngine.h"
 #include "../Utils/Visitor.h"
 #include "../Utils/CommonVisitors.h"
 
@@ -58,17 +59,16 @@ class Calibration : public Tool
 
     void bitwiseVCth ( int pTGroup );
 
-    void bitwiseOffset ( int pTGroup );
+    // binary search of the offsets of the channels of the test groups pTGroups on all the CBCs at once
+    void bitwiseOffset ( TrimEngine& pEngine, const std::vector<int>& pTGroups );
 
     void setOffset ( uint8_t pOffset, int  pTGroupId, bool pVPlus = false );
 
-    void toggleOffset ( int pTGroup, uint8_t pBit, bool pBegin );
-
     void measureOccupancy ( uint32_t pNEvents, int pTGroup );
 
     float findCbcOccupancy ( Cbc* pCbc, int pTGroup, int pEventsPerPoint );
 
-    void fillOccupancyHist ( Cbc* pCbc, int pTGroup, const Event* pEvent );
+    void fillOccupancyHist ( Cbc* pCbc, int pTGroup, const std::vector<Event*>& pEvents );
 
     void clearOccupancyHists ( Cbc* pCbc );
 
@@ -104,6 +104,7 @@ class Calibration : public Tool
     bool fCheckLoop;
     bool fAllChan;
     bool fDisableStubLogic;
+    bool fParallelTrim;
 
     //to hold the original register values
     std::map<Cbc*, uint8_t> fStubLogicValue;
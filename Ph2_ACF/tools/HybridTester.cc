@@ -670,7 +670,7 @@ void HybridTester::TestRegisters()
             uint8_t cFirstBitPattern = 0xAA;
             uint8_t cSecondBitPattern = 0x55;
 
-            CbcRegMap cMap = pCbc.getRegMap();
+            const CbcRegMap& cMap = pCbc.getRegMap();
 
             for ( const auto& cReg : cMap )
             {
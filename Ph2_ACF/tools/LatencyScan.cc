@@ -109,29 +109,14 @@ std::map<Module*, uint8_t> LatencyScan::ScanLatency ( uint8_t pStartLatency, uin
         this->accept ( cVisitor );
 
 
-        // Take Data for all Modules
+        // Take Data for all Modules, the boards are started, read until fNevents and stopped in parallel
+        ReadDataUntil ( fNevents );
+
         for ( BeBoard* pBoard : fBoardVector )
         {
-            // I need this to normalize the TDC values I get from the Strasbourg FW
-            int cNevents; 
-            fBeBoardInterface->Start(pBoard);
-            do
-            {
-                uint32_t cNeventsReadBack = ReadData( pBoard );
-                if( cNeventsReadBack == 0 )
-                {
-                    LOG (INFO) << BOLDRED << "..... Read back " << +cNeventsReadBack << " events!! Why?!" << RESET ;
-                    continue;
-                }
-
-                const std::vector<Event*>& events = GetEvents ( pBoard );
-                cNevents += events.size(); 
-                // Loop over Events from this Acquisition
-                countHitsLat ( pBoard, events, "module_latency", cLat, pStartLatency, pNoTdc );
-                // done counting hits for all FE's, now update the Histograms
-                updateHists ( "module_latency", false );
-            }while( cNevents < fNevents );
-            fBeBoardInterface->Stop(pBoard);
+            const std::vector<Event*>& events = GetEvents ( pBoard );
+            // Loop over Events from this Acquisition
+            countHitsLat ( pBoard, events, "module_latency", cLat, pStartLatency, pNoTdc );
 
             //ReadNEvents ( pBoard, fNevents );
             //const std::vector<Event*>& events = GetEvents ( pBoard );
@@ -193,39 +178,29 @@ std::map<Module*, uint8_t> LatencyScan::ScanStubLatency ( uint8_t pStartLatency,
 
     for ( uint8_t cLat = pStartLatency; cLat < pStartLatency + pLatencyRange; cLat++ )
     {
-        uint32_t cN = 0;
-        int cNStubs = 0;
-        uint32_t cNevents = 0 ;
+        //here set the stub latency on all boards
+        RunOnAllBoards ("SetStubLatency", [&] (BoardContext & pContext)
+        {
+            for (auto cReg : getStubLatencyName (pContext.fBoard->getBoardType() ) )
+                pContext.fBeBoardInterface->WriteBoardReg (pContext.fBoard, cReg, cLat);
+        } );
+
         // Take Data for all Modules
+        ReadDataUntil ( fNevents );
+
         for ( BeBoard* pBoard : fBoardVector )
         {
-            //here set the stub latency
-            for (auto cReg : getStubLatencyName (pBoard->getBoardType() ) )
-                fBeBoardInterface->WriteBoardReg (pBoard, cReg, cLat);
+            int cNStubs = 0;
+            const std::vector<Event*>& events = GetEvents ( pBoard );
 
-            fBeBoardInterface->Start(pBoard);
-            do
+            // Loop over Events from this Acquisition
+            for ( auto& cEvent : events )
             {
-                uint32_t cNeventsReadBack = ReadData( pBoard );
-                if( cNeventsReadBack == 0 )
-                {
-                    LOG (INFO) << BOLDRED << "..... Read back " << +cNeventsReadBack << " events!! Why?!" << RESET ;
-                    continue;
-                }
-
-                const std::vector<Event*>& events = GetEvents ( pBoard );
-                cNevents += events.size(); 
-
-                // Loop over Events from this Acquisition
-                for ( auto& cEvent : events )
-                {
-                    for ( auto cFe : pBoard->fModuleVector )
-                        cNStubs += countStubs ( cFe, cEvent, "module_stub_latency", cLat );
-                }
+                for ( auto cFe : pBoard->fModuleVector )
+                    cNStubs += countStubs ( cFe, cEvent, "module_stub_latency", cLat );
+            }
 
-            }while( cNevents < fNevents );
-            fBeBoardInterface->Stop(pBoard);
-            LOG (INFO) << "Stub Latency " << +cLat << " Stubs " << cNStubs  << " Events " << cN ;
+            LOG (INFO) << "Stub Latency " << +cLat << " Stubs " << cNStubs  << " Events " << events.size() ;
 
             //ReadNEvents ( pBoard, fNevents );
             //const std::vector<Event*>& events = GetEvents ( pBoard );
@@ -1,5 +1,15 @@
 #include "PedeNoise.h"
 
+namespace {
+    // same bin content and sum of weights squared as pCount unit weight Fill() calls, the binomial Divide and the fits rely on the bin errors
+    void addCounts ( TH1* pHist, int pBin, double pCount )
+    {
+        pHist->AddBinContent ( pBin, pCount );
+
+        if ( pHist->GetSumw2N() != 0 )
+            ( *pHist->GetSumw2() ) [pBin] += pCount;
+    }
+}
 
 PedeNoise::PedeNoise() :
     Tool(),
@@ -7,6 +17,7 @@ PedeNoise::PedeNoise() :
     fPedestalCanvas (nullptr),
     fFeSummaryCanvas (nullptr),
     fNormHist (nullptr),
+    fSCurveEventsMap(),
     fThresholdMap(),
     fHitCountMap(),
     fNCbc (0),
@@ -15,12 +26,18 @@ PedeNoise::PedeNoise() :
     fTestPulse (false),
     fFitted (false),
     fTestPulseAmplitude (0),
-    fEventsPerPoint (0)
+    fEventsPerPoint (0),
+    fAdaptiveSCurves (false),
+    fSCurveMinEvents (0),
+    fSCurveCoarseStep (4)
 {
 }
 
 PedeNoise::~PedeNoise()
 {
+    // the event counts of the adaptive S-curves are not booked, they are only the normalisation
+    for ( auto& cEvents : fSCurveEventsMap )
+        delete cEvents.second;
 }
 
 void PedeNoise::Initialise (bool pAllChan, bool pDisableStubLogic)
@@ -148,6 +165,12 @@ void PedeNoise::Initialise (bool pAllChan, bool pDisableStubLogic)
     fEventsPerPoint = ( cSetting != std::end ( fSettingsMap ) ) ? cSetting->second : 10;
     cSetting = fSettingsMap.find ( "FitSCurves" );
     fFitted = ( cSetting != std::end ( fSettingsMap ) ) ? cSetting->second : 0;
+    cSetting = fSettingsMap.find ( "AdaptiveSCurves" );
+    fAdaptiveSCurves = ( cSetting != std::end ( fSettingsMap ) ) ? cSetting->second : 0;
+    cSetting = fSettingsMap.find ( "SCurveMinEvents" );
+    fSCurveMinEvents = ( cSetting != std::end ( fSettingsMap ) ) ? cSetting->second : std::max ( 1u, fEventsPerPoint / 4 );
+    cSetting = fSettingsMap.find ( "SCurveCoarseStep" );
+    fSCurveCoarseStep = ( cSetting != std::end ( fSettingsMap ) ) ? cSetting->second : 4;
     //cSetting = fSettingsMap.find ( "TestPulseAmplitude" );
     //fTestPulseAmplitude = ( cSetting != std::end ( fSettingsMap ) ) ? cSetting->second : 0;
 
@@ -156,6 +179,9 @@ void PedeNoise::Initialise (bool pAllChan, bool pDisableStubLogic)
     LOG (INFO) << "	Nevents = " << fEventsPerPoint ;
     LOG (INFO) << " FitSCurves = " << int ( fFitted ) ;
 
+    if ( fAdaptiveSCurves )
+        LOG (INFO) << " AdaptiveSCurves: coarse step " << fSCurveCoarseStep << ", " << fSCurveMinEvents << " to " << fEventsPerPoint << " events per point" ;
+
     if (fType == ChipType::CBC3)
         LOG (INFO) << BOLDBLUE << "Chip Type determined to be " << BOLDRED << "CBC3" << RESET;
     else
@@ -245,6 +271,13 @@ std::string PedeNoise::sweepSCurves (uint8_t pTPAmplitude)
         cHist->Sumw2();
         bookHistogram ( cCbc.first, cHistogramname, cHist );
 
+        if ( fAdaptiveSCurves )
+        {
+            delete fSCurveEventsMap[cCbc.first];
+            fSCurveEventsMap[cCbc.first] = new TH2F ( cHistname + "_Events", cHistname + "_Events", NCHANNELS, -0.5, 253.5, 1024, -0.5, 1023.5 );
+            fSCurveEventsMap[cCbc.first]->SetDirectory ( nullptr );
+        }
+
         fNoiseCanvas->cd ( cCbc.first->getCbcId() + 1 );
         cHist->Draw ( "colz2" );
 
@@ -494,9 +527,17 @@ void PedeNoise::measureSCurves (int pTGrpId, std::string pHistName, uint16_t pSt
 {
     int cMinBreakCount = 10;
     const std::vector<uint8_t>& cTestGrpChannelVec = fTestGroupChannelMap[pTGrpId];
+    const ChannelMask cTestGrpMask = makeChannelMask (cTestGrpChannelVec);
+    std::vector<uint32_t> cCounts (NCHANNELS, 0);
 
     if (pStartValue == 0) pStartValue = this->findPedestal (pTGrpId);
 
+    if (fAdaptiveSCurves)
+    {
+        measureSCurvesAdaptive (pTGrpId, pHistName, pStartValue);
+        return;
+    }
+
     bool cAllZero = false;
     bool cAllOne = false;
     int cAllZeroCounter = 0;
@@ -509,104 +550,181 @@ void PedeNoise::measureSCurves (int pTGrpId, std::string pHistName, uint16_t pSt
     uint16_t cMaxValue = (1 << cNbits) - 1;
 
     //start with the threshold value found above
-    ThresholdVisitor cVisitor (fCbcInterface, cValue);
-
     while (! (cAllZero && cAllOne) )
     {
         uint32_t cHitCounter = 0;
+        uint32_t cMaxHits = 0;
 
-        for ( BeBoard* pBoard : fBoardVector )
+        // all boards move to the same threshold and take their data at the same time, each worker writes through its own CbcInterface
+        RunOnAllBoards ("SetThreshold", [&] (BoardContext & pContext)
         {
-            for (Module* cFe : pBoard->fModuleVector)
-            {
-                cVisitor.setThreshold (cValue);
+            ThresholdVisitor cVisitor (pContext.fCbcInterface.get(), cValue);
+
+            for (Module* cFe : pContext.fBoard->fModuleVector)
                 cFe->accept (cVisitor);
-            }
+        } );
 
-            ReadNEvents ( pBoard, fEventsPerPoint );
+        ReadNEvents ( fEventsPerPoint );
 
+        for ( BeBoard* pBoard : fBoardVector )
+        {
             const std::vector<Event*>& events = GetEvents ( pBoard );
 
-            // Loop over Events from this Acquisition
-            for ( auto& ev : events )
+            // count the hits of all the events of this Acquisition per channel, then fill the histograms once
+            for ( auto cFe : pBoard->fModuleVector )
             {
-                //uint32_t cHitCounter = 0;
-
-                for ( auto cFe : pBoard->fModuleVector )
+                for ( auto cCbc : cFe->fCbcVector )
                 {
-                    for ( auto cCbc : cFe->fCbcVector )
-                    {
-                        TH2F* cSCurveHist = dynamic_cast<TH2F*> (this->getHist (cCbc, pHistName) );
-
-                        for ( auto& cChan : cTestGrpChannelVec )
-                        {
+                    TH2F* cSCurveHist = dynamic_cast<TH2F*> (this->getHist (cCbc, pHistName) );
+                    std::fill (cCounts.begin(), cCounts.end(), 0);
+                    uint32_t cNHits = Event::accumulateOccupancy (events, cFe->getFeId(), cCbc->getCbcId(), cCounts.data(), cTestGrpMask);
 
-                            if ( ev->DataBit ( cFe->getFeId(), cCbc->getCbcId(), cChan) )
-                            {
-                                //fill the strip number and the current threshold
-                                cSCurveHist->Fill (cChan, cValue);
-                                cHitCounter++;
-                            }
-                        }
+                    for ( auto& cChan : cTestGrpChannelVec )
+                    {
+                        //fill the strip number and the current threshold
+                        if ( cCounts[cChan] != 0 )
+                            addCounts (cSCurveHist, cSCurveHist->FindBin (cChan, cValue), cCounts[cChan]);
                     }
+
+                    cSCurveHist->SetEntries (cSCurveHist->GetEntries() + cNHits);
+                    cHitCounter += cNHits;
                 }
             }
 
             Counter cCbcCounter;
             pBoard->accept ( cCbcCounter );
-            uint32_t cMaxHits = fEventsPerPoint *   cCbcCounter.getNCbc() * cTestGrpChannelVec.size();
+            cMaxHits += fEventsPerPoint *   cCbcCounter.getNCbc() * cTestGrpChannelVec.size();
+        }
 
-            //now establish if I'm zero or one
-            if (cHitCounter == 0) cAllZeroCounter ++;
+        //now establish if I'm zero or one
+        if (cHitCounter == 0) cAllZeroCounter ++;
 
-            if (cHitCounter > 0.98 * cMaxHits ) cAllOneCounter++;
+        if (cHitCounter > 0.98 * cMaxHits ) cAllOneCounter++;
 
-            //it will either find one or the other extreme first and thus these will be mutually exclusive
-            //if any of the two conditions is true, just revert the sign and go the opposite direction starting from startvalue+1
-            //check that cAllZero is not yet set, otherwise I'll be reversing signs a lot because once i switch direction, the statement stays true
-            if (!cAllZero && cAllZeroCounter == cMinBreakCount )
-            {
-                cAllZero = true;
-                cSign = fHoleMode ? -1 : 1;
-                cIncrement = 0;
-            }
+        //it will either find one or the other extreme first and thus these will be mutually exclusive
+        //if any of the two conditions is true, just revert the sign and go the opposite direction starting from startvalue+1
+        //check that cAllZero is not yet set, otherwise I'll be reversing signs a lot because once i switch direction, the statement stays true
+        if (!cAllZero && cAllZeroCounter == cMinBreakCount )
+        {
+            cAllZero = true;
+            cSign = fHoleMode ? -1 : 1;
+            cIncrement = 0;
+        }
 
-            if (!cAllOne && cAllOneCounter == cMinBreakCount)
-            {
-                cAllOne = true;
-                cSign = fHoleMode ? 1 : -1;
-                cIncrement = 0;
-            }
+        if (!cAllOne && cAllOneCounter == cMinBreakCount)
+        {
+            cAllOne = true;
+            cSign = fHoleMode ? 1 : -1;
+            cIncrement = 0;
+        }
+
+        cIncrement++;
+
+        // following checks if we're not going out of bounds
+        if (cSign == 1 && (pStartValue + (cIncrement * cSign) > cMaxValue) )
+        {
+            if (fHoleMode) cAllZero = true;
+            else cAllOne = true;
+
+            cIncrement = 0;
+            cSign = -1 * cSign;
+        }
+
+        if (cSign == -1 && (pStartValue + (cIncrement * cSign) < 0) )
+        {
+            if (fHoleMode) cAllOne = true;
+            else cAllZero = true;
+
+            cIncrement = 0;
+            cSign = -1 * cSign;
+        }
 
-            cIncrement++;
 
-            // following checks if we're not going out of bounds
-            if (cSign == 1 && (pStartValue + (cIncrement * cSign) > cMaxValue) )
+        LOG (DEBUG) << "All 0: " << cAllZero << " | All 1: " << cAllOne << " current value: " << cValue << " | next value: " << pStartValue + (cIncrement * cSign) << " | Sign: " << cSign << " | Increment: " << cIncrement << " Hitcounter: " << cHitCounter << " Max hits: " << cMaxHits;
+        cValue = pStartValue + (cIncrement * cSign);
+    }
+
+    this->HttpServerProcess();
+    LOG (INFO) << YELLOW << "Found minimal and maximal occupancy " << cMinBreakCount << " times, SCurves finished! " << RESET ;
+}
+
+void PedeNoise::measureSCurvesAdaptive (int pTGrpId, std::string pHistName, uint16_t pStartValue)
+{
+    const std::vector<uint8_t>& cTestGrpChannelVec = fTestGroupChannelMap[pTGrpId];
+    uint16_t cNbits = (fType == ChipType::CBC2) ? 8 : 10;
+
+    SCurveScan cScan ([this] (const std::map<Cbc*, uint16_t>& pThresholds)
+    {
+        // each CBC is at its own point of its curve, each worker writes through its own CbcInterface
+        RunOnAllBoards ("SetThreshold", [&] (BoardContext & pContext)
+        {
+            ThresholdVisitor cVisitor (pContext.fCbcInterface.get(), 0);
+
+            for (Module* cFe : pContext.fBoard->fModuleVector)
             {
-                if (fHoleMode) cAllZero = true;
-                else cAllOne = true;
+                for (Cbc* cCbc : cFe->fCbcVector)
+                {
+                    auto cThreshold = pThresholds.find (cCbc);
 
-                cIncrement = 0;
-                cSign = -1 * cSign;
+                    if (cThreshold == pThresholds.end() ) continue;
+
+                    cVisitor.setThreshold (cThreshold->second);
+                    cCbc->accept (cVisitor);
+                }
             }
+        } );
+    },
+    [this] (uint32_t pNEvents, std::map<Cbc*, std::vector<uint32_t>>& pCounts)
+    {
+        countChannelHits (pNEvents, pCounts);
+    },
+    cTestGrpChannelVec, (1 << cNbits) - 1, !fHoleMode);
+
+    for (auto& cCbc : fHitCountMap)
+        cScan.addCbc (cCbc.first, pStartValue);
+
+    cScan.run (fEventsPerPoint, fSCurveMinEvents, fSCurveCoarseStep, 3);
+
+    for (auto& cCbc : fHitCountMap)
+    {
+        TH2F* cSCurveHist = dynamic_cast<TH2F*> (this->getHist (cCbc.first, pHistName) );
+        TH2F* cEventsHist = fSCurveEventsMap[cCbc.first];
+        const SCurveScan::ScanPoints& cPoints = cScan.getPoints (cCbc.first);
+        uint32_t cNHits = 0;
 
-            if (cSign == -1 && (pStartValue + (cIncrement * cSign) < 0) )
+        for (auto& cChan : cTestGrpChannelVec)
+        {
+            for (auto cPoint = cPoints.begin(); cPoint != cPoints.end(); cPoint++)
             {
-                if (fHoleMode) cAllOne = true;
-                else cAllZero = true;
+                uint32_t cCount = cPoint->second.fCounts[cChan];
+                addCounts (cSCurveHist, cSCurveHist->FindBin (cChan, cPoint->first), cCount);
+                cEventsHist->SetBinContent (cEventsHist->FindBin (cChan, cPoint->first), cPoint->second.fNEvents);
+                cNHits += cCount;
 
-                cIncrement = 0;
-                cSign = -1 * cSign;
-            }
+                // the thresholds skipped on the plateaus get the occupancy interpolated from the points around them
+                auto cNext = std::next (cPoint);
 
+                if (cNext == cPoints.end() ) continue;
 
-            LOG (DEBUG) << "All 0: " << cAllZero << " | All 1: " << cAllOne << " current value: " << cValue << " | next value: " << pStartValue + (cIncrement * cSign) << " | Sign: " << cSign << " | Increment: " << cIncrement << " Hitcounter: " << cHitCounter << " Max hits: " << cMaxHits;
-            cValue = pStartValue + (cIncrement * cSign);
+                double cOccupancy = cCount / double (cPoint->second.fNEvents);
+                double cNextOccupancy = cNext->second.fCounts[cChan] / double (cNext->second.fNEvents);
+                uint32_t cNEvents = std::min (cPoint->second.fNEvents, cNext->second.fNEvents);
+
+                for (uint16_t cValue = cPoint->first + 1; cValue < cNext->first; cValue++)
+                {
+                    double cFraction = (cValue - cPoint->first) / double (cNext->first - cPoint->first);
+                    double cContent = (cOccupancy + cFraction * (cNextOccupancy - cOccupancy) ) * cNEvents;
+                    addCounts (cSCurveHist, cSCurveHist->FindBin (cChan, cValue), cContent);
+                    cEventsHist->SetBinContent (cEventsHist->FindBin (cChan, cValue), cNEvents);
+                }
+            }
         }
+
+        cSCurveHist->SetEntries (cSCurveHist->GetEntries() + cNHits);
     }
 
     this->HttpServerProcess();
-    LOG (INFO) << YELLOW << "Found minimal and maximal occupancy " << cMinBreakCount << " times, SCurves finished! " << RESET ;
+    LOG (INFO) << YELLOW << "Adaptive SCurves of Test Group " << pTGrpId << " finished: " << cScan.getNPoints() << " points and " << cScan.getNTriggers() << " triggers (" << fEventsPerPoint << " per point with the fixed step scan)" << RESET ;
 }
 
 void PedeNoise::enableTestGroupforNoise ( int  pTGrpId )
@@ -677,7 +795,9 @@ void PedeNoise::processSCurves (std::string pHistName)
         TH2F* cHist = dynamic_cast<TH2F*> ( getHist ( cCbc.first, pHistName) );
         //cHist->Scale (1 / double_t (fEventsPerPoint) );
         //in order to have proper binomial errors
-        cHist->Divide (cHist, fNormHist, 1, 1, "B");
+        auto cEvents = fSCurveEventsMap.find (cCbc.first);
+        TH2F* cNorm = (fAdaptiveSCurves && cEvents != fSCurveEventsMap.end() ) ? cEvents->second : fNormHist;
+        cHist->Divide (cHist, cNorm, 1, 1, "B");
         //do this in any case!
         this->differentiateHist (cCbc.first, pHistName);
 
@@ -1048,54 +1168,43 @@ void PedeNoise::measureOccupancy (BeBoard* pBoard, int pTGrpId)
 
     //now decode the events and measure the occupancy on the chip
     //in the first iteration, check if I'm in hole mode or electron mode
-    std::vector<Event*> events = GetEvents ( pBoard );
+    const std::vector<Event*>& events = GetEvents ( pBoard );
+    const ChannelMask cTestGroupMask = makeChannelMask ( fTestGroupChannelMap[pTGrpId] );
 
-    for ( auto& cEvent : events )
+    for ( auto cFe : pBoard->fModuleVector )
     {
-        for ( auto cFe : pBoard->fModuleVector )
+        for ( auto cCbc : cFe->fCbcVector )
         {
-            for ( auto cCbc : cFe->fCbcVector )
-            {
-                std::map<Cbc*, uint32_t>::iterator cHitCounter = fHitCountMap.find (cCbc);
-
-                if (cHitCounter != fHitCountMap.end() )
-                {
-                    const std::vector<uint8_t>& cTestGrpChannelVec = fTestGroupChannelMap[pTGrpId];
+            std::map<Cbc*, uint32_t>::iterator cHitCounter = fHitCountMap.find (cCbc);
 
-                    for ( auto& cChan : cTestGrpChannelVec )
-                    {
-                        if ( cEvent->DataBit ( cFe->getFeId(), cCbc->getCbcId(),  cChan ) )
-                            cHitCounter->second++;
-                    }
-                }
-                else LOG (INFO) << RED << "Error: could not find the HitCounter for CBC " << int ( cCbc->getCbcId() ) << RESET ;
-            }
+            if (cHitCounter != fHitCountMap.end() )
+                cHitCounter->second += Event::accumulateOccupancy ( events, cFe->getFeId(), cCbc->getCbcId(), nullptr, cTestGroupMask );
+            else LOG (INFO) << RED << "Error: could not find the HitCounter for CBC " << int ( cCbc->getCbcId() ) << RESET ;
         }
     }
 }
 
 void PedeNoise::fillOccupancyHist (BeBoard* pBoard, const std::vector<Event*>& pEvents)
 {
+    const ChannelMask cAllChannels = allChannelsMask();
+
     for ( auto cFe : pBoard->fModuleVector )
     {
         for ( auto cCbc : cFe->fCbcVector )
         {
             //get the histogram for the occupancy
             TH1F* cHist = dynamic_cast<TH1F*> ( getHist ( cCbc, "Cbc_occupancy" ) );
+            // count the hits per channel over all the events and fill the histogram once
+            std::vector<uint32_t> cCounts ( NCHANNELS, 0 );
+            uint32_t cNHits = Event::accumulateOccupancy ( pEvents, cCbc->getFeId(), cCbc->getCbcId(), cCounts.data(), cAllChannels );
 
-            for (auto& cEvent : pEvents)
+            for ( uint32_t cChan = 0; cChan < NCHANNELS; cChan++ )
             {
-                //for ( uint32_t cId = 0; cId < NCHANNELS; cId++ )
-                //{
-                //if ( cEvent->DataBit ( cCbc->getFeId(), cCbc->getCbcId(), cId ) )
-                //cHist->Fill (cId);
-                //}
-                //experimental
-                std::vector<uint32_t> cHits = cEvent->GetHits (cCbc->getFeId(), cCbc->getCbcId() );
-
-                for (auto cHit : cHits)
-                    cHist->Fill (cHit);
+                if ( cCounts[cChan] != 0 )
+                    addCounts ( cHist, cHist->FindBin ( cChan ), cCounts[cChan] );
             }
+
+            cHist->SetEntries ( cHist->GetEntries() + cNHits );
         }
     }
 
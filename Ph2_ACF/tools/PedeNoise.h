@@ -13,6 +13,7 @@
 #define PedeNoise_h__
 
 #include "Tool.h"
+#include "SCurveScan.h"
 #include "../Utils/Visitor.h"
 #include "../Utils/CommonVisitors.h"
 
@@ -62,6 +63,8 @@ class PedeNoise : public Tool
     TCanvas* fFeSummaryCanvas;
     //histogram to divide the Scurves by to get proper binomial errors
     TH2F*    fNormHist;
+    //with the adaptive scan the number of events differs from point to point, so it is counted per CBC
+    std::map<Cbc*, TH2F*> fSCurveEventsMap;
 
     //have a map of thresholds and hit counts
     std::map<Cbc*, uint16_t> fThresholdMap;
@@ -79,6 +82,9 @@ class PedeNoise : public Tool
     uint8_t fTestPulseAmplitude;
     uint32_t fEventsPerPoint;
     bool fDisableStubLogic;
+    bool fAdaptiveSCurves;
+    uint32_t fSCurveMinEvents;
+    uint16_t fSCurveCoarseStep;
 
     //to hold the original register values
     std::map<Cbc*, uint8_t> fStubLogicValue;
@@ -93,6 +99,8 @@ class PedeNoise : public Tool
 
   private:
     void measureSCurves ( int  pTGrpId, std::string pHistName,  uint16_t pStartValue = 0 );
+    // coarse steps on the plateaus, every DAC value only in the transition, events per point from the binomial error
+    void measureSCurvesAdaptive ( int  pTGrpId, std::string pHistName,  uint16_t pStartValue );
     void differentiateHist (Cbc* pCbc, std::string pHistName);
     void fitHist (Cbc* pCbc, std::string pHistName);
     void processSCurves (std::string pHistName);
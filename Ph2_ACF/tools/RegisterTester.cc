@@ -24,7 +24,7 @@ void RegisterTester::TestRegisters()
         {
             for ( auto cCbc : cFe->fCbcVector )
             {
-                CbcRegMap cMap = cCbc->getRegMap();
+                const CbcRegMap& cMap = cCbc->getRegMap();
 
                 for ( const auto& cReg : cMap )
                 {
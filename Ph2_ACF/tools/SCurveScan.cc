@@ -0,0 +1,228 @@
+#include "SCurveScan.h"
+#include "../Utils/ConsoleColor.h"
+#include "../Utils/Exception.h"
+#include "../Utils/easylogging++.h"
+#include <algorithm>
+#include <cmath>
+
+SCurveScan::SCurveScan ( ThresholdSetter pSetter, Measurement pMeasurement, const std::vector<uint8_t>& pChannels, uint16_t pMaxValue, bool pRising ) :
+    fSetter ( pSetter ),
+    fMeasurement ( pMeasurement ),
+    fChannels(),
+    fMaxValue ( pMaxValue ),
+    fRising ( pRising ),
+    fCbcs(),
+    fNTriggers ( 0 ),
+    fNPoints ( 0 )
+{
+    for ( auto cChannel : pChannels )
+        if ( cChannel < NCHANNELS ) fChannels.push_back ( cChannel );
+}
+
+void SCurveScan::addCbc ( Cbc* pCbc, uint16_t pStartValue )
+{
+    CbcScan& cScan = fCbcs[pCbc];
+    cScan.fPhase = Phase::COARSE_UP;
+    cScan.fStartValue = std::min ( pStartValue, fMaxValue );
+    cScan.fStep = 0;
+    cScan.fNPlateau = 0;
+    cScan.fFirstPlateau = 0;
+    cScan.fEndUp = fMaxValue + 1;
+    cScan.fEndDown = -1;
+    cScan.fDense.clear();
+    cScan.fPoints.clear();
+}
+
+const SCurveScan::ScanPoints& SCurveScan::getPoints ( Cbc* pCbc ) const
+{
+    auto cScan = fCbcs.find ( pCbc );
+
+    if ( cScan == fCbcs.end() ) throw Ph2_HwInterface::Exception ( "SCurveScan::getPoints: this Cbc is not part of the scan" );
+
+    return cScan->second.fPoints;
+}
+
+bool SCurveScan::isPlateau ( const ScanPoint& pPoint, bool pHigh ) const
+{
+    // strictly no hit or a hit in every event on every channel, so that the tails of all the curves are in the dense part
+    uint32_t cPlateauHits = ( pHigh == fRising ) ? pPoint.fNEvents : 0;
+
+    for ( auto cChannel : fChannels )
+        if ( pPoint.fCounts[cChannel] != cPlateauHits ) return false;
+
+    return true;
+}
+
+void SCurveScan::startDown ( CbcScan& pScan )
+{
+    pScan.fPhase = Phase::COARSE_DOWN;
+    pScan.fStep = 1;
+    pScan.fNPlateau = 0;
+
+    // the start value already tells if the lower plateau begins right there
+    auto cStart = pScan.fPoints.find ( pScan.fStartValue );
+
+    if ( cStart != pScan.fPoints.end() && isPlateau ( cStart->second, false ) )
+    {
+        pScan.fNPlateau = 1;
+        pScan.fFirstPlateau = pScan.fStartValue;
+    }
+}
+
+void SCurveScan::startDense ( CbcScan& pScan )
+{
+    pScan.fPhase = Phase::DENSE;
+    pScan.fDense.clear();
+
+    // highest first, the values are taken from the back
+    for ( int cValue = pScan.fEndUp - 1; cValue > pScan.fEndDown; cValue-- )
+        if ( pScan.fPoints.find ( cValue ) == pScan.fPoints.end() ) pScan.fDense.push_back ( cValue );
+}
+
+bool SCurveScan::nextValue ( CbcScan& pScan, uint16_t pCoarseStep, uint16_t& pValue )
+{
+    while ( true )
+    {
+        if ( pScan.fPhase == Phase::COARSE_UP )
+        {
+            int cValue = pScan.fStartValue + int ( pScan.fStep ) * pCoarseStep;
+
+            if ( cValue <= fMaxValue )
+            {
+                pValue = cValue;
+                return true;
+            }
+
+            // no upper plateau before the end of the range, the dense part goes up to it
+            pScan.fEndUp = fMaxValue + 1;
+            startDown ( pScan );
+        }
+        else if ( pScan.fPhase == Phase::COARSE_DOWN )
+        {
+            int cValue = pScan.fStartValue - int ( pScan.fStep ) * pCoarseStep;
+
+            if ( cValue >= 0 )
+            {
+                pValue = cValue;
+                return true;
+            }
+            else
+            {
+                pScan.fEndDown = -1;
+                startDense ( pScan );
+            }
+        }
+        else if ( pScan.fPhase == Phase::DENSE )
+        {
+            if ( !pScan.fDense.empty() )
+            {
+                pValue = pScan.fDense.back();
+                pScan.fDense.pop_back();
+                return true;
+            }
+
+            pScan.fPhase = Phase::DONE;
+        }
+        else return false;
+    }
+}
+
+void SCurveScan::update ( CbcScan& pScan, uint16_t pValue, uint32_t pNPlateauPoints )
+{
+    if ( pScan.fPhase != Phase::COARSE_UP && pScan.fPhase != Phase::COARSE_DOWN ) return;
+
+    bool cUp = pScan.fPhase == Phase::COARSE_UP;
+
+    if ( isPlateau ( pScan.fPoints[pValue], cUp ) )
+    {
+        if ( pScan.fNPlateau == 0 ) pScan.fFirstPlateau = pValue;
+
+        pScan.fNPlateau++;
+    }
+    else pScan.fNPlateau = 0;
+
+    pScan.fStep++;
+
+    if ( pScan.fNPlateau < pNPlateauPoints ) return;
+
+    if ( cUp )
+    {
+        pScan.fEndUp = pScan.fFirstPlateau;
+        startDown ( pScan );
+    }
+    else
+    {
+        pScan.fEndDown = pScan.fFirstPlateau;
+        startDense ( pScan );
+    }
+}
+
+void SCurveScan::run ( uint32_t pEventsPerPoint, uint32_t pMinEvents, uint16_t pCoarseStep, uint32_t pNPlateauPoints )
+{
+    if ( fCbcs.empty() || fChannels.empty() || pEventsPerPoint == 0 ) return;
+
+    uint32_t cMinEvents = std::max ( 1u, std::min ( pMinEvents, pEventsPerPoint ) );
+    pCoarseStep = std::max<uint16_t> ( 1, pCoarseStep );
+    pNPlateauPoints = std::max ( 1u, pNPlateauPoints );
+
+    while ( true )
+    {
+        std::map<Cbc*, uint16_t> cThresholds;
+
+        for ( auto& cScan : fCbcs )
+        {
+            uint16_t cValue;
+
+            if ( nextValue ( cScan.second, pCoarseStep, cValue ) ) cThresholds[cScan.first] = cValue;
+        }
+
+        // every curve is bracketed and filled
+        if ( cThresholds.empty() ) break;
+
+        fSetter ( cThresholds );
+
+        std::map<Cbc*, std::vector<uint32_t>> cCounts;
+
+        for ( auto& cThreshold : cThresholds )
+            cCounts[cThreshold.first].assign ( NCHANNELS, 0 );
+
+        fMeasurement ( cMinEvents, cCounts );
+        uint32_t cNEvents = cMinEvents;
+
+        // complete the point for the channel with the largest binomial variance
+        uint32_t cNeeded = cMinEvents;
+
+        for ( auto& cCbcCounts : cCounts )
+        {
+            for ( auto cChannel : fChannels )
+            {
+                double cOccupancy = cCbcCounts.second[cChannel] / double ( cNEvents );
+                uint32_t cEvents = std::ceil ( 4 * cOccupancy * ( 1 - cOccupancy ) * pEventsPerPoint );
+                cNeeded = std::max ( cNeeded, cEvents );
+            }
+        }
+
+        cNeeded = std::min ( cNeeded, pEventsPerPoint );
+
+        if ( cNeeded > cNEvents )
+        {
+            fMeasurement ( cNeeded - cNEvents, cCounts );
+            cNEvents = cNeeded;
+        }
+
+        fNTriggers += cNEvents;
+
+        for ( auto& cThreshold : cThresholds )
+        {
+            CbcScan& cScan = fCbcs[cThreshold.first];
+            ScanPoint& cPoint = cScan.fPoints[cThreshold.second];
+            cPoint.fNEvents = cNEvents;
+            cPoint.fCounts.swap ( cCounts[cThreshold.first] );
+            fNPoints++;
+
+            update ( cScan, cThreshold.second, pNPlateauPoints );
+        }
+    }
+
+    LOG (DEBUG) << "Adaptive S-curve scan done: " << fNPoints << " points, " << fNTriggers << " triggers";
+}
@@ -0,0 +1,135 @@
+/*!
+
+        \file                   SCurveScan.h
+        \brief                  Adaptive threshold scan of the S-curves of many Cbcs at once
+        \version                1.0
+
+ */
+
+#ifndef _SCURVESCAN_H__
+#define _SCURVESCAN_H__
+
+#include <functional>
+#include <map>
+#include <vector>
+#include <stdint.h>
+#include "../HWDescription/Cbc.h"
+
+using namespace Ph2_HwDescription;
+
+/*!
+ * \class SCurveScan
+ * \brief Threshold scan that only samples the transition of the S-curves densely
+ *
+ * Each Cbc walks its own threshold: first away from its start value in coarse steps, up and then down, until the
+ * channels are all at the occupancy of the plateau of that side on a few consecutive points, then every
+ * threshold between the first plateau point of each side that was not measured yet. A Cbc stops as soon as its curve
+ * is bracketed and filled, the scan ends when all of them are done.
+ *
+ * The events per point are chosen from the binomial uncertainty: a first sample of pMinEvents triggers estimates the
+ * occupancy p of each channel and the point is completed up to 4 p (1 - p) pEventsPerPoint triggers for the worst
+ * channel, which gives every point the uncertainty that pEventsPerPoint triggers give at 50% occupancy. On the plateaus
+ * this is just the first sample.
+ */
+class SCurveScan
+{
+  public:
+    /*!
+     * \brief Move each Cbc of the map to its threshold
+     */
+    using ThresholdSetter = std::function<void ( const std::map<Cbc*, uint16_t>& pThresholds )>;
+    /*!
+     * \brief Take pNEvents triggers and add the hits of every channel to pCounts[Cbc][channel], NCHANNELS counters per Cbc
+     */
+    using Measurement = std::function<void ( uint32_t pNEvents, std::map<Cbc*, std::vector<uint32_t>>& pCounts )>;
+
+    /*!
+     * \brief Result of one threshold of one Cbc
+     */
+    struct ScanPoint
+    {
+        uint32_t fNEvents;
+        std::vector<uint32_t> fCounts;          /*!< hits per channel, NCHANNELS entries */
+    };
+    using ScanPoints = std::map<uint16_t, ScanPoint>;
+
+    /*!
+     * \brief Constructor
+     * \param pSetter : the threshold writes
+     * \param pMeasurement : the data taking
+     * \param pChannels : the channels taken into account for the plateaus and the number of events, counting from 0
+     * \param pMaxValue : largest threshold value
+     * \param pRising : the occupancy goes up with the threshold value (electron mode)
+     */
+    SCurveScan ( ThresholdSetter pSetter, Measurement pMeasurement, const std::vector<uint8_t>& pChannels, uint16_t pMaxValue, bool pRising );
+
+    /*!
+     * \brief Add a Cbc to the scan
+     * \param pCbc : the Cbc
+     * \param pStartValue : threshold around which the transition is expected
+     */
+    void addCbc ( Cbc* pCbc, uint16_t pStartValue );
+    /*!
+     * \brief Scan all the Cbcs
+     * \param pEventsPerPoint : events at 50% occupancy
+     * \param pMinEvents : events at a point on a plateau
+     * \param pCoarseStep : threshold step outside the transition
+     * \param pNPlateauPoints : consecutive coarse points on a plateau that end a direction
+     */
+    void run ( uint32_t pEventsPerPoint, uint32_t pMinEvents, uint16_t pCoarseStep, uint32_t pNPlateauPoints );
+    /*!
+     * \brief The points measured for a Cbc
+     */
+    const ScanPoints& getPoints ( Cbc* pCbc ) const;
+    /*!
+     * \brief Number of triggers taken since construction
+     */
+    uint64_t getNTriggers() const
+    {
+        return fNTriggers;
+    }
+    /*!
+     * \brief Number of threshold points measured since construction, summed over the Cbcs
+     */
+    uint64_t getNPoints() const
+    {
+        return fNPoints;
+    }
+
+  private:
+    enum class Phase {COARSE_UP, COARSE_DOWN, DENSE, DONE};
+
+    struct CbcScan
+    {
+        Phase fPhase;
+        uint16_t fStartValue;
+        uint32_t fStep;                         /*!< coarse steps away from the start value */
+        uint32_t fNPlateau;                     /*!< consecutive coarse points on a plateau */
+        int fFirstPlateau;                      /*!< first of them */
+        int fEndUp;                             /*!< the dense part is between fEndDown and fEndUp, both excluded */
+        int fEndDown;
+        std::vector<uint16_t> fDense;           /*!< thresholds left to measure in the dense part */
+        ScanPoints fPoints;
+    };
+
+    // all the channels at the occupancy of the plateau on the high (pHigh) or on the low threshold side
+    bool isPlateau ( const ScanPoint& pPoint, bool pHigh ) const;
+    void startDown ( CbcScan& pScan );
+    void startDense ( CbcScan& pScan );
+    // the next threshold of a Cbc, false once it is done
+    bool nextValue ( CbcScan& pScan, uint16_t pCoarseStep, uint16_t& pValue );
+    // take the result of the point at pValue into account
+    void update ( CbcScan& pScan, uint16_t pValue, uint32_t pNPlateauPoints );
+
+    ThresholdSetter fSetter;
+    Measurement fMeasurement;
+    std::vector<uint8_t> fChannels;
+    uint16_t fMaxValue;
+    bool fRising;
+    std::map<Cbc*, CbcScan> fCbcs;
+
+    uint64_t fNTriggers;
+    uint64_t fNPoints;
+};
+
+#endif
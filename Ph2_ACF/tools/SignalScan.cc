@@ -97,6 +97,11 @@ void SignalScan::ScanSignal(uint16_t cVcthStart, uint16_t cVcthStop )
 
             }
 
+            // clusters are found on the whole module, a cluster shared by two CBCs is counted on the CBC of its first strip
+            ClusterFinder cClusterFinder ( cFe );
+            std::vector<Cluster> cModuleClusters;
+            std::map<uint8_t, uint32_t> cNClusters;
+
             for( int cVcth = cVcthStart ; cVcth >= cVcthStop ; cVcth -= cVcthStep )
             {   
                 ThresholdVisitor cVisitor (fCbcInterface, cVcth);
@@ -132,42 +137,45 @@ void SignalScan::ScanSignal(uint16_t cVcthStart, uint16_t cVcthStop )
                     cTotalEventCounter+= events.size() ;
                     for (auto& cEvent : events)
                     {
-                        
+                        cModuleClusters.clear();
+                        cClusterFinder.findClusters ( cEvent, cModuleClusters );
+
                         for ( auto cCbc : cFe->fCbcVector )
+                            cNClusters[cCbc->getCbcId()] = 0;
+
+                        for(auto& cCluster : cModuleClusters)
                         {
-                            TString cHistName;
-                            cHistName = Form("Fe%dCbc%d_Clusters_SignalScan" , +cFe->getFeId() ,+cCbc->getCbcId() );
-                            TH1D* cClustersHisto = ( TH1D* ) ( gROOT->FindObject ( cHistName ) );
+                            uint8_t cCbcId = cClusterFinder.getCbcId ( cCluster.fFirstStrip );
+                            TH2D* cClusterWidth = ( TH2D* ) ( gROOT->FindObject ( Form("Fe%dCbc%d_ClusterWidth_SignalScan" , +cFe->getFeId() , +cCbcId ) ) );
 
+                            if ( cClusterWidth ) cClusterWidth->Fill(cCluster.fClusterWidth, cVcth );
 
-                            cHistName = Form("Fe%dCbc%d_ClusterWidth_SignalScan" , +cFe->getFeId() , +cCbc->getCbcId() );
-                            TH2D* cClusterWidth = ( TH2D* ) ( gROOT->FindObject ( cHistName ) );
-                            // cHistName = Form("Fe%dCbc%d_ClusterOccupancy" , +cFe->getFeId() , +cCbc->getCbcId() );
-                            // TH2F* cClustersHisto = ( TH2F* ) ( gROOT->FindObject ( cHistName ) );
+                            cNClusters[cCbcId]++;
 
-                            const std::vector<Cluster>& cClusters = cEvent->getClusters( cFe->getFeId(), cCbc->getCbcId() );
-                            cClustersHisto->Fill( cVcth , cClusters.size() );
-                            for(auto& cCluster : cClusters)
+                            if( cCluster.fClusterWidth  <= 2 )
                             {
-                                cClusterWidth->Fill(cCluster.fClusterWidth, cVcth );
-                                //cClustersHisto->Fill(cCluster.fFirstStrip, cCluster.fClusterWidth);
-                                if( cCluster.fClusterWidth  <= 2 )
-                                {
-                                    cClusterCounter++;
-                                }
+                                cClusterCounter++;
                             }
-                            
+                        }
+
+                        for ( auto cCbc : cFe->fCbcVector )
+                        {
+                            TString cHistName;
+                            cHistName = Form("Fe%dCbc%d_Clusters_SignalScan" , +cFe->getFeId() ,+cCbc->getCbcId() );
+                            TH1D* cClustersHisto = ( TH1D* ) ( gROOT->FindObject ( cHistName ) );
+                            cClustersHisto->Fill( cVcth , cNClusters[cCbc->getCbcId()] );
+
                             cHistName = Form("Fe%dCbc%d_SignalScan" , +cFe->getFeId() , +cCbc->getCbcId() );
                             TH2D* cSignalScan = dynamic_cast<TH2D*> ( getHist ( cCbc, cHistName.Data() ) );
 
-                            for(int cChan = 0 ; cChan < NCHANNELS ; cChan++ )
-                            {
+                            // only the hit channels are filled, the empty ones would add 0
+                            const std::vector<uint32_t> cHits = cEvent->GetHits ( cFe->getFeId(), cCbc->getCbcId() );
 
-                                int cHits = cEvent->DataBit ( cFe->getFeId(), cCbc->getCbcId(), cChan ); 
-                                cSignalScan->Fill( cChan,cVcth,  cHits );
-                                cHitCounter += cHits;
-                                cTotalHitCounter += cHits;
-                            }
+                            for ( auto cChan : cHits )
+                                cSignalScan->Fill( cChan, cVcth );
+
+                            cHitCounter += cHits.size();
+                            cTotalHitCounter += cHits.size();
                         }
                     }
 
@@ -17,6 +17,7 @@
 #include "../Utils/Utilities.h"
 #include "../Utils/CommonVisitors.h"
 #include "../Utils/Timer.h"
+#include "../Utils/ClusterFinder.h"
 
 
 #include "TString.h"
@@ -422,6 +422,8 @@ void Tool::dumpConfigFiles()
 }
 void Tool::setSystemTestPulse ( uint8_t pTPAmplitude, uint8_t pTestGroup, bool pTPState, bool pHoleMode )
 {
+    // the test pulse settings of all the Cbcs go out together, one I2C transaction per board
+    CbcRegBatch cBatch;
 
     for (auto cBoard : this->fBoardVector)
     {
@@ -469,10 +471,12 @@ void Tool::setSystemTestPulse ( uint8_t pTPAmplitude, uint8_t pTestGroup, bool p
                     cRegVec.push_back ( std::make_pair ( "TestPulsePot", pTPAmplitude ) );
                 }
 
-                this->fCbcInterface->WriteCbcMultReg (cCbc, cRegVec);
+                cBatch.write (cCbc, cRegVec);
             }
         }
     }
+
+    this->fCbcInterface->FlushCbcRegBatch (cBatch);
 }
 
 void Tool::setFWTestPulse()
@@ -551,6 +555,28 @@ void Tool::MakeTestGroups ( bool pAllChan )
     }
 }
 
+void Tool::countChannelHits ( uint32_t pNEvents, std::map<Cbc*, std::vector<uint32_t>>& pCounts )
+{
+    ReadNEvents (pNEvents);
+    ChannelMask cMask = allChannelsMask();
+
+    for ( BeBoard* pBoard : fBoardVector )
+    {
+        const std::vector<Event*>& events = GetEvents ( pBoard );
+
+        for ( auto cFe : pBoard->fModuleVector )
+        {
+            for ( auto cCbc : cFe->fCbcVector )
+            {
+                auto cCounts = pCounts.find ( cCbc );
+
+                if ( cCounts != pCounts.end() )
+                    Event::accumulateOccupancy ( events, cCbc->getFeId(), cCbc->getCbcId(), cCounts->second.data(), cMask );
+            }
+        }
+    }
+}
+
 void Tool::CreateReport()
 {
     std::ofstream report;
@@ -102,6 +102,8 @@ class Tool : public SystemController
     void setFWTestPulse();
     // make test groups for everything Test pulse or Calibration
     void MakeTestGroups ( bool pAllChan = false );
+    // take pNEvents events on all boards and add the hits per channel of the Cbcs in pCounts (NCHANNELS counters each)
+    void countChannelHits ( uint32_t pNEvents, std::map<Cbc*, std::vector<uint32_t>>& pCounts );
     //for hybrid testing
     void CreateReport();
     void AmmendReport (std::string pString );
@@ -0,0 +1,146 @@
+#include "TrimEngine.h"
+#include "../Utils/ConsoleColor.h"
+#include "../Utils/Exception.h"
+#include "../Utils/easylogging++.h"
+#include <algorithm>
+
+TrimEngine::TrimEngine ( CbcInterface* pCbcInterface, Measurement pMeasurement ) :
+    fCbcInterface ( pCbcInterface ),
+    fMeasurement ( pMeasurement ),
+    fChips(),
+    fNTriggers ( 0 ),
+    fNI2CWrites ( 0 )
+{
+}
+
+void TrimEngine::addChannels ( Cbc* pCbc, const std::vector<uint8_t>& pChannels, const std::vector<uint8_t>& pStartValues )
+{
+    ChipTrims& cChip = fChips[pCbc];
+
+    for ( size_t cIndex = 0; cIndex < pChannels.size(); cIndex++ )
+    {
+        if ( pChannels[cIndex] >= NCHANNELS ) continue;
+
+        cChip.fChannels.push_back ( pChannels[cIndex] );
+        cChip.fOffsets.push_back ( ( cIndex < pStartValues.size() ) ? pStartValues[cIndex] : 0 );
+        cChip.fRevert.push_back ( false );
+    }
+}
+
+void TrimEngine::clearChannels()
+{
+    fChips.clear();
+}
+
+const std::vector<uint8_t>& TrimEngine::getOffsets ( Cbc* pCbc ) const
+{
+    auto cChip = fChips.find ( pCbc );
+
+    if ( cChip == fChips.end() ) throw Ph2_HwInterface::Exception ( "TrimEngine::getOffsets: no channels of this Cbc in the search" );
+
+    return cChip->second.fOffsets;
+}
+
+const std::vector<uint8_t>& TrimEngine::getChannels ( Cbc* pCbc ) const
+{
+    auto cChip = fChips.find ( pCbc );
+
+    if ( cChip == fChips.end() ) throw Ph2_HwInterface::Exception ( "TrimEngine::getChannels: no channels of this Cbc in the search" );
+
+    return cChip->second.fChannels;
+}
+
+void TrimEngine::writeStep ( int pRevertBit, int pToggleBit )
+{
+    CbcRegBatch cBatch;
+
+    for ( auto& cChip : fChips )
+    {
+        ChipTrims& cTrims = cChip.second;
+
+        for ( size_t cIndex = 0; cIndex < cTrims.fChannels.size(); cIndex++ )
+        {
+            uint8_t cOffset = cTrims.fOffsets[cIndex];
+
+            if ( pRevertBit >= 0 && cTrims.fRevert[cIndex] ) cOffset ^= 1 << pRevertBit;
+
+            if ( pToggleBit >= 0 ) cOffset ^= 1 << pToggleBit;
+
+            cTrims.fRevert[cIndex] = false;
+
+            if ( cOffset == cTrims.fOffsets[cIndex] ) continue;
+
+            cTrims.fOffsets[cIndex] = cOffset;
+            cBatch.write ( cChip.first, CbcRegIndex::channelOffset ( cTrims.fChannels[cIndex] + 1 ), cOffset );
+        }
+    }
+
+    fNI2CWrites += cBatch.size();
+    fCbcInterface->FlushCbcRegBatch ( cBatch );
+}
+
+void TrimEngine::run ( uint32_t pEventsPerStep, float pThreshold, uint32_t pNChunks )
+{
+    if ( fChips.empty() || pEventsPerStep == 0 ) return;
+
+    uint32_t cChunkSize = std::max ( 1u, ( pEventsPerStep + std::max ( 1u, pNChunks ) - 1 ) / std::max ( 1u, pNChunks ) );
+    float cMaxHits = pThreshold * pEventsPerStep;
+
+    for ( int iBit = 7; iBit >= 0; iBit-- )
+    {
+        // toggle back the previous bit where the occupancy was too high and toggle this one, in the same write
+        writeStep ( iBit + 1 <= 7 ? iBit + 1 : -1, iBit );
+
+        std::map<Cbc*, std::vector<uint32_t>> cCounts;
+
+        for ( auto& cChip : fChips )
+            cCounts[cChip.first].assign ( NCHANNELS, 0 );
+
+        uint32_t cNEvents = 0;
+
+        while ( cNEvents < pEventsPerStep )
+        {
+            uint32_t cNChunk = std::min ( cChunkSize, pEventsPerStep - cNEvents );
+            fMeasurement ( cNChunk, cCounts );
+            cNEvents += cNChunk;
+
+            // a channel is decided once it is above the threshold or can not get above it with the remaining events
+            uint32_t cRemaining = pEventsPerStep - cNEvents;
+            bool cAllDecided = true;
+
+            for ( auto& cChip : fChips )
+            {
+                const std::vector<uint32_t>& cChipCounts = cCounts[cChip.first];
+
+                for ( auto cChannel : cChip.second.fChannels )
+                {
+                    if ( cChipCounts[cChannel] <= cMaxHits && cChipCounts[cChannel] + cRemaining > cMaxHits )
+                    {
+                        cAllDecided = false;
+                        break;
+                    }
+                }
+
+                if ( !cAllDecided ) break;
+            }
+
+            if ( cAllDecided ) break;
+        }
+
+        fNTriggers += cNEvents;
+
+        for ( auto& cChip : fChips )
+        {
+            ChipTrims& cTrims = cChip.second;
+            const std::vector<uint32_t>& cChipCounts = cCounts[cChip.first];
+
+            for ( size_t cIndex = 0; cIndex < cTrims.fChannels.size(); cIndex++ )
+                cTrims.fRevert[cIndex] = cChipCounts[cTrims.fChannels[cIndex]] > cMaxHits;
+        }
+
+        LOG (DEBUG) << "Bit " << iBit << " of the offsets decided after " << cNEvents << " of " << pEventsPerStep << " events";
+    }
+
+    // toggle back the LSB where needed
+    writeStep ( 0, -1 );
+}
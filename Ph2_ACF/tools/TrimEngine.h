@@ -0,0 +1,107 @@
+/*!
+
+        \file                   TrimEngine.h
+        \brief                  Successive approximation of the per-channel trim registers of many Cbcs at once
+        \version                1.0
+
+ */
+
+#ifndef _TRIMENGINE_H__
+#define _TRIMENGINE_H__
+
+#include <functional>
+#include <map>
+#include <vector>
+#include <stdint.h>
+#include "../HWDescription/Cbc.h"
+#include "../HWInterface/CbcInterface.h"
+
+using namespace Ph2_HwDescription;
+using namespace Ph2_HwInterface;
+
+/*!
+ * \class TrimEngine
+ * \brief Binary search of the 8 bit offset (ChannelXXX) registers of any number of channels on any number of Cbcs
+ *
+ * Each step toggles one bit of the offsets of all the channels, from the MSB down, takes data once for all of them and
+ * toggles the bit back where the occupancy is above the threshold. The bit that is toggled back and the next bit go out
+ * in the same register write, and all the writes of a step are a single I2C batch per board. A step stops taking
+ * triggers as soon as the decision of every channel is fixed, whatever the remaining events would show, so the result
+ * is the one of the full number of events.
+ */
+class TrimEngine
+{
+  public:
+    /*!
+     * \brief Take pNEvents triggers and add the hits of every channel to pCounts[Cbc][channel], NCHANNELS counters per Cbc
+     */
+    using Measurement = std::function<void ( uint32_t pNEvents, std::map<Cbc*, std::vector<uint32_t>>& pCounts )>;
+
+    /*!
+     * \brief Constructor
+     * \param pCbcInterface : interface used for the register writes
+     * \param pMeasurement : the data taking
+     */
+    TrimEngine ( CbcInterface* pCbcInterface, Measurement pMeasurement );
+
+    /*!
+     * \brief Add channels of a Cbc to the search
+     * \param pCbc : the Cbc
+     * \param pChannels : channels, counting from 0
+     * \param pStartValues : offsets the search starts from, one per channel
+     */
+    void addChannels ( Cbc* pCbc, const std::vector<uint8_t>& pChannels, const std::vector<uint8_t>& pStartValues );
+    /*!
+     * \brief Forget the channels, the counters are kept
+     */
+    void clearChannels();
+    /*!
+     * \brief Run the binary search on all the channels
+     * \param pEventsPerStep : events per bit
+     * \param pThreshold : the bit is toggled back on the channels with an occupancy above this fraction of the events
+     * \param pNChunks : the events of a step are taken in up to this many acquisitions, to be able to stop early
+     */
+    void run ( uint32_t pEventsPerStep, float pThreshold, uint32_t pNChunks = 4 );
+    /*!
+     * \brief Offsets found for the channels of a Cbc, in the order they were added
+     */
+    const std::vector<uint8_t>& getOffsets ( Cbc* pCbc ) const;
+    /*!
+     * \brief Channels of a Cbc, in the order they were added
+     */
+    const std::vector<uint8_t>& getChannels ( Cbc* pCbc ) const;
+    /*!
+     * \brief Number of triggers taken since construction
+     */
+    uint64_t getNTriggers() const
+    {
+        return fNTriggers;
+    }
+    /*!
+     * \brief Number of register writes sent since construction
+     */
+    uint64_t getNI2CWrites() const
+    {
+        return fNI2CWrites;
+    }
+
+  private:
+    struct ChipTrims
+    {
+        std::vector<uint8_t> fChannels;
+        std::vector<uint8_t> fOffsets;
+        std::vector<bool> fRevert;             /*!< the current bit has to be toggled back */
+    };
+
+    // write the offsets of all the channels, toggling back the bit pRevertBit where needed and toggling pToggleBit
+    void writeStep ( int pRevertBit, int pToggleBit );
+
+    CbcInterface* fCbcInterface;
+    Measurement fMeasurement;
+    std::map<Cbc*, ChipTrims> fChips;
+
+    uint64_t fNTriggers;
+    uint64_t fNI2CWrites;
+};
+
+#endif